@@ -11,6 +11,12 @@ STB_IMAGE_WRITE_DIR := $(SDL_GPU_DIR)/src/externals/stb_image_write
 LOCAL_CFLAGS := -I$(LOCAL_PATH)/../SDL/include -I$(LOCAL_PATH)/$(SDL_GPU_DIR)/include -I$(LOCAL_PATH)/$(STB_IMAGE_DIR) -I$(LOCAL_PATH)/$(STB_IMAGE_WRITE_DIR)
 
 LOCAL_SRC_FILES := $(SDL_GPU_DIR)/src/SDL_gpu.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_compressed.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_capture.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_png.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_pixels.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_mipmap.c \
+				   $(SDL_GPU_DIR)/src/SDL_gpu_shaders.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_matrix.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_renderer.c \
 				   $(SDL_GPU_DIR)/src/SDL_gpu_shapes.c \
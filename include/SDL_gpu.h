@@ -238,6 +238,7 @@ typedef enum {
 
 /*! \ingroup ImageControls
  * Image format enum
+ * The block-compressed formats (GPU_FORMAT_BC1 and up) come only from GPU_LoadImage() and cannot be passed to GPU_CreateImage().
  * \see GPU_CreateImage()
  */
 typedef enum {
@@ -251,7 +252,13 @@ typedef enum {
     GPU_FORMAT_YCbCr420P = 8,
     GPU_FORMAT_BGR = 9,
     GPU_FORMAT_BGRA = 10,
-    GPU_FORMAT_ABGR = 11
+    GPU_FORMAT_ABGR = 11,
+    GPU_FORMAT_BC1 = 12,
+    GPU_FORMAT_BC2 = 13,
+    GPU_FORMAT_BC3 = 14,
+    GPU_FORMAT_ETC2_RGB8 = 15,
+    GPU_FORMAT_ETC2_RGBA8 = 16,
+    GPU_FORMAT_ASTC_4x4 = 17
 } GPU_FormatEnum;
 
 /*! \ingroup ImageControls
@@ -268,6 +275,68 @@ typedef enum {
     GPU_FILE_TGA
 } GPU_FileFormatEnum;
 
+/*! \ingroup SurfaceControls
+ * Row filter used when saving PNG files.  GPU_PNG_FILTER_ADAPTIVE picks the best filter for each row.
+ * \see GPU_SaveOptions
+ */
+typedef enum {
+    GPU_PNG_FILTER_ADAPTIVE = 0,
+    GPU_PNG_FILTER_NONE,
+    GPU_PNG_FILTER_SUB,
+    GPU_PNG_FILTER_UP,
+    GPU_PNG_FILTER_AVERAGE,
+    GPU_PNG_FILTER_PAETH
+} GPU_PNGFilterEnum;
+
+/*! \ingroup SurfaceControls
+ * Options for saving images and surfaces.
+ * \see GPU_SetSaveOptions()
+ */
+typedef struct GPU_SaveOptions
+{
+    int compression_level;  // 0 (stored, fastest) to 9 (smallest).  Defaults to 6.
+    GPU_PNGFilterEnum filter;
+    int num_threads;  // PNG row bands are compressed on this many threads.  0 (the default) uses one per CPU core.
+} GPU_SaveOptions;
+
+/*! \ingroup ImageControls
+ * Resampling filter for mipmap chains built on the CPU.  GPU_MIPMAP_FILTER_BOX averages each 2x2 block and is the fastest.
+ * GPU_MIPMAP_FILTER_KAISER and GPU_MIPMAP_FILTER_LANCZOS are windowed sinc filters that keep smaller levels sharper.
+ * \see GPU_SetMipmapsOnLoad()
+ */
+typedef enum {
+    GPU_MIPMAP_FILTER_BOX = 0,
+    GPU_MIPMAP_FILTER_KAISER,
+    GPU_MIPMAP_FILTER_LANCZOS
+} GPU_MipmapFilterEnum;
+
+/*! \ingroup Conversions
+ * Output format of a capture.  The image formats write one numbered file per frame.  GPU_CAPTURE_Y4M and GPU_CAPTURE_RAW write all frames to a single uncompressed stream.
+ * \see GPU_StartCapture()
+ */
+typedef enum {
+    GPU_CAPTURE_PNG = 0,
+    GPU_CAPTURE_BMP,
+    GPU_CAPTURE_TGA,
+    GPU_CAPTURE_QOI,
+    GPU_CAPTURE_Y4M,  // YUV4MPEG2 with 4:2:0 BT.601 frames, readable by ffmpeg and most video tools
+    GPU_CAPTURE_RAW  // Tightly packed RGBA frames with no header
+} GPU_CaptureFormatEnum;
+
+/*! \ingroup Conversions
+ * What a capture does with a new frame when its encoder queue is full.
+ * \see GPU_SetCaptureOptions()
+ */
+typedef enum {
+    GPU_CAPTURE_DROP_FRAMES = 0,  // Skip the frame and keep the frame rate
+    GPU_CAPTURE_WAIT = 1  // Block GPU_Flip() until an encoder thread catches up, so every frame is kept
+} GPU_CapturePolicyEnum;
+
+/*! \ingroup Conversions
+ * An active capture started with GPU_StartCapture().
+ */
+typedef struct GPU_Capture GPU_Capture;
+
 
 
 /*! \ingroup ImageControls
@@ -308,8 +377,27 @@ typedef struct GPU_Image
 	void* data;
 	int refcount;
 	GPU_bool is_alias;
+	GPU_bool has_premultiplied_alpha;  // The color channels are stored multiplied by alpha.  See GPU_SetPremultiplyOnLoad().
 } GPU_Image;
 
+/*! \ingroup ImageControls
+ * Called on the rendering thread when a request from GPU_LoadImageAsync() completes.
+ * \param image The new image, or NULL if loading failed.  The callback takes ownership, so don't forget to GPU_FreeImage() it.
+ * \param filename The requested file
+ * \param userdata The pointer given to GPU_LoadImageAsync()
+ * \see GPU_LoadImageAsync()
+ */
+typedef void (SDLCALL *GPU_LoadImageCallback)(GPU_Image* image, const char* filename, void* userdata);
+
+/*! \ingroup Conversions
+ * Called by GPU_Flip() when the pixels requested with GPU_ReadTargetAsync() are ready.
+ * \param target The target that was read
+ * \param surface The requested region in RGBA, or NULL if reading failed.  The callback takes ownership, so don't forget to SDL_FreeSurface() it.
+ * \param userdata The pointer given to GPU_ReadTargetAsync()
+ * \see GPU_ReadTargetAsync()
+ */
+typedef void (SDLCALL *GPU_ReadTargetCallback)(GPU_Target* target, SDL_Surface* surface, void* userdata);
+
 /*! \ingroup ImageControls
  * A backend-neutral type that is intended to hold a backend-specific handle/pointer to a texture.
  * \see GPU_CreateImageUsingTexture()
@@ -317,6 +405,23 @@ typedef struct GPU_Image
  */
 typedef uintptr_t GPU_TextureHandle;
 
+/*! \ingroup ImageControls
+ * Video memory used by the current renderer, as counted by SDL_gpu.  Driver overhead and padding are not included.
+ * \see GPU_GetMemoryStats()
+ * \see GPU_SetTextureBudget()
+ */
+typedef struct GPU_MemoryStats
+{
+	Uint64 texture_bytes;  // Resident textures, including mipmaps and chroma planes
+	Uint64 renderbuffer_bytes;  // Depth buffers from GPU_AddDepthBuffer()
+	Uint64 evicted_bytes;  // Texture memory currently held in CPU copies by the texture budget
+	Uint64 budget_bytes;  // The limit set with GPU_SetTextureBudget(), or 0
+	int num_textures;
+	int num_renderbuffers;
+	int num_framebuffers;
+	int num_evicted_images;
+} GPU_MemoryStats;
+
 
 /*! \ingroup TargetControls
  * Camera object that determines viewing transform.
@@ -348,6 +453,17 @@ typedef struct GPU_ShaderBlock
     int modelViewProjection_loc;
 } GPU_ShaderBlock;
 
+/*! \ingroup ShaderInterface
+ * A vertex and fragment shader source pair that is built in variants selected by feature keywords.
+ * \see GPU_CreateShaderVariantSet()
+ * \see GPU_GetShaderVariant()
+ */
+typedef struct GPU_ShaderVariantSet GPU_ShaderVariantSet;
+
+/*! \ingroup ShaderInterface
+ * The most feature keywords a GPU_ShaderVariantSet can have, one per bit of a keyword mask. */
+#define GPU_SHADER_MAX_VARIANT_KEYWORDS 32
+
 
 
 
@@ -472,6 +588,10 @@ static const GPU_FeatureEnum GPU_FEATURE_PIXEL_SHADER = 0x200;
 static const GPU_FeatureEnum GPU_FEATURE_GEOMETRY_SHADER = 0x400;
 static const GPU_FeatureEnum GPU_FEATURE_WRAP_REPEAT_MIRRORED = 0x800;
 static const GPU_FeatureEnum GPU_FEATURE_CORE_FRAMEBUFFER_OBJECTS = 0x1000;
+static const GPU_FeatureEnum GPU_FEATURE_TEXTURE_COMPRESSION_S3TC = 0x2000;
+static const GPU_FeatureEnum GPU_FEATURE_TEXTURE_COMPRESSION_ETC2 = 0x4000;
+static const GPU_FeatureEnum GPU_FEATURE_TEXTURE_COMPRESSION_ASTC = 0x8000;
+static const GPU_FeatureEnum GPU_FEATURE_UNIFORM_BUFFERS = 0x10000;
 
 /*! Combined feature flags */
 #define GPU_FEATURE_ALL_BASE GPU_FEATURE_RENDER_TARGETS
@@ -591,6 +711,16 @@ typedef enum {
     GPU_GEOMETRY_SHADER = 2
 } GPU_ShaderEnum;
 
+/*! \ingroup ShaderInterface
+ * Progress of a shader program linked with GPU_LinkShaderProgramAsync().
+ * \see GPU_GetShaderProgramStatus()
+ */
+typedef enum {
+    GPU_SHADER_STATUS_FAILED = 0,
+    GPU_SHADER_STATUS_PENDING = 1,
+    GPU_SHADER_STATUS_READY = 2
+} GPU_ShaderStatusEnum;
+
 
 
 /*! \ingroup ShaderInterface
@@ -848,20 +978,22 @@ DECLSPEC void SDLCALL GPU_LogError(const char* format, ...);
 /*! Sets a custom callback for handling logging.  Use stdio's vsnprintf() to process the va_list into a string.  Passing NULL as the callback will reset to the default internal logging. */
 DECLSPEC void SDLCALL GPU_SetLogCallback(int (*callback)(GPU_LogLevelEnum log_level, const char* format, va_list args));
 
-/*! Pushes a new error code into the error queue.  If the queue is full, the queue is not modified.
+/*! Pushes a new error code into the calling thread's error queue.  If the queue is full, the queue is not modified.
+ * The details are stored unformatted and only formatted when the error is popped.
  * \param function The name of the function that pushed the error
  * \param error The error code to push on the error queue
  * \param details Additional information string, can be NULL.
  */
 DECLSPEC void SDLCALL GPU_PushErrorCode(const char* function, GPU_ErrorEnum error, const char* details, ...);
 
-/*! Pops an error object from the error queue and returns it.  If the error queue is empty, it returns an error object with NULL function, GPU_ERROR_NONE error, and NULL details. */
+/*! Pops an error object from the calling thread's error queue and returns it.  If the error queue is empty, it returns an error object with NULL function, GPU_ERROR_NONE error, and NULL details.
+ * The returned strings stay valid until the next call to GPU_PopErrorCode() on the same thread. */
 DECLSPEC GPU_ErrorObject SDLCALL GPU_PopErrorCode(void);
 
 /*! Gets the string representation of an error code. */
 DECLSPEC const char* SDLCALL GPU_GetErrorString(GPU_ErrorEnum error);
 
-/*! Changes the maximum number of error objects that SDL_gpu will store.  This deletes all currently stored errors. */
+/*! Changes the maximum number of error objects that SDL_gpu will store per thread.  This deletes all errors currently stored for the calling thread. */
 DECLSPEC void SDLCALL GPU_SetErrorQueueMax(unsigned int max);
 
 // End of Logging
@@ -1138,7 +1270,8 @@ DECLSPEC void SDLCALL GPU_UnsetTargetColor(GPU_Target* target);
 /*! \ingroup SurfaceControls
  *  @{ */
 
-/*! Load surface from an image file that is supported by this renderer.  Don't forget to SDL_FreeSurface() it. */
+/*! Load surface from an image file that is supported by this renderer.  Don't forget to SDL_FreeSurface() it.
+ * The base level of a BC1-BC3 or ETC2 KTX, KTX2 or DDS file is decompressed to 32-bit RGBA. */
 DECLSPEC SDL_Surface* SDLCALL GPU_LoadSurface(const char* filename);
 
 /*! Load surface from an image file in memory.  Don't forget to SDL_FreeSurface() it. */
@@ -1154,6 +1287,13 @@ DECLSPEC GPU_bool SDLCALL GPU_SaveSurface(SDL_Surface* surface, const char* file
  * Returns 0 on failure. */
 DECLSPEC GPU_bool SDLCALL GPU_SaveSurface_RW(SDL_Surface* surface, SDL_RWops* rwops, GPU_bool free_rwops, GPU_FileFormatEnum format);
 
+/*! Sets the options used by GPU_SaveSurface(), GPU_SaveImage() and their RWops versions.
+ * PNG files are filtered and deflated in row bands on several threads, so large saves scale with the number of cores. */
+DECLSPEC void SDLCALL GPU_SetSaveOptions(GPU_SaveOptions options);
+
+/*! \return The current save options. */
+DECLSPEC GPU_SaveOptions SDLCALL GPU_GetSaveOptions(void);
+
 // End of SurfaceControls
 /*! @} */
 
@@ -1173,12 +1313,84 @@ DECLSPEC GPU_Image* SDLCALL GPU_CreateImage(Uint16 w, Uint16 h, GPU_FormatEnum f
 /*! Create a new image that uses the given native texture handle as the image texture. */
 DECLSPEC GPU_Image* SDLCALL GPU_CreateImageUsingTexture(GPU_TextureHandle handle, GPU_bool take_ownership);
 
-/*! Load image from an image file that is supported by this renderer.  Don't forget to GPU_FreeImage() it. */
+/*! Create a new, blank image that is meant to be rewritten every frame (e.g. for video playback).  Don't forget to GPU_FreeImage() it.
+ * The image owns a ring of pixel buffers (where supported) that GPU_LockImage() maps directly, so a decoder can write into memory the driver uploads from without an intermediate copy.
+	 * \param w Image width in pixels
+	 * \param h Image height in pixels
+	 * \param format Format of color channels.
+	 */
+DECLSPEC GPU_Image* SDLCALL GPU_CreateStreamingImage(Uint16 w, Uint16 h, GPU_FormatEnum format);
+
+/*! Load image from an image file that is supported by this renderer.  Don't forget to GPU_FreeImage() it.
+ * KTX, KTX2 and DDS files holding BC1-BC3 (S3TC), ETC2 or ASTC 4x4 data are uploaded compressed along with their mipmap levels.
+ * If the renderer lacks the format (see GPU_FEATURE_TEXTURE_COMPRESSION_S3TC and friends), BC and ETC2 data is decompressed to GPU_FORMAT_RGBA instead. */
 DECLSPEC GPU_Image* SDLCALL GPU_LoadImage(const char* filename);
 
-/*! Load image from an image file in memory.  Don't forget to GPU_FreeImage() it. */
+/*! Load image from an image file in memory.  Don't forget to GPU_FreeImage() it.
+ * \see GPU_LoadImage() */
 DECLSPEC GPU_Image* SDLCALL GPU_LoadImage_RW(SDL_RWops* rwops, GPU_bool free_rwops);
 
+/*! Load image from an image file without blocking.  Files are read and decoded on a pool of worker threads, then the decoded pixels are queued and uploaded on the rendering thread by GPU_Flip() or GPU_PumpAsyncLoads(), which call the callback.
+ * \param filename The image file to load
+ * \param callback Receives the new image (or NULL on failure) on the rendering thread
+ * \param userdata Passed to the callback
+ * \return GPU_FALSE if the request could not be queued */
+DECLSPEC GPU_bool SDLCALL GPU_LoadImageAsync(const char* filename, GPU_LoadImageCallback callback, void* userdata);
+
+/*! Uploads images decoded for GPU_LoadImageAsync() and calls their callbacks.  Must be called on the rendering thread.
+ * \param budget_ms Stop once this many milliseconds have been spent.  At least one image is completed if any is ready.  Pass 0 to complete everything that is ready.
+ * \return The number of requests completed */
+DECLSPEC int SDLCALL GPU_PumpAsyncLoads(Uint32 budget_ms);
+
+/*! Sets how much of each frame GPU_Flip() spends completing GPU_LoadImageAsync() requests.  Defaults to 2 ms and 16 MB of decoded pixels, whichever comes first.  A value of 0 removes that limit. */
+DECLSPEC void SDLCALL GPU_SetAsyncLoadBudget(Uint32 budget_ms, Uint32 budget_bytes);
+
+/*! Returns the number of GPU_LoadImageAsync() requests whose callbacks have not been called yet. */
+DECLSPEC int SDLCALL GPU_GetNumPendingAsyncLoads(void);
+
+/*! Sets whether images created from decoded pixels have their color multiplied by alpha, which defaults to GPU_FALSE.
+ * This applies to GPU_LoadImage(), GPU_CopyImageFromSurface() and the loaders built on them.  Block-compressed images are left as they are.
+ * Premultiplied images have has_premultiplied_alpha set and use the GPU_BLEND_PREMULTIPLIED_ALPHA blend mode, and their modulation color is premultiplied when drawn.
+ * Linear filtering then no longer pulls the color of transparent texels into the edges of sprites, so atlases need less padding. */
+DECLSPEC void SDLCALL GPU_SetPremultiplyOnLoad(GPU_bool enable);
+
+/*! \return GPU_TRUE if new images are premultiplied.  \see GPU_SetPremultiplyOnLoad() */
+DECLSPEC GPU_bool SDLCALL GPU_GetPremultiplyOnLoad(void);
+
+/*! Sets whether images created from decoded RGB and RGBA pixels get a full mipmap chain built on the CPU, which defaults to GPU_FALSE.
+ * This applies to GPU_LoadImage() and GPU_LoadImageAsync(), which build the chain on their decoding threads and upload every level at once.
+ * Levels are filtered in linear light with alpha weighting, so they neither darken nor pick up the color of transparent texels.
+ * GPU_GenerateMipmaps() also uses this filter on renderers that have no way to generate mipmaps on the GPU. */
+DECLSPEC void SDLCALL GPU_SetMipmapsOnLoad(GPU_bool enable, GPU_MipmapFilterEnum filter);
+
+/*! \return GPU_TRUE if new images get mipmaps built on the CPU.
+ * \param filter Receives the filter if it is not NULL.
+ * \see GPU_SetMipmapsOnLoad() */
+DECLSPEC GPU_bool SDLCALL GPU_GetMipmapsOnLoad(GPU_MipmapFilterEnum* filter);
+
+/*! Load image from an image file, sharing it with earlier requests for the same file.  Don't forget to GPU_FreeImage() it.
+ * Files are matched by normalized path, so different spellings of one file give the same image with one decode and one texture.  Each call adds to the image's refcount.
+ * The GPU_SetPremultiplyOnLoad() and GPU_SetMipmapsOnLoad() settings are part of the match, so changing them loads a separate image.
+ * Since the image itself is shared, settings like the modulation color are too.  Use GPU_CreateAliasImage() for settings of your own.
+ * The cache keeps every image it loads until GPU_PurgeImageCache() or GPU_PurgeCachedImagesUnusedSince() releases it.
+ * \see GPU_LoadImage() */
+DECLSPEC GPU_Image* SDLCALL GPU_LoadImageCached(const char* filename);
+
+/*! Returns the number of GPU_Flip() calls so far, for use with GPU_GetCachedImagesUnusedSince() and GPU_PurgeCachedImagesUnusedSince(). */
+DECLSPEC Uint32 SDLCALL GPU_GetFrameCount(void);
+
+/*! Finds the cached images that have not been requested or held outside of the cache since the given frame.
+ * \param frame A value from GPU_GetFrameCount()
+ * \param filenames Receives the normalized paths of up to max_filenames images, valid until they are purged.  May be NULL.
+ * \return The number of unused images, which can be more than max_filenames */
+DECLSPEC int SDLCALL GPU_GetCachedImagesUnusedSince(Uint32 frame, const char** filenames, int max_filenames);
+
+/*! Releases the cached images that have not been requested or held outside of the cache since the given frame (see GPU_GetFrameCount()).  Returns the number of images released. */
+DECLSPEC int SDLCALL GPU_PurgeCachedImagesUnusedSince(Uint32 frame);
+
+/*! Releases every cached image that is not held outside of the cache, e.g. at a level transition.  Returns the number of images released. */
+DECLSPEC int SDLCALL GPU_PurgeImageCache(void);
+
 /*! Creates an image that aliases the given image.  Aliases can be used to store image settings (e.g. modulation color) for easy switching.
  * GPU_FreeImage() frees the alias's memory, but does not affect the original. */
 DECLSPEC GPU_Image* SDLCALL GPU_CreateAliasImage(GPU_Image* image);
@@ -1201,6 +1413,35 @@ DECLSPEC void SDLCALL GPU_UpdateImage(GPU_Image* image, const GPU_Rect* image_re
 /*! Update an image from an array of pixel data.  Ignores virtual resolution on the image so the number of pixels needed from the surface is known. */
 DECLSPEC void SDLCALL GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 
+/*! Update a planar YCbCr image (GPU_FORMAT_YCbCr420P or GPU_FORMAT_YCbCr422) from separate Y, Cb (U) and Cr (V) planes.  Each plane is uploaded to its own texture and GPU_Blit() converts to RGB with a built-in shader, so no CPU color conversion is needed.
+ * Ignores virtual resolution on the image.  The region's position is rounded down to the nearest chroma sample (even coordinates where subsampled).
+ * \param image The planar image to update
+ * \param image_rect The region of the image to update.  Pass NULL for the whole image.
+ * \param y_plane Luma samples for the region
+ * \param u_plane Cb samples for the region, subsampled horizontally (and vertically for GPU_FORMAT_YCbCr420P)
+ * \param v_plane Cr samples for the region, subsampled like u_plane
+ * \param pitches Bytes per row of the Y, U and V planes, in that order */
+DECLSPEC void SDLCALL GPU_UpdateImageYUV(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* y_plane, const unsigned char* u_plane, const unsigned char* v_plane, const int* pitches);
+
+/*! Locks a region of an image for writing, giving direct access to pixel memory in the image's format.  Ignores virtual resolution on the image.
+ * On renderers with pixel buffer objects (OpenGL 3+, GLES 3), the memory is a mapped buffer from a small ring and GPU_UnlockImageRegion() starts an asynchronous texture update on the GPU.  Other renderers return a temporary CPU buffer that is uploaded on unlock.
+ * The memory is write-only and its previous contents are undefined.  An image can only have one locked region at a time.
+ * \param image The image to update
+ * \param image_rect The region of the image to lock.  Pass NULL for the whole image.
+ * \param pixels Filled with a pointer to the locked pixel memory
+ * \param pitch Filled with the number of bytes per row of the locked pixel memory
+ * \return GPU_FALSE on failure */
+DECLSPEC GPU_bool SDLCALL GPU_LockImageRegion(GPU_Image* image, const GPU_Rect* image_rect, void** pixels, int* pitch);
+
+/*! Unlocks a region locked with GPU_LockImageRegion() and uploads its pixels to the image. */
+DECLSPEC void SDLCALL GPU_UnlockImageRegion(GPU_Image* image);
+
+/*! Locks the whole image for writing.  Same as GPU_LockImageRegion() with a NULL rect.  Works best with images from GPU_CreateStreamingImage(). */
+DECLSPEC GPU_bool SDLCALL GPU_LockImage(GPU_Image* image, void** pixels, int* pitch);
+
+/*! Unlocks an image locked with GPU_LockImage() and uploads its pixels. */
+DECLSPEC void SDLCALL GPU_UnlockImage(GPU_Image* image);
+
 /*! Update an image from surface data, replacing its underlying texture to allow for size changes.  Ignores virtual resolution on the image so the number of pixels needed from the surface is known. */
 DECLSPEC GPU_bool SDLCALL GPU_ReplaceImage(GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect);
 
@@ -1266,6 +1507,14 @@ DECLSPEC void SDLCALL GPU_SetWrapMode(GPU_Image* image, GPU_WrapEnum wrap_mode_x
 /*! Returns the backend-specific texture handle associated with the given image.  Note that SDL_gpu will be unaware of changes made to the texture.  */
 DECLSPEC GPU_TextureHandle SDLCALL GPU_GetTextureHandle(GPU_Image* image);
 
+/*! Returns the texture, renderbuffer and framebuffer memory allocated by the current renderer.  All zero if there is no renderer. */
+DECLSPEC GPU_MemoryStats SDLCALL GPU_GetMemoryStats(void);
+
+/*! Limits the texture memory of the current renderer to max_bytes.  A value of 0 (the default) removes the limit.
+ * While over budget, GPU_Flip() evicts the images that were least recently drawn into CPU copies and frees their textures.  An evicted image is uploaded again the next time it is used, so eviction is invisible apart from the cost of the readback and upload.
+ * Images that are render targets, locked, streaming, planar, compressed or made with GPU_CreateImageUsingTexture() without ownership are never evicted. */
+DECLSPEC void SDLCALL GPU_SetTextureBudget(Uint64 max_bytes);
+
 // End of ImageControls
 /*! @} */
 
@@ -1283,6 +1532,39 @@ DECLSPEC GPU_Image* SDLCALL GPU_CopyImageFromTarget(GPU_Target* target);
 /*! Copy GPU_Target data into a new SDL_Surface.  Don't forget to SDL_FreeSurface() the surface.*/
 DECLSPEC SDL_Surface* SDLCALL GPU_CopySurfaceFromTarget(GPU_Target* target);
 
+/*! Starts copying a region of GPU_Target data without waiting for the GPU.  Use this instead of GPU_CopySurfaceFromTarget() for screenshots and capture while rendering continues.
+ * On renderers with pixel buffer objects (OpenGL 3+, GLES 3), the pixels are copied into a buffer from a small ring and a later GPU_Flip() calls the callback once a fence shows they have arrived, usually a frame or two later.  Other renderers read the pixels right away and call the callback from the next GPU_Flip().
+ * Pending reads of a target are completed when it is freed.
+ * \param target The target to read
+ * \param rect The region to read in pixels, or NULL for the whole target
+ * \param callback Receives the pixels in a new surface
+ * \param userdata Passed to the callback
+ * \return GPU_FALSE if the read could not be started */
+DECLSPEC GPU_bool SDLCALL GPU_ReadTargetAsync(GPU_Target* target, const GPU_Rect* rect, GPU_ReadTargetCallback callback, void* userdata);
+
+/*! Starts recording every frame that GPU_Flip() presents on the given target.
+ * Frames are read back with GPU_ReadTargetAsync() and encoded and written on a pool of encoder threads, so the rendering thread does not wait on readback or compression.
+ * \param target The target to record
+ * \param format The output format
+ * \param path_pattern For image formats, a printf pattern that receives the frame number, e.g. "capture/frame%05d.png".  It may hold at most one %d conversion (with optional flags and width) besides %% escapes.  For GPU_CAPTURE_Y4M and GPU_CAPTURE_RAW, the name of the stream file.
+ * \return The new capture, or NULL on failure.  Don't forget to GPU_StopCapture() it.
+ * \see GPU_SetCaptureOptions() */
+DECLSPEC GPU_Capture* SDLCALL GPU_StartCapture(GPU_Target* target, GPU_CaptureFormatEnum format, const char* path_pattern);
+
+/*! Stops a capture.  Frames that are already queued are finished before its files are closed.  Up to a few frames that are still being read back finish during the next GPU_Flip() of the target.
+ * Frames that failed to be written are reported as one GPU_ERROR_BACKEND_ERROR. */
+DECLSPEC void SDLCALL GPU_StopCapture(GPU_Capture* capture);
+
+/*! Sets the options for captures started after this call.
+ * \param policy What to do with frames that arrive while the queue is full.  Defaults to GPU_CAPTURE_DROP_FRAMES.
+ * \param max_queued_frames How many frames may wait for readback and encoding.  Defaults to 8.
+ * \param num_threads How many encoder threads each capture uses.  0 (the default) picks one per spare CPU core, up to 8.  Stream formats use the extra threads for color conversion.
+ * \param frame_rate The frame rate written to Y4M headers.  Defaults to 60. */
+DECLSPEC void SDLCALL GPU_SetCaptureOptions(GPU_CapturePolicyEnum policy, int max_queued_frames, int num_threads, int frame_rate);
+
+/*! Returns the number of frames a capture has written and dropped so far through the given pointers, either of which may be NULL. */
+DECLSPEC void SDLCALL GPU_GetCaptureFrameCounts(GPU_Capture* capture, int* num_written, int* num_dropped);
+
 /*! Copy GPU_Image data into a new SDL_Surface.  Don't forget to SDL_FreeSurface() the surface and GPU_FreeImage() the image.*/
 DECLSPEC SDL_Surface* SDLCALL GPU_CopySurfaceFromImage(GPU_Image* image);
 
@@ -1759,7 +2041,7 @@ DECLSPEC void SDLCALL GPU_Polygon(GPU_Target* target, unsigned int num_vertices,
  */
 DECLSPEC void SDLCALL GPU_Polyline(GPU_Target* target, unsigned int num_vertices, float* vertices, SDL_Color color, GPU_bool close_loop);
 	
-/*! Renders a colored filled polygon.  The vertices are expected to define a convex polygon.
+/*! Renders a colored filled polygon.  The vertices are expected to define a convex polygon.  Use GPU_PolygonFilledEx() for concave polygons or polygons with holes.
  * \param target The destination render target
  * \param num_vertices Number of vertices (x and y pairs)
  * \param vertices An array of vertex positions stored as interlaced x and y coords, e.g. {x1, y1, x2, y2, ...}
@@ -1767,6 +2049,61 @@ DECLSPEC void SDLCALL GPU_Polyline(GPU_Target* target, unsigned int num_vertices
  */
 DECLSPEC void SDLCALL GPU_PolygonFilled(GPU_Target* target, unsigned int num_vertices, float* vertices, SDL_Color color);
 
+/*! Renders a colored filled polygon that may be concave and may have holes.  The polygon is triangulated by ear clipping.
+ * Recently drawn polygons are cached by their vertex data, so drawing the same polygon again skips the triangulation.
+ * \param target The destination render target
+ * \param num_contours Number of contours.  The first contour is the outline and any others are holes.
+ * \param contour_sizes An array of num_contours vertex counts, one for each contour
+ * \param vertices An array of vertex positions for all of the contours, one after another, stored as interlaced x and y coords, e.g. {x1, y1, x2, y2, ...}
+ * \param color The color of the shape to render
+ */
+DECLSPEC void SDLCALL GPU_PolygonFilledEx(GPU_Target* target, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, SDL_Color color);
+
+/*! Renders many colored points in one call.  This is much faster than calling GPU_Pixel() for each point.
+ * \param target The destination render target
+ * \param num_points Number of points (x and y pairs)
+ * \param points An array of point positions stored as interlaced x and y coords, e.g. {x1, y1, x2, y2, ...}
+ * \param colors An array of num_points colors, one per point.  Pass NULL to use color for every point.
+ * \param color The color of the points if colors is NULL
+ */
+DECLSPEC void SDLCALL GPU_Points(GPU_Target* target, unsigned int num_points, float* points, SDL_Color* colors, SDL_Color color);
+
+/*! Renders many colored lines with the current line thickness in one call.
+ * \param target The destination render target
+ * \param num_lines Number of lines
+ * \param endpoints An array of line endpoints stored as {x1, y1, x2, y2} for each line
+ * \param colors An array of num_lines colors, one per line.  Pass NULL to use color for every line.
+ * \param color The color of the lines if colors is NULL
+ */
+DECLSPEC void SDLCALL GPU_Lines(GPU_Target* target, unsigned int num_lines, float* endpoints, SDL_Color* colors, SDL_Color color);
+
+/*! Renders many colored filled triangles in one call.
+ * \param target The destination render target
+ * \param num_tris Number of triangles
+ * \param vertices An array of triangle vertices stored as {x1, y1, x2, y2, x3, y3} for each triangle
+ * \param colors An array of num_tris colors, one per triangle.  Pass NULL to use color for every triangle.
+ * \param color The color of the triangles if colors is NULL
+ */
+DECLSPEC void SDLCALL GPU_TrisFilled(GPU_Target* target, unsigned int num_tris, float* vertices, SDL_Color* colors, SDL_Color color);
+
+/*! Renders many colored filled rectangles in one call.
+ * \param target The destination render target
+ * \param num_rects Number of rectangles
+ * \param rects An array of num_rects rectangles
+ * \param colors An array of num_rects colors, one per rectangle.  Pass NULL to use color for every rectangle.
+ * \param color The color of the rectangles if colors is NULL
+ */
+DECLSPEC void SDLCALL GPU_RectanglesFilled(GPU_Target* target, unsigned int num_rects, GPU_Rect* rects, SDL_Color* colors, SDL_Color color);
+
+/*! Renders many colored filled circles in one call.
+ * \param target The destination render target
+ * \param num_circles Number of circles
+ * \param circles An array of circles stored as {x, y, radius} for each circle
+ * \param colors An array of num_circles colors, one per circle.  Pass NULL to use color for every circle.
+ * \param color The color of the circles if colors is NULL
+ */
+DECLSPEC void SDLCALL GPU_CirclesFilled(GPU_Target* target, unsigned int num_circles, float* circles, SDL_Color* colors, SDL_Color color);
+
 // End of Shapes
 /*! @} */
 
@@ -1792,6 +2129,16 @@ DECLSPEC Uint32 SDLCALL GPU_CompileShader_RW(GPU_ShaderEnum shader_type, SDL_RWo
 /*! Compiles shader source and returns the new shader object. */
 DECLSPEC Uint32 SDLCALL GPU_CompileShader(GPU_ShaderEnum shader_type, const char* shader_source);
 
+/*! Compiles shader source with extra preprocessor definitions and returns the new shader object.  This lets one source file serve several shader permutations.
+ * The definitions are inserted after the #version directive, or at the start if there is none.
+ * \param defines Definitions of the form "NAME" or "NAME=VALUE"
+ * \param num_defines The number of entries in 'defines' */
+DECLSPEC Uint32 SDLCALL GPU_CompileShaderWithDefines(GPU_ShaderEnum shader_type, const char* shader_source, const char** defines, int num_defines);
+
+/*! Starts compiling shader source and returns the new shader object without waiting for the compiler.  Errors are reported when a program using the shader is linked.
+ * Issue every compile and then every GPU_LinkShaderProgramAsync() up front, so that drivers with GL_KHR_parallel_shader_compile can work on them all at once. */
+DECLSPEC Uint32 SDLCALL GPU_CompileShaderAsync(GPU_ShaderEnum shader_type, const char* shader_source);
+
 /*! Loads shader source from a file, compiles it, and returns the new shader object. */
 DECLSPEC Uint32 SDLCALL GPU_LoadShader(GPU_ShaderEnum shader_type, const char* filename);
 
@@ -1813,6 +2160,15 @@ DECLSPEC void SDLCALL GPU_DetachShader(Uint32 program_object, Uint32 shader_obje
 /*! Links a shader program with any attached shader objects. */
 DECLSPEC GPU_bool SDLCALL GPU_LinkShaderProgram(Uint32 program_object);
 
+/*! Starts linking a shader program without waiting for the result.  The result is checked when the program is first activated, which waits for the driver if it is not done, or when GPU_GetShaderProgramStatus() reports it.
+ * Unlike GPU_LinkShaderProgram(), a program that fails to link is not deleted, so free it with GPU_FreeShaderProgram().
+ * \return GPU_FALSE if linking could not be started */
+DECLSPEC GPU_bool SDLCALL GPU_LinkShaderProgramAsync(Uint32 program_object);
+
+/*! Polls a shader program linked with GPU_LinkShaderProgramAsync().  With GL_KHR_parallel_shader_compile, this returns GPU_SHADER_STATUS_PENDING while the driver is still working.  Otherwise it waits for the result.
+ * Failures push an error and leave the compiler or linker log in GPU_GetShaderMessage(). */
+DECLSPEC GPU_ShaderStatusEnum SDLCALL GPU_GetShaderProgramStatus(Uint32 program_object);
+
 /*! \return The current shader program */
 DECLSPEC Uint32 SDLCALL GPU_GetCurrentShaderProgram(void);
 
@@ -1828,7 +2184,19 @@ DECLSPEC void SDLCALL GPU_DeactivateShaderProgram(void);
 /*! Returns the last shader log message. */
 DECLSPEC const char* SDLCALL GPU_GetShaderMessage(void);
 
-/*! Returns an integer representing the location of the specified attribute shader variable. */
+/*! Forgets the files read for #include directives in shader sources.  Each file is read once and reused by later shaders until this is called, so call it before recompiling shaders whose includes have changed on disk.  GPU_Quit() also clears them. */
+DECLSPEC void SDLCALL GPU_ClearShaderIncludeCache(void);
+
+/*! Sets a directory where linked shader programs are kept as driver-specific binaries, or NULL (the default) to turn the cache off.  Set it before GPU_Init() to cover the built-in shaders too.
+ * The directory must already exist.  SDL_GetPrefPath() gives a suitable one.
+ * Programs are keyed by the renderer, the GL vendor, renderer and version strings, and the source of every attached shader, so a driver update or an edited shader just misses the cache.
+ * Sources that have compiled before are not compiled again unless their program has no usable binary.  Requires GL 4.1 or GL_ARB_get_program_binary, or GLES 3.0. */
+DECLSPEC void SDLCALL GPU_SetShaderCacheDirectory(const char* directory);
+
+/*! \return The directory set with GPU_SetShaderCacheDirectory(), or NULL. */
+DECLSPEC const char* SDLCALL GPU_GetShaderCacheDirectory(void);
+
+/*! Returns an integer representing the location of the specified attribute shader variable.  Locations are remembered per program, so only the first lookup of a name asks the driver. */
 DECLSPEC int SDLCALL GPU_GetAttributeLocation(Uint32 program_object, const char* attrib_name);
 
 /*! Returns a filled GPU_AttributeFormat object. */
@@ -1837,7 +2205,7 @@ DECLSPEC GPU_AttributeFormat SDLCALL GPU_MakeAttributeFormat(int num_elems_per_v
 /*! Returns a filled GPU_Attribute object. */
 DECLSPEC GPU_Attribute SDLCALL GPU_MakeAttribute(int location, void* values, GPU_AttributeFormat format);
 
-/*! Returns an integer representing the location of the specified uniform shader variable. */
+/*! Returns an integer representing the location of the specified uniform shader variable.  Locations are remembered per program until it is relinked, so this is cheap enough to call per draw. */
 DECLSPEC int SDLCALL GPU_GetUniformLocation(Uint32 program_object, const char* uniform_name);
 
 /*! Loads the given shader program's built-in attribute and uniform locations. */
@@ -1849,6 +2217,31 @@ DECLSPEC void SDLCALL GPU_SetShaderBlock(GPU_ShaderBlock block);
 /*! Gets the shader block for the current shader. */
 DECLSPEC GPU_ShaderBlock SDLCALL GPU_GetShaderBlock(void);
 
+/*! Creates a set of shader variants from one vertex and one fragment shader source.  Nothing is compiled here.  Each variant is compiled and linked the first time it is requested, with a "#define KEYWORD" for each keyword in its mask, and is then kept along with its GPU_ShaderBlock.
+ * The sources are copied and should start with their #version directive.  The set belongs to the current renderer.
+ * \param keywords Feature keywords, such as "LIGHTING" or "ALPHA_TEST".  Keyword i is bit (1 << i) of a keyword mask.
+ * \param num_keywords The number of keywords, up to GPU_SHADER_MAX_VARIANT_KEYWORDS
+ * \param position_name, texcoord_name, color_name, modelViewMatrix_name Names used to load each variant's GPU_ShaderBlock, as in GPU_LoadShaderBlock()
+ * \return The new set, or NULL on error */
+DECLSPEC GPU_ShaderVariantSet* SDLCALL GPU_CreateShaderVariantSet(const char* vertex_source, const char* fragment_source, const char** keywords, int num_keywords, const char* position_name, const char* texcoord_name, const char* color_name, const char* modelViewMatrix_name);
+
+/*! Frees a shader variant set and every shader program built from it. */
+DECLSPEC void SDLCALL GPU_FreeShaderVariantSet(GPU_ShaderVariantSet* set);
+
+/*! \return The keyword mask bit for the given keyword, or 0 if the set does not declare it. */
+DECLSPEC Uint32 SDLCALL GPU_GetShaderVariantKeyword(GPU_ShaderVariantSet* set, const char* keyword);
+
+/*! Returns the shader program for the given keyword mask, compiling and linking it if this is its first use.  A variant that fails to build returns 0 from then on without being compiled again.
+ * \param block If not NULL, receives the variant's GPU_ShaderBlock */
+DECLSPEC Uint32 SDLCALL GPU_GetShaderVariant(GPU_ShaderVariantSet* set, Uint32 keywords, GPU_ShaderBlock* block);
+
+/*! Activates the shader program and block for the given keyword mask, building the variant first if needed.
+ * \return GPU_FALSE if the variant failed to build */
+DECLSPEC GPU_bool SDLCALL GPU_ActivateShaderVariant(GPU_ShaderVariantSet* set, Uint32 keywords);
+
+/*! \return The number of variants requested from the set so far, including any that failed to build. */
+DECLSPEC int SDLCALL GPU_GetNumShaderVariants(GPU_ShaderVariantSet* set);
+
 /*! Sets the given image unit to the given image so that a custom shader can sample multiple textures.
     \param image The source image/texture.  Pass NULL to disable the image unit.
     \param location The uniform location of a texture sampler
@@ -1912,6 +2305,26 @@ DECLSPEC void SDLCALL GPU_SetAttributeuiv(int location, int num_elements, unsign
 /*! Enables a shader attribute and sets its source data. */
 DECLSPEC void SDLCALL GPU_SetAttributeSource(int num_values, GPU_Attribute source);
 
+/*! Creates a uniform buffer object, which holds the values of a uniform block that any number of shader programs can read.  Data shared by many programs, such as the time, camera or lights, can then be written once per frame instead of once per program.
+ * Requires GPU_FEATURE_UNIFORM_BUFFERS (GL 3.1 or GL_ARB_uniform_buffer_object, or GLES 3.0).
+ * \param size_bytes The size of the buffer, laid out as the uniform block declares (std140 is the portable choice)
+ * \param data The initial contents, or NULL to leave them undefined
+ * \return The buffer handle, or 0 if uniform buffers are not supported */
+DECLSPEC Uint32 SDLCALL GPU_CreateUniformBuffer(Uint32 size_bytes, const void* data);
+
+/*! Writes part of a uniform buffer.  Draws already batched with the old contents are flushed first. */
+DECLSPEC void SDLCALL GPU_UpdateUniformBuffer(Uint32 buffer, Uint32 offset_bytes, Uint32 size_bytes, const void* data);
+
+/*! Attaches a uniform buffer to a binding point.  Uniform blocks assigned to that binding point with GPU_SetUniformBlockBinding() read from it.  Pass 0 for 'buffer' to detach the binding point. */
+DECLSPEC void SDLCALL GPU_BindUniformBuffer(Uint32 buffer, Uint32 binding_point);
+
+/*! Assigns the named uniform block of a shader program to a binding point.  Do this again after relinking the program.
+ * \return GPU_FALSE if the program has no such uniform block */
+DECLSPEC GPU_bool SDLCALL GPU_SetUniformBlockBinding(Uint32 program_object, const char* block_name, Uint32 binding_point);
+
+/*! Deletes a uniform buffer. */
+DECLSPEC void SDLCALL GPU_FreeUniformBuffer(Uint32 buffer);
+
 // End of ShaderInterface
 /*! @} */
 
@@ -207,6 +207,25 @@ void main(void)\n\
     gl_FragColor = texture2D(tex, texCoord) * color;\n\
 }"
 
+// Converts planar YCbCr (BT.601, video range) sampled from three single-channel textures
+#define GPU_DEFAULT_YUV_FRAGMENT_SHADER_SOURCE \
+"#version 110\n\
+\
+varying vec4 color;\n\
+varying vec2 texCoord;\n\
+\
+uniform sampler2D tex;\n\
+uniform sampler2D tex_u;\n\
+uniform sampler2D tex_v;\n\
+\
+void main(void)\n\
+{\n\
+    float y = 1.1643 * (texture2D(tex, texCoord).r - 0.0625);\n\
+    float u = texture2D(tex_u, texCoord).r - 0.5;\n\
+    float v = texture2D(tex_v, texCoord).r - 0.5;\n\
+    gl_FragColor = vec4(y + 1.5958*v, y - 0.39173*u - 0.81290*v, y + 2.017*u, 1.0) * color;\n\
+}"
+
 #define GPU_DEFAULT_UNTEXTURED_FRAGMENT_SHADER_SOURCE \
 "#version 110\n\
 \
@@ -251,7 +270,15 @@ typedef struct ContextData_OpenGL_1
     GPU_bool blit_VBO_flop;
     
 	GPU_AttributeSource shader_attributes[16];
-	unsigned int attribute_VBO[16];
+	unsigned int attribute_VBO;  // Streams all of the custom attributes, interleaved
+	char* attribute_buffer;  // Staging for one flush worth of interleaved custom attributes
+	int attribute_buffer_size;
+	int attribute_stride_bytes;  // Vertex stride of the custom attribute layout that is currently specified
+	Uint32 attribute_layout[16];  // Format currently specified for each location, 0 if the array is not enabled
+	
+	// Built-in planar YCbCr conversion shader, compiled on first use
+	Uint32 yuv_shader_program;
+	GPU_ShaderBlock yuv_shader_block;
 } ContextData_OpenGL_1;
 
 typedef struct ImageData_OpenGL_1
@@ -260,6 +287,26 @@ typedef struct ImageData_OpenGL_1
     GPU_bool owns_handle;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 plane_handles[2];  // Cb and Cr textures for planar YCbCr formats, Y is in handle
+	
+	// Region locked by GPU_LockImageRegion()
+	GPU_bool locked;
+	GPU_Rect locked_rect;
+	int locked_pitch;
+	int locked_PBO;  // Index into the context's upload PBO ring, or -1 when locked_pixels is a CPU buffer
+	void* locked_pixels;
+	
+	// Backing store for images from GPU_CreateStreamingImage()
+	GPU_bool streaming;
+	void* stream_pixels;  // Reused CPU buffer when no stream PBO can be mapped
+	
+	// Memory accounting and GPU_SetTextureBudget() eviction
+	Uint32 texture_bytes;
+	Uint32 last_use_frame;
+	GPU_Image* lru_image;  // An image sharing this data, used to read it back and reupload it
+	struct ImageData_OpenGL_1* lru_prev;
+	struct ImageData_OpenGL_1* lru_next;
+	unsigned char* evicted_pixels;  // CPU copy while the texture is evicted
 } ImageData_OpenGL_1;
 
 typedef struct TargetData_OpenGL_1
@@ -267,6 +314,8 @@ typedef struct TargetData_OpenGL_1
     int refcount;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 depth_buffer;  // Renderbuffer from GPU_AddDepthBuffer()
+	Uint32 depth_buffer_bytes;
 } TargetData_OpenGL_1;
 
 
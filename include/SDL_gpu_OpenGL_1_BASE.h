@@ -67,6 +67,26 @@ typedef struct ImageData_OpenGL_1_BASE
     GPU_bool owns_handle;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 plane_handles[2];  // Cb and Cr textures for planar YCbCr formats, Y is in handle
+	
+	// Region locked by GPU_LockImageRegion()
+	GPU_bool locked;
+	GPU_Rect locked_rect;
+	int locked_pitch;
+	int locked_PBO;  // Index into the context's upload PBO ring, or -1 when locked_pixels is a CPU buffer
+	void* locked_pixels;
+	
+	// Backing store for images from GPU_CreateStreamingImage()
+	GPU_bool streaming;
+	void* stream_pixels;  // Reused CPU buffer when no stream PBO can be mapped
+	
+	// Memory accounting and GPU_SetTextureBudget() eviction
+	Uint32 texture_bytes;
+	Uint32 last_use_frame;
+	GPU_Image* lru_image;  // An image sharing this data, used to read it back and reupload it
+	struct ImageData_OpenGL_1_BASE* lru_prev;
+	struct ImageData_OpenGL_1_BASE* lru_next;
+	unsigned char* evicted_pixels;  // CPU copy while the texture is evicted
 } ImageData_OpenGL_1_BASE;
 
 typedef struct TargetData_OpenGL_1_BASE
@@ -74,6 +94,8 @@ typedef struct TargetData_OpenGL_1_BASE
     int refcount;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 depth_buffer;  // Renderbuffer from GPU_AddDepthBuffer()
+	Uint32 depth_buffer_bytes;
 } TargetData_OpenGL_1_BASE;
 
 
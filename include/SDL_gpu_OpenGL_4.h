@@ -29,6 +29,14 @@
 #define GPU_IMAGE_DATA ImageData_OpenGL_4
 #define GPU_TARGET_DATA TargetData_OpenGL_4
 
+#ifndef GPU_UPLOAD_PBO_RING_SIZE
+#define GPU_UPLOAD_PBO_RING_SIZE 3
+#endif
+
+#ifndef GPU_DOWNLOAD_PBO_RING_SIZE
+#define GPU_DOWNLOAD_PBO_RING_SIZE 3
+#endif
+
 
 
 #define GPU_DEFAULT_TEXTURED_VERTEX_SHADER_SOURCE \
@@ -80,6 +88,27 @@ void main(void)\n\
     fragColor = texture(tex, texCoord) * color;\n\
 }"
 
+// Converts planar YCbCr (BT.601, video range) sampled from three single-channel textures
+#define GPU_DEFAULT_YUV_FRAGMENT_SHADER_SOURCE \
+"#version 400\n\
+\
+in vec4 color;\n\
+in vec2 texCoord;\n\
+\
+uniform sampler2D tex;\n\
+uniform sampler2D tex_u;\n\
+uniform sampler2D tex_v;\n\
+\
+out vec4 fragColor;\n\
+\
+void main(void)\n\
+{\n\
+    float y = 1.1643 * (texture(tex, texCoord).r - 0.0625);\n\
+    float u = texture(tex_u, texCoord).r - 0.5;\n\
+    float v = texture(tex_v, texCoord).r - 0.5;\n\
+    fragColor = vec4(y + 1.5958*v, y - 0.39173*u - 0.81290*v, y + 2.017*u, 1.0) * color;\n\
+}"
+
 #define GPU_DEFAULT_UNTEXTURED_FRAGMENT_SHADER_SOURCE \
 "#version 400\n\
 \
@@ -124,7 +153,28 @@ typedef struct ContextData_OpenGL_4
     GPU_bool blit_VBO_flop;
     
 	GPU_AttributeSource shader_attributes[16];
-	unsigned int attribute_VBO[16];
+	unsigned int attribute_VBO;  // Streams all of the custom attributes, interleaved
+	char* attribute_buffer;  // Staging for one flush worth of interleaved custom attributes
+	int attribute_buffer_size;
+	int attribute_stride_bytes;  // Vertex stride of the custom attribute layout that is currently specified
+	Uint32 attribute_layout[16];  // Format currently specified for each location, 0 if the array is not enabled
+	
+	// Built-in planar YCbCr conversion shader, compiled on first use
+	Uint32 yuv_shader_program;
+	GPU_ShaderBlock yuv_shader_block;
+	
+	// Pixel unpack buffers for GPU_LockImageRegion(), reused round-robin
+	unsigned int upload_PBO[GPU_UPLOAD_PBO_RING_SIZE];
+	unsigned int upload_PBO_size[GPU_UPLOAD_PBO_RING_SIZE];
+	void* upload_PBO_fence[GPU_UPLOAD_PBO_RING_SIZE];  // GLsync, NULL when the buffer is free
+	unsigned int upload_PBO_next;
+	unsigned int upload_PBO_mapped;  // Bit for each buffer that is mapped by a locked image
+	
+	// Pixel pack buffers for GPU_ReadTargetAsync(), reused round-robin
+	unsigned int download_PBO[GPU_DOWNLOAD_PBO_RING_SIZE];
+	unsigned int download_PBO_size[GPU_DOWNLOAD_PBO_RING_SIZE];
+	void* download_PBO_fence[GPU_DOWNLOAD_PBO_RING_SIZE];  // GLsync, NULL when the buffer is free
+	unsigned int download_PBO_next;
 } ContextData_OpenGL_4;
 
 typedef struct ImageData_OpenGL_4
@@ -133,6 +183,29 @@ typedef struct ImageData_OpenGL_4
     GPU_bool owns_handle;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 plane_handles[2];  // Cb and Cr textures for planar YCbCr formats, Y is in handle
+	
+	// Region locked by GPU_LockImageRegion()
+	GPU_bool locked;
+	GPU_Rect locked_rect;
+	int locked_pitch;
+	int locked_PBO;  // Index into the context's upload PBO ring, or -1 when locked_pixels is a CPU buffer
+	void* locked_pixels;
+	
+	// Backing store for images from GPU_CreateStreamingImage()
+	GPU_bool streaming;
+	void* stream_pixels;  // Reused CPU buffer when no stream PBO can be mapped
+	unsigned int stream_PBO[GPU_UPLOAD_PBO_RING_SIZE];
+	void* stream_PBO_fence[GPU_UPLOAD_PBO_RING_SIZE];  // GLsync, NULL when the buffer is free
+	unsigned int stream_PBO_next;
+	
+	// Memory accounting and GPU_SetTextureBudget() eviction
+	Uint32 texture_bytes;
+	Uint32 last_use_frame;
+	GPU_Image* lru_image;  // An image sharing this data, used to read it back and reupload it
+	struct ImageData_OpenGL_4* lru_prev;
+	struct ImageData_OpenGL_4* lru_next;
+	unsigned char* evicted_pixels;  // CPU copy while the texture is evicted
 } ImageData_OpenGL_4;
 
 typedef struct TargetData_OpenGL_4
@@ -140,6 +213,8 @@ typedef struct TargetData_OpenGL_4
     int refcount;
 	Uint32 handle;
 	Uint32 format;
+	Uint32 depth_buffer;  // Renderbuffer from GPU_AddDepthBuffer()
+	Uint32 depth_buffer_bytes;
 } TargetData_OpenGL_4;
 
 
@@ -64,6 +64,15 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_CreateImageUsingTexture() */
 	GPU_Image* (SDLCALL *CreateImageUsingTexture)(GPU_Renderer* renderer, GPU_TextureHandle handle, GPU_bool take_ownership);
 	
+    /*! \see GPU_CreateStreamingImage() */
+	GPU_Image* (SDLCALL *CreateStreamingImage)(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format);
+	
+    /*! Creates an image from prebuilt block-compressed mipmap levels, largest first.  Used by GPU_LoadImage() for KTX, KTX2 and DDS files. */
+	GPU_Image* (SDLCALL *CreateCompressedImage)(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char** level_data, const unsigned int* level_sizes);
+	
+    /*! Uploads mipmap levels 1 and up of an RGB or RGBA image, packed one after another with tightly packed rows.  Returns GPU_FALSE if the texture can't take them as they are.  Used by GPU_LoadImage() for GPU_SetMipmapsOnLoad(). */
+	GPU_bool (SDLCALL *UploadMipmaps)(GPU_Renderer* renderer, GPU_Image* image, int num_levels, const unsigned char* levels);
+	
     /*! \see GPU_CreateAliasImage() */
 	GPU_Image* (SDLCALL *CreateAliasImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
@@ -79,6 +88,15 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_UpdateImageBytes */
 	void (SDLCALL *UpdateImageBytes)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* bytes, int bytes_per_row);
 	
+	/*! \see GPU_UpdateImageYUV */
+	void (SDLCALL *UpdateImageYUV)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* y_plane, const unsigned char* u_plane, const unsigned char* v_plane, const int* pitches);
+	
+	/*! \see GPU_LockImageRegion */
+	GPU_bool (SDLCALL *LockImageRegion)(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, void** pixels, int* pitch);
+	
+	/*! \see GPU_UnlockImageRegion */
+	void (SDLCALL *UnlockImageRegion)(GPU_Renderer* renderer, GPU_Image* image);
+	
 	/*! \see GPU_ReplaceImage */
 	GPU_bool (SDLCALL *ReplaceImage)(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect);
 	
@@ -91,6 +109,9 @@ typedef struct GPU_RendererImpl
 	/*! \see GPU_CopySurfaceFromTarget() */
 	SDL_Surface* (SDLCALL *CopySurfaceFromTarget)(GPU_Renderer* renderer, GPU_Target* target);
 	
+	/*! \see GPU_ReadTargetAsync() */
+	GPU_bool (SDLCALL *ReadTargetAsync)(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect, GPU_ReadTargetCallback callback, void* userdata);
+	
 	/*! \see GPU_CopySurfaceFromImage() */
 	SDL_Surface* (SDLCALL *CopySurfaceFromImage)(GPU_Renderer* renderer, GPU_Image* image);
 	
@@ -142,6 +163,12 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_GetTextureHandle() */
     GPU_TextureHandle (SDLCALL *GetTextureHandle)(GPU_Renderer* renderer, GPU_Image* image);
     
+	/*! \see GPU_GetMemoryStats() */
+	GPU_MemoryStats (SDLCALL *GetMemoryStats)(GPU_Renderer* renderer);
+	
+	/*! \see GPU_SetTextureBudget() */
+	void (SDLCALL *SetTextureBudget)(GPU_Renderer* renderer, Uint64 max_bytes);
+	
 	/*! \see GPU_ClearRGBA() */
 	void (SDLCALL *ClearRGBA)(GPU_Renderer* renderer, GPU_Target* target, Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	/*! \see GPU_FlushBlitBuffer() */
@@ -162,6 +189,12 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_CompileShader() */
 	Uint32 (SDLCALL *CompileShader)(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source);
 
+    /*! \see GPU_CompileShaderWithDefines() */
+	Uint32 (SDLCALL *CompileShaderWithDefines)(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source, const char** defines, int num_defines);
+
+    /*! \see GPU_CompileShaderAsync() */
+	Uint32 (SDLCALL *CompileShaderAsync)(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source);
+
     /*! \see GPU_FreeShader() */
 	void (SDLCALL *FreeShader)(GPU_Renderer* renderer, Uint32 shader_object);
 
@@ -174,6 +207,12 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_LinkShaderProgram() */
 	GPU_bool (SDLCALL *LinkShaderProgram)(GPU_Renderer* renderer, Uint32 program_object);
 
+    /*! \see GPU_LinkShaderProgramAsync() */
+	GPU_bool (SDLCALL *LinkShaderProgramAsync)(GPU_Renderer* renderer, Uint32 program_object);
+
+    /*! \see GPU_GetShaderProgramStatus() */
+	GPU_ShaderStatusEnum (SDLCALL *GetShaderProgramStatus)(GPU_Renderer* renderer, Uint32 program_object);
+
     /*! \see GPU_ActivateShaderProgram() */
 	void (SDLCALL *ActivateShaderProgram)(GPU_Renderer* renderer, Uint32 program_object, GPU_ShaderBlock* block);
 
@@ -249,6 +288,21 @@ typedef struct GPU_RendererImpl
     /*! \see GPU_SetAttributeSource() */
 	void (SDLCALL *SetAttributeSource)(GPU_Renderer* renderer, int num_values, GPU_Attribute source);
     
+    /*! \see GPU_CreateUniformBuffer() */
+	Uint32 (SDLCALL *CreateUniformBuffer)(GPU_Renderer* renderer, Uint32 size_bytes, const void* data);
+    
+    /*! \see GPU_UpdateUniformBuffer() */
+	void (SDLCALL *UpdateUniformBuffer)(GPU_Renderer* renderer, Uint32 buffer, Uint32 offset_bytes, Uint32 size_bytes, const void* data);
+    
+    /*! \see GPU_BindUniformBuffer() */
+	void (SDLCALL *BindUniformBuffer)(GPU_Renderer* renderer, Uint32 buffer, Uint32 binding_point);
+    
+    /*! \see GPU_SetUniformBlockBinding() */
+	GPU_bool (SDLCALL *SetUniformBlockBinding)(GPU_Renderer* renderer, Uint32 program_object, const char* block_name, Uint32 binding_point);
+    
+    /*! \see GPU_FreeUniformBuffer() */
+	void (SDLCALL *FreeUniformBuffer)(GPU_Renderer* renderer, Uint32 buffer);
+    
     
     // Shapes
     
@@ -314,6 +368,24 @@ typedef struct GPU_RendererImpl
 	
     /*! \see GPU_PolygonFilled() */
 	void (SDLCALL *PolygonFilled)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_vertices, float* vertices, SDL_Color color);
+
+    /*! \see GPU_PolygonFilledEx() */
+	void (SDLCALL *PolygonFilledEx)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, SDL_Color color);
+
+    /*! \see GPU_Points() */
+	void (SDLCALL *Points)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, float* points, SDL_Color* colors, SDL_Color color);
+
+    /*! \see GPU_Lines() */
+	void (SDLCALL *Lines)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_lines, float* endpoints, SDL_Color* colors, SDL_Color color);
+
+    /*! \see GPU_TrisFilled() */
+	void (SDLCALL *TrisFilled)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_tris, float* vertices, SDL_Color* colors, SDL_Color color);
+
+    /*! \see GPU_RectanglesFilled() */
+	void (SDLCALL *RectanglesFilled)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_rects, GPU_Rect* rects, SDL_Color* colors, SDL_Color color);
+
+    /*! \see GPU_CirclesFilled() */
+	void (SDLCALL *CirclesFilled)(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_circles, float* circles, SDL_Color* colors, SDL_Color color);
 	
 } GPU_RendererImpl;
 
@@ -5,6 +5,7 @@
 #include "stb_image_write.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 #ifdef __ANDROID__
 #include <android/log.h>
@@ -30,6 +31,13 @@
 #define CHECK_CONTEXT (_gpu_current_renderer->current_context_target != NULL)
 #define RETURN_ERROR(code, details) do{ GPU_PushErrorCode(__func__, code, "%s", details); return; } while(0)
 
+// Building with SDL_GPU_DISABLE_ARGUMENT_CHECKS drops the validation from the per-draw calls (blits and primitive batches)
+#ifdef SDL_GPU_DISABLE_ARGUMENT_CHECKS
+#define CHECK_ARGUMENT(condition, code, details) do{} while(0)
+#else
+#define CHECK_ARGUMENT(condition, code, details) do{ if(!(condition)) RETURN_ERROR(code, details); } while(0)
+#endif
+
 int gpu_strcasecmp(const char* s1, const char* s2);
 
 void gpu_init_renderer_register(void);
@@ -38,6 +46,51 @@ GPU_Renderer* gpu_create_and_add_renderer(GPU_RendererID id);
 
 int gpu_default_print(GPU_LogLevelEnum log_level, const char* format, va_list args);
 
+void gpu_free_polygon_cache(void);
+
+GPU_bool gpu_is_compressed_container(const unsigned char* data, int data_bytes);
+unsigned char* gpu_load_compressed_pixels(const unsigned char* data, int data_bytes, int* width, int* height);
+GPU_Image* gpu_load_compressed_image(GPU_Renderer* renderer, const unsigned char* data, int data_bytes);
+
+typedef struct GPU_WriteBuffer GPU_WriteBuffer;
+GPU_WriteBuffer* gpu_open_write_buffer(SDL_RWops* rwops);
+void gpu_write_buffered(void* context, void* data, int size);
+GPU_bool gpu_close_write_buffer(GPU_WriteBuffer* buffer);
+GPU_bool gpu_write_png(SDL_RWops* rwops, int w, int h, int comp, const unsigned char* pixels, int pitch, const GPU_SaveOptions* options);
+
+void gpu_premultiply_alpha(unsigned char* pixels, int pitch, int w, int h);
+unsigned char* gpu_build_mipmaps(const unsigned char* pixels, int w, int h, int channels, GPU_bool premultiplied, GPU_MipmapFilterEnum filter, int num_threads, int* num_levels);
+
+void gpu_capture_frame(GPU_Target* target);
+void gpu_free_captures(void);
+
+void gpu_clear_shader_include_cache(void);
+
+static void gpu_free_async_loader(void);
+static void gpu_free_image_cache(GPU_Renderer* renderer);
+static void gpu_update_image_cache(void);
+
+/*! Feeds an SDL_RWops to stb_image in small reads, so an encoded file is never held in memory as a whole.
+ * The first bytes are read ahead to recognize compressed texture containers, then replayed to the decoder. */
+typedef struct GPU_RWopsStream
+{
+    SDL_RWops* rwops;
+    unsigned char peek[12];
+    int peek_size;
+    int peek_pos;
+    GPU_bool eof;
+} GPU_RWopsStream;
+
+// Initial buffer for reading a stream whose size is unknown
+#define GPU_STREAM_READ_CHUNK_SIZE 65536
+
+static void gpu_open_stream(GPU_RWopsStream* stream, SDL_RWops* rwops);
+static const stbi_io_callbacks gpu_stream_callbacks;
+static unsigned char* gpu_read_stream(GPU_RWopsStream* stream, int* data_bytes);
+static SDL_Surface* gpu_copy_raw_surface_data(unsigned char* data, int width, int height, int channels);
+static unsigned char* gpu_prepare_decoded_pixels(unsigned char* pixels, int width, int height, int channels, GPU_bool premultiply, GPU_bool build_mipmaps, GPU_MipmapFilterEnum filter, int num_threads, int* num_levels);
+static GPU_Image* gpu_create_image_from_pixels(unsigned char* pixels, int width, int height, int channels, GPU_bool premultiplied, GPU_bool mipmapped, const unsigned char* mipmaps, int num_levels);
+
 /*! A mapping of windowID to a GPU_Target to facilitate GPU_GetWindowTarget(). */
 typedef struct GPU_WindowMapping
 {
@@ -52,10 +105,64 @@ static GPU_DebugLevelEnum _gpu_debug_level = GPU_DEBUG_LEVEL_0;
 #define GPU_DEFAULT_MAX_NUM_ERRORS 20
 #define GPU_ERROR_FUNCTION_STRING_MAX 128
 #define GPU_ERROR_DETAILS_STRING_MAX 512
-static GPU_ErrorObject* _gpu_error_code_queue = NULL;
-static unsigned int _gpu_num_error_codes = 0;
+#define GPU_ERROR_MAX_ARGUMENTS 8
+#define GPU_ERROR_SPEC_STRING_MAX 32
+
+typedef enum {
+    GPU_ERROR_ARG_INT,
+    GPU_ERROR_ARG_UINT,
+    GPU_ERROR_ARG_LONG,
+    GPU_ERROR_ARG_ULONG,
+    GPU_ERROR_ARG_LLONG,
+    GPU_ERROR_ARG_ULLONG,
+    GPU_ERROR_ARG_SIZE,
+    GPU_ERROR_ARG_DOUBLE,
+    GPU_ERROR_ARG_STRING,
+    GPU_ERROR_ARG_POINTER
+} GPU_ErrorArgumentEnum;
+
+typedef struct GPU_ErrorArgument
+{
+    GPU_ErrorArgumentEnum type;
+    union
+    {
+        long long i;
+        unsigned long long u;
+        double d;
+        const void* p;
+    } value;  // Strings are stored as an offset into the error's string storage
+} GPU_ErrorArgument;
+
+// An error as it was pushed.  The details are only formatted when the error is popped.
+typedef struct GPU_QueuedError
+{
+    GPU_ErrorEnum error;
+    int function;  // Offsets into 'strings', -1 for NULL
+    int details;
+    GPU_bool formatted;  // The details are already a complete string
+    int num_arguments;
+    GPU_ErrorArgument arguments[GPU_ERROR_MAX_ARGUMENTS];
+    char strings[GPU_ERROR_FUNCTION_STRING_MAX + GPU_ERROR_DETAILS_STRING_MAX + 2];
+} GPU_QueuedError;
+
+// Each thread has its own ring of errors
+typedef struct GPU_ErrorQueue
+{
+    GPU_QueuedError* errors;
+    unsigned int size;
+    unsigned int head;
+    unsigned int count;
+    char function[GPU_ERROR_FUNCTION_STRING_MAX+1];  // Storage for the last popped error
+    char details[GPU_ERROR_DETAILS_STRING_MAX+1];
+} GPU_ErrorQueue;
+
 static unsigned int _gpu_error_code_queue_size = GPU_DEFAULT_MAX_NUM_ERRORS;
-static GPU_ErrorObject _gpu_error_code_result;
+#ifdef SDL_GPU_USE_SDL2
+static SDL_TLSID _gpu_error_queue_tls = 0;
+static SDL_SpinLock _gpu_error_queue_tls_lock = 0;
+#else
+static GPU_ErrorQueue* _gpu_error_queue = NULL;
+#endif
 
 #define GPU_INITIAL_WINDOW_MAPPINGS_SIZE 10
 static GPU_WindowMapping* _gpu_window_mappings = NULL;
@@ -237,25 +344,70 @@ GPU_FeatureEnum GPU_GetRequiredFeatures(void)
     return _gpu_required_features;
 }
 
-static void gpu_init_error_queue(void)
+static void SDLCALL gpu_destroy_error_queue(void* data)
+{
+    GPU_ErrorQueue* queue = (GPU_ErrorQueue*)data;
+    if(queue == NULL)
+        return;
+
+    SDL_free(queue->errors);
+    SDL_free(queue);
+}
+
+static void gpu_set_error_queue(GPU_ErrorQueue* queue)
 {
-    if(_gpu_error_code_queue == NULL)
+    #ifdef SDL_GPU_USE_SDL2
+    SDL_TLSSet(_gpu_error_queue_tls, queue, &gpu_destroy_error_queue);
+    #else
+    _gpu_error_queue = queue;
+    #endif
+}
+
+// Returns the calling thread's error queue, creating it if needed.
+static GPU_ErrorQueue* gpu_get_error_queue(GPU_bool create)
+{
+    GPU_ErrorQueue* queue;
+
+    #ifdef SDL_GPU_USE_SDL2
+    if(_gpu_error_queue_tls == 0)
     {
-        unsigned int i;
-        _gpu_error_code_queue = (GPU_ErrorObject*)SDL_malloc(sizeof(GPU_ErrorObject)*_gpu_error_code_queue_size);
+        if(!create)
+            return NULL;
 
-        for(i = 0; i < _gpu_error_code_queue_size; i++)
-        {
-            _gpu_error_code_queue[i].function = (char*)SDL_malloc(GPU_ERROR_FUNCTION_STRING_MAX+1);
-            _gpu_error_code_queue[i].error = GPU_ERROR_NONE;
-            _gpu_error_code_queue[i].details = (char*)SDL_malloc(GPU_ERROR_DETAILS_STRING_MAX+1);
-        }
-        _gpu_num_error_codes = 0;
+        SDL_AtomicLock(&_gpu_error_queue_tls_lock);
+        if(_gpu_error_queue_tls == 0)
+            _gpu_error_queue_tls = SDL_TLSCreate();
+        SDL_AtomicUnlock(&_gpu_error_queue_tls_lock);
+    }
+    queue = (GPU_ErrorQueue*)SDL_TLSGet(_gpu_error_queue_tls);
+    #else
+    queue = _gpu_error_queue;
+    #endif
 
-        _gpu_error_code_result.function = (char*)SDL_malloc(GPU_ERROR_FUNCTION_STRING_MAX+1);
-        _gpu_error_code_result.error = GPU_ERROR_NONE;
-        _gpu_error_code_result.details = (char*)SDL_malloc(GPU_ERROR_DETAILS_STRING_MAX+1);
+    if(queue == NULL && create)
+    {
+        queue = (GPU_ErrorQueue*)SDL_malloc(sizeof(GPU_ErrorQueue));
+        if(queue == NULL)
+            return NULL;
+
+        queue->size = _gpu_error_code_queue_size;
+        queue->errors = (queue->size > 0? (GPU_QueuedError*)SDL_malloc(sizeof(GPU_QueuedError)*queue->size) : NULL);
+        if(queue->errors == NULL)
+            queue->size = 0;
+        queue->head = 0;
+        queue->count = 0;
+        queue->function[0] = '\0';
+        queue->details[0] = '\0';
+
+        gpu_set_error_queue(queue);
     }
+
+    return queue;
+}
+
+static void gpu_init_error_queue(void)
+{
+    gpu_get_error_queue(GPU_TRUE);
 }
 
 static void gpu_init_window_mappings(void)
@@ -627,28 +779,18 @@ void GPU_UnsetImageVirtualResolution(GPU_Image* image)
     image->using_virtual_resolution = 0;
 }
 
+// Frees the calling thread's error queue.  Other threads free theirs when they exit.
 void gpu_free_error_queue(void)
 {
-    unsigned int i;
-    // Free the error queue
-    for(i = 0; i < _gpu_error_code_queue_size; i++)
-    {
-        SDL_free(_gpu_error_code_queue[i].function);
-        _gpu_error_code_queue[i].function = NULL;
-        SDL_free(_gpu_error_code_queue[i].details);
-        _gpu_error_code_queue[i].details = NULL;
-    }
-    SDL_free(_gpu_error_code_queue);
-    _gpu_error_code_queue = NULL;
-    _gpu_num_error_codes = 0;
+    GPU_ErrorQueue* queue = gpu_get_error_queue(GPU_FALSE);
+    if(queue == NULL)
+        return;
 
-    SDL_free(_gpu_error_code_result.function);
-    _gpu_error_code_result.function = NULL;
-    SDL_free(_gpu_error_code_result.details);
-    _gpu_error_code_result.details = NULL;
+    gpu_set_error_queue(NULL);
+    gpu_destroy_error_queue(queue);
 }
 
-// Deletes all existing errors
+// Deletes all existing errors of the calling thread
 void GPU_SetErrorQueueMax(unsigned int max)
 {
     gpu_free_error_queue();
@@ -663,16 +805,23 @@ void GPU_CloseCurrentRenderer(void)
     if(_gpu_current_renderer == NULL)
         return;
 
+    gpu_free_image_cache(_gpu_current_renderer);
     _gpu_current_renderer->impl->Quit(_gpu_current_renderer);
     GPU_FreeRenderer(_gpu_current_renderer);
 }
 
 void GPU_Quit(void)
 {
-    if(_gpu_num_error_codes > 0 && GPU_GetDebugLevel() >= GPU_DEBUG_LEVEL_1)
-        GPU_LogError("GPU_Quit: %d uncleared error%s.\n", _gpu_num_error_codes, (_gpu_num_error_codes > 1? "s" : ""));
+    GPU_ErrorQueue* queue = gpu_get_error_queue(GPU_FALSE);
+    if(queue != NULL && queue->count > 0 && GPU_GetDebugLevel() >= GPU_DEBUG_LEVEL_1)
+        GPU_LogError("GPU_Quit: %u uncleared error%s.\n", queue->count, (queue->count > 1? "s" : ""));
 
+    gpu_free_captures();
+    gpu_free_async_loader();
+    gpu_free_image_cache(NULL);
     gpu_free_error_queue();
+    gpu_free_polygon_cache();
+    gpu_clear_shader_include_cache();
 
     if(_gpu_current_renderer == NULL)
         return;
@@ -717,9 +866,260 @@ GPU_DebugLevelEnum GPU_GetDebugLevel(void)
     return _gpu_debug_level;
 }
 
+// Copies a string into an error's storage and returns its offset, or -1 for NULL
+static int gpu_store_error_string(GPU_QueuedError* e, int* used, const char* s, int max_length)
+{
+    int start = *used;
+    int room = (int)sizeof(e->strings) - start - 1;
+    int length = 0;
+
+    // Out of room: the argument is dropped and reads back as an empty string
+    if(s == NULL || room <= 0)
+        return -1;
+
+    if(max_length > room)
+        max_length = room;
+    while(length < max_length && s[length] != '\0')
+        length++;
+
+    memcpy(e->strings + start, s, length);
+    e->strings[start + length] = '\0';
+    *used = start + length + 1;
+    if(*used > (int)sizeof(e->strings))
+        *used = (int)sizeof(e->strings);
+    return start;
+}
+
+// Stores the format and its arguments without formatting them.  Returns GPU_FALSE for formats this does not handle (e.g. '*' widths), which are formatted right away instead.
+static GPU_bool gpu_store_error_arguments(GPU_QueuedError* e, int* used, const char* format, va_list lst)
+{
+    int start = *used;
+    int length = (int)strlen(format);
+    const char* c;
+    int i;
+
+    if(start + length + 1 > (int)sizeof(e->strings))
+        return GPU_FALSE;
+
+    for(c = format; *c != '\0'; c++)
+    {
+        const char* spec;
+        int long_count = 0;
+        GPU_bool size_length = GPU_FALSE;
+        GPU_ErrorArgument* arg;
+
+        if(*c != '%')
+            continue;
+        if(c[1] == '%')
+        {
+            c++;
+            continue;
+        }
+
+        spec = c++;
+        while(*c != '\0' && strchr("-+ #0123456789.", *c) != NULL)
+            c++;
+        while(*c == 'h')
+            c++;
+        while(*c == 'l')
+        {
+            long_count++;
+            c++;
+        }
+        if(*c == 'z')
+        {
+            size_length = GPU_TRUE;
+            c++;
+        }
+
+        if(*c == '\0' || c - spec + 1 >= GPU_ERROR_SPEC_STRING_MAX || e->num_arguments >= GPU_ERROR_MAX_ARGUMENTS)
+            return GPU_FALSE;
+
+        arg = &e->arguments[e->num_arguments];
+        switch(*c)
+        {
+        case 'd':
+        case 'i':
+            if(size_length)
+            {
+                arg->type = GPU_ERROR_ARG_SIZE;
+                arg->value.u = va_arg(lst, size_t);
+            }
+            else if(long_count >= 2)
+            {
+                arg->type = GPU_ERROR_ARG_LLONG;
+                arg->value.i = va_arg(lst, long long);
+            }
+            else if(long_count == 1)
+            {
+                arg->type = GPU_ERROR_ARG_LONG;
+                arg->value.i = va_arg(lst, long);
+            }
+            else
+            {
+                arg->type = GPU_ERROR_ARG_INT;
+                arg->value.i = va_arg(lst, int);
+            }
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            if(size_length)
+            {
+                arg->type = GPU_ERROR_ARG_SIZE;
+                arg->value.u = va_arg(lst, size_t);
+            }
+            else if(long_count >= 2)
+            {
+                arg->type = GPU_ERROR_ARG_ULLONG;
+                arg->value.u = va_arg(lst, unsigned long long);
+            }
+            else if(long_count == 1)
+            {
+                arg->type = GPU_ERROR_ARG_ULONG;
+                arg->value.u = va_arg(lst, unsigned long);
+            }
+            else
+            {
+                arg->type = GPU_ERROR_ARG_UINT;
+                arg->value.u = va_arg(lst, unsigned int);
+            }
+            break;
+        case 'c':
+            arg->type = GPU_ERROR_ARG_INT;
+            arg->value.i = va_arg(lst, int);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            arg->type = GPU_ERROR_ARG_DOUBLE;
+            arg->value.d = va_arg(lst, double);
+            break;
+        case 's':
+            if(long_count > 0)
+                return GPU_FALSE;
+            arg->type = GPU_ERROR_ARG_STRING;
+            arg->value.p = va_arg(lst, const char*);
+            break;
+        case 'p':
+            arg->type = GPU_ERROR_ARG_POINTER;
+            arg->value.p = va_arg(lst, void*);
+            break;
+        default:
+            return GPU_FALSE;
+        }
+        e->num_arguments++;
+    }
+
+    memcpy(e->strings + start, format, length + 1);
+    e->details = start;
+    *used = start + length + 1;
+
+    // The strings may not outlive the call, so they are copied behind the format
+    for(i = 0; i < e->num_arguments; i++)
+    {
+        GPU_ErrorArgument* arg = &e->arguments[i];
+        if(arg->type == GPU_ERROR_ARG_STRING)
+        {
+            const char* s = (arg->value.p == NULL? "(null)" : (const char*)arg->value.p);
+            arg->value.i = gpu_store_error_string(e, used, s, GPU_ERROR_DETAILS_STRING_MAX);
+        }
+    }
+
+    return GPU_TRUE;
+}
+
+static int gpu_print_error_argument(char* result, int size, const char* spec, GPU_QueuedError* e, GPU_ErrorArgument* arg)
+{
+    switch(arg->type)
+    {
+    case GPU_ERROR_ARG_INT:
+        return SDL_snprintf(result, size, spec, (int)arg->value.i);
+    case GPU_ERROR_ARG_UINT:
+        return SDL_snprintf(result, size, spec, (unsigned int)arg->value.u);
+    case GPU_ERROR_ARG_LONG:
+        return SDL_snprintf(result, size, spec, (long)arg->value.i);
+    case GPU_ERROR_ARG_ULONG:
+        return SDL_snprintf(result, size, spec, (unsigned long)arg->value.u);
+    case GPU_ERROR_ARG_LLONG:
+        return SDL_snprintf(result, size, spec, arg->value.i);
+    case GPU_ERROR_ARG_ULLONG:
+        return SDL_snprintf(result, size, spec, arg->value.u);
+    case GPU_ERROR_ARG_SIZE:
+        return SDL_snprintf(result, size, spec, (size_t)arg->value.u);
+    case GPU_ERROR_ARG_DOUBLE:
+        return SDL_snprintf(result, size, spec, arg->value.d);
+    case GPU_ERROR_ARG_STRING:
+        return SDL_snprintf(result, size, spec, (arg->value.i < 0? "" : e->strings + arg->value.i));
+    case GPU_ERROR_ARG_POINTER:
+        return SDL_snprintf(result, size, spec, arg->value.p);
+    }
+    return 0;
+}
+
+// Builds the details string from a stored format, one conversion at a time
+static void gpu_format_error_details(GPU_QueuedError* e, char* result, int size)
+{
+    const char* c;
+    int length = 0;
+    int arg = 0;
+
+    result[0] = '\0';
+    if(e->details < 0)
+        return;
+
+    c = e->strings + e->details;
+    if(e->formatted)
+    {
+        SDL_strlcpy(result, c, size);
+        return;
+    }
+
+    while(*c != '\0' && length < size - 1)
+    {
+        char spec[GPU_ERROR_SPEC_STRING_MAX];
+        int spec_length;
+        int n;
+
+        if(*c != '%')
+        {
+            result[length++] = *c++;
+            continue;
+        }
+        if(c[1] == '%')
+        {
+            result[length++] = '%';
+            c += 2;
+            continue;
+        }
+
+        // The stored format was checked when it was pushed, so each conversion has an argument
+        spec_length = 1;
+        while(strchr("diouxXcfFeEgGaAsp", c[spec_length]) == NULL)
+            spec_length++;
+        spec_length++;
+        memcpy(spec, c, spec_length);
+        spec[spec_length] = '\0';
+        c += spec_length;
+
+        n = gpu_print_error_argument(result + length, size - length, spec, e, &e->arguments[arg++]);
+        if(n > 0)
+            length += (n < size - length? n : size - length - 1);
+    }
+    result[length] = '\0';
+}
+
 void GPU_PushErrorCode(const char* function, GPU_ErrorEnum error, const char* details, ...)
 {
-    gpu_init_error_queue();
+    GPU_ErrorQueue* queue = gpu_get_error_queue(GPU_TRUE);
+    GPU_QueuedError* e;
+    int used = 0;
 
     if(GPU_GetDebugLevel() >= GPU_DEBUG_LEVEL_1)
     {
@@ -738,55 +1138,57 @@ void GPU_PushErrorCode(const char* function, GPU_ErrorEnum error, const char* de
             GPU_LogError("%s: %s\n", (function == NULL? "NULL" : function), GPU_GetErrorString(error));
     }
 
-    if(_gpu_num_error_codes < _gpu_error_code_queue_size)
+    if(queue == NULL || queue->count >= queue->size)
+        return;
+
+    e = &queue->errors[(queue->head + queue->count) % queue->size];
+    e->error = error;
+    e->function = gpu_store_error_string(e, &used, function, GPU_ERROR_FUNCTION_STRING_MAX);
+    e->details = -1;
+    e->formatted = GPU_FALSE;
+    e->num_arguments = 0;
+    if(details != NULL)
     {
-        if(function == NULL)
-            _gpu_error_code_queue[_gpu_num_error_codes].function[0] = '\0';
-        else
-        {
-            strncpy(_gpu_error_code_queue[_gpu_num_error_codes].function, function, GPU_ERROR_FUNCTION_STRING_MAX);
-            _gpu_error_code_queue[_gpu_num_error_codes].function[GPU_ERROR_FUNCTION_STRING_MAX] = '\0';
-        }
-        _gpu_error_code_queue[_gpu_num_error_codes].error = error;
-        if(details == NULL)
-            _gpu_error_code_queue[_gpu_num_error_codes].details[0] = '\0';
-        else
+        GPU_bool stored;
+        va_list lst;
+        va_start(lst, details);
+        stored = gpu_store_error_arguments(e, &used, details, lst);
+        va_end(lst);
+
+        if(!stored)
         {
-            va_list lst;
+            // Fall back to formatting now
+            e->num_arguments = 0;
+            e->formatted = GPU_TRUE;
+            e->details = used;
             va_start(lst, details);
-            vsnprintf(_gpu_error_code_queue[_gpu_num_error_codes].details, GPU_ERROR_DETAILS_STRING_MAX, details, lst);
+            vsnprintf(e->strings + used, sizeof(e->strings) - used, details, lst);
             va_end(lst);
         }
-        _gpu_num_error_codes++;
     }
+    queue->count++;
 }
 
 GPU_ErrorObject GPU_PopErrorCode(void)
 {
-    unsigned int i;
+    GPU_ErrorQueue* queue = gpu_get_error_queue(GPU_TRUE);
     GPU_ErrorObject result = {NULL, GPU_ERROR_NONE, NULL};
+    GPU_QueuedError* e;
 
-    gpu_init_error_queue();
-
-    if(_gpu_num_error_codes <= 0)
+    if(queue == NULL || queue->count == 0)
         return result;
 
     // Pop the oldest
-    strcpy(_gpu_error_code_result.function, _gpu_error_code_queue[0].function);
-    _gpu_error_code_result.error = _gpu_error_code_queue[0].error;
-    strcpy(_gpu_error_code_result.details, _gpu_error_code_queue[0].details);
+    e = &queue->errors[queue->head];
+    SDL_strlcpy(queue->function, (e->function < 0? "" : e->strings + e->function), GPU_ERROR_FUNCTION_STRING_MAX+1);
+    gpu_format_error_details(e, queue->details, GPU_ERROR_DETAILS_STRING_MAX+1);
 
-    // We'll be returning that one
-    result = _gpu_error_code_result;
+    queue->head = (queue->head + 1) % queue->size;
+    queue->count--;
 
-    // Move the rest down
-    _gpu_num_error_codes--;
-    for(i = 0; i < _gpu_num_error_codes; i++)
-    {
-        strcpy(_gpu_error_code_queue[i].function, _gpu_error_code_queue[i+1].function);
-        _gpu_error_code_queue[i].error = _gpu_error_code_queue[i+1].error;
-        strcpy(_gpu_error_code_queue[i].details, _gpu_error_code_queue[i+1].details);
-    }
+    result.function = queue->function;
+    result.error = e->error;
+    result.details = queue->details;
     return result;
 }
 
@@ -947,6 +1349,18 @@ GPU_Image* GPU_CreateImageUsingTexture(GPU_TextureHandle handle, GPU_bool take_o
     return _gpu_current_renderer->impl->CreateImageUsingTexture(_gpu_current_renderer, handle, take_ownership);
 }
 
+GPU_Image* GPU_CreateStreamingImage(Uint16 w, Uint16 h, GPU_FormatEnum format)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return NULL;
+
+    return _gpu_current_renderer->impl->CreateStreamingImage(_gpu_current_renderer, w, h, format);
+}
+
+static GPU_bool _gpu_premultiply_on_load = GPU_FALSE;
+static GPU_bool _gpu_mipmaps_on_load = GPU_FALSE;
+static GPU_MipmapFilterEnum _gpu_mipmap_filter = GPU_MIPMAP_FILTER_BOX;
+
 GPU_Image* GPU_LoadImage(const char* filename)
 {
     return GPU_LoadImage_RW(SDL_RWFromFile(filename, "r"), 1);
@@ -955,19 +1369,57 @@ GPU_Image* GPU_LoadImage(const char* filename)
 GPU_Image* GPU_LoadImage_RW(SDL_RWops* rwops, GPU_bool free_rwops)
 {
 	GPU_Image* result;
-	SDL_Surface* surface;
+	GPU_RWopsStream stream;
+	unsigned char* data;
+	int data_bytes;
+	int width, height, channels;
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
         return NULL;
-        
-    surface = GPU_LoadSurface_RW(rwops, free_rwops);
-    if(surface == NULL)
+
+    if(rwops == NULL)
     {
-        GPU_PushErrorCode("GPU_LoadImage_RW", GPU_ERROR_DATA_ERROR, "Failed to load image data.");
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "rwops");
         return NULL;
     }
 
-    result = _gpu_current_renderer->impl->CopyImageFromSurface(_gpu_current_renderer, surface);
-    SDL_FreeSurface(surface);
+    gpu_open_stream(&stream, rwops);
+
+    if(gpu_is_compressed_container(stream.peek, stream.peek_size))
+    {
+        // Compressed texture containers go to the GPU without being decoded
+        data = gpu_read_stream(&stream, &data_bytes);
+        if(data == NULL)
+        {
+            GPU_PushErrorCode("GPU_LoadImage_RW", GPU_ERROR_DATA_ERROR, "Failed to read texture container");
+            result = NULL;
+        }
+        else
+            result = gpu_load_compressed_image(_gpu_current_renderer, data, data_bytes);
+        SDL_free(data);
+    }
+    else
+    {
+        // Decode straight from the stream and upload stb_image's buffer as it is
+        data = stbi_load_from_callbacks(&gpu_stream_callbacks, &stream, &width, &height, &channels, 0);
+        if(data == NULL)
+        {
+            GPU_PushErrorCode("GPU_LoadImage_RW", GPU_ERROR_DATA_ERROR, "Failed to load image data: %s", stbi_failure_reason());
+            result = NULL;
+        }
+        else
+        {
+            unsigned char* mipmaps;
+            int num_levels;
+
+            mipmaps = gpu_prepare_decoded_pixels(data, width, height, channels, _gpu_premultiply_on_load, _gpu_mipmaps_on_load, _gpu_mipmap_filter, 0, &num_levels);
+            result = gpu_create_image_from_pixels(data, width, height, channels, _gpu_premultiply_on_load, _gpu_mipmaps_on_load, mipmaps, num_levels);
+            SDL_free(mipmaps);
+            stbi_image_free(data);
+        }
+    }
+
+    if(free_rwops)
+        SDL_RWclose(rwops);
 
     return result;
 }
@@ -1024,6 +1476,40 @@ void GPU_UpdateImageBytes(GPU_Image* image, const GPU_Rect* image_rect, const un
     _gpu_current_renderer->impl->UpdateImageBytes(_gpu_current_renderer, image, image_rect, bytes, bytes_per_row);
 }
 
+void GPU_UpdateImageYUV(GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* y_plane, const unsigned char* u_plane, const unsigned char* v_plane, const int* pitches)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->UpdateImageYUV(_gpu_current_renderer, image, image_rect, y_plane, u_plane, v_plane, pitches);
+}
+
+GPU_bool GPU_LockImageRegion(GPU_Image* image, const GPU_Rect* image_rect, void** pixels, int* pitch)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    return _gpu_current_renderer->impl->LockImageRegion(_gpu_current_renderer, image, image_rect, pixels, pitch);
+}
+
+void GPU_UnlockImageRegion(GPU_Image* image)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->UnlockImageRegion(_gpu_current_renderer, image);
+}
+
+GPU_bool GPU_LockImage(GPU_Image* image, void** pixels, int* pitch)
+{
+    return GPU_LockImageRegion(image, NULL, pixels, pitch);
+}
+
+void GPU_UnlockImage(GPU_Image* image)
+{
+    GPU_UnlockImageRegion(image);
+}
+
 GPU_bool GPU_ReplaceImage(GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -1087,81 +1573,976 @@ static SDL_Surface* gpu_copy_raw_surface_data(unsigned char* data, int width, in
     // Copy row-by-row in case the pitch doesn't match
     for(i = 0; i < height; ++i)
     {
-        memcpy((Uint8*)result->pixels + i*result->pitch, data + channels*width*i, channels*width);
+        memcpy((Uint8*)result->pixels + i*result->pitch, data + channels*width*i, channels*width);
+    }
+    
+    if(result != NULL && result->format->palette != NULL)
+    {
+        // SDL_CreateRGBSurface has no idea what palette to use, so it uses a blank one.
+        // We'll at least create a grayscale one, but it's not ideal...
+        // Better would be to get the palette from stbi, but stbi doesn't do that!
+        SDL_Color colors[256];
+
+        for(i = 0; i < 256; i++)
+        {
+            colors[i].r = colors[i].g = colors[i].b = (Uint8)i;
+        }
+
+        /* Set palette */
+#ifdef SDL_GPU_USE_SDL2
+        SDL_SetPaletteColors(result->format->palette, colors, 0, 256);
+#else
+        SDL_SetPalette(result, SDL_LOGPAL, colors, 0, 256);
+#endif
+    }
+    
+    return result;
+}
+
+static void gpu_open_stream(GPU_RWopsStream* stream, SDL_RWops* rwops)
+{
+    SDL_RWseek(rwops, 0, SEEK_SET);
+
+    stream->rwops = rwops;
+    stream->peek_size = (int)SDL_RWread(rwops, stream->peek, 1, sizeof(stream->peek));
+    stream->peek_pos = 0;
+    stream->eof = (stream->peek_size < (int)sizeof(stream->peek));
+}
+
+static int gpu_stream_read(void* user, char* data, int size)
+{
+    GPU_RWopsStream* stream = (GPU_RWopsStream*)user;
+    int num_read = 0;
+
+    if(stream->peek_pos < stream->peek_size)
+    {
+        num_read = stream->peek_size - stream->peek_pos;
+        if(num_read > size)
+            num_read = size;
+        memcpy(data, stream->peek + stream->peek_pos, num_read);
+        stream->peek_pos += num_read;
+    }
+
+    if(num_read < size && !stream->eof)
+    {
+        int n = (int)SDL_RWread(stream->rwops, data + num_read, 1, size - num_read);
+        if(n < size - num_read)
+            stream->eof = GPU_TRUE;
+        num_read += n;
+    }
+
+    return num_read;
+}
+
+// stb_image only skips forward
+static void gpu_stream_skip(void* user, int n)
+{
+    GPU_RWopsStream* stream = (GPU_RWopsStream*)user;
+    char discard[256];
+    int num_peeked = stream->peek_size - stream->peek_pos;
+
+    if(num_peeked > n)
+        num_peeked = n;
+    stream->peek_pos += num_peeked;
+    n -= num_peeked;
+
+    if(n <= 0 || stream->eof || SDL_RWseek(stream->rwops, n, SEEK_CUR) >= 0)
+        return;
+
+    // Not seekable, so read past the data instead
+    while(n > 0 && !stream->eof)
+        n -= gpu_stream_read(stream, discard, (n < (int)sizeof(discard)? n : (int)sizeof(discard)));
+}
+
+static int gpu_stream_eof(void* user)
+{
+    GPU_RWopsStream* stream = (GPU_RWopsStream*)user;
+    return (stream->peek_pos >= stream->peek_size && stream->eof);
+}
+
+static const stbi_io_callbacks gpu_stream_callbacks = {&gpu_stream_read, &gpu_stream_skip, &gpu_stream_eof};
+
+// Reads the whole stream, peeked bytes included, into one buffer for formats that are used as they are stored.
+// Works on rwops that can't seek.  Returns NULL if nothing could be read or the buffer can't be allocated.
+static unsigned char* gpu_read_stream(GPU_RWopsStream* stream, int* data_bytes)
+{
+    unsigned char* data;
+    int size_hint = 0;
+    int capacity;
+    int size = 0;
+    int pos, end;
+
+    *data_bytes = 0;
+
+    // Size the buffer up front when the rwops can tell where it ends
+    pos = (int)SDL_RWseek(stream->rwops, 0, SEEK_CUR);
+    end = (pos >= 0? (int)SDL_RWseek(stream->rwops, 0, SEEK_END) : -1);
+    if(end >= 0)
+    {
+        SDL_RWseek(stream->rwops, pos, SEEK_SET);
+        size_hint = stream->peek_size - stream->peek_pos + (end - pos);
+    }
+
+    capacity = (size_hint > 0? size_hint : GPU_STREAM_READ_CHUNK_SIZE);
+    data = (unsigned char*)SDL_malloc(capacity);
+    if(data == NULL)
+        return NULL;
+
+    while(!gpu_stream_eof(stream))
+    {
+        int num_read;
+
+        if(size == capacity)
+        {
+            unsigned char* new_data;
+
+            if(size >= size_hint && size_hint > 0)
+                break;
+            if(capacity > 0x3FFFFFFF)
+            {
+                SDL_free(data);
+                return NULL;
+            }
+
+            new_data = (unsigned char*)SDL_realloc(data, 2*capacity);
+            if(new_data == NULL)
+            {
+                SDL_free(data);
+                return NULL;
+            }
+            data = new_data;
+            capacity *= 2;
+        }
+
+        num_read = gpu_stream_read(stream, (char*)data + size, capacity - size);
+        if(num_read <= 0)
+            break;
+        size += num_read;
+    }
+
+    if(size == 0)
+    {
+        SDL_free(data);
+        return NULL;
+    }
+
+    *data_bytes = size;
+    return data;
+}
+
+void GPU_SetPremultiplyOnLoad(GPU_bool enable)
+{
+    _gpu_premultiply_on_load = enable;
+}
+
+GPU_bool GPU_GetPremultiplyOnLoad(void)
+{
+    return _gpu_premultiply_on_load;
+}
+
+void GPU_SetMipmapsOnLoad(GPU_bool enable, GPU_MipmapFilterEnum filter)
+{
+    _gpu_mipmaps_on_load = enable;
+    _gpu_mipmap_filter = filter;
+}
+
+GPU_bool GPU_GetMipmapsOnLoad(GPU_MipmapFilterEnum* filter)
+{
+    if(filter != NULL)
+        *filter = _gpu_mipmap_filter;
+    return _gpu_mipmaps_on_load;
+}
+
+// Premultiplies RGBA pixels in place and builds their mipmap chain, as the loader settings ask.  Returns the levels from gpu_build_mipmaps() or NULL.
+// Does not push errors, so the async loader calls this on its decoding threads.
+static unsigned char* gpu_prepare_decoded_pixels(unsigned char* pixels, int width, int height, int channels, GPU_bool premultiply, GPU_bool build_mipmaps, GPU_MipmapFilterEnum filter, int num_threads, int* num_levels)
+{
+    *num_levels = 1;
+
+    if(premultiply && channels == 4)
+        gpu_premultiply_alpha(pixels, width*4, width, height);
+
+    if(!build_mipmaps)
+        return NULL;
+    return gpu_build_mipmaps(pixels, width, height, channels, premultiply, filter, num_threads, num_levels);
+}
+
+// Uploads pixels from gpu_prepare_decoded_pixels() into a new image without an intermediate SDL_Surface.  Images that get no prebuilt levels fall back to GPU_GenerateMipmaps() when mipmapped is set.
+static GPU_Image* gpu_create_image_from_pixels(unsigned char* pixels, int width, int height, int channels, GPU_bool premultiplied, GPU_bool mipmapped, const unsigned char* mipmaps, int num_levels)
+{
+    GPU_Image* result;
+    GPU_FormatEnum format;
+
+    switch(channels)
+    {
+    case 3:
+        format = GPU_FORMAT_RGB;
+        break;
+    case 4:
+        format = GPU_FORMAT_RGBA;
+        break;
+    default:
+        // Gray images keep the palette conversion of the surface path
+        {
+            SDL_Surface* surface = gpu_copy_raw_surface_data(pixels, width, height, channels);
+            if(surface == NULL)
+                return NULL;
+            result = _gpu_current_renderer->impl->CopyImageFromSurface(_gpu_current_renderer, surface);
+            SDL_FreeSurface(surface);
+            if(result != NULL && mipmapped)
+                _gpu_current_renderer->impl->GenerateMipmaps(_gpu_current_renderer, result);
+            return result;
+        }
+    }
+
+    result = _gpu_current_renderer->impl->CreateImage(_gpu_current_renderer, (Uint16)width, (Uint16)height, format);
+    if(result == NULL)
+        return NULL;
+
+    if(premultiplied && format == GPU_FORMAT_RGBA)
+    {
+        result->has_premultiplied_alpha = GPU_TRUE;
+        result->blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_PREMULTIPLIED_ALPHA);
+    }
+
+    _gpu_current_renderer->impl->UpdateImageBytes(_gpu_current_renderer, result, NULL, pixels, width*channels);
+
+    if(mipmapped && (mipmaps == NULL || !_gpu_current_renderer->impl->UploadMipmaps(_gpu_current_renderer, result, num_levels, mipmaps)))
+        _gpu_current_renderer->impl->GenerateMipmaps(_gpu_current_renderer, result);
+    return result;
+}
+
+SDL_Surface* GPU_LoadSurface_RW(SDL_RWops* rwops, GPU_bool free_rwops)
+{
+    int width, height, channels;
+    int data_bytes;
+    unsigned char* data;
+    SDL_Surface* result;
+    GPU_RWopsStream stream;
+    GPU_bool is_container;
+
+    if(rwops == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "rwops");
+        return NULL;
+    }
+
+    gpu_open_stream(&stream, rwops);
+
+    is_container = gpu_is_compressed_container(stream.peek, stream.peek_size);
+    if(is_container)
+    {
+        // Compressed texture containers are decoded on the CPU
+        unsigned char* c_data = gpu_read_stream(&stream, &data_bytes);
+        if(c_data == NULL)
+        {
+            GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Failed to read texture container from rwops");
+            data = NULL;
+        }
+        else
+            data = gpu_load_compressed_pixels(c_data, data_bytes, &width, &height);
+        SDL_free(c_data);
+        channels = 4;
+    }
+    else
+    {
+        data = stbi_load_from_callbacks(&gpu_stream_callbacks, &stream, &width, &height, &channels, 0);
+        if(data == NULL)
+            GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Failed to load from rwops: %s", stbi_failure_reason());
+    }
+
+    if(free_rwops)
+        SDL_RWclose(rwops);
+
+    if(data == NULL)
+        return NULL;
+
+    // Copy into a surface
+    result = gpu_copy_raw_surface_data(data, width, height, channels);
+
+    if(is_container)
+        SDL_free(data);
+    else
+        stbi_image_free(data);
+
+    return result;
+}
+
+SDL_Surface* GPU_LoadSurface(const char* filename)
+{
+    return GPU_LoadSurface_RW(SDL_RWFromFile(filename, "r"), 1);
+}
+
+
+// Asynchronous image loading
+
+#define GPU_ASYNC_LOAD_MAX_THREADS 4
+
+/*! A request from GPU_LoadImageAsync().  It moves from the pending queue to a worker thread, then to the decoded queue. */
+typedef struct GPU_AsyncLoadJob
+{
+    char* filename;
+    GPU_LoadImageCallback callback;
+    void* userdata;
+    unsigned char* data;  // Decoded pixels or a whole compressed texture container.  NULL on failure.
+    int data_bytes;
+    GPU_bool is_container;
+    int w, h, channels;
+    GPU_bool premultiply;  // Loader settings when the request was made
+    GPU_bool build_mipmaps;
+    GPU_MipmapFilterEnum mipmap_filter;
+    unsigned char* mipmaps;  // Levels from gpu_build_mipmaps(), or NULL
+    int num_mipmap_levels;
+    struct GPU_AsyncLoadJob* next;
+} GPU_AsyncLoadJob;
+
+static SDL_mutex* _gpu_async_mutex = NULL;
+static SDL_cond* _gpu_async_cond = NULL;
+static SDL_Thread* _gpu_async_threads[GPU_ASYNC_LOAD_MAX_THREADS];
+static int _gpu_async_num_threads = 0;
+static GPU_bool _gpu_async_quit = GPU_FALSE;
+static GPU_AsyncLoadJob* _gpu_async_pending = NULL;
+static GPU_AsyncLoadJob* _gpu_async_pending_last = NULL;
+static GPU_AsyncLoadJob* _gpu_async_decoded = NULL;
+static GPU_AsyncLoadJob* _gpu_async_decoded_last = NULL;
+static int _gpu_async_num_jobs = 0;  // Queued, decoding, or waiting for upload
+
+static Uint32 _gpu_async_frame_budget_ms = 2;
+static Uint32 _gpu_async_frame_budget_bytes = 16*1024*1024;
+
+static void gpu_async_append(GPU_AsyncLoadJob** first, GPU_AsyncLoadJob** last, GPU_AsyncLoadJob* job)
+{
+    job->next = NULL;
+    if(*last == NULL)
+        *first = job;
+    else
+        (*last)->next = job;
+    *last = job;
+}
+
+static GPU_AsyncLoadJob* gpu_async_pop(GPU_AsyncLoadJob** first, GPU_AsyncLoadJob** last)
+{
+    GPU_AsyncLoadJob* job = *first;
+    if(job != NULL)
+    {
+        *first = job->next;
+        if(*first == NULL)
+            *last = NULL;
+        job->next = NULL;
+    }
+    return job;
+}
+
+// Decodes without touching the error queue, which belongs to the rendering thread.
+static void gpu_async_decode(GPU_AsyncLoadJob* job)
+{
+    SDL_RWops* rwops;
+    GPU_RWopsStream stream;
+
+    rwops = SDL_RWFromFile(job->filename, "r");
+    if(rwops == NULL)
+        return;
+
+    gpu_open_stream(&stream, rwops);
+
+    job->is_container = gpu_is_compressed_container(stream.peek, stream.peek_size);
+    if(job->is_container)
+        job->data = gpu_read_stream(&stream, &job->data_bytes);
+    else
+    {
+        job->data = stbi_load_from_callbacks(&gpu_stream_callbacks, &stream, &job->w, &job->h, &job->channels, 0);
+        job->data_bytes = job->w * job->h * job->channels;
+
+        // The other workers are decoding too, so the chain is built on this thread alone
+        if(job->data != NULL)
+            job->mipmaps = gpu_prepare_decoded_pixels(job->data, job->w, job->h, job->channels, job->premultiply, job->build_mipmaps, job->mipmap_filter, 1, &job->num_mipmap_levels);
+    }
+
+    SDL_RWclose(rwops);
+}
+
+static void gpu_async_free_data(GPU_AsyncLoadJob* job)
+{
+    if(job->is_container)
+        SDL_free(job->data);
+    else
+        stbi_image_free(job->data);
+    SDL_free(job->mipmaps);
+    job->data = NULL;
+    job->mipmaps = NULL;
+}
+
+static int SDLCALL gpu_async_worker(void* unused)
+{
+    (void)unused;
+
+    SDL_LockMutex(_gpu_async_mutex);
+    while(!_gpu_async_quit)
+    {
+        GPU_AsyncLoadJob* job = gpu_async_pop(&_gpu_async_pending, &_gpu_async_pending_last);
+        if(job == NULL)
+        {
+            SDL_CondWait(_gpu_async_cond, _gpu_async_mutex);
+            continue;
+        }
+
+        SDL_UnlockMutex(_gpu_async_mutex);
+        gpu_async_decode(job);
+        SDL_LockMutex(_gpu_async_mutex);
+
+        gpu_async_append(&_gpu_async_decoded, &_gpu_async_decoded_last, job);
+    }
+    SDL_UnlockMutex(_gpu_async_mutex);
+
+    return 0;
+}
+
+static GPU_bool gpu_init_async_loader(void)
+{
+    int i, num_threads;
+
+    if(_gpu_async_mutex != NULL)
+        return GPU_TRUE;
+
+    _gpu_async_mutex = SDL_CreateMutex();
+    _gpu_async_cond = SDL_CreateCond();
+    if(_gpu_async_mutex == NULL || _gpu_async_cond == NULL)
+    {
+        SDL_DestroyMutex(_gpu_async_mutex);
+        SDL_DestroyCond(_gpu_async_cond);
+        _gpu_async_mutex = NULL;
+        _gpu_async_cond = NULL;
+        return GPU_FALSE;
+    }
+
+    // Leave a core for the rendering thread
+    #ifdef SDL_GPU_USE_SDL2
+    num_threads = SDL_GetCPUCount() - 1;
+    #else
+    num_threads = 2;
+    #endif
+    if(num_threads < 1)
+        num_threads = 1;
+    if(num_threads > GPU_ASYNC_LOAD_MAX_THREADS)
+        num_threads = GPU_ASYNC_LOAD_MAX_THREADS;
+
+    _gpu_async_quit = GPU_FALSE;
+    _gpu_async_num_threads = 0;
+    for(i = 0; i < num_threads; ++i)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        SDL_Thread* thread = SDL_CreateThread(&gpu_async_worker, "GPU_LoadImageAsync", NULL);
+        #else
+        SDL_Thread* thread = SDL_CreateThread(&gpu_async_worker, NULL);
+        #endif
+        if(thread != NULL)
+            _gpu_async_threads[_gpu_async_num_threads++] = thread;
+    }
+
+    if(_gpu_async_num_threads == 0)
+    {
+        SDL_DestroyMutex(_gpu_async_mutex);
+        SDL_DestroyCond(_gpu_async_cond);
+        _gpu_async_mutex = NULL;
+        _gpu_async_cond = NULL;
+        return GPU_FALSE;
+    }
+
+    return GPU_TRUE;
+}
+
+// Stops the workers and drops unfinished requests without calling their callbacks.
+static void gpu_free_async_loader(void)
+{
+    int i;
+    GPU_AsyncLoadJob* job;
+
+    if(_gpu_async_mutex == NULL)
+        return;
+
+    SDL_LockMutex(_gpu_async_mutex);
+    _gpu_async_quit = GPU_TRUE;
+    SDL_CondBroadcast(_gpu_async_cond);
+    SDL_UnlockMutex(_gpu_async_mutex);
+
+    for(i = 0; i < _gpu_async_num_threads; ++i)
+    {
+        SDL_WaitThread(_gpu_async_threads[i], NULL);
+    }
+    _gpu_async_num_threads = 0;
+
+    while((job = gpu_async_pop(&_gpu_async_pending, &_gpu_async_pending_last)) != NULL
+          || (job = gpu_async_pop(&_gpu_async_decoded, &_gpu_async_decoded_last)) != NULL)
+    {
+        gpu_async_free_data(job);
+        SDL_free(job->filename);
+        SDL_free(job);
+    }
+    _gpu_async_num_jobs = 0;
+
+    SDL_DestroyCond(_gpu_async_cond);
+    SDL_DestroyMutex(_gpu_async_mutex);
+    _gpu_async_cond = NULL;
+    _gpu_async_mutex = NULL;
+}
+
+GPU_bool GPU_LoadImageAsync(const char* filename, GPU_LoadImageCallback callback, void* userdata)
+{
+    GPU_AsyncLoadJob* job;
+
+    if(filename == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "filename");
+        return GPU_FALSE;
+    }
+    if(callback == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "callback");
+        return GPU_FALSE;
+    }
+
+    if(!gpu_init_async_loader())
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to start loader threads");
+        return GPU_FALSE;
+    }
+
+    job = (GPU_AsyncLoadJob*)SDL_malloc(sizeof(GPU_AsyncLoadJob));
+    if(job == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to allocate load job");
+        return GPU_FALSE;
+    }
+    job->filename = (char*)SDL_malloc(strlen(filename) + 1);
+    if(job->filename == NULL)
+    {
+        SDL_free(job);
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to allocate load job");
+        return GPU_FALSE;
+    }
+    strcpy(job->filename, filename);
+    job->callback = callback;
+    job->userdata = userdata;
+    job->data = NULL;
+    job->data_bytes = 0;
+    job->is_container = GPU_FALSE;
+    job->premultiply = _gpu_premultiply_on_load;
+    job->build_mipmaps = _gpu_mipmaps_on_load;
+    job->mipmap_filter = _gpu_mipmap_filter;
+    job->mipmaps = NULL;
+    job->num_mipmap_levels = 1;
+
+    SDL_LockMutex(_gpu_async_mutex);
+    gpu_async_append(&_gpu_async_pending, &_gpu_async_pending_last, job);
+    _gpu_async_num_jobs++;
+    SDL_CondSignal(_gpu_async_cond);
+    SDL_UnlockMutex(_gpu_async_mutex);
+
+    return GPU_TRUE;
+}
+
+static int gpu_pump_async_loads(Uint32 budget_ms, Uint32 budget_bytes)
+{
+    Uint32 start_time;
+    Uint32 num_bytes = 0;
+    int num_completed = 0;
+
+    if(_gpu_async_mutex == NULL)
+        return 0;
+
+    start_time = SDL_GetTicks();
+    while(1)
+    {
+        GPU_AsyncLoadJob* job;
+        GPU_Image* image = NULL;
+
+        SDL_LockMutex(_gpu_async_mutex);
+        job = gpu_async_pop(&_gpu_async_decoded, &_gpu_async_decoded_last);
+        SDL_UnlockMutex(_gpu_async_mutex);
+
+        if(job == NULL)
+            break;
+
+        if(job->data != NULL)
+        {
+            num_bytes += job->data_bytes;
+            if(job->is_container)
+                image = gpu_load_compressed_image(_gpu_current_renderer, job->data, job->data_bytes);
+            else
+                image = gpu_create_image_from_pixels(job->data, job->w, job->h, job->channels, job->premultiply, job->build_mipmaps, job->mipmaps, job->num_mipmap_levels);
+            gpu_async_free_data(job);
+        }
+        else
+            GPU_PushErrorCode("GPU_LoadImageAsync", GPU_ERROR_DATA_ERROR, "Failed to load \"%s\"", job->filename);
+
+        SDL_LockMutex(_gpu_async_mutex);
+        _gpu_async_num_jobs--;
+        SDL_UnlockMutex(_gpu_async_mutex);
+
+        job->callback(image, job->filename, job->userdata);
+        SDL_free(job->filename);
+        SDL_free(job);
+        num_completed++;
+
+        if((budget_ms > 0 && SDL_GetTicks() - start_time >= budget_ms)
+           || (budget_bytes > 0 && num_bytes >= budget_bytes))
+            break;
+    }
+
+    return num_completed;
+}
+
+int GPU_PumpAsyncLoads(Uint32 budget_ms)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    return gpu_pump_async_loads(budget_ms, 0);
+}
+
+void GPU_SetAsyncLoadBudget(Uint32 budget_ms, Uint32 budget_bytes)
+{
+    _gpu_async_frame_budget_ms = budget_ms;
+    _gpu_async_frame_budget_bytes = budget_bytes;
+}
+
+int GPU_GetNumPendingAsyncLoads(void)
+{
+    int result;
+
+    if(_gpu_async_mutex == NULL)
+        return 0;
+
+    SDL_LockMutex(_gpu_async_mutex);
+    result = _gpu_async_num_jobs;
+    SDL_UnlockMutex(_gpu_async_mutex);
+    return result;
+}
+
+// Image cache
+
+#define GPU_IMAGE_CACHE_MIN_BUCKETS 64
+
+/*! An image from GPU_LoadImageCached().  The cache holds one reference, so an image with a refcount of 1 is only kept alive by the cache. */
+typedef struct GPU_ImageCacheEntry
+{
+    char* path;  // Normalized
+    Uint32 hash;
+    GPU_Image* image;
+    GPU_bool premultiplied;  // GPU_GetPremultiplyOnLoad() when it was loaded
+    GPU_bool mipmapped;  // GPU_GetMipmapsOnLoad() when it was loaded
+    GPU_MipmapFilterEnum mipmap_filter;
+    Uint32 last_use_frame;
+    struct GPU_ImageCacheEntry* next;
+} GPU_ImageCacheEntry;
+
+static GPU_ImageCacheEntry** _gpu_image_cache = NULL;
+static unsigned int _gpu_image_cache_num_buckets = 0;  // Always a power of two
+static unsigned int _gpu_image_cache_size = 0;
+static Uint32 _gpu_frame_count = 0;
+
+// Spells each file one way, so "data/./a.png" and "data/b/../a.png" share an entry
+static char* gpu_normalize_path(const char* filename)
+{
+    char* result = (char*)SDL_malloc(strlen(filename) + 1);
+    size_t out = 0;
+    const char* s = filename;
+
+    if(*s == '/' || *s == '\\')
+        result[out++] = '/';
+
+    while(*s != '\0')
+    {
+        const char* end;
+        size_t n;
+
+        while(*s == '/' || *s == '\\')
+            s++;
+        end = s;
+        while(*end != '\0' && *end != '/' && *end != '\\')
+            end++;
+        n = end - s;
+        if(n == 0)
+            break;
+
+        if(n == 2 && s[0] == '.' && s[1] == '.')
+        {
+            size_t start = out;
+            while(start > 0 && result[start - 1] != '/')
+                start--;
+
+            if(out > start && !(out - start == 2 && result[start] == '.' && result[start + 1] == '.'))
+            {
+                // Drop the previous segment along with its separator, but not the root
+                out = start;
+                if(out > 1)
+                    out--;
+            }
+            else if(out == 0 || result[out - 1] != '/')
+            {
+                if(out > 0)
+                    result[out++] = '/';
+                result[out++] = '.';
+                result[out++] = '.';
+            }
+        }
+        else if(!(n == 1 && s[0] == '.'))
+        {
+            if(out > 0 && result[out - 1] != '/')
+                result[out++] = '/';
+            memcpy(result + out, s, n);
+            out += n;
+        }
+
+        s = end;
+    }
+    result[out] = '\0';
+
+    #ifdef _WIN32
+    {
+        // Windows paths are case-insensitive
+        char* c;
+        for(c = result; *c != '\0'; ++c)
+            *c = (char)tolower((unsigned char)*c);
+    }
+    #endif
+
+    return result;
+}
+
+// FNV-1a
+static Uint32 gpu_hash_string(const char* s)
+{
+    Uint32 hash = 2166136261u;
+    while(*s != '\0')
+    {
+        hash ^= (unsigned char)*s++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static GPU_ImageCacheEntry* gpu_find_cached_image(const char* path, Uint32 hash)
+{
+    GPU_ImageCacheEntry* entry;
+
+    if(_gpu_image_cache == NULL)
+        return NULL;
+
+    for(entry = _gpu_image_cache[hash & (_gpu_image_cache_num_buckets - 1)]; entry != NULL; entry = entry->next)
+    {
+        if(entry->hash != hash || entry->image->renderer != _gpu_current_renderer || strcmp(entry->path, path) != 0)
+            continue;
+
+        // The load settings change the pixels, so each combination gets its own image
+        if(entry->premultiplied != _gpu_premultiply_on_load || entry->mipmapped != _gpu_mipmaps_on_load)
+            continue;
+        if(entry->mipmapped && entry->mipmap_filter != _gpu_mipmap_filter)
+            continue;
+
+        return entry;
+    }
+    return NULL;
+}
+
+static void gpu_add_cached_image(GPU_ImageCacheEntry* entry)
+{
+    GPU_ImageCacheEntry** bucket;
+
+    // Keep the load factor under 3/4
+    if(4*(_gpu_image_cache_size + 1) > 3*_gpu_image_cache_num_buckets)
+    {
+        unsigned int num_buckets = (_gpu_image_cache_num_buckets > 0? 2*_gpu_image_cache_num_buckets : GPU_IMAGE_CACHE_MIN_BUCKETS);
+        GPU_ImageCacheEntry** buckets = (GPU_ImageCacheEntry**)SDL_malloc(num_buckets * sizeof(GPU_ImageCacheEntry*));
+        unsigned int i;
+
+        memset(buckets, 0, num_buckets * sizeof(GPU_ImageCacheEntry*));
+        for(i = 0; i < _gpu_image_cache_num_buckets; ++i)
+        {
+            GPU_ImageCacheEntry* e = _gpu_image_cache[i];
+            while(e != NULL)
+            {
+                GPU_ImageCacheEntry* next = e->next;
+                e->next = buckets[e->hash & (num_buckets - 1)];
+                buckets[e->hash & (num_buckets - 1)] = e;
+                e = next;
+            }
+        }
+
+        SDL_free(_gpu_image_cache);
+        _gpu_image_cache = buckets;
+        _gpu_image_cache_num_buckets = num_buckets;
+    }
+
+    bucket = &_gpu_image_cache[entry->hash & (_gpu_image_cache_num_buckets - 1)];
+    entry->next = *bucket;
+    *bucket = entry;
+    _gpu_image_cache_size++;
+}
+
+static GPU_bool gpu_is_cached_image_unused(GPU_ImageCacheEntry* entry, Uint32 since_frame)
+{
+    return (entry->image->refcount <= 1 && entry->last_use_frame < since_frame);
+}
+
+// Releases the cache's reference to the matching images of the given renderer (or of all renderers if NULL).  Returns how many were removed.
+static int gpu_remove_cached_images(GPU_Renderer* renderer, Uint32 unused_since_frame, GPU_bool remove_all)
+{
+    int num_removed = 0;
+    unsigned int i;
+
+    for(i = 0; i < _gpu_image_cache_num_buckets; ++i)
+    {
+        GPU_ImageCacheEntry** link = &_gpu_image_cache[i];
+        while(*link != NULL)
+        {
+            GPU_ImageCacheEntry* entry = *link;
+            if((renderer == NULL || entry->image->renderer == renderer)
+               && (remove_all || gpu_is_cached_image_unused(entry, unused_since_frame)))
+            {
+                *link = entry->next;
+                entry->image->renderer->impl->FreeImage(entry->image->renderer, entry->image);
+                SDL_free(entry->path);
+                SDL_free(entry);
+                _gpu_image_cache_size--;
+                num_removed++;
+            }
+            else
+                link = &entry->next;
+        }
+    }
+
+    return num_removed;
+}
+
+static void gpu_free_image_cache(GPU_Renderer* renderer)
+{
+    gpu_remove_cached_images(renderer, 0, GPU_TRUE);
+
+    if(_gpu_image_cache_size == 0)
+    {
+        SDL_free(_gpu_image_cache);
+        _gpu_image_cache = NULL;
+        _gpu_image_cache_num_buckets = 0;
     }
-    
-    if(result != NULL && result->format->palette != NULL)
-    {
-        // SDL_CreateRGBSurface has no idea what palette to use, so it uses a blank one.
-        // We'll at least create a grayscale one, but it's not ideal...
-        // Better would be to get the palette from stbi, but stbi doesn't do that!
-        SDL_Color colors[256];
+}
 
-        for(i = 0; i < 256; i++)
+// Called once per GPU_Flip()
+static void gpu_update_image_cache(void)
+{
+    unsigned int i;
+    GPU_ImageCacheEntry* entry;
+
+    // Images that are held outside of the cache count as used
+    for(i = 0; i < _gpu_image_cache_num_buckets; ++i)
+    {
+        for(entry = _gpu_image_cache[i]; entry != NULL; entry = entry->next)
         {
-            colors[i].r = colors[i].g = colors[i].b = (Uint8)i;
+            if(entry->image->refcount > 1)
+                entry->last_use_frame = _gpu_frame_count;
         }
-
-        /* Set palette */
-#ifdef SDL_GPU_USE_SDL2
-        SDL_SetPaletteColors(result->format->palette, colors, 0, 256);
-#else
-        SDL_SetPalette(result, SDL_LOGPAL, colors, 0, 256);
-#endif
     }
-    
-    return result;
+
+    _gpu_frame_count++;
 }
 
-SDL_Surface* GPU_LoadSurface_RW(SDL_RWops* rwops, GPU_bool free_rwops)
+GPU_Image* GPU_LoadImageCached(const char* filename)
 {
-    int width, height, channels;
-    unsigned char* data;
-    SDL_Surface* result;
-    
-    int data_bytes;
-    unsigned char* c_data;
+    GPU_ImageCacheEntry* entry;
+    GPU_Image* image;
+    char* path;
+    Uint32 hash;
 
-    if(rwops == NULL)
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return NULL;
+
+    if(filename == NULL)
     {
-        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "rwops");
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "filename");
         return NULL;
     }
 
-    // Get count of bytes
-    SDL_RWseek(rwops, 0, SEEK_SET);
-    data_bytes = (int)SDL_RWseek(rwops, 0, SEEK_END);
-    SDL_RWseek(rwops, 0, SEEK_SET);
-    
-    // Read in the rwops data
-    c_data = (unsigned char*)SDL_malloc(data_bytes);
-    SDL_RWread(rwops, c_data, 1, data_bytes);
-    
-    // Load image
-    data = stbi_load_from_memory(c_data, data_bytes, &width, &height, &channels, 0);
-    
-    // Clean up temp data
-    SDL_free(c_data);
-    if(free_rwops)
-        SDL_RWclose(rwops);
+    path = gpu_normalize_path(filename);
+    hash = gpu_hash_string(path);
 
-    if(data == NULL)
+    entry = gpu_find_cached_image(path, hash);
+    if(entry != NULL)
+    {
+        SDL_free(path);
+        entry->image->refcount++;
+        entry->last_use_frame = _gpu_frame_count;
+        return entry->image;
+    }
+
+    image = GPU_LoadImage(filename);
+    if(image == NULL)
     {
-        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Failed to load from rwops: %s", stbi_failure_reason());
+        SDL_free(path);
         return NULL;
     }
 
-    // Copy into a surface
-    result = gpu_copy_raw_surface_data(data, width, height, channels);
+    entry = (GPU_ImageCacheEntry*)SDL_malloc(sizeof(GPU_ImageCacheEntry));
+    if(entry == NULL)
+    {
+        // The image still works, it just isn't shared
+        SDL_free(path);
+        return image;
+    }
+    entry->path = path;
+    entry->hash = hash;
+    entry->image = image;
+    entry->premultiplied = _gpu_premultiply_on_load;
+    entry->mipmapped = _gpu_mipmaps_on_load;
+    entry->mipmap_filter = _gpu_mipmap_filter;
+    entry->last_use_frame = _gpu_frame_count;
+    gpu_add_cached_image(entry);
 
-    stbi_image_free(data);
+    // One reference for the caller and one for the cache
+    image->refcount++;
+    return image;
+}
 
-    return result;
+Uint32 GPU_GetFrameCount(void)
+{
+    return _gpu_frame_count;
 }
 
-SDL_Surface* GPU_LoadSurface(const char* filename)
+int GPU_GetCachedImagesUnusedSince(Uint32 frame, const char** filenames, int max_filenames)
 {
-    return GPU_LoadSurface_RW(SDL_RWFromFile(filename, "r"), 1);
+    int num_unused = 0;
+    unsigned int i;
+    GPU_ImageCacheEntry* entry;
+
+    for(i = 0; i < _gpu_image_cache_num_buckets; ++i)
+    {
+        for(entry = _gpu_image_cache[i]; entry != NULL; entry = entry->next)
+        {
+            if(entry->image->renderer != _gpu_current_renderer || !gpu_is_cached_image_unused(entry, frame))
+                continue;
+
+            if(filenames != NULL && num_unused < max_filenames)
+                filenames[num_unused] = entry->path;
+            num_unused++;
+        }
+    }
+
+    return num_unused;
+}
+
+int GPU_PurgeCachedImagesUnusedSince(Uint32 frame)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    return gpu_remove_cached_images(_gpu_current_renderer, frame, GPU_FALSE);
+}
+
+int GPU_PurgeImageCache(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    return gpu_remove_cached_images(_gpu_current_renderer, 0xFFFFFFFF, GPU_FALSE);
 }
 
 // From http://stackoverflow.com/questions/5309471/getting-file-extension-in-c
@@ -1173,10 +2554,26 @@ static const char *get_filename_ext(const char *filename)
     return dot + 1;
 }
 
+static GPU_SaveOptions _gpu_save_options = {6, GPU_PNG_FILTER_ADAPTIVE, 0};
+
+void GPU_SetSaveOptions(GPU_SaveOptions options)
+{
+    if(options.compression_level < 0)
+        options.compression_level = 0;
+    if(options.compression_level > 9)
+        options.compression_level = 9;
+    _gpu_save_options = options;
+}
+
+GPU_SaveOptions GPU_GetSaveOptions(void)
+{
+    return _gpu_save_options;
+}
+
 GPU_bool GPU_SaveSurface(SDL_Surface* surface, const char* filename, GPU_FileFormatEnum format)
 {
     GPU_bool result;
-    unsigned char* data;
+    SDL_RWops* rwops;
 
     if(surface == NULL || filename == NULL ||
             surface->w < 1 || surface->h < 1)
@@ -1184,9 +2581,6 @@ GPU_bool GPU_SaveSurface(SDL_Surface* surface, const char* filename, GPU_FileFor
         return GPU_FALSE;
     }
 
-
-    data = surface->pixels;
-
     if(format == GPU_FILE_AUTO)
     {
         const char* extension = get_filename_ext(filename);
@@ -1206,32 +2600,29 @@ GPU_bool GPU_SaveSurface(SDL_Surface* surface, const char* filename, GPU_FileFor
     switch(format)
     {
     case GPU_FILE_PNG:
-        result = (stbi_write_png(filename, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data, 0) > 0);
-        break;
     case GPU_FILE_BMP:
-        result = (stbi_write_bmp(filename, surface->w, surface->h, surface->format->BytesPerPixel, (void*)data) > 0);
-        break;
     case GPU_FILE_TGA:
-        result = (stbi_write_tga(filename, surface->w, surface->h, surface->format->BytesPerPixel, (void*)data) > 0);
         break;
     default:
         GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Unsupported output file format");
-        result = GPU_FALSE;
-        break;
+        return GPU_FALSE;
     }
 
-    return result;
-}
+    // Every format goes through the buffered stream writers
+    rwops = SDL_RWFromFile(filename, "wb");
+    if(rwops == NULL)
+        return GPU_FALSE;
 
-static void write_func(void *context, void *data, int size)
-{
-    SDL_RWwrite((SDL_RWops*)context, data, 1, size);
+    result = GPU_SaveSurface_RW(surface, rwops, GPU_FALSE, format);
+    SDL_RWclose(rwops);
+    return result;
 }
 
 GPU_bool GPU_SaveSurface_RW(SDL_Surface* surface, SDL_RWops* rwops, GPU_bool free_rwops, GPU_FileFormatEnum format)
 {
     GPU_bool result;
     unsigned char* data;
+    GPU_WriteBuffer* buffer;
 
     if(surface == NULL || rwops == NULL ||
             surface->w < 1 || surface->h < 1)
@@ -1251,13 +2642,17 @@ GPU_bool GPU_SaveSurface_RW(SDL_Surface* surface, SDL_RWops* rwops, GPU_bool fre
     switch(format)
     {
     case GPU_FILE_PNG:
-        result = (stbi_write_png_to_func(write_func, rwops, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data, surface->pitch) > 0);
+        result = gpu_write_png(rwops, surface->w, surface->h, surface->format->BytesPerPixel, data, surface->pitch, &_gpu_save_options);
         break;
     case GPU_FILE_BMP:
-        result = (stbi_write_bmp_to_func(write_func, rwops, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data) > 0);
+        buffer = gpu_open_write_buffer(rwops);
+        result = (buffer != NULL && stbi_write_bmp_to_func(gpu_write_buffered, buffer, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data) > 0);
+        result = (gpu_close_write_buffer(buffer) && result);
         break;
     case GPU_FILE_TGA:
-        result = (stbi_write_tga_to_func(write_func, rwops, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data) > 0);
+        buffer = gpu_open_write_buffer(rwops);
+        result = (buffer != NULL && stbi_write_tga_to_func(gpu_write_buffered, buffer, surface->w, surface->h, surface->format->BytesPerPixel, (const unsigned char *const)data) > 0);
+        result = (gpu_close_write_buffer(buffer) && result);
         break;
     default:
         GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Unsupported output file format");
@@ -1300,6 +2695,17 @@ SDL_Surface* GPU_CopySurfaceFromTarget(GPU_Target* target)
     return _gpu_current_renderer->impl->CopySurfaceFromTarget(_gpu_current_renderer, target);
 }
 
+GPU_bool GPU_ReadTargetAsync(GPU_Target* target, const GPU_Rect* rect, GPU_ReadTargetCallback callback, void* userdata)
+{
+    if(_gpu_current_renderer == NULL)
+        return GPU_FALSE;
+    MAKE_CURRENT_IF_NONE(target);
+    if(_gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    return _gpu_current_renderer->impl->ReadTargetAsync(_gpu_current_renderer, target, rect, callback, userdata);
+}
+
 SDL_Surface* GPU_CopySurfaceFromImage(GPU_Image* image)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -1359,16 +2765,12 @@ void GPU_FreeTarget(GPU_Target* target)
 
 void GPU_Blit(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(image == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(image != NULL, GPU_ERROR_NULL_ARGUMENT, "image");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     _gpu_current_renderer->impl->Blit(_gpu_current_renderer, image, src_rect, target, x, y);
 }
@@ -1376,64 +2778,48 @@ void GPU_Blit(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x,
 
 void GPU_BlitRotate(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(image == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(image != NULL, GPU_ERROR_NULL_ARGUMENT, "image");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     _gpu_current_renderer->impl->BlitRotate(_gpu_current_renderer, image, src_rect, target, x, y, degrees);
 }
 
 void GPU_BlitScale(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float scaleX, float scaleY)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(image == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(image != NULL, GPU_ERROR_NULL_ARGUMENT, "image");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     _gpu_current_renderer->impl->BlitScale(_gpu_current_renderer, image, src_rect, target, x, y, scaleX, scaleY);
 }
 
 void GPU_BlitTransform(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees, float scaleX, float scaleY)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(image == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(image != NULL, GPU_ERROR_NULL_ARGUMENT, "image");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     _gpu_current_renderer->impl->BlitTransform(_gpu_current_renderer, image, src_rect, target, x, y, degrees, scaleX, scaleY);
 }
 
 void GPU_BlitTransformX(GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float pivot_x, float pivot_y, float degrees, float scaleX, float scaleY)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(image == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "image");
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(image != NULL, GPU_ERROR_NULL_ARGUMENT, "image");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     _gpu_current_renderer->impl->BlitTransformX(_gpu_current_renderer, image, src_rect, target, x, y, pivot_x, pivot_y, degrees, scaleX, scaleY);
 }
@@ -1532,14 +2918,11 @@ void GPU_PrimitiveBatch(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum
 
 void GPU_PrimitiveBatchV(GPU_Image* image, GPU_Target* target, GPU_PrimitiveEnum primitive_type, unsigned short num_vertices, void* values, unsigned int num_indices, unsigned short* indices, GPU_BatchFlagEnum flags)
 {
-    if(!CHECK_RENDERER)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+    CHECK_ARGUMENT(CHECK_RENDERER, GPU_ERROR_USER_ERROR, "NULL renderer");
     MAKE_CURRENT_IF_NONE(target);
-    if(!CHECK_CONTEXT)
-        RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
+    CHECK_ARGUMENT(CHECK_CONTEXT, GPU_ERROR_USER_ERROR, "NULL context");
 
-    if(target == NULL)
-        RETURN_ERROR(GPU_ERROR_NULL_ARGUMENT, "target");
+    CHECK_ARGUMENT(target != NULL, GPU_ERROR_NULL_ARGUMENT, "target");
 
     if(num_vertices == 0)
         return;
@@ -2015,6 +3398,26 @@ GPU_TextureHandle GPU_GetTextureHandle(GPU_Image* image)
     return image->renderer->impl->GetTextureHandle(image->renderer, image);
 }
 
+GPU_MemoryStats GPU_GetMemoryStats(void)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+    {
+        GPU_MemoryStats stats;
+        memset(&stats, 0, sizeof(GPU_MemoryStats));
+        return stats;
+    }
+
+    return _gpu_current_renderer->impl->GetMemoryStats(_gpu_current_renderer);
+}
+
+void GPU_SetTextureBudget(Uint64 max_bytes)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->SetTextureBudget(_gpu_current_renderer, max_bytes);
+}
+
 
 SDL_Color GPU_GetPixel(GPU_Target* target, Sint16 x, Sint16 y)
 {
@@ -2089,6 +3492,9 @@ void GPU_Flip(GPU_Target* target)
 {
     if(!CHECK_RENDERER)
         RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL renderer");
+
+    // Read the finished frame for GPU_StartCapture() before it is presented
+    gpu_capture_frame(target);
     
     if(target != NULL && target->context == NULL)
     {
@@ -2101,6 +3507,11 @@ void GPU_Flip(GPU_Target* target)
         RETURN_ERROR(GPU_ERROR_USER_ERROR, "NULL context");
 
     _gpu_current_renderer->impl->Flip(_gpu_current_renderer, target);
+
+    // Give images from GPU_LoadImageAsync() a slice of the next frame
+    gpu_pump_async_loads(_gpu_async_frame_budget_ms, _gpu_async_frame_budget_bytes);
+
+    gpu_update_image_cache();
 }
 
 
@@ -2150,6 +3561,39 @@ Uint32 GPU_CompileShader(GPU_ShaderEnum shader_type, const char* shader_source)
     return _gpu_current_renderer->impl->CompileShader(_gpu_current_renderer, shader_type, shader_source);
 }
 
+Uint32 GPU_CompileShaderWithDefines(GPU_ShaderEnum shader_type, const char* shader_source, const char** defines, int num_defines)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    if(shader_source == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "shader_source");
+        return 0;
+    }
+    if(defines == NULL && num_defines > 0)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "defines");
+        return 0;
+    }
+
+    return _gpu_current_renderer->impl->CompileShaderWithDefines(_gpu_current_renderer, shader_type, shader_source, defines, num_defines);
+}
+
+Uint32 GPU_CompileShaderAsync(GPU_ShaderEnum shader_type, const char* shader_source)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    if(shader_source == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "shader_source");
+        return 0;
+    }
+
+    return _gpu_current_renderer->impl->CompileShaderAsync(_gpu_current_renderer, shader_type, shader_source);
+}
+
 GPU_bool GPU_LinkShaderProgram(Uint32 program_object)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -2158,6 +3602,22 @@ GPU_bool GPU_LinkShaderProgram(Uint32 program_object)
     return _gpu_current_renderer->impl->LinkShaderProgram(_gpu_current_renderer, program_object);
 }
 
+GPU_bool GPU_LinkShaderProgramAsync(Uint32 program_object)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    return _gpu_current_renderer->impl->LinkShaderProgramAsync(_gpu_current_renderer, program_object);
+}
+
+GPU_ShaderStatusEnum GPU_GetShaderProgramStatus(Uint32 program_object)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_SHADER_STATUS_FAILED;
+
+    return _gpu_current_renderer->impl->GetShaderProgramStatus(_gpu_current_renderer, program_object);
+}
+
 Uint32 GPU_CreateShaderProgram(void)
 {
     if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
@@ -2229,6 +3689,30 @@ void GPU_DetachShader(Uint32 program_object, Uint32 shader_object)
     _gpu_current_renderer->impl->DetachShader(_gpu_current_renderer, program_object, shader_object);
 }
 
+void GPU_ClearShaderIncludeCache(void)
+{
+    gpu_clear_shader_include_cache();
+}
+
+static char* _gpu_shader_cache_directory = NULL;
+
+void GPU_SetShaderCacheDirectory(const char* directory)
+{
+    SDL_free(_gpu_shader_cache_directory);
+    _gpu_shader_cache_directory = NULL;
+
+    if(directory != NULL)
+    {
+        _gpu_shader_cache_directory = (char*)SDL_malloc(strlen(directory) + 1);
+        strcpy(_gpu_shader_cache_directory, directory);
+    }
+}
+
+const char* GPU_GetShaderCacheDirectory(void)
+{
+    return _gpu_shader_cache_directory;
+}
+
 GPU_bool GPU_IsDefaultShaderProgram(Uint32 program_object)
 {
     GPU_Context* context;
@@ -2495,6 +3979,69 @@ void GPU_SetAttributeSource(int num_values, GPU_Attribute source)
     _gpu_current_renderer->impl->SetAttributeSource(_gpu_current_renderer, num_values, source);
 }
 
+Uint32 GPU_CreateUniformBuffer(Uint32 size_bytes, const void* data)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return 0;
+
+    if(size_bytes == 0)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Uniform buffers need a size greater than 0");
+        return 0;
+    }
+
+    return _gpu_current_renderer->impl->CreateUniformBuffer(_gpu_current_renderer, size_bytes, data);
+}
+
+void GPU_UpdateUniformBuffer(Uint32 buffer, Uint32 offset_bytes, Uint32 size_bytes, const void* data)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    if(data == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "data");
+        return;
+    }
+    if(buffer == 0 || size_bytes == 0)
+        return;
+
+    _gpu_current_renderer->impl->UpdateUniformBuffer(_gpu_current_renderer, buffer, offset_bytes, size_bytes, data);
+}
+
+void GPU_BindUniformBuffer(Uint32 buffer, Uint32 binding_point)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    _gpu_current_renderer->impl->BindUniformBuffer(_gpu_current_renderer, buffer, binding_point);
+}
+
+GPU_bool GPU_SetUniformBlockBinding(Uint32 program_object, const char* block_name, Uint32 binding_point)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return GPU_FALSE;
+
+    if(block_name == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "block_name");
+        return GPU_FALSE;
+    }
+
+    return _gpu_current_renderer->impl->SetUniformBlockBinding(_gpu_current_renderer, program_object, block_name, binding_point);
+}
+
+void GPU_FreeUniformBuffer(Uint32 buffer)
+{
+    if(_gpu_current_renderer == NULL || _gpu_current_renderer->current_context_target == NULL)
+        return;
+
+    if(buffer == 0)
+        return;
+
+    _gpu_current_renderer->impl->FreeUniformBuffer(_gpu_current_renderer, buffer);
+}
+
 
 
 
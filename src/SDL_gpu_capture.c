@@ -0,0 +1,646 @@
+#include "SDL_gpu.h"
+#include "stb_image_write.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+#define __func__ __FUNCTION__
+#endif
+
+// Continuous recording of a target for GPU_StartCapture().
+// GPU_Flip() requests a GPU_ReadTargetAsync() of the target each frame.  When the pixels arrive, the frame joins a queue that the capture's encoder threads drain.
+// Image formats are encoded independently.  Stream formats are converted in parallel, then written strictly in frame order.
+
+#define GPU_CAPTURE_MAX_THREADS 8
+#define GPU_CAPTURE_PATH_MAX 1024
+
+typedef struct GPU_WriteBuffer GPU_WriteBuffer;
+GPU_WriteBuffer* gpu_open_write_buffer(SDL_RWops* rwops);
+void gpu_write_buffered(void* context, void* data, int size);
+GPU_bool gpu_close_write_buffer(GPU_WriteBuffer* buffer);
+GPU_bool gpu_write_png(SDL_RWops* rwops, int w, int h, int comp, const unsigned char* pixels, int pitch, const GPU_SaveOptions* options);
+
+/*! A frame that has been read back and waits for an encoder thread */
+typedef struct GPU_CaptureFrame
+{
+    SDL_Surface* surface;  // NULL if the readback failed
+    int index;
+    struct GPU_CaptureFrame* next;
+} GPU_CaptureFrame;
+
+struct GPU_Capture
+{
+    GPU_Target* target;
+    GPU_CaptureFormatEnum format;
+    GPU_CapturePolicyEnum policy;
+    int max_queued_frames;
+    Uint16 w, h;  // Every frame is read at the size the target had at the start
+    GPU_SaveOptions save_options;  // One thread per frame, as the encoder threads already run in parallel
+    char* path;
+    SDL_RWops* stream;  // Output of GPU_CAPTURE_Y4M and GPU_CAPTURE_RAW
+
+    SDL_mutex* mutex;
+    SDL_cond* cond;  // Broadcast whenever a frame is queued, encoded or written
+    SDL_Thread* threads[GPU_CAPTURE_MAX_THREADS];
+    int num_threads;
+    GPU_CaptureFrame* queue_first;
+    GPU_CaptureFrame* queue_last;
+    int num_queued;  // Queued or being encoded
+    int next_write;  // The next stream frame to be written
+    int num_written;
+    int num_dropped;
+    int num_failed;
+    GPU_bool quit;
+
+    // Only used on the rendering thread
+    int num_reading;
+    int next_index;
+    GPU_bool stopped;
+    struct GPU_Capture* next;
+};
+
+static GPU_Capture* _gpu_captures = NULL;
+
+static GPU_CapturePolicyEnum _gpu_capture_policy = GPU_CAPTURE_DROP_FRAMES;
+static int _gpu_capture_max_queued_frames = 8;
+static int _gpu_capture_num_threads = 0;
+static int _gpu_capture_frame_rate = 60;
+
+
+static void gpu_put_u32_be(unsigned char* p, Uint32 value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+// Encodes RGBA pixels as QOI (https://qoiformat.org), which compresses screen content well at a fraction of the cost of PNG
+static unsigned char* gpu_encode_qoi(const unsigned char* pixels, int w, int h, int pitch, int* size)
+{
+    unsigned char index[64][4];
+    unsigned char prev[4] = {0, 0, 0, 255};
+    unsigned char* result;
+    unsigned char* out;
+    int run = 0;
+    int x, y;
+
+    result = (unsigned char*)SDL_malloc(14 + w*h*5 + 8);
+    if(result == NULL)
+        return NULL;
+    memset(index, 0, sizeof(index));
+
+    out = result;
+    memcpy(out, "qoif", 4);
+    gpu_put_u32_be(out + 4, w);
+    gpu_put_u32_be(out + 8, h);
+    out[12] = 4;  // RGBA
+    out[13] = 0;  // sRGB with linear alpha
+    out += 14;
+
+    for(y = 0; y < h; ++y)
+    {
+        const unsigned char* px = pixels + y*pitch;
+        for(x = 0; x < w; ++x, px += 4)
+        {
+            GPU_bool last = (x == w - 1 && y == h - 1);
+            int hash;
+
+            if(memcmp(px, prev, 4) == 0)
+            {
+                run++;
+                if(run == 62 || last)
+                {
+                    *out++ = (unsigned char)(0xC0 | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if(run > 0)
+            {
+                *out++ = (unsigned char)(0xC0 | (run - 1));
+                run = 0;
+            }
+
+            hash = (px[0]*3 + px[1]*5 + px[2]*7 + px[3]*11) % 64;
+            if(memcmp(index[hash], px, 4) == 0)
+                *out++ = (unsigned char)hash;
+            else
+            {
+                memcpy(index[hash], px, 4);
+
+                if(px[3] == prev[3])
+                {
+                    signed char dr = (signed char)(px[0] - prev[0]);
+                    signed char dg = (signed char)(px[1] - prev[1]);
+                    signed char db = (signed char)(px[2] - prev[2]);
+                    signed char dr_dg = (signed char)(dr - dg);
+                    signed char db_dg = (signed char)(db - dg);
+
+                    if(dr > -3 && dr < 2 && dg > -3 && dg < 2 && db > -3 && db < 2)
+                        *out++ = (unsigned char)(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    else if(dr_dg > -9 && dr_dg < 8 && dg > -33 && dg < 32 && db_dg > -9 && db_dg < 8)
+                    {
+                        *out++ = (unsigned char)(0x80 | (dg + 32));
+                        *out++ = (unsigned char)((dr_dg + 8) << 4 | (db_dg + 8));
+                    }
+                    else
+                    {
+                        *out++ = 0xFE;
+                        *out++ = px[0];
+                        *out++ = px[1];
+                        *out++ = px[2];
+                    }
+                }
+                else
+                {
+                    *out++ = 0xFF;
+                    memcpy(out, px, 4);
+                    out += 4;
+                }
+            }
+
+            memcpy(prev, px, 4);
+        }
+    }
+
+    // End marker
+    memset(out, 0, 7);
+    out[7] = 1;
+    out += 8;
+
+    *size = (int)(out - result);
+    return result;
+}
+
+// Converts RGBA pixels to 4:2:0 planes with BT.601 studio range, the usual Y4M interpretation
+static void gpu_convert_to_i420(const unsigned char* pixels, int w, int h, int pitch, unsigned char* y_plane, unsigned char* u_plane, unsigned char* v_plane)
+{
+    int chroma_w = (w + 1)/2;
+    int x, y;
+
+    for(y = 0; y < h; ++y)
+    {
+        const unsigned char* px = pixels + y*pitch;
+        unsigned char* luma = y_plane + y*w;
+        for(x = 0; x < w; ++x, px += 4)
+            luma[x] = (unsigned char)(16 + ((66*px[0] + 129*px[1] + 25*px[2] + 128) >> 8));
+    }
+
+    // Average each 2x2 block for chroma
+    for(y = 0; y < h; y += 2)
+    {
+        const unsigned char* row0 = pixels + y*pitch;
+        const unsigned char* row1 = (y + 1 < h? row0 + pitch : row0);
+        for(x = 0; x < w; x += 2)
+        {
+            int x1 = (x + 1 < w? x + 1 : x);
+            int r = row0[x*4] + row0[x1*4] + row1[x*4] + row1[x1*4];
+            int g = row0[x*4 + 1] + row0[x1*4 + 1] + row1[x*4 + 1] + row1[x1*4 + 1];
+            int b = row0[x*4 + 2] + row0[x1*4 + 2] + row1[x*4 + 2] + row1[x1*4 + 2];
+            int i = (y/2)*chroma_w + x/2;
+
+            u_plane[i] = (unsigned char)(128 + ((-38*r - 74*g + 112*b + 512) >> 10));
+            v_plane[i] = (unsigned char)(128 + ((112*r - 94*g - 18*b + 512) >> 10));
+        }
+    }
+}
+
+// Writes a stream frame once all earlier frames are written.  A NULL 'data' just gives up the frame's turn.
+static GPU_bool gpu_write_stream_frame(GPU_Capture* capture, int index, const char* header, const unsigned char* data, int size)
+{
+    GPU_bool result = GPU_TRUE;
+
+    SDL_LockMutex(capture->mutex);
+    while(capture->next_write != index)
+        SDL_CondWait(capture->cond, capture->mutex);
+    SDL_UnlockMutex(capture->mutex);
+
+    // Only this thread can write until next_write moves on
+    if(data != NULL)
+    {
+        if(header != NULL)
+            result = (SDL_RWwrite(capture->stream, header, strlen(header), 1) == 1);
+        if(result)
+            result = (SDL_RWwrite(capture->stream, data, size, 1) == 1);
+    }
+
+    SDL_LockMutex(capture->mutex);
+    capture->next_write++;
+    SDL_CondBroadcast(capture->cond);
+    SDL_UnlockMutex(capture->mutex);
+
+    return (result && data != NULL);
+}
+
+static GPU_bool gpu_encode_capture_frame(GPU_Capture* capture, GPU_CaptureFrame* frame)
+{
+    SDL_Surface* surface = frame->surface;
+    GPU_bool result = GPU_FALSE;
+
+    if(capture->format == GPU_CAPTURE_Y4M || capture->format == GPU_CAPTURE_RAW)
+    {
+        unsigned char* data = NULL;
+        int size = 0;
+
+        // Never write a frame that does not match the stream's size
+        if(surface != NULL && (surface->w != capture->w || surface->h != capture->h))
+            surface = NULL;
+
+        if(surface != NULL)
+        {
+            if(capture->format == GPU_CAPTURE_Y4M)
+            {
+                int luma_size = surface->w*surface->h;
+                int chroma_size = ((surface->w + 1)/2)*((surface->h + 1)/2);
+                size = luma_size + 2*chroma_size;
+                data = (unsigned char*)SDL_malloc(size);
+                if(data != NULL)
+                    gpu_convert_to_i420((const unsigned char*)surface->pixels, surface->w, surface->h, surface->pitch, data, data + luma_size, data + luma_size + chroma_size);
+            }
+            else if(surface->pitch == surface->w*4)
+                data = (unsigned char*)surface->pixels;
+            else
+            {
+                int y;
+                data = (unsigned char*)SDL_malloc(surface->w*surface->h*4);
+                if(data != NULL)
+                {
+                    for(y = 0; y < surface->h; ++y)
+                        memcpy(data + y*surface->w*4, (unsigned char*)surface->pixels + y*surface->pitch, surface->w*4);
+                }
+            }
+            if(capture->format == GPU_CAPTURE_RAW)
+                size = surface->w*surface->h*4;
+        }
+
+        result = gpu_write_stream_frame(capture, frame->index, (capture->format == GPU_CAPTURE_Y4M? "FRAME\n" : NULL), data, size);
+
+        if(surface != NULL && data != surface->pixels)
+            SDL_free(data);
+        return result;
+    }
+
+    if(surface != NULL)
+    {
+        char path[GPU_CAPTURE_PATH_MAX];
+        SDL_RWops* rwops;
+        GPU_WriteBuffer* buffer;
+
+        SDL_snprintf(path, GPU_CAPTURE_PATH_MAX, capture->path, frame->index);
+        rwops = SDL_RWFromFile(path, "wb");
+        if(rwops == NULL)
+            return GPU_FALSE;
+
+        switch(capture->format)
+        {
+        case GPU_CAPTURE_PNG:
+            result = gpu_write_png(rwops, surface->w, surface->h, 4, (const unsigned char*)surface->pixels, surface->pitch, &capture->save_options);
+            break;
+        case GPU_CAPTURE_BMP:
+            buffer = gpu_open_write_buffer(rwops);
+            result = (buffer != NULL && stbi_write_bmp_to_func(gpu_write_buffered, buffer, surface->w, surface->h, 4, surface->pixels) > 0);
+            result = (gpu_close_write_buffer(buffer) && result);
+            break;
+        case GPU_CAPTURE_TGA:
+            buffer = gpu_open_write_buffer(rwops);
+            result = (buffer != NULL && stbi_write_tga_to_func(gpu_write_buffered, buffer, surface->w, surface->h, 4, surface->pixels) > 0);
+            result = (gpu_close_write_buffer(buffer) && result);
+            break;
+        case GPU_CAPTURE_QOI:
+            {
+                int size;
+                unsigned char* data = gpu_encode_qoi((const unsigned char*)surface->pixels, surface->w, surface->h, surface->pitch, &size);
+                result = (data != NULL && SDL_RWwrite(rwops, data, size, 1) == 1);
+                SDL_free(data);
+            }
+            break;
+        default:
+            break;
+        }
+
+        SDL_RWclose(rwops);
+    }
+
+    return result;
+}
+
+// Encodes queued frames until the capture is finished and its queue is empty.  Errors are counted here and reported on the rendering thread.
+static int SDLCALL gpu_capture_worker(void* data)
+{
+    GPU_Capture* capture = (GPU_Capture*)data;
+
+    SDL_LockMutex(capture->mutex);
+    while(1)
+    {
+        GPU_CaptureFrame* frame = capture->queue_first;
+        GPU_bool written;
+
+        if(frame == NULL)
+        {
+            if(capture->quit)
+                break;
+            SDL_CondWait(capture->cond, capture->mutex);
+            continue;
+        }
+
+        capture->queue_first = frame->next;
+        if(capture->queue_first == NULL)
+            capture->queue_last = NULL;
+        SDL_UnlockMutex(capture->mutex);
+
+        written = gpu_encode_capture_frame(capture, frame);
+        SDL_FreeSurface(frame->surface);
+        SDL_free(frame);
+
+        SDL_LockMutex(capture->mutex);
+        capture->num_queued--;
+        if(written)
+            capture->num_written++;
+        else
+            capture->num_failed++;
+        SDL_CondBroadcast(capture->cond);
+    }
+    SDL_UnlockMutex(capture->mutex);
+
+    return 0;
+}
+
+// Joins the encoder threads once they have drained the queue, then frees the capture
+static void gpu_finish_capture(GPU_Capture* capture)
+{
+    int i;
+
+    SDL_LockMutex(capture->mutex);
+    capture->quit = GPU_TRUE;
+    SDL_CondBroadcast(capture->cond);
+    SDL_UnlockMutex(capture->mutex);
+
+    for(i = 0; i < capture->num_threads; ++i)
+    {
+        SDL_WaitThread(capture->threads[i], NULL);
+    }
+
+    if(capture->stream != NULL)
+        SDL_RWclose(capture->stream);
+
+    if(capture->num_failed > 0)
+        GPU_PushErrorCode("GPU_StopCapture", GPU_ERROR_BACKEND_ERROR, "%d frame(s) of \"%s\" could not be written", capture->num_failed, capture->path);
+
+    SDL_DestroyCond(capture->cond);
+    SDL_DestroyMutex(capture->mutex);
+    SDL_free(capture->path);
+    SDL_free(capture);
+}
+
+static void SDLCALL gpu_capture_read_done(GPU_Target* target, SDL_Surface* surface, void* userdata)
+{
+    GPU_Capture* capture = (GPU_Capture*)userdata;
+    GPU_CaptureFrame* frame;
+    (void)target;
+
+    capture->num_reading--;
+
+    // Reads complete in order, so numbering them here keeps the sequence
+    frame = (GPU_CaptureFrame*)SDL_malloc(sizeof(GPU_CaptureFrame));
+    frame->surface = surface;
+    frame->index = capture->next_index++;
+    frame->next = NULL;
+
+    SDL_LockMutex(capture->mutex);
+    if(capture->queue_last != NULL)
+        capture->queue_last->next = frame;
+    else
+        capture->queue_first = frame;
+    capture->queue_last = frame;
+    SDL_CondBroadcast(capture->cond);
+    SDL_UnlockMutex(capture->mutex);
+
+    // A stopped capture ends when its last frame has arrived
+    if(capture->stopped && capture->num_reading == 0)
+        gpu_finish_capture(capture);
+}
+
+// Called by GPU_Flip() before the target is presented
+void gpu_capture_frame(GPU_Target* target)
+{
+    GPU_Capture* capture;
+    GPU_Capture* next;
+
+    for(capture = _gpu_captures; capture != NULL; capture = next)
+    {
+        GPU_Rect rect;
+        GPU_bool accept;
+
+        next = capture->next;
+        if(capture->target != target)
+            continue;
+
+        // The stream header fixes the frame size, so a resized target ends the stream
+        if((capture->format == GPU_CAPTURE_Y4M || capture->format == GPU_CAPTURE_RAW) && (target->base_w != capture->w || target->base_h != capture->h))
+        {
+            GPU_PushErrorCode("GPU_Flip", GPU_ERROR_USER_ERROR, "Capture of \"%s\" stopped: the target was resized from %dx%d to %dx%d", capture->path, capture->w, capture->h, target->base_w, target->base_h);
+            GPU_StopCapture(capture);
+            continue;
+        }
+
+        SDL_LockMutex(capture->mutex);
+        if(capture->policy == GPU_CAPTURE_WAIT)
+        {
+            // Only wait for frames the encoders already have.  Frames still being read back are handed over by a later GPU_Flip() on this thread, and the readback ring bounds them.
+            while(capture->num_queued - capture->num_reading >= capture->max_queued_frames)
+                SDL_CondWait(capture->cond, capture->mutex);
+            accept = GPU_TRUE;
+        }
+        else
+            accept = (capture->num_queued < capture->max_queued_frames);  // Counts the frames still being read back
+
+        if(accept)
+            capture->num_queued++;
+        else
+            capture->num_dropped++;
+        SDL_UnlockMutex(capture->mutex);
+
+        if(!accept)
+            continue;
+
+        rect = GPU_MakeRect(0, 0, capture->w, capture->h);
+        if(GPU_ReadTargetAsync(target, &rect, &gpu_capture_read_done, capture))
+            capture->num_reading++;
+        else
+        {
+            SDL_LockMutex(capture->mutex);
+            capture->num_queued--;
+            capture->num_dropped++;
+            SDL_UnlockMutex(capture->mutex);
+        }
+    }
+}
+
+// The pattern becomes a format string, so it may only hold one integer conversion (%d with optional flags and width) besides %% escapes
+static GPU_bool gpu_is_valid_capture_pattern(const char* pattern)
+{
+    int num_conversions = 0;
+    const char* c;
+
+    for(c = pattern; *c != '\0'; c++)
+    {
+        if(*c != '%')
+            continue;
+        c++;
+        if(*c == '%')
+            continue;
+
+        while(*c == '-' || *c == '+' || *c == ' ' || *c == '0' || *c == '#')
+            c++;
+        while(*c >= '0' && *c <= '9')
+            c++;
+        if(*c != 'd' || ++num_conversions > 1)
+            return GPU_FALSE;
+    }
+    return GPU_TRUE;
+}
+
+void gpu_free_captures(void)
+{
+    while(_gpu_captures != NULL)
+        GPU_StopCapture(_gpu_captures);
+}
+
+GPU_Capture* GPU_StartCapture(GPU_Target* target, GPU_CaptureFormatEnum format, const char* path_pattern)
+{
+    GPU_Capture* capture;
+    int i, num_threads;
+
+    if(target == NULL || path_pattern == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "%s", (target == NULL? "target" : "path_pattern"));
+        return NULL;
+    }
+    if(format < GPU_CAPTURE_PNG || format > GPU_CAPTURE_RAW)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Unsupported capture format (%d)", format);
+        return NULL;
+    }
+    if(format != GPU_CAPTURE_Y4M && format != GPU_CAPTURE_RAW && !gpu_is_valid_capture_pattern(path_pattern))
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Invalid path pattern \"%s\" (expected at most one %%d)", path_pattern);
+        return NULL;
+    }
+
+    capture = (GPU_Capture*)SDL_malloc(sizeof(GPU_Capture));
+    memset(capture, 0, sizeof(GPU_Capture));
+    capture->target = target;
+    capture->format = format;
+    capture->policy = _gpu_capture_policy;
+    capture->max_queued_frames = _gpu_capture_max_queued_frames;
+    capture->save_options = GPU_GetSaveOptions();
+    capture->save_options.num_threads = 1;
+    capture->w = target->base_w;
+    capture->h = target->base_h;
+    capture->path = (char*)SDL_malloc(strlen(path_pattern) + 1);
+    strcpy(capture->path, path_pattern);
+
+    if(format == GPU_CAPTURE_Y4M || format == GPU_CAPTURE_RAW)
+    {
+        capture->stream = SDL_RWFromFile(path_pattern, "wb");
+        if(capture->stream == NULL)
+        {
+            GPU_PushErrorCode(__func__, GPU_ERROR_FILE_NOT_FOUND, "Failed to open \"%s\" for writing", path_pattern);
+            SDL_free(capture->path);
+            SDL_free(capture);
+            return NULL;
+        }
+
+        if(format == GPU_CAPTURE_Y4M)
+        {
+            char header[128];
+            SDL_snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", capture->w, capture->h, _gpu_capture_frame_rate);
+            SDL_RWwrite(capture->stream, header, strlen(header), 1);
+        }
+    }
+
+    capture->mutex = SDL_CreateMutex();
+    capture->cond = SDL_CreateCond();
+
+    num_threads = _gpu_capture_num_threads;
+    if(num_threads <= 0)
+    {
+        // Leave a core for the rendering thread
+        #ifdef SDL_GPU_USE_SDL2
+        num_threads = SDL_GetCPUCount() - 1;
+        #else
+        num_threads = 2;
+        #endif
+    }
+    if(num_threads < 1)
+        num_threads = 1;
+    if(num_threads > GPU_CAPTURE_MAX_THREADS)
+        num_threads = GPU_CAPTURE_MAX_THREADS;
+
+    for(i = 0; i < num_threads; ++i)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        SDL_Thread* thread = SDL_CreateThread(&gpu_capture_worker, "GPU_StartCapture", capture);
+        #else
+        SDL_Thread* thread = SDL_CreateThread(&gpu_capture_worker, capture);
+        #endif
+        if(thread == NULL)
+            break;
+        capture->threads[capture->num_threads++] = thread;
+    }
+
+    if(capture->mutex == NULL || capture->cond == NULL || capture->num_threads == 0)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_BACKEND_ERROR, "Failed to start encoder threads");
+        gpu_finish_capture(capture);
+        return NULL;
+    }
+
+    capture->next = _gpu_captures;
+    _gpu_captures = capture;
+    return capture;
+}
+
+void GPU_StopCapture(GPU_Capture* capture)
+{
+    GPU_Capture** link;
+
+    if(capture == NULL)
+        return;
+
+    for(link = &_gpu_captures; *link != NULL; link = &(*link)->next)
+    {
+        if(*link == capture)
+        {
+            *link = capture->next;
+            break;
+        }
+    }
+
+    // Frames that are still being read back finish in a later GPU_Flip()
+    capture->stopped = GPU_TRUE;
+    if(capture->num_reading == 0)
+        gpu_finish_capture(capture);
+}
+
+void GPU_SetCaptureOptions(GPU_CapturePolicyEnum policy, int max_queued_frames, int num_threads, int frame_rate)
+{
+    _gpu_capture_policy = policy;
+    _gpu_capture_max_queued_frames = (max_queued_frames > 0? max_queued_frames : 1);
+    _gpu_capture_num_threads = num_threads;
+    _gpu_capture_frame_rate = (frame_rate > 0? frame_rate : 60);
+}
+
+void GPU_GetCaptureFrameCounts(GPU_Capture* capture, int* num_written, int* num_dropped)
+{
+    if(capture == NULL)
+        return;
+
+    SDL_LockMutex(capture->mutex);
+    if(num_written != NULL)
+        *num_written = capture->num_written;
+    if(num_dropped != NULL)
+        *num_dropped = capture->num_dropped;
+    SDL_UnlockMutex(capture->mutex);
+}
@@ -0,0 +1,836 @@
+#include "SDL_gpu.h"
+#include "SDL_gpu_RendererImpl.h"
+#include <string.h>
+
+// Visual C does not support static inline
+#ifndef static_inline
+	#ifdef _MSC_VER
+		#define static_inline static
+	#else
+		#define static_inline static inline
+	#endif
+#endif
+
+// Loading of block-compressed textures from KTX, KTX2 and DDS containers.
+// The level data is never copied: it is handed to the renderer straight out of the file buffer.
+// When the renderer lacks a format, BC1-BC3 and ETC2 blocks are decoded here and uploaded as RGBA.
+
+#define GPU_COMPRESSED_MAX_LEVELS 16
+
+#define GPU_FOURCC(a, b, c, d) ((Uint32)(a) | ((Uint32)(b) << 8) | ((Uint32)(c) << 16) | ((Uint32)(d) << 24))
+
+/*! A parsed container.  Level pointers point into the file data. */
+typedef struct GPU_CompressedTexture
+{
+    GPU_FormatEnum format;
+    Uint32 w, h;
+    int num_levels;
+    const unsigned char* level_data[GPU_COMPRESSED_MAX_LEVELS];
+    unsigned int level_sizes[GPU_COMPRESSED_MAX_LEVELS];
+} GPU_CompressedTexture;
+
+static const unsigned char ktx1_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+static const unsigned char ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+
+static Uint32 read_u32(const unsigned char* p, GPU_bool swap)
+{
+    if(swap)
+        return ((Uint32)p[0] << 24) | ((Uint32)p[1] << 16) | ((Uint32)p[2] << 8) | (Uint32)p[3];
+    return (Uint32)p[0] | ((Uint32)p[1] << 8) | ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+// Only the low 32 bits of the 64-bit KTX2 offsets are used.  Returns GPU_FALSE if the high bits are set.
+static GPU_bool read_u64_low(const unsigned char* p, Uint32* result)
+{
+    *result = read_u32(p, GPU_FALSE);
+    return (read_u32(p + 4, GPU_FALSE) == 0);
+}
+
+static unsigned int get_block_bytes(GPU_FormatEnum format)
+{
+    switch(format)
+    {
+        case GPU_FORMAT_BC1:
+        case GPU_FORMAT_ETC2_RGB8:
+            return 8;
+        case GPU_FORMAT_BC2:
+        case GPU_FORMAT_BC3:
+        case GPU_FORMAT_ETC2_RGBA8:
+        case GPU_FORMAT_ASTC_4x4:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+// All of the supported formats use 4x4 texel blocks.
+static unsigned int get_level_size(GPU_FormatEnum format, Uint32 w, Uint32 h)
+{
+    return ((w + 3)/4) * ((h + 3)/4) * get_block_bytes(format);
+}
+
+static GPU_FeatureEnum get_format_feature(GPU_FormatEnum format)
+{
+    switch(format)
+    {
+        case GPU_FORMAT_BC1:
+        case GPU_FORMAT_BC2:
+        case GPU_FORMAT_BC3:
+            return GPU_FEATURE_TEXTURE_COMPRESSION_S3TC;
+        case GPU_FORMAT_ETC2_RGB8:
+        case GPU_FORMAT_ETC2_RGBA8:
+            return GPU_FEATURE_TEXTURE_COMPRESSION_ETC2;
+        case GPU_FORMAT_ASTC_4x4:
+            return GPU_FEATURE_TEXTURE_COMPRESSION_ASTC;
+        default:
+            return 0;
+    }
+}
+
+// sRGB variants map to the same format.  SDL_gpu does not track color spaces, so they are sampled as linear data.
+static GPU_FormatEnum get_format_from_gl(Uint32 internal_format)
+{
+    switch(internal_format)
+    {
+        case 0x83F0:  // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+        case 0x83F1:  // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        case 0x8C4C:  // GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+        case 0x8C4D:  // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+            return GPU_FORMAT_BC1;
+        case 0x83F2:  // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+        case 0x8C4E:  // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+            return GPU_FORMAT_BC2;
+        case 0x83F3:  // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        case 0x8C4F:  // GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+            return GPU_FORMAT_BC3;
+        case 0x8D64:  // GL_ETC1_RGB8_OES (a subset of ETC2)
+        case 0x9274:  // GL_COMPRESSED_RGB8_ETC2
+        case 0x9275:  // GL_COMPRESSED_SRGB8_ETC2
+            return GPU_FORMAT_ETC2_RGB8;
+        case 0x9278:  // GL_COMPRESSED_RGBA8_ETC2_EAC
+        case 0x9279:  // GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC
+            return GPU_FORMAT_ETC2_RGBA8;
+        case 0x93B0:  // GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+        case 0x93D0:  // GL_COMPRESSED_SRGB8_ALPHA8_ASTC_4x4_KHR
+            return GPU_FORMAT_ASTC_4x4;
+        default:
+            return 0;
+    }
+}
+
+static GPU_FormatEnum get_format_from_vulkan(Uint32 vk_format)
+{
+    switch(vk_format)
+    {
+        case 131:  // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+        case 132:  // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+        case 133:  // VK_FORMAT_BC1_RGBA_UNORM_BLOCK
+        case 134:  // VK_FORMAT_BC1_RGBA_SRGB_BLOCK
+            return GPU_FORMAT_BC1;
+        case 135:  // VK_FORMAT_BC2_UNORM_BLOCK
+        case 136:  // VK_FORMAT_BC2_SRGB_BLOCK
+            return GPU_FORMAT_BC2;
+        case 137:  // VK_FORMAT_BC3_UNORM_BLOCK
+        case 138:  // VK_FORMAT_BC3_SRGB_BLOCK
+            return GPU_FORMAT_BC3;
+        case 147:  // VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK
+        case 148:  // VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK
+            return GPU_FORMAT_ETC2_RGB8;
+        case 151:  // VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK
+        case 152:  // VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK
+            return GPU_FORMAT_ETC2_RGBA8;
+        case 157:  // VK_FORMAT_ASTC_4x4_UNORM_BLOCK
+        case 158:  // VK_FORMAT_ASTC_4x4_SRGB_BLOCK
+            return GPU_FORMAT_ASTC_4x4;
+        default:
+            return 0;
+    }
+}
+
+static GPU_FormatEnum get_format_from_dxgi(Uint32 dxgi_format)
+{
+    switch(dxgi_format)
+    {
+        case 71:  // DXGI_FORMAT_BC1_UNORM
+        case 72:  // DXGI_FORMAT_BC1_UNORM_SRGB
+            return GPU_FORMAT_BC1;
+        case 74:  // DXGI_FORMAT_BC2_UNORM
+        case 75:  // DXGI_FORMAT_BC2_UNORM_SRGB
+            return GPU_FORMAT_BC2;
+        case 77:  // DXGI_FORMAT_BC3_UNORM
+        case 78:  // DXGI_FORMAT_BC3_UNORM_SRGB
+            return GPU_FORMAT_BC3;
+        default:
+            return 0;
+    }
+}
+
+// Checks the size and format of the parsed header before the levels are located.
+static GPU_bool check_texture_header(GPU_CompressedTexture* tex, const char* container)
+{
+    if(tex->format == 0)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Unsupported %s texture format", container);
+        return GPU_FALSE;
+    }
+    if(tex->w == 0 || tex->h == 0 || tex->w > 65535 || tex->h > 65535)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Invalid %s texture size (%ux%u)", container, tex->w, tex->h);
+        return GPU_FALSE;
+    }
+    if(tex->num_levels < 1)
+        tex->num_levels = 1;
+    if(tex->num_levels > GPU_COMPRESSED_MAX_LEVELS)
+        tex->num_levels = GPU_COMPRESSED_MAX_LEVELS;
+    return GPU_TRUE;
+}
+
+// Records one mipmap level, making sure it lies inside the file.
+static GPU_bool set_texture_level(GPU_CompressedTexture* tex, int level, const unsigned char* data, int data_bytes, Uint32 offset, Uint32 size)
+{
+    Uint32 w = tex->w >> level;
+    Uint32 h = tex->h >> level;
+    Uint32 expected = get_level_size(tex->format, (w > 0? w : 1), (h > 0? h : 1));
+
+    if(size < expected || offset > (Uint32)data_bytes || expected > (Uint32)data_bytes - offset)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Texture data for mipmap level %d is truncated", level);
+        return GPU_FALSE;
+    }
+    tex->level_data[level] = data + offset;
+    tex->level_sizes[level] = expected;
+    return GPU_TRUE;
+}
+
+static GPU_bool parse_ktx1(const unsigned char* data, int data_bytes, GPU_CompressedTexture* tex)
+{
+    GPU_bool swap;
+    Uint32 offset, size;
+    int i;
+
+    if(data_bytes < 64)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX header is truncated");
+        return GPU_FALSE;
+    }
+
+    // The endianness field reads as 0x04030201 in the writer's byte order
+    swap = (read_u32(data + 12, GPU_FALSE) != 0x04030201);
+
+    // Only compressed (glType 0), 2D, single-face textures
+    if(read_u32(data + 16, swap) != 0 || read_u32(data + 44, swap) > 1 || read_u32(data + 48, swap) > 1 || read_u32(data + 52, swap) != 1)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Only compressed 2D KTX textures are supported");
+        return GPU_FALSE;
+    }
+
+    tex->format = get_format_from_gl(read_u32(data + 28, swap));
+    tex->w = read_u32(data + 36, swap);
+    tex->h = read_u32(data + 40, swap);
+    tex->num_levels = (int)read_u32(data + 56, swap);
+    if(!check_texture_header(tex, "KTX"))
+        return GPU_FALSE;
+
+    // Skip the key/value data.  Each level is prefixed with its size and padded to 4 bytes.
+    offset = 64 + read_u32(data + 60, swap);
+    for(i = 0; i < tex->num_levels; ++i)
+    {
+        if(offset > (Uint32)data_bytes - 4)
+        {
+            GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Texture data for mipmap level %d is truncated", i);
+            return GPU_FALSE;
+        }
+        size = read_u32(data + offset, swap);
+        if(!set_texture_level(tex, i, data, data_bytes, offset + 4, size))
+            return GPU_FALSE;
+        offset += 4 + ((size + 3) & ~3u);
+    }
+
+    return GPU_TRUE;
+}
+
+static GPU_bool parse_ktx2(const unsigned char* data, int data_bytes, GPU_CompressedTexture* tex)
+{
+    Uint32 offset, size;
+    int i;
+
+    if(data_bytes < 80)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX2 header is truncated");
+        return GPU_FALSE;
+    }
+
+    // Basis Universal and zstd supercompression would need a transcoder
+    if(read_u32(data + 44, GPU_FALSE) != 0)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Supercompressed KTX2 textures are not supported");
+        return GPU_FALSE;
+    }
+    if(read_u32(data + 28, GPU_FALSE) > 1 || read_u32(data + 32, GPU_FALSE) > 1 || read_u32(data + 36, GPU_FALSE) != 1)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Only 2D KTX2 textures are supported");
+        return GPU_FALSE;
+    }
+
+    tex->format = get_format_from_vulkan(read_u32(data + 12, GPU_FALSE));
+    tex->w = read_u32(data + 20, GPU_FALSE);
+    tex->h = read_u32(data + 24, GPU_FALSE);
+    tex->num_levels = (int)read_u32(data + 40, GPU_FALSE);
+    if(!check_texture_header(tex, "KTX2"))
+        return GPU_FALSE;
+
+    if(80 + 24*tex->num_levels > data_bytes)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "KTX2 level index is truncated");
+        return GPU_FALSE;
+    }
+
+    // The level index holds a byte offset and length for each level, largest first
+    for(i = 0; i < tex->num_levels; ++i)
+    {
+        const unsigned char* entry = data + 80 + 24*i;
+        if(!read_u64_low(entry, &offset) || !read_u64_low(entry + 8, &size))
+        {
+            GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Invalid KTX2 level index");
+            return GPU_FALSE;
+        }
+        if(!set_texture_level(tex, i, data, data_bytes, offset, size))
+            return GPU_FALSE;
+    }
+
+    return GPU_TRUE;
+}
+
+static GPU_bool parse_dds(const unsigned char* data, int data_bytes, GPU_CompressedTexture* tex)
+{
+    const unsigned char* header = data + 4;
+    Uint32 fourcc;
+    Uint32 offset = 4 + 124;
+    int i;
+
+    if(data_bytes < (int)offset || read_u32(header, GPU_FALSE) != 124)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "DDS header is truncated");
+        return GPU_FALSE;
+    }
+
+    // Cube maps and volume textures
+    if(read_u32(header + 108, GPU_FALSE) & (0x200 | 0x200000))
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Only 2D DDS textures are supported");
+        return GPU_FALSE;
+    }
+
+    fourcc = ((read_u32(header + 76, GPU_FALSE) & 0x4)? read_u32(header + 80, GPU_FALSE) : 0);
+    if(fourcc == GPU_FOURCC('D', 'X', 'T', '1'))
+        tex->format = GPU_FORMAT_BC1;
+    else if(fourcc == GPU_FOURCC('D', 'X', 'T', '2') || fourcc == GPU_FOURCC('D', 'X', 'T', '3'))
+        tex->format = GPU_FORMAT_BC2;
+    else if(fourcc == GPU_FOURCC('D', 'X', 'T', '4') || fourcc == GPU_FOURCC('D', 'X', 'T', '5'))
+        tex->format = GPU_FORMAT_BC3;
+    else if(fourcc == GPU_FOURCC('D', 'X', '1', '0'))
+    {
+        // The extended header follows, with a DXGI format and array size
+        if(data_bytes < (int)offset + 20 || read_u32(data + offset + 12, GPU_FALSE) > 1)
+        {
+            GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Only single 2D DDS textures are supported");
+            return GPU_FALSE;
+        }
+        tex->format = get_format_from_dxgi(read_u32(data + offset, GPU_FALSE));
+        offset += 20;
+    }
+    else
+        tex->format = 0;
+
+    tex->h = read_u32(header + 8, GPU_FALSE);
+    tex->w = read_u32(header + 12, GPU_FALSE);
+    // DDSD_MIPMAPCOUNT
+    tex->num_levels = ((read_u32(header + 4, GPU_FALSE) & 0x20000)? (int)read_u32(header + 24, GPU_FALSE) : 1);
+    if(!check_texture_header(tex, "DDS"))
+        return GPU_FALSE;
+
+    // Levels are packed back to back
+    for(i = 0; i < tex->num_levels; ++i)
+    {
+        Uint32 w = tex->w >> i;
+        Uint32 h = tex->h >> i;
+        Uint32 size = get_level_size(tex->format, (w > 0? w : 1), (h > 0? h : 1));
+        if(!set_texture_level(tex, i, data, data_bytes, offset, size))
+            return GPU_FALSE;
+        offset += size;
+    }
+
+    return GPU_TRUE;
+}
+
+static GPU_bool parse_container(const unsigned char* data, int data_bytes, GPU_CompressedTexture* tex)
+{
+    memset(tex, 0, sizeof(GPU_CompressedTexture));
+
+    if(data == NULL)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Failed to read the texture container");
+        return GPU_FALSE;
+    }
+
+    if(data_bytes >= 12 && memcmp(data, ktx1_identifier, 12) == 0)
+        return parse_ktx1(data, data_bytes, tex);
+    if(data_bytes >= 12 && memcmp(data, ktx2_identifier, 12) == 0)
+        return parse_ktx2(data, data_bytes, tex);
+    if(data_bytes >= 4 && read_u32(data, GPU_FALSE) == GPU_FOURCC('D', 'D', 'S', ' '))
+        return parse_dds(data, data_bytes, tex);
+
+    GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_DATA_ERROR, "Not a KTX, KTX2 or DDS file");
+    return GPU_FALSE;
+}
+
+
+
+// CPU decoders.  Each writes a 4x4 block as 16 RGBA texels in row-major order.
+
+static_inline unsigned char clamp_byte(int value)
+{
+    return (unsigned char)(value < 0? 0 : (value > 255? 255 : value));
+}
+
+// Decodes a BC1 color block.  BC2 and BC3 always use the four-color mode and keep the alpha written by their alpha block.
+static void decode_bc1_colors(const unsigned char* block, unsigned char* texels, GPU_bool has_alpha_block)
+{
+    unsigned char palette[4][4];
+    Uint32 c0 = block[0] | (block[1] << 8);
+    Uint32 c1 = block[2] | (block[3] << 8);
+    Uint32 indices = read_u32(block + 4, GPU_FALSE);
+    int i, j;
+
+    for(i = 0; i < 2; ++i)
+    {
+        Uint32 c = (i == 0? c0 : c1);
+        Uint32 r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        palette[i][0] = (unsigned char)((r << 3) | (r >> 2));
+        palette[i][1] = (unsigned char)((g << 2) | (g >> 4));
+        palette[i][2] = (unsigned char)((b << 3) | (b >> 2));
+        palette[i][3] = 255;
+    }
+
+    for(j = 0; j < 3; ++j)
+    {
+        if(c0 > c1 || has_alpha_block)
+        {
+            palette[2][j] = (unsigned char)((2*palette[0][j] + palette[1][j])/3);
+            palette[3][j] = (unsigned char)((palette[0][j] + 2*palette[1][j])/3);
+        }
+        else
+        {
+            palette[2][j] = (unsigned char)((palette[0][j] + palette[1][j])/2);
+            palette[3][j] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = ((c0 > c1 || has_alpha_block)? 255 : 0);
+
+    for(i = 0; i < 16; ++i)
+    {
+        const unsigned char* color = palette[(indices >> (2*i)) & 3];
+        texels[4*i] = color[0];
+        texels[4*i+1] = color[1];
+        texels[4*i+2] = color[2];
+        if(!has_alpha_block)
+            texels[4*i+3] = color[3];
+    }
+}
+
+// BC2 stores 4 bits of alpha per texel
+static void decode_bc2_alpha(const unsigned char* block, unsigned char* texels)
+{
+    int i;
+    for(i = 0; i < 16; ++i)
+    {
+        unsigned char a = (block[i/2] >> (4*(i & 1))) & 15;
+        texels[4*i+3] = (unsigned char)(a * 17);
+    }
+}
+
+// BC3 interpolates alpha between two endpoints with 3-bit indices
+static void decode_bc3_alpha(const unsigned char* block, unsigned char* texels)
+{
+    unsigned char palette[8];
+    int a0 = block[0], a1 = block[1];
+    int i;
+
+    palette[0] = (unsigned char)a0;
+    palette[1] = (unsigned char)a1;
+    if(a0 > a1)
+    {
+        for(i = 1; i < 7; ++i)
+            palette[i+1] = (unsigned char)(((7 - i)*a0 + i*a1)/7);
+    }
+    else
+    {
+        for(i = 1; i < 5; ++i)
+            palette[i+1] = (unsigned char)(((5 - i)*a0 + i*a1)/5);
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    // Each half of the 48-bit index field holds eight texels
+    {
+        Uint32 low = block[2] | (block[3] << 8) | ((Uint32)block[4] << 16);
+        Uint32 high = block[5] | (block[6] << 8) | ((Uint32)block[7] << 16);
+        for(i = 0; i < 16; ++i)
+            texels[4*i+3] = palette[(i < 8? low >> (3*i) : high >> (3*(i - 8))) & 7];
+    }
+}
+
+static const int etc1_modifiers[8][2] = {
+    {2, 8}, {5, 17}, {9, 29}, {13, 42}, {18, 60}, {24, 80}, {33, 106}, {47, 183}
+};
+
+static const int etc2_distances[8] = {3, 6, 11, 16, 23, 32, 41, 64};
+
+static_inline int extend_4(int x) { return (x << 4) | x; }
+static_inline int extend_5(int x) { return (x << 3) | (x >> 2); }
+static_inline int extend_6(int x) { return (x << 2) | (x >> 4); }
+static_inline int extend_7(int x) { return (x << 1) | (x >> 6); }
+
+// Texel (x, y) of an ETC block is bit x*4 + y of the two 16-bit index planes
+static_inline int get_etc_index(const unsigned char* block, int x, int y)
+{
+    int k = x*4 + y;
+    int msb = ((block[4] << 8) | block[5]) >> k;
+    int lsb = ((block[6] << 8) | block[7]) >> k;
+    return ((msb & 1) << 1) | (lsb & 1);
+}
+
+static void set_texel(unsigned char* texels, int x, int y, int r, int g, int b)
+{
+    unsigned char* t = texels + 4*(y*4 + x);
+    t[0] = clamp_byte(r);
+    t[1] = clamp_byte(g);
+    t[2] = clamp_byte(b);
+}
+
+// Decodes an ETC2 RGB block (including plain ETC1 blocks) into the color channels of the texels
+static void decode_etc2_colors(const unsigned char* block, unsigned char* texels)
+{
+    const unsigned char* b = block;
+    int x, y;
+
+    if(!(b[3] & 2))
+    {
+        // Individual mode: two 4-bit base colors
+        int base[2][3];
+        int table[2];
+        GPU_bool flip = (b[3] & 1);
+
+        base[0][0] = extend_4(b[0] >> 4); base[1][0] = extend_4(b[0] & 15);
+        base[0][1] = extend_4(b[1] >> 4); base[1][1] = extend_4(b[1] & 15);
+        base[0][2] = extend_4(b[2] >> 4); base[1][2] = extend_4(b[2] & 15);
+        table[0] = (b[3] >> 5) & 7;
+        table[1] = (b[3] >> 2) & 7;
+
+        for(y = 0; y < 4; ++y)
+        {
+            for(x = 0; x < 4; ++x)
+            {
+                int sub = (flip? y >= 2 : x >= 2);
+                int index = get_etc_index(b, x, y);
+                int modifier = etc1_modifiers[table[sub]][index & 1];
+                if(index & 2)
+                    modifier = -modifier;
+                set_texel(texels, x, y, base[sub][0] + modifier, base[sub][1] + modifier, base[sub][2] + modifier);
+            }
+        }
+        return;
+    }
+
+    {
+        int r = b[0] >> 3, g = b[1] >> 3, bl = b[2] >> 3;
+        int dr = (b[0] & 7) - ((b[0] & 4) << 1);
+        int dg = (b[1] & 7) - ((b[1] & 4) << 1);
+        int db = (b[2] & 7) - ((b[2] & 4) << 1);
+
+        if(r + dr < 0 || r + dr > 31)
+        {
+            // T mode
+            int paint[4][3];
+            int c1[3], c2[3], d, i;
+
+            c1[0] = extend_4((((b[0] >> 3) & 3) << 2) | (b[0] & 3));
+            c1[1] = extend_4(b[1] >> 4);
+            c1[2] = extend_4(b[1] & 15);
+            c2[0] = extend_4(b[2] >> 4);
+            c2[1] = extend_4(b[2] & 15);
+            c2[2] = extend_4(b[3] >> 4);
+            d = etc2_distances[(((b[3] >> 2) & 3) << 1) | (b[3] & 1)];
+
+            for(i = 0; i < 3; ++i)
+            {
+                paint[0][i] = c1[i];
+                paint[1][i] = c2[i] + d;
+                paint[2][i] = c2[i];
+                paint[3][i] = c2[i] - d;
+            }
+
+            for(y = 0; y < 4; ++y)
+            {
+                for(x = 0; x < 4; ++x)
+                {
+                    int* p = paint[get_etc_index(b, x, y)];
+                    set_texel(texels, x, y, p[0], p[1], p[2]);
+                }
+            }
+        }
+        else if(g + dg < 0 || g + dg > 31)
+        {
+            // H mode
+            int paint[4][3];
+            int r1, g1, b1, r2, g2, b2, d, i;
+
+            r1 = (b[0] >> 3) & 15;
+            g1 = ((b[0] & 7) << 1) | ((b[1] >> 4) & 1);
+            b1 = (b[1] & 8) | ((b[1] & 3) << 1) | (b[2] >> 7);
+            r2 = (b[2] >> 3) & 15;
+            g2 = ((b[2] & 7) << 1) | (b[3] >> 7);
+            b2 = (b[3] >> 3) & 15;
+            d = etc2_distances[(b[3] & 4) | ((b[3] & 1) << 1) | (((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2))];
+
+            for(i = 0; i < 3; ++i)
+            {
+                int c1 = extend_4(i == 0? r1 : (i == 1? g1 : b1));
+                int c2 = extend_4(i == 0? r2 : (i == 1? g2 : b2));
+                paint[0][i] = c1 + d;
+                paint[1][i] = c1 - d;
+                paint[2][i] = c2 + d;
+                paint[3][i] = c2 - d;
+            }
+
+            for(y = 0; y < 4; ++y)
+            {
+                for(x = 0; x < 4; ++x)
+                {
+                    int* p = paint[get_etc_index(b, x, y)];
+                    set_texel(texels, x, y, p[0], p[1], p[2]);
+                }
+            }
+        }
+        else if(bl + db < 0 || bl + db > 31)
+        {
+            // Planar mode: a gradient between three colors
+            int o[3], h[3], v[3];
+
+            o[0] = extend_6((b[0] >> 1) & 63);
+            o[1] = extend_7(((b[0] & 1) << 6) | ((b[1] >> 1) & 63));
+            o[2] = extend_6(((b[1] & 1) << 5) | (((b[2] >> 3) & 3) << 3) | ((b[2] & 3) << 1) | (b[3] >> 7));
+            h[0] = extend_6((((b[3] >> 2) & 31) << 1) | (b[3] & 1));
+            h[1] = extend_7(b[4] >> 1);
+            h[2] = extend_6(((b[4] & 1) << 5) | (b[5] >> 3));
+            v[0] = extend_6(((b[5] & 7) << 3) | (b[6] >> 5));
+            v[1] = extend_7(((b[6] & 31) << 2) | (b[7] >> 6));
+            v[2] = extend_6(b[7] & 63);
+
+            for(y = 0; y < 4; ++y)
+            {
+                for(x = 0; x < 4; ++x)
+                {
+                    set_texel(texels, x, y,
+                              (x*(h[0] - o[0]) + y*(v[0] - o[0]) + 4*o[0] + 2) >> 2,
+                              (x*(h[1] - o[1]) + y*(v[1] - o[1]) + 4*o[1] + 2) >> 2,
+                              (x*(h[2] - o[2]) + y*(v[2] - o[2]) + 4*o[2] + 2) >> 2);
+                }
+            }
+        }
+        else
+        {
+            // Differential mode: a 5-bit base color and a 3-bit signed offset for the second subblock
+            int base[2][3];
+            int table[2];
+            GPU_bool flip = (b[3] & 1);
+
+            base[0][0] = extend_5(r); base[1][0] = extend_5(r + dr);
+            base[0][1] = extend_5(g); base[1][1] = extend_5(g + dg);
+            base[0][2] = extend_5(bl); base[1][2] = extend_5(bl + db);
+            table[0] = (b[3] >> 5) & 7;
+            table[1] = (b[3] >> 2) & 7;
+
+            for(y = 0; y < 4; ++y)
+            {
+                for(x = 0; x < 4; ++x)
+                {
+                    int sub = (flip? y >= 2 : x >= 2);
+                    int index = get_etc_index(b, x, y);
+                    int modifier = etc1_modifiers[table[sub]][index & 1];
+                    if(index & 2)
+                        modifier = -modifier;
+                    set_texel(texels, x, y, base[sub][0] + modifier, base[sub][1] + modifier, base[sub][2] + modifier);
+                }
+            }
+        }
+    }
+}
+
+static const int eac_modifiers[16][8] = {
+    {-3, -6, -9, -15, 2, 5, 8, 14},
+    {-3, -7, -10, -13, 2, 6, 9, 12},
+    {-2, -5, -8, -13, 1, 4, 7, 12},
+    {-2, -4, -6, -13, 1, 3, 5, 12},
+    {-3, -6, -8, -12, 2, 5, 7, 11},
+    {-3, -7, -9, -11, 2, 6, 8, 10},
+    {-4, -7, -8, -11, 3, 6, 7, 10},
+    {-3, -5, -8, -11, 2, 4, 7, 10},
+    {-2, -6, -8, -10, 1, 5, 7, 9},
+    {-2, -5, -8, -10, 1, 4, 7, 9},
+    {-2, -4, -8, -10, 1, 3, 7, 9},
+    {-2, -5, -7, -10, 1, 4, 6, 9},
+    {-3, -4, -7, -10, 2, 3, 6, 9},
+    {-1, -2, -3, -10, 0, 1, 2, 9},
+    {-4, -6, -8, -9, 3, 5, 7, 8},
+    {-3, -5, -7, -9, 2, 4, 6, 8}
+};
+
+// EAC alpha: a base value plus a scaled modifier, with 3-bit indices stored big-endian in column-major order
+static void decode_eac_alpha(const unsigned char* block, unsigned char* texels)
+{
+    int base = block[0];
+    int multiplier = block[1] >> 4;
+    const int* modifiers = eac_modifiers[block[1] & 15];
+    Uint32 high = ((Uint32)block[2] << 16) | ((Uint32)block[3] << 8) | block[4];
+    Uint32 low = ((Uint32)block[5] << 16) | ((Uint32)block[6] << 8) | block[7];
+    int x, y;
+
+    for(x = 0; x < 4; ++x)
+    {
+        for(y = 0; y < 4; ++y)
+        {
+            int k = x*4 + y;
+            int index = (k < 8? (high >> (21 - 3*k)) : (low >> (21 - 3*(k - 8)))) & 7;
+            texels[4*(y*4 + x) + 3] = clamp_byte(base + modifiers[index]*multiplier);
+        }
+    }
+}
+
+static void decode_block(GPU_FormatEnum format, const unsigned char* block, unsigned char* texels)
+{
+    int i;
+    switch(format)
+    {
+        case GPU_FORMAT_BC1:
+            decode_bc1_colors(block, texels, GPU_FALSE);
+            break;
+        case GPU_FORMAT_BC2:
+            decode_bc2_alpha(block, texels);
+            decode_bc1_colors(block + 8, texels, GPU_TRUE);
+            break;
+        case GPU_FORMAT_BC3:
+            decode_bc3_alpha(block, texels);
+            decode_bc1_colors(block + 8, texels, GPU_TRUE);
+            break;
+        case GPU_FORMAT_ETC2_RGB8:
+            for(i = 0; i < 16; ++i)
+                texels[4*i+3] = 255;
+            decode_etc2_colors(block, texels);
+            break;
+        case GPU_FORMAT_ETC2_RGBA8:
+            decode_eac_alpha(block, texels);
+            decode_etc2_colors(block + 8, texels);
+            break;
+        default:
+            break;
+    }
+}
+
+// Decodes one level into a tightly packed RGBA buffer.  Returns NULL for formats without a CPU decoder (ASTC).
+static unsigned char* decompress_level(GPU_FormatEnum format, const unsigned char* blocks, Uint32 w, Uint32 h)
+{
+    unsigned char texels[64];
+    unsigned char* result;
+    unsigned int block_bytes = get_block_bytes(format);
+    Uint32 bx, by, row;
+
+    if(format == GPU_FORMAT_ASTC_4x4 || block_bytes == 0)
+        return NULL;
+
+    result = (unsigned char*)SDL_malloc(w*h*4);
+    if(result == NULL)
+        return NULL;
+
+    for(by = 0; by < h; by += 4)
+    {
+        for(bx = 0; bx < w; bx += 4)
+        {
+            Uint32 copy_w = (w - bx < 4? w - bx : 4);
+            decode_block(format, blocks, texels);
+            blocks += block_bytes;
+
+            // Clip blocks that hang over the edge of the image
+            for(row = 0; row < 4 && by + row < h; ++row)
+                memcpy(result + ((by + row)*w + bx)*4, texels + row*16, copy_w*4);
+        }
+    }
+
+    return result;
+}
+
+
+
+GPU_bool gpu_is_compressed_container(const unsigned char* data, int data_bytes)
+{
+    if(data_bytes >= 12 && (memcmp(data, ktx1_identifier, 12) == 0 || memcmp(data, ktx2_identifier, 12) == 0))
+        return GPU_TRUE;
+    return (data_bytes >= 4 && read_u32(data, GPU_FALSE) == GPU_FOURCC('D', 'D', 'S', ' '));
+}
+
+unsigned char* gpu_load_compressed_pixels(const unsigned char* data, int data_bytes, int* width, int* height)
+{
+    GPU_CompressedTexture tex;
+    unsigned char* result;
+
+    if(!parse_container(data, data_bytes, &tex))
+        return NULL;
+
+    result = decompress_level(tex.format, tex.level_data[0], tex.w, tex.h);
+    if(result == NULL)
+    {
+        GPU_PushErrorCode("GPU_LoadSurface", GPU_ERROR_UNSUPPORTED_FUNCTION, "No CPU decoder for image format (0x%x)", tex.format);
+        return NULL;
+    }
+
+    *width = (int)tex.w;
+    *height = (int)tex.h;
+    return result;
+}
+
+GPU_Image* gpu_load_compressed_image(GPU_Renderer* renderer, const unsigned char* data, int data_bytes)
+{
+    GPU_CompressedTexture tex;
+    GPU_Image* result;
+    unsigned char* pixels;
+    GPU_bool npot;
+
+    if(!parse_container(data, data_bytes, &tex))
+        return NULL;
+
+    // Upload the blocks directly when the driver can sample them
+    npot = ((tex.w & (tex.w - 1)) != 0 || (tex.h & (tex.h - 1)) != 0);
+    if((renderer->enabled_features & get_format_feature(tex.format)) && (!npot || (renderer->enabled_features & GPU_FEATURE_NON_POWER_OF_TWO)))
+        return renderer->impl->CreateCompressedImage(renderer, (Uint16)tex.w, (Uint16)tex.h, tex.format, tex.num_levels, tex.level_data, tex.level_sizes);
+
+    // Otherwise decode the base level and let the GPU rebuild the mipmaps
+    pixels = decompress_level(tex.format, tex.level_data[0], tex.w, tex.h);
+    if(pixels == NULL)
+    {
+        GPU_PushErrorCode("GPU_LoadImage", GPU_ERROR_UNSUPPORTED_FUNCTION, "Image format (0x%x) is not supported by this renderer and has no CPU decoder", tex.format);
+        return NULL;
+    }
+
+    result = renderer->impl->CreateImage(renderer, (Uint16)tex.w, (Uint16)tex.h, GPU_FORMAT_RGBA);
+    if(result != NULL)
+    {
+        renderer->impl->UpdateImageBytes(renderer, result, NULL, pixels, (int)tex.w*4);
+        if(tex.num_levels > 1)
+            renderer->impl->GenerateMipmaps(renderer, result);
+    }
+
+    SDL_free(pixels);
+    return result;
+}
@@ -0,0 +1,536 @@
+#include "SDL_gpu.h"
+#include <math.h>
+#include <string.h>
+
+// Mipmap chains built on the CPU, for GPU_SetMipmapsOnLoad() and for renderers that can't generate them on the GPU.
+// Levels are filtered in linear light with premultiplied alpha, so bright and opaque texels keep their weight.  Each level is
+// resampled from the float copy of the one before it and rounded to 8 bits only for upload.  Rows of a level are split into bands
+// on worker threads, and SSE2 or NEON accumulate a whole RGBA texel per instruction.  Define SDL_GPU_DISABLE_SIMD to use only the scalar code.
+
+#ifndef SDL_GPU_DISABLE_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define GPU_MIPMAP_SSE2
+        #include <emmintrin.h>
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define GPU_MIPMAP_NEON
+        #include <arm_neon.h>
+    #endif
+#endif
+
+#define GPU_MIPMAP_MAX_THREADS 8
+#define GPU_MIPMAP_MIN_BAND_PIXELS (64*1024)
+
+// Kaiser and Lanczos reach this many destination texels to each side
+#define GPU_MIPMAP_FILTER_RADIUS 3.0f
+#define GPU_MIPMAP_KAISER_ALPHA 4.0
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// sRGB byte to linear intensity
+static const float gpu_srgb_to_linear[256] = {
+    0.0f, 3.03526984e-4f, 6.07053967e-4f, 9.10580951e-4f, 1.21410793e-3f, 1.51763492e-3f, 1.82116190e-3f, 2.12468888e-3f,
+    2.42821587e-3f, 2.73174285e-3f, 3.03526984e-3f, 3.34653576e-3f, 3.67650732e-3f, 4.02471702e-3f, 4.39144204e-3f, 4.77695348e-3f,
+    5.18151670e-3f, 5.60539162e-3f, 6.04883302e-3f, 6.51209079e-3f, 6.99541019e-3f, 7.49903204e-3f, 8.02319299e-3f, 8.56812562e-3f,
+    9.13405870e-3f, 9.72121732e-3f, 1.03298230e-2f, 1.09600940e-2f, 1.16122452e-2f, 1.22864884e-2f, 1.29830323e-2f, 1.37020830e-2f,
+    1.44438436e-2f, 1.52085144e-2f, 1.59962934e-2f, 1.68073758e-2f, 1.76419545e-2f, 1.85002201e-2f, 1.93823610e-2f, 2.02885631e-2f,
+    2.12190104e-2f, 2.21738848e-2f, 2.31533662e-2f, 2.41576324e-2f, 2.51868596e-2f, 2.62412219e-2f, 2.73208916e-2f, 2.84260395e-2f,
+    2.95568344e-2f, 3.07134437e-2f, 3.18960331e-2f, 3.31047666e-2f, 3.43398068e-2f, 3.56013149e-2f, 3.68894504e-2f, 3.82043716e-2f,
+    3.95462353e-2f, 4.09151969e-2f, 4.23114106e-2f, 4.37350293e-2f, 4.51862044e-2f, 4.66650863e-2f, 4.81718242e-2f, 4.97065660e-2f,
+    5.12694584e-2f, 5.28606470e-2f, 5.44802764e-2f, 5.61284900e-2f, 5.78054302e-2f, 5.95112382e-2f, 6.12460542e-2f, 6.30100177e-2f,
+    6.48032667e-2f, 6.66259386e-2f, 6.84781698e-2f, 7.03600957e-2f, 7.22718507e-2f, 7.42135684e-2f, 7.61853815e-2f, 7.81874218e-2f,
+    8.02198203e-2f, 8.22827071e-2f, 8.43762115e-2f, 8.65004620e-2f, 8.86555863e-2f, 9.08417112e-2f, 9.30589628e-2f, 9.53074666e-2f,
+    9.75873471e-2f, 9.98987282e-2f, 1.02241733e-1f, 1.04616484e-1f, 1.07023103e-1f, 1.09461711e-1f, 1.11932428e-1f, 1.14435374e-1f,
+    1.16970668e-1f, 1.19538428e-1f, 1.22138772e-1f, 1.24771818e-1f, 1.27437680e-1f, 1.30136477e-1f, 1.32868322e-1f, 1.35633330e-1f,
+    1.38431615e-1f, 1.41263291e-1f, 1.44128471e-1f, 1.47027266e-1f, 1.49959790e-1f, 1.52926152e-1f, 1.55926464e-1f, 1.58960835e-1f,
+    1.62029376e-1f, 1.65132195e-1f, 1.68269400e-1f, 1.71441101e-1f, 1.74647404e-1f, 1.77888416e-1f, 1.81164244e-1f, 1.84474995e-1f,
+    1.87820772e-1f, 1.91201683e-1f, 1.94617830e-1f, 1.98069320e-1f, 2.01556254e-1f, 2.05078736e-1f, 2.08636870e-1f, 2.12230757e-1f,
+    2.15860500e-1f, 2.19526200e-1f, 2.23227957e-1f, 2.26965874e-1f, 2.30740049e-1f, 2.34550582e-1f, 2.38397574e-1f, 2.42281122e-1f,
+    2.46201327e-1f, 2.50158285e-1f, 2.54152094e-1f, 2.58182853e-1f, 2.62250658e-1f, 2.66355605e-1f, 2.70497791e-1f, 2.74677312e-1f,
+    2.78894263e-1f, 2.83148740e-1f, 2.87440838e-1f, 2.91770650e-1f, 2.96138271e-1f, 3.00543794e-1f, 3.04987314e-1f, 3.09468923e-1f,
+    3.13988713e-1f, 3.18546778e-1f, 3.23143209e-1f, 3.27778098e-1f, 3.32451536e-1f, 3.37163615e-1f, 3.41914425e-1f, 3.46704056e-1f,
+    3.51532600e-1f, 3.56400144e-1f, 3.61306780e-1f, 3.66252596e-1f, 3.71237680e-1f, 3.76262123e-1f, 3.81326011e-1f, 3.86429434e-1f,
+    3.91572478e-1f, 3.96755231e-1f, 4.01977780e-1f, 4.07240212e-1f, 4.12542613e-1f, 4.17885071e-1f, 4.23267670e-1f, 4.28690497e-1f,
+    4.34153636e-1f, 4.39657174e-1f, 4.45201195e-1f, 4.50785783e-1f, 4.56411023e-1f, 4.62077000e-1f, 4.67783796e-1f, 4.73531496e-1f,
+    4.79320183e-1f, 4.85149940e-1f, 4.91020850e-1f, 4.96932995e-1f, 5.02886458e-1f, 5.08881321e-1f, 5.14917665e-1f, 5.20995573e-1f,
+    5.27115126e-1f, 5.33276404e-1f, 5.39479489e-1f, 5.45724461e-1f, 5.52011402e-1f, 5.58340390e-1f, 5.64711506e-1f, 5.71124829e-1f,
+    5.77580440e-1f, 5.84078418e-1f, 5.90618841e-1f, 5.97201788e-1f, 6.03827339e-1f, 6.10495571e-1f, 6.17206562e-1f, 6.23960392e-1f,
+    6.30757136e-1f, 6.37596874e-1f, 6.44479682e-1f, 6.51405637e-1f, 6.58374817e-1f, 6.65387298e-1f, 6.72443157e-1f, 6.79542470e-1f,
+    6.86685312e-1f, 6.93871761e-1f, 7.01101892e-1f, 7.08375780e-1f, 7.15693501e-1f, 7.23055129e-1f, 7.30460740e-1f, 7.37910409e-1f,
+    7.45404210e-1f, 7.52942217e-1f, 7.60524505e-1f, 7.68151147e-1f, 7.75822218e-1f, 7.83537792e-1f, 7.91297940e-1f, 7.99102738e-1f,
+    8.06952258e-1f, 8.14846572e-1f, 8.22785754e-1f, 8.30769877e-1f, 8.38799012e-1f, 8.46873232e-1f, 8.54992608e-1f, 8.63157213e-1f,
+    8.71367119e-1f, 8.79622397e-1f, 8.87923118e-1f, 8.96269353e-1f, 9.04661174e-1f, 9.13098652e-1f, 9.21581856e-1f, 9.30110858e-1f,
+    9.38685728e-1f, 9.47306537e-1f, 9.55973353e-1f, 9.64686248e-1f, 9.73445290e-1f, 9.82250550e-1f, 9.91102097e-1f, 1.00000000f
+};
+
+// The smallest linear intensity that rounds to each sRGB byte.  The first entry is unused.
+static const float gpu_srgb_thresholds[256] = {
+    0.0f, 1.51763492e-4f, 4.55290475e-4f, 7.58817459e-4f, 1.06234444e-3f, 1.36587143e-3f, 1.66939841e-3f, 1.97292539e-3f,
+    2.27645238e-3f, 2.57997936e-3f, 2.88350634e-3f, 3.18830090e-3f, 3.50925935e-3f, 3.84831493e-3f, 4.20574803e-3f, 4.58183274e-3f,
+    4.97683725e-3f, 5.39102416e-3f, 5.82465078e-3f, 6.27796943e-3f, 6.75122763e-3f, 7.24466842e-3f, 7.75853050e-3f, 8.29304845e-3f,
+    8.84845295e-3f, 9.42497089e-3f, 1.00228256e-2f, 1.06422369e-2f, 1.12834213e-2f, 1.19465921e-2f, 1.26319598e-2f, 1.33397316e-2f,
+    1.40701120e-2f, 1.48233028e-2f, 1.55995031e-2f, 1.63989095e-2f, 1.72217161e-2f, 1.80681146e-2f, 1.89382945e-2f, 1.98324428e-2f,
+    2.07507446e-2f, 2.16933829e-2f, 2.26605384e-2f, 2.36523902e-2f, 2.46691150e-2f, 2.57108881e-2f, 2.67778826e-2f, 2.78702702e-2f,
+    2.89882206e-2f, 3.01319019e-2f, 3.13014806e-2f, 3.24971216e-2f, 3.37189882e-2f, 3.49672424e-2f, 3.62420443e-2f, 3.75435530e-2f,
+    3.88719259e-2f, 4.02273192e-2f, 4.16098877e-2f, 4.30197848e-2f, 4.44571628e-2f, 4.59221727e-2f, 4.74149640e-2f, 4.89356854e-2f,
+    5.04844842e-2f, 5.20615066e-2f, 5.36668976e-2f, 5.53008013e-2f, 5.69633604e-2f, 5.86547169e-2f, 6.03750115e-2f, 6.21243839e-2f,
+    6.39029729e-2f, 6.57109163e-2f, 6.75483509e-2f, 6.94154125e-2f, 7.13122362e-2f, 7.32389559e-2f, 7.51957047e-2f, 7.71826150e-2f,
+    7.91998181e-2f, 8.12474446e-2f, 8.33256241e-2f, 8.54344855e-2f, 8.75741570e-2f, 8.97447658e-2f, 9.19464383e-2f, 9.41793004e-2f,
+    9.64434770e-2f, 9.87390924e-2f, 1.01066270e-1f, 1.03425133e-1f, 1.05815802e-1f, 1.08238401e-1f, 1.10693048e-1f, 1.13179865e-1f,
+    1.15698970e-1f, 1.18250482e-1f, 1.20834520e-1f, 1.23451200e-1f, 1.26100640e-1f, 1.28782955e-1f, 1.31498261e-1f, 1.34246673e-1f,
+    1.37028306e-1f, 1.39843272e-1f, 1.42691686e-1f, 1.45573660e-1f, 1.48489305e-1f, 1.51438734e-1f, 1.54422057e-1f, 1.57439385e-1f,
+    1.60490827e-1f, 1.63576493e-1f, 1.66696492e-1f, 1.69850932e-1f, 1.73039920e-1f, 1.76263564e-1f, 1.79521971e-1f, 1.82815248e-1f,
+    1.86143498e-1f, 1.89506829e-1f, 1.92905345e-1f, 1.96339151e-1f, 1.99808350e-1f, 2.03313045e-1f, 2.06853340e-1f, 2.10429338e-1f,
+    2.14041140e-1f, 2.17688849e-1f, 2.21372565e-1f, 2.25092389e-1f, 2.28848422e-1f, 2.32640764e-1f, 2.36469515e-1f, 2.40334772e-1f,
+    2.44236636e-1f, 2.48175205e-1f, 2.52150577e-1f, 2.56162849e-1f, 2.60212118e-1f, 2.64298482e-1f, 2.68422037e-1f, 2.72582879e-1f,
+    2.76781103e-1f, 2.81016805e-1f, 2.85290081e-1f, 2.89601024e-1f, 2.93949728e-1f, 2.98336289e-1f, 3.02760799e-1f, 3.07223352e-1f,
+    3.11724040e-1f, 3.16262956e-1f, 3.20840192e-1f, 3.25455841e-1f, 3.30109993e-1f, 3.34802740e-1f, 3.39534173e-1f, 3.44304382e-1f,
+    3.49113458e-1f, 3.53961491e-1f, 3.58848570e-1f, 3.63774785e-1f, 3.68740224e-1f, 3.73744977e-1f, 3.78789131e-1f, 3.83872775e-1f,
+    3.88995998e-1f, 3.94158885e-1f, 3.99361525e-1f, 4.04604005e-1f, 4.09886411e-1f, 4.15208830e-1f, 4.20571347e-1f, 4.25974050e-1f,
+    4.31417022e-1f, 4.36900350e-1f, 4.42424119e-1f, 4.47988412e-1f, 4.53593316e-1f, 4.59238914e-1f, 4.64925290e-1f, 4.70652528e-1f,
+    4.76420711e-1f, 4.82229923e-1f, 4.88080246e-1f, 4.93971763e-1f, 4.99904557e-1f, 5.05878709e-1f, 5.11894303e-1f, 5.17951419e-1f,
+    5.24050139e-1f, 5.30190544e-1f, 5.36372716e-1f, 5.42596734e-1f, 5.48862680e-1f, 5.55170635e-1f, 5.61520677e-1f, 5.67912887e-1f,
+    5.74347344e-1f, 5.80824128e-1f, 5.87343319e-1f, 5.93904994e-1f, 6.00509233e-1f, 6.07156115e-1f, 6.13845717e-1f, 6.20578117e-1f,
+    6.27353395e-1f, 6.34171626e-1f, 6.41032889e-1f, 6.47937261e-1f, 6.54884819e-1f, 6.61875640e-1f, 6.68909801e-1f, 6.75987377e-1f,
+    6.83108445e-1f, 6.90273081e-1f, 6.97481362e-1f, 7.04733362e-1f, 7.12029156e-1f, 7.19368822e-1f, 7.26752432e-1f, 7.34180063e-1f,
+    7.41651788e-1f, 7.49167683e-1f, 7.56727821e-1f, 7.64332277e-1f, 7.71981125e-1f, 7.79674438e-1f, 7.87412289e-1f, 7.95194753e-1f,
+    8.03021903e-1f, 8.10893811e-1f, 8.18810550e-1f, 8.26772194e-1f, 8.34778813e-1f, 8.42830482e-1f, 8.50927271e-1f, 8.59069253e-1f,
+    8.67256499e-1f, 8.75489082e-1f, 8.83767073e-1f, 8.92090542e-1f, 9.00459561e-1f, 9.08874202e-1f, 9.17334534e-1f, 9.25840628e-1f,
+    9.34392556e-1f, 9.42990386e-1f, 9.51634190e-1f, 9.60324036e-1f, 9.69059996e-1f, 9.77842139e-1f, 9.86670534e-1f, 9.95545250e-1f
+};
+
+/*! The source texels and weights for every destination texel along one axis.  Destination texel i reads index[i*num_taps + k]. */
+typedef struct GPU_MipmapTaps
+{
+    int num_taps;
+    int* index;
+    float* weight;
+} GPU_MipmapTaps;
+
+/*! One level of the chain.  Bands of destination rows are resampled independently. */
+typedef struct GPU_MipmapLevelJob
+{
+    const unsigned char* pixels;  // The 8-bit base level, when decoding it
+    const float* src;  // The previous level, as premultiplied linear RGBA
+    int src_w, src_h;
+    float* dst;
+    int dst_w, dst_h;
+    GPU_MipmapTaps x_taps, y_taps;
+    unsigned char* out;  // The 8-bit copy of dst that gets uploaded
+    int channels;
+    GPU_bool premultiplied;
+} GPU_MipmapLevelJob;
+
+typedef void (*GPU_MipmapBandFunc)(GPU_MipmapLevelJob* job, int first_row, int end_row);
+
+typedef struct GPU_MipmapBand
+{
+    GPU_MipmapBandFunc func;
+    GPU_MipmapLevelJob* job;
+    int first_row, end_row;
+} GPU_MipmapBand;
+
+
+static Uint8 gpu_linear_to_srgb(float value)
+{
+    int result = 0;
+    int step;
+    for(step = 128; step > 0; step >>= 1)
+    {
+        if(value >= gpu_srgb_thresholds[result + step])
+            result += step;
+    }
+    return (Uint8)result;
+}
+
+static double gpu_bessel_i0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    int k;
+    for(k = 1; k < 32 && term > sum*1e-12; ++k)
+    {
+        term *= (x*x)/(4.0*k*k);
+        sum += term;
+    }
+    return sum;
+}
+
+static double gpu_sinc(double x)
+{
+    if(fabs(x) < 1e-6)
+        return 1.0;
+    x *= M_PI;
+    return sin(x)/x;
+}
+
+// Kaiser-windowed and Lanczos-windowed sinc, in destination texels
+static float gpu_mipmap_kernel(GPU_MipmapFilterEnum filter, float x)
+{
+    double t = x/GPU_MIPMAP_FILTER_RADIUS;
+    if(t <= -1.0 || t >= 1.0)
+        return 0.0f;
+
+    if(filter == GPU_MIPMAP_FILTER_KAISER)
+        return (float)(gpu_sinc(x)*gpu_bessel_i0(GPU_MIPMAP_KAISER_ALPHA*sqrt(1.0 - t*t))/gpu_bessel_i0(GPU_MIPMAP_KAISER_ALPHA));
+    return (float)(gpu_sinc(x)*gpu_sinc(t));
+}
+
+static GPU_bool gpu_build_mipmap_taps(GPU_MipmapTaps* taps, int src_size, int dst_size, GPU_MipmapFilterEnum filter)
+{
+    float scale = (float)src_size/dst_size;
+    float support = (filter == GPU_MIPMAP_FILTER_BOX? 0.5f : GPU_MIPMAP_FILTER_RADIUS)*scale;
+    int i, k;
+
+    taps->num_taps = (int)ceil(2*support) + 2;
+    taps->index = (int*)SDL_malloc(dst_size*taps->num_taps*sizeof(int));
+    taps->weight = (float*)SDL_malloc(dst_size*taps->num_taps*sizeof(float));
+    if(taps->index == NULL || taps->weight == NULL)
+    {
+        SDL_free(taps->index);
+        SDL_free(taps->weight);
+        taps->index = NULL;
+        taps->weight = NULL;
+        return GPU_FALSE;
+    }
+
+    for(i = 0; i < dst_size; ++i)
+    {
+        // Source texel j covers [j, j+1)
+        float center = (i + 0.5f)*scale;
+        int first = (int)floor(center - support);
+        int* index = taps->index + i*taps->num_taps;
+        float* weight = taps->weight + i*taps->num_taps;
+        float sum = 0.0f;
+
+        for(k = 0; k < taps->num_taps; ++k)
+        {
+            int j = first + k;
+            float w;
+
+            if(filter == GPU_MIPMAP_FILTER_BOX)
+            {
+                // The part of the source texel inside the destination texel
+                float lo = (j > center - support? (float)j : center - support);
+                float hi = (j + 1 < center + support? (float)(j + 1) : center + support);
+                w = (hi > lo? hi - lo : 0.0f);
+            }
+            else
+                w = gpu_mipmap_kernel(filter, (j + 0.5f - center)/scale);
+
+            // Clamp to the edge
+            index[k] = (j < 0? 0 : (j >= src_size? src_size - 1 : j));
+            weight[k] = w;
+            sum += w;
+        }
+
+        for(k = 0; k < taps->num_taps; ++k)
+            weight[k] /= sum;
+    }
+
+    return GPU_TRUE;
+}
+
+static void gpu_free_mipmap_taps(GPU_MipmapTaps* taps)
+{
+    SDL_free(taps->index);
+    SDL_free(taps->weight);
+    taps->index = NULL;
+    taps->weight = NULL;
+}
+
+// Weighted sum of the RGBA texels at src + (index[k] - index_offset)*stride
+#if defined(GPU_MIPMAP_SSE2)
+static void gpu_mipmap_filter_texel(float* result, const float* src, int stride, const int* index, int index_offset, const float* weight, int num_taps)
+{
+    __m128 sum = _mm_setzero_ps();
+    int k;
+    for(k = 0; k < num_taps; ++k)
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(src + (index[k] - index_offset)*stride), _mm_set1_ps(weight[k])));
+    _mm_storeu_ps(result, sum);
+}
+#elif defined(GPU_MIPMAP_NEON)
+static void gpu_mipmap_filter_texel(float* result, const float* src, int stride, const int* index, int index_offset, const float* weight, int num_taps)
+{
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    int k;
+    for(k = 0; k < num_taps; ++k)
+        sum = vmlaq_n_f32(sum, vld1q_f32(src + (index[k] - index_offset)*stride), weight[k]);
+    vst1q_f32(result, sum);
+}
+#else
+static void gpu_mipmap_filter_texel(float* result, const float* src, int stride, const int* index, int index_offset, const float* weight, int num_taps)
+{
+    float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int k;
+    for(k = 0; k < num_taps; ++k)
+    {
+        const float* texel = src + (index[k] - index_offset)*stride;
+        sum[0] += texel[0]*weight[k];
+        sum[1] += texel[1]*weight[k];
+        sum[2] += texel[2]*weight[k];
+        sum[3] += texel[3]*weight[k];
+    }
+    memcpy(result, sum, sizeof(sum));
+}
+#endif
+
+// Clamps away the ringing of the sharper filters and writes the 8-bit texel
+static void gpu_store_mipmap_texel(float* texel, unsigned char* out, int channels, GPU_bool premultiplied)
+{
+    float alpha = (texel[3] < 0.0f? 0.0f : (texel[3] > 1.0f? 1.0f : texel[3]));
+    int c;
+
+    texel[3] = alpha;
+    for(c = 0; c < 3; ++c)
+    {
+        float value = (texel[c] < 0.0f? 0.0f : (texel[c] > alpha? alpha : texel[c]));
+        texel[c] = value;
+        out[c] = (alpha > 0.0f? gpu_linear_to_srgb(value/alpha) : 0);
+    }
+
+    if(channels == 4)
+    {
+        out[3] = (Uint8)(alpha*255.0f + 0.5f);
+        if(premultiplied)
+        {
+            for(c = 0; c < 3; ++c)
+                out[c] = (Uint8)((out[c]*out[3] + 127)/255);
+        }
+    }
+}
+
+static void gpu_decode_mipmap_band(GPU_MipmapLevelJob* job, int first_row, int end_row)
+{
+    int x, y, c;
+    for(y = first_row; y < end_row; ++y)
+    {
+        const unsigned char* p = job->pixels + y*job->dst_w*job->channels;
+        float* texel = job->dst + y*job->dst_w*4;
+        for(x = 0; x < job->dst_w; ++x)
+        {
+            if(job->channels == 4)
+            {
+                int alpha = p[3];
+                for(c = 0; c < 3; ++c)
+                {
+                    int value = p[c];
+                    if(job->premultiplied)
+                        value = (alpha > 0? (value*255 + alpha/2)/alpha : 0);
+                    texel[c] = gpu_srgb_to_linear[value > 255? 255 : value]*(alpha/255.0f);
+                }
+                texel[3] = alpha/255.0f;
+            }
+            else
+            {
+                for(c = 0; c < 3; ++c)
+                    texel[c] = gpu_srgb_to_linear[p[c]];
+                texel[3] = 1.0f;
+            }
+            p += job->channels;
+            texel += 4;
+        }
+    }
+}
+
+static void gpu_resample_mipmap_band(GPU_MipmapLevelJob* job, int first_row, int end_row)
+{
+    const GPU_MipmapTaps* x_taps = &job->x_taps;
+    const GPU_MipmapTaps* y_taps = &job->y_taps;
+    int first_src_row = job->src_h;
+    int last_src_row = -1;
+    float* rows;
+    int i, x, y;
+
+    // The source rows this band reads
+    for(i = first_row*y_taps->num_taps; i < end_row*y_taps->num_taps; ++i)
+    {
+        if(y_taps->index[i] < first_src_row)
+            first_src_row = y_taps->index[i];
+        if(y_taps->index[i] > last_src_row)
+            last_src_row = y_taps->index[i];
+    }
+
+    rows = (float*)SDL_malloc((last_src_row - first_src_row + 1)*job->dst_w*4*sizeof(float));
+    if(rows == NULL)
+    {
+        // Leave the band transparent black rather than uninitialized
+        memset(job->dst + first_row*job->dst_w*4, 0, (end_row - first_row)*job->dst_w*4*sizeof(float));
+        memset(job->out + first_row*job->dst_w*job->channels, 0, (end_row - first_row)*job->dst_w*job->channels);
+        return;
+    }
+
+    // Horizontal pass into the band's own rows
+    for(y = first_src_row; y <= last_src_row; ++y)
+    {
+        const float* src_row = job->src + y*job->src_w*4;
+        float* row = rows + (y - first_src_row)*job->dst_w*4;
+        for(x = 0; x < job->dst_w; ++x)
+            gpu_mipmap_filter_texel(row + x*4, src_row, 4, x_taps->index + x*x_taps->num_taps, 0, x_taps->weight + x*x_taps->num_taps, x_taps->num_taps);
+    }
+
+    // Vertical pass into the level
+    for(y = first_row; y < end_row; ++y)
+    {
+        float* texel = job->dst + y*job->dst_w*4;
+        unsigned char* out = job->out + y*job->dst_w*job->channels;
+        for(x = 0; x < job->dst_w; ++x)
+        {
+            gpu_mipmap_filter_texel(texel, rows + x*4, job->dst_w*4, y_taps->index + y*y_taps->num_taps, first_src_row, y_taps->weight + y*y_taps->num_taps, y_taps->num_taps);
+            gpu_store_mipmap_texel(texel, out, job->channels, job->premultiplied);
+            texel += 4;
+            out += job->channels;
+        }
+    }
+
+    SDL_free(rows);
+}
+
+static int SDLCALL gpu_run_mipmap_band(void* data)
+{
+    GPU_MipmapBand* band = (GPU_MipmapBand*)data;
+    band->func(band->job, band->first_row, band->end_row);
+    return 0;
+}
+
+// Splits the destination rows of a level between threads
+static void gpu_run_mipmap_bands(GPU_MipmapBandFunc func, GPU_MipmapLevelJob* job, int num_threads)
+{
+    GPU_MipmapBand bands[GPU_MIPMAP_MAX_THREADS];
+    SDL_Thread* threads[GPU_MIPMAP_MAX_THREADS];
+    int num_bands, i;
+
+    // Small levels are not worth the threads
+    num_bands = (int)((Uint64)job->dst_w*job->dst_h/GPU_MIPMAP_MIN_BAND_PIXELS) + 1;
+    if(num_bands > num_threads)
+        num_bands = num_threads;
+    if(num_bands > job->dst_h)
+        num_bands = job->dst_h;
+
+    for(i = 0; i < num_bands; ++i)
+    {
+        bands[i].func = func;
+        bands[i].job = job;
+        bands[i].first_row = job->dst_h*i/num_bands;
+        bands[i].end_row = job->dst_h*(i + 1)/num_bands;
+    }
+
+    // The calling thread takes the first band
+    for(i = 1; i < num_bands; ++i)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        threads[i] = SDL_CreateThread(&gpu_run_mipmap_band, "gpu_build_mipmaps", &bands[i]);
+        #else
+        threads[i] = SDL_CreateThread(&gpu_run_mipmap_band, &bands[i]);
+        #endif
+    }
+    gpu_run_mipmap_band(&bands[0]);
+    for(i = 1; i < num_bands; ++i)
+    {
+        if(threads[i] != NULL)
+            SDL_WaitThread(threads[i], NULL);
+        else
+            gpu_run_mipmap_band(&bands[i]);
+    }
+}
+
+/*! Builds the full mipmap chain of 8-bit RGB or RGBA pixels with tightly packed rows, treating the color as sRGB.
+ * Returns levels 1 and up packed one after another (level i is max(w >> i, 1) by max(h >> i, 1)), or NULL if the image has no smaller levels or memory runs out.
+ * \param premultiplied The alpha of the pixels is premultiplied, and so will be the alpha of the levels.
+ * \param num_threads Bands of each level are resampled on up to this many threads.  0 uses one per CPU core.
+ * \param num_levels Receives the number of levels, counting the base level.
+ * Does not push errors, so it is safe to call from any thread. */
+unsigned char* gpu_build_mipmaps(const unsigned char* pixels, int w, int h, int channels, GPU_bool premultiplied, GPU_MipmapFilterEnum filter, int num_threads, int* num_levels)
+{
+    GPU_MipmapLevelJob job;
+    unsigned char* result;
+    unsigned char* out;
+    float* buffers[2];
+    int levels, level, size, level_w, level_h;
+    Uint32 total_bytes;
+
+    *num_levels = 1;
+    if(pixels == NULL || w < 1 || h < 1 || (channels != 3 && channels != 4) || (w == 1 && h == 1))
+        return NULL;
+
+    if(num_threads <= 0)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        num_threads = SDL_GetCPUCount();
+        #else
+        num_threads = 2;
+        #endif
+    }
+    if(num_threads > GPU_MIPMAP_MAX_THREADS)
+        num_threads = GPU_MIPMAP_MAX_THREADS;
+
+    levels = 1;
+    for(size = (w > h? w : h); size > 1; size >>= 1)
+        levels++;
+
+    total_bytes = 0;
+    for(level = 1; level < levels; ++level)
+    {
+        level_w = (w >> level > 0? w >> level : 1);
+        level_h = (h >> level > 0? h >> level : 1);
+        total_bytes += level_w*level_h*channels;
+    }
+
+    // Levels ping-pong between the base level's buffer and one the size of level 1
+    level_w = (w >> 1 > 0? w >> 1 : 1);
+    level_h = (h >> 1 > 0? h >> 1 : 1);
+    result = (unsigned char*)SDL_malloc(total_bytes);
+    buffers[0] = (float*)SDL_malloc(w*h*4*sizeof(float));
+    buffers[1] = (float*)SDL_malloc(level_w*level_h*4*sizeof(float));
+    if(result == NULL || buffers[0] == NULL || buffers[1] == NULL)
+    {
+        SDL_free(result);
+        SDL_free(buffers[0]);
+        SDL_free(buffers[1]);
+        return NULL;
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.pixels = pixels;
+    job.dst = buffers[0];
+    job.dst_w = w;
+    job.dst_h = h;
+    job.channels = channels;
+    job.premultiplied = (premultiplied && channels == 4);
+    gpu_run_mipmap_bands(&gpu_decode_mipmap_band, &job, num_threads);
+
+    out = result;
+    for(level = 1; level < levels; ++level)
+    {
+        job.src = job.dst;
+        job.src_w = job.dst_w;
+        job.src_h = job.dst_h;
+        job.dst = buffers[level % 2];
+        job.dst_w = (w >> level > 0? w >> level : 1);
+        job.dst_h = (h >> level > 0? h >> level : 1);
+        job.out = out;
+
+        if(!gpu_build_mipmap_taps(&job.x_taps, job.src_w, job.dst_w, filter)
+           || !gpu_build_mipmap_taps(&job.y_taps, job.src_h, job.dst_h, filter))
+        {
+            gpu_free_mipmap_taps(&job.x_taps);
+            SDL_free(result);
+            result = NULL;
+            break;
+        }
+
+        gpu_run_mipmap_bands(&gpu_resample_mipmap_band, &job, num_threads);
+        gpu_free_mipmap_taps(&job.x_taps);
+        gpu_free_mipmap_taps(&job.y_taps);
+
+        out += job.dst_w*job.dst_h*channels;
+    }
+
+    SDL_free(buffers[0]);
+    SDL_free(buffers[1]);
+
+    if(result != NULL)
+        *num_levels = levels;
+    return result;
+}
@@ -0,0 +1,480 @@
+#include "SDL_gpu.h"
+#include <string.h>
+
+// CPU-side pixel conversion for uploads and readbacks: channel swizzles, 24 <-> 32 bit repacking, alpha premultiplication and vertical flips.
+// Each kernel has a scalar version that handles what the vector versions leave over.  SSE2 is used whenever the compiler targets it,
+// AVX2 is picked at runtime, and NEON is used when the compiler targets it.  Define SDL_GPU_DISABLE_SIMD to use only the scalar code.
+
+#ifndef SDL_GPU_DISABLE_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define GPU_PIXELS_SSE2
+        #include <emmintrin.h>
+        // SDL_HasAVX2() arrived in SDL 2.0.2
+        #if defined(SDL_GPU_USE_SDL2) && SDL_VERSION_ATLEAST(2, 0, 2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+            #define GPU_PIXELS_AVX2
+            #include <immintrin.h>
+        #endif
+    #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+        #define GPU_PIXELS_NEON
+        #include <arm_neon.h>
+    #endif
+#endif
+
+// Lets the AVX2 kernels live in this file without compiling everything else for AVX2
+#if defined(GPU_PIXELS_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    #define GPU_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define GPU_TARGET_AVX2
+#endif
+
+// An entry of a byte order that writes 255 instead of copying a source byte
+#define GPU_PIXEL_OPAQUE 4
+
+#define GPU_FLIP_CHUNK_SIZE 4096
+
+
+#ifdef GPU_PIXELS_AVX2
+static int has_avx2 = -1;
+
+static GPU_bool gpu_has_avx2(void)
+{
+    if(has_avx2 < 0)
+        has_avx2 = (SDL_HasAVX2()? 1 : 0);
+    return (has_avx2 != 0);
+}
+#endif
+
+// Finds the byte that holds a channel.  Returns -1 if the channel is not a whole byte.
+static int gpu_get_channel_byte(Uint32 mask, int bytes_per_pixel)
+{
+    int i;
+    for(i = 0; i < bytes_per_pixel; ++i)
+    {
+        if(mask == ((Uint32)0xFF << (8*i)))
+        {
+            #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            return bytes_per_pixel - 1 - i;
+            #else
+            return i;
+            #endif
+        }
+    }
+    return -1;
+}
+
+/*! Fills 'order' with the source byte for each destination byte, for use with gpu_convert_pixels().
+ * Destination bytes without a source channel (e.g. alpha from an RGB source) become GPU_PIXEL_OPAQUE.
+ * Returns GPU_FALSE unless both formats are 24 or 32 bits per pixel with one byte per channel. */
+GPU_bool gpu_get_pixel_order(const SDL_PixelFormat* src_format, const SDL_PixelFormat* dst_format, Uint8* order)
+{
+    const Uint32 src_masks[4] = {src_format->Rmask, src_format->Gmask, src_format->Bmask, src_format->Amask};
+    const Uint32 dst_masks[4] = {dst_format->Rmask, dst_format->Gmask, dst_format->Bmask, dst_format->Amask};
+    int src_bpp = src_format->BytesPerPixel;
+    int dst_bpp = dst_format->BytesPerPixel;
+    int i, c;
+
+    if((src_bpp != 3 && src_bpp != 4) || (dst_bpp != 3 && dst_bpp != 4))
+        return GPU_FALSE;
+
+    for(i = 0; i < dst_bpp; ++i)
+        order[i] = GPU_PIXEL_OPAQUE;
+
+    for(c = 0; c < 4; ++c)
+    {
+        int src_byte, dst_byte;
+
+        if(dst_masks[c] == 0)
+            continue;
+        dst_byte = gpu_get_channel_byte(dst_masks[c], dst_bpp);
+        if(dst_byte < 0)
+            return GPU_FALSE;
+
+        if(src_masks[c] == 0)
+        {
+            // Only a missing alpha channel has an obvious value
+            if(c != 3)
+                return GPU_FALSE;
+            continue;
+        }
+        src_byte = gpu_get_channel_byte(src_masks[c], src_bpp);
+        if(src_byte < 0)
+            return GPU_FALSE;
+        order[dst_byte] = (Uint8)src_byte;
+    }
+
+    return GPU_TRUE;
+}
+
+static void convert_pixels_scalar(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    unsigned char source[GPU_PIXEL_OPAQUE + 1];
+    int i, k;
+
+    source[GPU_PIXEL_OPAQUE] = 255;
+    for(i = 0; i < num_pixels; ++i)
+    {
+        for(k = 0; k < src_bpp; ++k)
+            source[k] = src[k];
+        for(k = 0; k < dst_bpp; ++k)
+            dst[k] = source[order[k]];
+        src += src_bpp;
+        dst += dst_bpp;
+    }
+}
+
+#if defined(GPU_PIXELS_SSE2) || defined(GPU_PIXELS_AVX2)
+static Uint32 get_opaque_bits(const Uint8* order)
+{
+    Uint32 bits = 0;
+    int k;
+    for(k = 0; k < 4; ++k)
+    {
+        if(order[k] == GPU_PIXEL_OPAQUE)
+            bits |= (Uint32)0xFF << (8*k);
+    }
+    return bits;
+}
+#endif
+
+#ifdef GPU_PIXELS_SSE2
+// 32 -> 32 bits.  SSE2 has no byte shuffle, so each channel is shifted into place within its 32-bit lane.
+static int permute4_sse2(unsigned char* dst, const unsigned char* src, const Uint8* order, int num_pixels)
+{
+    __m128i byte_mask = _mm_set1_epi32(0xFF);
+    __m128i opaque = _mm_set1_epi32((int)get_opaque_bits(order));
+    __m128i shift_in[4];
+    __m128i shift_out[4];
+    int num_channels = 0;
+    int i, k;
+
+    for(k = 0; k < 4; ++k)
+    {
+        if(order[k] == GPU_PIXEL_OPAQUE)
+            continue;
+        shift_in[num_channels] = _mm_cvtsi32_si128(8*order[k]);
+        shift_out[num_channels] = _mm_cvtsi32_si128(8*k);
+        num_channels++;
+    }
+
+    for(i = 0; i + 4 <= num_pixels; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 4*i));
+        __m128i out = opaque;
+        for(k = 0; k < num_channels; ++k)
+            out = _mm_or_si128(out, _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(v, shift_in[k]), byte_mask), shift_out[k]));
+        _mm_storeu_si128((__m128i*)(dst + 4*i), out);
+    }
+    return i;
+}
+#endif
+
+#ifdef GPU_PIXELS_AVX2
+// 32 -> 32 bits, 8 pixels at a time
+static GPU_TARGET_AVX2 int permute4_avx2(unsigned char* dst, const unsigned char* src, const Uint8* order, int num_pixels)
+{
+    char mask[32];
+    __m256i shuffle, opaque;
+    int i, k;
+
+    for(i = 0; i < 32; ++i)
+    {
+        k = i % 4;
+        mask[i] = (char)(order[k] == GPU_PIXEL_OPAQUE? 0x80 : (i % 16) - k + order[k]);
+    }
+    shuffle = _mm256_loadu_si256((const __m256i*)mask);
+    opaque = _mm256_set1_epi32((int)get_opaque_bits(order));
+
+    for(i = 0; i + 8 <= num_pixels; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(src + 4*i));
+        _mm256_storeu_si256((__m256i*)(dst + 4*i), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), opaque));
+    }
+    return i;
+}
+
+// 24 -> 32 bits, 4 pixels at a time.  Each load reads 16 bytes, so the last few pixels are left for the scalar code.
+static GPU_TARGET_AVX2 int expand3_avx2(unsigned char* dst, const unsigned char* src, const Uint8* order, int num_pixels)
+{
+    char mask[16];
+    __m128i shuffle, opaque;
+    int i, k;
+
+    for(i = 0; i < 16; ++i)
+    {
+        k = i % 4;
+        mask[i] = (char)(order[k] == GPU_PIXEL_OPAQUE? 0x80 : 3*(i/4) + order[k]);
+    }
+    shuffle = _mm_loadu_si128((const __m128i*)mask);
+    opaque = _mm_set1_epi32((int)get_opaque_bits(order));
+
+    for(i = 0; i + 6 <= num_pixels; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 3*i));
+        _mm_storeu_si128((__m128i*)(dst + 4*i), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), opaque));
+    }
+    return i;
+}
+#endif
+
+#ifdef GPU_PIXELS_NEON
+// Any combination of 24 and 32 bits: the interleaved loads and stores split pixels into channel planes
+static int convert_neon(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    uint8x16_t planes[GPU_PIXEL_OPAQUE + 1];
+    int i;
+
+    planes[GPU_PIXEL_OPAQUE] = vdupq_n_u8(255);
+    for(i = 0; i + 16 <= num_pixels; i += 16)
+    {
+        if(src_bpp == 4)
+        {
+            uint8x16x4_t v = vld4q_u8(src + 4*i);
+            planes[0] = v.val[0];
+            planes[1] = v.val[1];
+            planes[2] = v.val[2];
+            planes[3] = v.val[3];
+        }
+        else
+        {
+            uint8x16x3_t v = vld3q_u8(src + 3*i);
+            planes[0] = v.val[0];
+            planes[1] = v.val[1];
+            planes[2] = v.val[2];
+        }
+
+        if(dst_bpp == 4)
+        {
+            uint8x16x4_t out;
+            out.val[0] = planes[order[0]];
+            out.val[1] = planes[order[1]];
+            out.val[2] = planes[order[2]];
+            out.val[3] = planes[order[3]];
+            vst4q_u8(dst + 4*i, out);
+        }
+        else
+        {
+            uint8x16x3_t out;
+            out.val[0] = planes[order[0]];
+            out.val[1] = planes[order[1]];
+            out.val[2] = planes[order[2]];
+            vst3q_u8(dst + 3*i, out);
+        }
+    }
+    return i;
+}
+#endif
+
+static void convert_pixel_span(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    int done = 0;
+
+    #if defined(GPU_PIXELS_NEON)
+    done = convert_neon(dst, dst_bpp, src, src_bpp, order, num_pixels);
+    #else
+    if(src_bpp == 4 && dst_bpp == 4)
+    {
+        #ifdef GPU_PIXELS_AVX2
+        if(gpu_has_avx2())
+            done = permute4_avx2(dst, src, order, num_pixels);
+        #endif
+        #ifdef GPU_PIXELS_SSE2
+        done += permute4_sse2(dst + 4*done, src + 4*done, order, num_pixels - done);
+        #endif
+    }
+    #ifdef GPU_PIXELS_AVX2
+    else if(src_bpp == 3 && dst_bpp == 4 && gpu_has_avx2())
+        done = expand3_avx2(dst, src, order, num_pixels);
+    #endif
+    #endif
+
+    convert_pixels_scalar(dst + dst_bpp*done, dst_bpp, src + src_bpp*done, src_bpp, order, num_pixels - done);
+}
+
+/*! Converts rows of 24 or 32 bit pixels using a byte order from gpu_get_pixel_order().
+ * A negative source pitch (with 'src' pointing at the last row) flips the image vertically as it converts. */
+void gpu_convert_pixels(unsigned char* dst, int dst_pitch, int dst_bpp, const unsigned char* src, int src_pitch, int src_bpp, const Uint8* order, int w, int h)
+{
+    int y;
+
+    // Contiguous rows are one long span
+    if(dst_pitch == w*dst_bpp && src_pitch == w*src_bpp)
+    {
+        w *= h;
+        h = 1;
+    }
+
+    for(y = 0; y < h; ++y)
+    {
+        convert_pixel_span(dst, dst_bpp, src, src_bpp, order, w);
+        dst += dst_pitch;
+        src += src_pitch;
+    }
+}
+
+
+static void premultiply_scalar(unsigned char* pixels, int num_pixels)
+{
+    int i, k;
+    for(i = 0; i < num_pixels; ++i, pixels += 4)
+    {
+        unsigned int a = pixels[3];
+        for(k = 0; k < 3; ++k)
+        {
+            // Rounded c*a/255
+            unsigned int t = pixels[k]*a + 128;
+            pixels[k] = (unsigned char)((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+static void unpremultiply_scalar(unsigned char* pixels, int num_pixels)
+{
+    int i, k;
+    for(i = 0; i < num_pixels; ++i, pixels += 4)
+    {
+        float a = pixels[3];
+        for(k = 0; k < 3; ++k)
+        {
+            if(pixels[3] == 0)
+                pixels[k] = 0;
+            else
+            {
+                // The same operations as the vector code, so both round alike
+                int c = (int)(pixels[k]*255.0f/a + 0.5f);
+                pixels[k] = (unsigned char)(c > 255? 255 : c);
+            }
+        }
+    }
+}
+
+#ifdef GPU_PIXELS_SSE2
+static int premultiply_sse2(unsigned char* pixels, int num_pixels)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i round = _mm_set1_epi16(128);
+    __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    int i;
+
+    for(i = 0; i + 4 <= num_pixels; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pixels + 4*i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i alpha_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, 0xFF), 0xFF);
+        __m128i alpha_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, 0xFF), 0xFF);
+        __m128i out;
+
+        lo = _mm_add_epi16(_mm_mullo_epi16(lo, alpha_lo), round);
+        hi = _mm_add_epi16(_mm_mullo_epi16(hi, alpha_hi), round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        out = _mm_packus_epi16(lo, hi);
+        out = _mm_or_si128(_mm_andnot_si128(alpha_mask, out), _mm_and_si128(alpha_mask, v));
+        _mm_storeu_si128((__m128i*)(pixels + 4*i), out);
+    }
+    return i;
+}
+
+static int unpremultiply_sse2(unsigned char* pixels, int num_pixels)
+{
+    __m128i byte_mask = _mm_set1_epi32(0xFF);
+    __m128 scale = _mm_set1_ps(255.0f);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 zero = _mm_setzero_ps();
+    int i, k;
+
+    for(i = 0; i + 4 <= num_pixels; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(pixels + 4*i));
+        __m128i alpha_bits = _mm_srli_epi32(v, 24);
+        __m128 a = _mm_cvtepi32_ps(alpha_bits);
+        // Zero alpha divides to infinity, which is masked to zero below
+        __m128 nonzero = _mm_cmpneq_ps(a, zero);
+        __m128i out = _mm_slli_epi32(alpha_bits, 24);
+
+        for(k = 0; k < 3; ++k)
+        {
+            __m128 c = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(v, 8*k), byte_mask));
+            __m128 r = _mm_add_ps(_mm_div_ps(_mm_mul_ps(c, scale), a), half);
+            __m128i ri = _mm_cvttps_epi32(_mm_and_ps(_mm_min_ps(r, scale), nonzero));
+            out = _mm_or_si128(out, _mm_slli_epi32(ri, 8*k));
+        }
+        _mm_storeu_si128((__m128i*)(pixels + 4*i), out);
+    }
+    return i;
+}
+#endif
+
+#ifdef GPU_PIXELS_NEON
+static int premultiply_neon(unsigned char* pixels, int num_pixels)
+{
+    int i, k;
+    for(i = 0; i + 16 <= num_pixels; i += 16)
+    {
+        uint8x16x4_t v = vld4q_u8(pixels + 4*i);
+        for(k = 0; k < 3; ++k)
+        {
+            // (x + ((x + 128) >> 8) + 128) >> 8 is the rounded x/255
+            uint16x8_t lo = vmull_u8(vget_low_u8(v.val[k]), vget_low_u8(v.val[3]));
+            uint16x8_t hi = vmull_u8(vget_high_u8(v.val[k]), vget_high_u8(v.val[3]));
+            v.val[k] = vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+        }
+        vst4q_u8(pixels + 4*i, v);
+    }
+    return i;
+}
+#endif
+
+/*! Multiplies the color of 32-bit pixels by their alpha, which must be the last byte of each pixel (RGBA or BGRA). */
+void gpu_premultiply_alpha(unsigned char* pixels, int pitch, int w, int h)
+{
+    int y;
+    for(y = 0; y < h; ++y, pixels += pitch)
+    {
+        int done = 0;
+        #if defined(GPU_PIXELS_SSE2)
+        done = premultiply_sse2(pixels, w);
+        #elif defined(GPU_PIXELS_NEON)
+        done = premultiply_neon(pixels, w);
+        #endif
+        premultiply_scalar(pixels + 4*done, w - done);
+    }
+}
+
+/*! Divides the color of 32-bit pixels by their alpha, which must be the last byte of each pixel (RGBA or BGRA).
+ * Fully transparent pixels become transparent black. */
+void gpu_unpremultiply_alpha(unsigned char* pixels, int pitch, int w, int h)
+{
+    int y;
+    for(y = 0; y < h; ++y, pixels += pitch)
+    {
+        int done = 0;
+        #if defined(GPU_PIXELS_SSE2)
+        done = unpremultiply_sse2(pixels, w);
+        #endif
+        unpremultiply_scalar(pixels + 4*done, w - done);
+    }
+}
+
+/*! Flips rows in place, e.g. to turn OpenGL's bottom-up readback into top-down order. */
+void gpu_flip_rows(unsigned char* pixels, int pitch, int row_bytes, int h)
+{
+    unsigned char chunk[GPU_FLIP_CHUNK_SIZE];
+    int y;
+
+    for(y = 0; y < h/2; ++y)
+    {
+        unsigned char* top = pixels + y*pitch;
+        unsigned char* bottom = pixels + (h - 1 - y)*pitch;
+        int offset;
+
+        for(offset = 0; offset < row_bytes; offset += GPU_FLIP_CHUNK_SIZE)
+        {
+            int n = (row_bytes - offset < GPU_FLIP_CHUNK_SIZE? row_bytes - offset : GPU_FLIP_CHUNK_SIZE);
+            memcpy(chunk, top + offset, n);
+            memcpy(top + offset, bottom + offset, n);
+            memcpy(bottom + offset, chunk, n);
+        }
+    }
+}
@@ -0,0 +1,719 @@
+#include "SDL_gpu.h"
+#include <string.h>
+
+// PNG writing for GPU_SaveSurface() and friends.
+// The image is split into bands of rows.  Each band is filtered and deflated on its own thread into DEFLATE blocks that end on a byte boundary,
+// so the bands are simply written one after another as consecutive IDAT chunks.  The zlib checksum of the whole stream is combined from the band checksums.
+
+#define GPU_PNG_MAX_THREADS 16
+#define GPU_PNG_MIN_BAND_BYTES (256*1024)
+#define GPU_WRITE_BUFFER_SIZE (256*1024)
+
+#define GPU_DEFLATE_WINDOW_SIZE 32768
+#define GPU_DEFLATE_HASH_BITS 15
+#define GPU_DEFLATE_MAX_MATCH 258
+#define GPU_DEFLATE_MAX_STORED 65535
+
+#define GPU_ADLER_BASE 65521
+
+
+/*! Collects small writes into large SDL_RWwrite() calls */
+typedef struct GPU_WriteBuffer
+{
+    SDL_RWops* rwops;
+    unsigned char* data;  // NULL if the buffer could not be allocated, in which case writes go straight through
+    int size;
+    GPU_bool failed;
+} GPU_WriteBuffer;
+
+GPU_WriteBuffer* gpu_open_write_buffer(SDL_RWops* rwops)
+{
+    GPU_WriteBuffer* buffer = (GPU_WriteBuffer*)SDL_malloc(sizeof(GPU_WriteBuffer));
+    if(buffer == NULL)
+        return NULL;
+
+    buffer->rwops = rwops;
+    buffer->data = (unsigned char*)SDL_malloc(GPU_WRITE_BUFFER_SIZE);
+    buffer->size = 0;
+    buffer->failed = GPU_FALSE;
+    return buffer;
+}
+
+static void gpu_flush_write_buffer(GPU_WriteBuffer* buffer)
+{
+    if(buffer->size > 0 && !buffer->failed)
+        buffer->failed = (SDL_RWwrite(buffer->rwops, buffer->data, buffer->size, 1) != 1);
+    buffer->size = 0;
+}
+
+// Has the signature of stbi_write_func, so stb_image_write can use the buffer too
+void gpu_write_buffered(void* context, void* data, int size)
+{
+    GPU_WriteBuffer* buffer = (GPU_WriteBuffer*)context;
+
+    if(buffer->failed || size <= 0)
+        return;
+
+    if(buffer->data == NULL || size >= GPU_WRITE_BUFFER_SIZE)
+    {
+        // Large writes gain nothing from another copy
+        gpu_flush_write_buffer(buffer);
+        if(!buffer->failed)
+            buffer->failed = (SDL_RWwrite(buffer->rwops, data, size, 1) != 1);
+        return;
+    }
+
+    if(buffer->size + size > GPU_WRITE_BUFFER_SIZE)
+        gpu_flush_write_buffer(buffer);
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+}
+
+// Flushes and frees the buffer.  Returns GPU_FALSE if any write failed.
+GPU_bool gpu_close_write_buffer(GPU_WriteBuffer* buffer)
+{
+    GPU_bool result;
+
+    if(buffer == NULL)
+        return GPU_FALSE;
+
+    gpu_flush_write_buffer(buffer);
+    result = !buffer->failed;
+    SDL_free(buffer->data);
+    SDL_free(buffer);
+    return result;
+}
+
+
+
+// CRC-32 (polynomial 0xEDB88320) of each byte value.  A constant, so the encoder threads can share it.
+static const Uint32 crc_table[256] = {
+    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
+    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
+    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
+    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
+    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
+    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
+    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
+    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
+    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
+    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
+    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
+    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
+    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
+    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
+    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
+    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
+    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
+    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
+    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
+    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
+    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
+    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
+    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
+    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
+    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
+    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
+    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
+    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
+    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
+    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
+    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
+    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
+    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
+    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
+    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
+    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
+    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
+    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
+    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
+    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
+    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
+    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
+    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
+};
+
+// Continues a CRC that started at 0xFFFFFFFF.  The final CRC is the result XOR 0xFFFFFFFF.
+static Uint32 gpu_update_crc(Uint32 crc, const unsigned char* data, int size)
+{
+    int i;
+    for(i = 0; i < size; ++i)
+        crc = crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+static Uint32 gpu_adler32(const unsigned char* data, int size)
+{
+    Uint32 a = 1, b = 0;
+
+    while(size > 0)
+    {
+        // The largest run that cannot overflow before the modulo
+        int n = (size < 5552? size : 5552);
+        size -= n;
+        while(n-- > 0)
+        {
+            a += *data++;
+            b += a;
+        }
+        a %= GPU_ADLER_BASE;
+        b %= GPU_ADLER_BASE;
+    }
+
+    return (b << 16) | a;
+}
+
+// Checksum of the concatenation of two blocks, given the length of the second (as in zlib's adler32_combine())
+static Uint32 gpu_adler32_combine(Uint32 adler1, Uint32 adler2, Uint32 size2)
+{
+    Uint32 rem = size2 % GPU_ADLER_BASE;
+    Uint32 sum1 = adler1 & 0xFFFF;
+    Uint32 sum2 = (rem * sum1) % GPU_ADLER_BASE;
+
+    sum1 += (adler2 & 0xFFFF) + GPU_ADLER_BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + GPU_ADLER_BASE - rem;
+    if(sum1 >= GPU_ADLER_BASE)
+        sum1 -= GPU_ADLER_BASE;
+    if(sum1 >= GPU_ADLER_BASE)
+        sum1 -= GPU_ADLER_BASE;
+    if(sum2 >= 2*GPU_ADLER_BASE)
+        sum2 -= 2*GPU_ADLER_BASE;
+    if(sum2 >= GPU_ADLER_BASE)
+        sum2 -= GPU_ADLER_BASE;
+    return (sum2 << 16) | sum1;
+}
+
+
+
+static unsigned char gpu_paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = (p > a? p - a : a - p);
+    int pb = (p > b? p - b : b - p);
+    int pc = (p > c? p - c : c - p);
+    if(pa <= pb && pa <= pc)
+        return (unsigned char)a;
+    if(pb <= pc)
+        return (unsigned char)b;
+    return (unsigned char)c;
+}
+
+// Writes the filter type byte and the filtered row.  'prior' is NULL for the first row of the image.
+static void gpu_filter_row(unsigned char* out, const unsigned char* row, const unsigned char* prior, int row_bytes, int bpp, GPU_PNGFilterEnum filter)
+{
+    int i;
+
+    switch(filter)
+    {
+    case GPU_PNG_FILTER_SUB:
+        *out++ = 1;
+        for(i = 0; i < bpp; ++i)
+            out[i] = row[i];
+        for(; i < row_bytes; ++i)
+            out[i] = (unsigned char)(row[i] - row[i - bpp]);
+        break;
+    case GPU_PNG_FILTER_UP:
+        *out++ = 2;
+        for(i = 0; i < row_bytes; ++i)
+            out[i] = (unsigned char)(row[i] - (prior != NULL? prior[i] : 0));
+        break;
+    case GPU_PNG_FILTER_AVERAGE:
+        *out++ = 3;
+        for(i = 0; i < row_bytes; ++i)
+        {
+            int a = (i >= bpp? row[i - bpp] : 0);
+            int b = (prior != NULL? prior[i] : 0);
+            out[i] = (unsigned char)(row[i] - ((a + b) >> 1));
+        }
+        break;
+    case GPU_PNG_FILTER_PAETH:
+        *out++ = 4;
+        for(i = 0; i < row_bytes; ++i)
+        {
+            int a = (i >= bpp? row[i - bpp] : 0);
+            int b = (prior != NULL? prior[i] : 0);
+            int c = (i >= bpp && prior != NULL? prior[i - bpp] : 0);
+            out[i] = (unsigned char)(row[i] - gpu_paeth(a, b, c));
+        }
+        break;
+    default:
+        *out++ = 0;
+        memcpy(out, row, row_bytes);
+        break;
+    }
+}
+
+// The usual heuristic: the filter that leaves the smallest sum of signed residuals tends to compress best
+static Uint32 gpu_filter_cost(const unsigned char* filtered, int row_bytes)
+{
+    Uint32 cost = 0;
+    int i;
+    for(i = 1; i <= row_bytes; ++i)
+    {
+        int v = (signed char)filtered[i];
+        cost += (v < 0? -v : v);
+    }
+    return cost;
+}
+
+
+
+/*! Accumulates DEFLATE output, least significant bit first */
+typedef struct GPU_BitWriter
+{
+    unsigned char* data;
+    int size;
+    Uint32 bits;
+    int num_bits;
+} GPU_BitWriter;
+
+static const unsigned short length_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const unsigned char length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const unsigned char dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Hash chain length searched at each compression level
+static const int max_chain_for_level[10] = {0, 4, 8, 16, 32, 64, 128, 256, 1024, 4096};
+
+static void gpu_put_bits(GPU_BitWriter* writer, Uint32 value, int num_bits)
+{
+    writer->bits |= value << writer->num_bits;
+    writer->num_bits += num_bits;
+    while(writer->num_bits >= 8)
+    {
+        writer->data[writer->size++] = (unsigned char)writer->bits;
+        writer->bits >>= 8;
+        writer->num_bits -= 8;
+    }
+}
+
+static void gpu_align_bits(GPU_BitWriter* writer)
+{
+    if(writer->num_bits > 0)
+        gpu_put_bits(writer, 0, 8 - writer->num_bits);
+}
+
+// Huffman codes are packed starting from their most significant bit
+static void gpu_put_code(GPU_BitWriter* writer, Uint32 code, int num_bits)
+{
+    Uint32 reversed = 0;
+    int i;
+    for(i = 0; i < num_bits; ++i)
+    {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    gpu_put_bits(writer, reversed, num_bits);
+}
+
+// Writes a literal/length symbol with the fixed Huffman code
+static void gpu_put_symbol(GPU_BitWriter* writer, int symbol)
+{
+    if(symbol <= 143)
+        gpu_put_code(writer, 0x30 + symbol, 8);
+    else if(symbol <= 255)
+        gpu_put_code(writer, 0x190 + symbol - 144, 9);
+    else if(symbol <= 279)
+        gpu_put_code(writer, symbol - 256, 7);
+    else
+        gpu_put_code(writer, 0xC0 + symbol - 280, 8);
+}
+
+static void gpu_put_match(GPU_BitWriter* writer, int length, int dist)
+{
+    int code = 28;
+    while(length_base[code] > length)
+        code--;
+    gpu_put_symbol(writer, 257 + code);
+    gpu_put_bits(writer, length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while(dist_base[code] > dist)
+        code--;
+    gpu_put_code(writer, code, 5);
+    gpu_put_bits(writer, dist - dist_base[code], dist_extra[code]);
+}
+
+static Uint32 gpu_hash3(const unsigned char* p)
+{
+    return ((((Uint32)p[0] << 16) | ((Uint32)p[1] << 8) | p[2]) * 2654435761u) >> (32 - GPU_DEFLATE_HASH_BITS);
+}
+
+// Compresses 'data' into DEFLATE blocks that end on a byte boundary.  Unless this is the last band, the blocks are not final,
+// so the output of the next band can follow directly.  Returns GPU_FALSE if the match tables could not be allocated.
+static GPU_bool gpu_deflate_band(GPU_BitWriter* writer, const unsigned char* data, int size, int level, GPU_bool is_last)
+{
+    int* head;
+    int* prev;
+    int max_chain, nice_length, max_insert;
+    int i;
+
+    if(level <= 0)
+    {
+        // Stored blocks
+        for(i = 0; i < size; i += GPU_DEFLATE_MAX_STORED)
+        {
+            int n = (size - i < GPU_DEFLATE_MAX_STORED? size - i : GPU_DEFLATE_MAX_STORED);
+            gpu_put_bits(writer, (is_last && i + n == size), 1);
+            gpu_put_bits(writer, 0, 2);
+            gpu_align_bits(writer);
+            gpu_put_bits(writer, n & 0xFFFF, 16);
+            gpu_put_bits(writer, ~n & 0xFFFF, 16);
+            memcpy(writer->data + writer->size, data + i, n);
+            writer->size += n;
+        }
+        return GPU_TRUE;
+    }
+
+    head = (int*)SDL_malloc(sizeof(int) << GPU_DEFLATE_HASH_BITS);
+    prev = (int*)SDL_malloc(sizeof(int) * GPU_DEFLATE_WINDOW_SIZE);
+    if(head == NULL || prev == NULL)
+    {
+        SDL_free(head);
+        SDL_free(prev);
+        return GPU_FALSE;
+    }
+    for(i = 0; i < (1 << GPU_DEFLATE_HASH_BITS); ++i)
+        head[i] = -1;
+
+    if(level > 9)
+        level = 9;
+    max_chain = max_chain_for_level[level];
+    nice_length = (level < 4? 32 : level < 7? 128 : GPU_DEFLATE_MAX_MATCH);
+    // Fast levels skip indexing the inside of long matches
+    max_insert = (level < 4? 8 : GPU_DEFLATE_MAX_MATCH);
+
+    // One block with the fixed Huffman codes
+    gpu_put_bits(writer, is_last, 1);
+    gpu_put_bits(writer, 1, 2);
+
+    i = 0;
+    while(i < size)
+    {
+        int best_length = 0;
+        int best_dist = 0;
+
+        if(i + 3 <= size)
+        {
+            Uint32 hash = gpu_hash3(data + i);
+            int max_length = (size - i < GPU_DEFLATE_MAX_MATCH? size - i : GPU_DEFLATE_MAX_MATCH);
+            int candidate = head[hash];
+            int chain = max_chain;
+
+            while(candidate >= 0 && i - candidate <= GPU_DEFLATE_WINDOW_SIZE && chain-- > 0)
+            {
+                if(data[candidate + best_length] == data[i + best_length])
+                {
+                    int length = 0;
+                    while(length < max_length && data[candidate + length] == data[i + length])
+                        length++;
+                    if(length > best_length)
+                    {
+                        best_length = length;
+                        best_dist = i - candidate;
+                        if(length >= nice_length || length == max_length)
+                            break;
+                    }
+                }
+                candidate = prev[candidate & (GPU_DEFLATE_WINDOW_SIZE - 1)];
+            }
+
+            prev[i & (GPU_DEFLATE_WINDOW_SIZE - 1)] = head[hash];
+            head[hash] = i;
+        }
+
+        if(best_length >= 3)
+        {
+            int end = i + best_length;
+            gpu_put_match(writer, best_length, best_dist);
+
+            // Index the matched bytes too, so later data can refer into them
+            if(best_length <= max_insert)
+            {
+                for(i = i + 1; i < end && i + 3 <= size; ++i)
+                {
+                    Uint32 hash = gpu_hash3(data + i);
+                    prev[i & (GPU_DEFLATE_WINDOW_SIZE - 1)] = head[hash];
+                    head[hash] = i;
+                }
+            }
+            i = end;
+        }
+        else
+        {
+            gpu_put_symbol(writer, data[i]);
+            i++;
+        }
+    }
+
+    // End of block
+    gpu_put_symbol(writer, 256);
+    if(!is_last)
+    {
+        // An empty stored block brings the stream to a byte boundary
+        gpu_put_bits(writer, 0, 3);
+        gpu_align_bits(writer);
+        gpu_put_bits(writer, 0x0000, 16);
+        gpu_put_bits(writer, 0xFFFF, 16);
+    }
+    gpu_align_bits(writer);
+
+    SDL_free(head);
+    SDL_free(prev);
+    return GPU_TRUE;
+}
+
+
+
+/*! A band of rows that one thread filters and compresses */
+typedef struct GPU_PNGBand
+{
+    const unsigned char* pixels;
+    int pitch;
+    int first_row;
+    int num_rows;
+    int row_bytes;
+    int bpp;
+    GPU_PNGFilterEnum filter;
+    int level;
+    GPU_bool is_last;
+
+    unsigned char* data;  // "IDAT" followed by the compressed band, ready to be written as a chunk
+    int size;  // Bytes of compressed data after "IDAT"
+    int filtered_size;
+    Uint32 adler;
+    Uint32 crc;  // Not finalized, so the last band can still add the stream checksum
+    GPU_bool ok;
+} GPU_PNGBand;
+
+static int SDLCALL gpu_encode_png_band(void* userdata)
+{
+    GPU_PNGBand* band = (GPU_PNGBand*)userdata;
+    int filtered_row_bytes = band->row_bytes + 1;
+    unsigned char* filtered;
+    unsigned char* scratch = NULL;
+    GPU_BitWriter writer;
+    int y;
+
+    band->ok = GPU_FALSE;
+    band->filtered_size = band->num_rows * filtered_row_bytes;
+
+    filtered = (unsigned char*)SDL_malloc(band->filtered_size);
+    if(band->filter == GPU_PNG_FILTER_ADAPTIVE)
+        scratch = (unsigned char*)SDL_malloc(2*filtered_row_bytes);
+    // Room for the chunk type, a zlib header and the worst case of fixed Huffman codes
+    band->data = (unsigned char*)SDL_malloc(4 + 2 + band->filtered_size + band->filtered_size/2 + 64);
+    if(filtered == NULL || band->data == NULL || (band->filter == GPU_PNG_FILTER_ADAPTIVE && scratch == NULL))
+    {
+        SDL_free(filtered);
+        SDL_free(scratch);
+        return 0;
+    }
+
+    for(y = 0; y < band->num_rows; ++y)
+    {
+        int row = band->first_row + y;
+        const unsigned char* pixels = band->pixels + row*band->pitch;
+        const unsigned char* prior = (row > 0? pixels - band->pitch : NULL);
+        unsigned char* out = filtered + y*filtered_row_bytes;
+
+        if(band->filter == GPU_PNG_FILTER_ADAPTIVE)
+        {
+            Uint32 best_cost = 0xFFFFFFFF;
+            int f;
+            for(f = GPU_PNG_FILTER_NONE; f <= GPU_PNG_FILTER_PAETH; ++f)
+            {
+                unsigned char* candidate = scratch + (f & 1)*filtered_row_bytes;
+                Uint32 cost;
+                gpu_filter_row(candidate, pixels, prior, band->row_bytes, band->bpp, (GPU_PNGFilterEnum)f);
+                cost = gpu_filter_cost(candidate, band->row_bytes);
+                if(cost < best_cost)
+                {
+                    best_cost = cost;
+                    memcpy(out, candidate, filtered_row_bytes);
+                }
+            }
+        }
+        else
+            gpu_filter_row(out, pixels, prior, band->row_bytes, band->bpp, band->filter);
+    }
+
+    band->adler = gpu_adler32(filtered, band->filtered_size);
+
+    memcpy(band->data, "IDAT", 4);
+    writer.data = band->data + 4;
+    writer.size = 0;
+    writer.bits = 0;
+    writer.num_bits = 0;
+
+    if(band->first_row == 0)
+    {
+        // zlib header: deflate with a 32K window, check bits, no dictionary
+        gpu_put_bits(&writer, 0x78, 8);
+        gpu_put_bits(&writer, 0x01, 8);
+    }
+    band->ok = gpu_deflate_band(&writer, filtered, band->filtered_size, band->level, band->is_last);
+    band->size = writer.size;
+
+    band->crc = gpu_update_crc(0xFFFFFFFF, band->data, 4 + band->size);
+
+    SDL_free(filtered);
+    SDL_free(scratch);
+    return 0;
+}
+
+static void gpu_put_u32_be(unsigned char* p, Uint32 value)
+{
+    p[0] = (unsigned char)(value >> 24);
+    p[1] = (unsigned char)(value >> 16);
+    p[2] = (unsigned char)(value >> 8);
+    p[3] = (unsigned char)value;
+}
+
+static void gpu_write_png_chunk(GPU_WriteBuffer* buffer, const char* type, const unsigned char* data, int size)
+{
+    unsigned char bytes[4];
+    Uint32 crc;
+
+    gpu_put_u32_be(bytes, size);
+    gpu_write_buffered(buffer, bytes, 4);
+    gpu_write_buffered(buffer, (void*)type, 4);
+    gpu_write_buffered(buffer, (void*)data, size);
+
+    crc = gpu_update_crc(gpu_update_crc(0xFFFFFFFF, (const unsigned char*)type, 4), data, size);
+    gpu_put_u32_be(bytes, crc ^ 0xFFFFFFFF);
+    gpu_write_buffered(buffer, bytes, 4);
+}
+
+// Writes 8-bit grey, grey+alpha, RGB or RGBA pixels (1-4 components) as a PNG.  Does not push errors, so it is safe to call from any thread.
+GPU_bool gpu_write_png(SDL_RWops* rwops, int w, int h, int comp, const unsigned char* pixels, int pitch, const GPU_SaveOptions* options)
+{
+    static const unsigned char signature[8] = {137, 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    static const unsigned char color_types[5] = {0, 0, 4, 2, 6};
+    GPU_PNGBand bands[GPU_PNG_MAX_THREADS];
+    SDL_Thread* threads[GPU_PNG_MAX_THREADS];
+    GPU_WriteBuffer* buffer;
+    unsigned char header[13];
+    int num_threads, num_bands, rows_per_band, i;
+    GPU_bool result = GPU_TRUE;
+    Uint32 adler;
+
+    if(rwops == NULL || pixels == NULL || w < 1 || h < 1 || comp < 1 || comp > 4)
+        return GPU_FALSE;
+
+    num_threads = options->num_threads;
+    if(num_threads <= 0)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        num_threads = SDL_GetCPUCount();
+        #else
+        num_threads = 2;
+        #endif
+    }
+    if(num_threads > GPU_PNG_MAX_THREADS)
+        num_threads = GPU_PNG_MAX_THREADS;
+
+    // Small images are not worth the threads
+    num_bands = (int)((Uint64)w*comp*h/GPU_PNG_MIN_BAND_BYTES) + 1;
+    if(num_bands > num_threads)
+        num_bands = num_threads;
+    if(num_bands > h)
+        num_bands = h;
+    if(num_bands < 1)
+        num_bands = 1;
+    rows_per_band = (h + num_bands - 1)/num_bands;
+    num_bands = (h + rows_per_band - 1)/rows_per_band;
+
+    for(i = 0; i < num_bands; ++i)
+    {
+        GPU_PNGBand* band = &bands[i];
+        band->pixels = pixels;
+        band->pitch = pitch;
+        band->first_row = i*rows_per_band;
+        band->num_rows = (h - band->first_row < rows_per_band? h - band->first_row : rows_per_band);
+        band->row_bytes = w*comp;
+        band->bpp = comp;
+        band->filter = options->filter;
+        band->level = options->compression_level;
+        band->is_last = (i == num_bands - 1);
+        band->data = NULL;
+        band->ok = GPU_FALSE;
+    }
+
+    // The calling thread takes the first band
+    for(i = 1; i < num_bands; ++i)
+    {
+        #ifdef SDL_GPU_USE_SDL2
+        threads[i] = SDL_CreateThread(&gpu_encode_png_band, "gpu_write_png", &bands[i]);
+        #else
+        threads[i] = SDL_CreateThread(&gpu_encode_png_band, &bands[i]);
+        #endif
+    }
+    gpu_encode_png_band(&bands[0]);
+    for(i = 1; i < num_bands; ++i)
+    {
+        if(threads[i] != NULL)
+            SDL_WaitThread(threads[i], NULL);
+        else
+            gpu_encode_png_band(&bands[i]);
+    }
+
+    for(i = 0; i < num_bands; ++i)
+    {
+        if(!bands[i].ok)
+            result = GPU_FALSE;
+    }
+
+    buffer = (result? gpu_open_write_buffer(rwops) : NULL);
+    if(buffer != NULL)
+    {
+        gpu_put_u32_be(header, w);
+        gpu_put_u32_be(header + 4, h);
+        header[8] = 8;  // Bit depth
+        header[9] = color_types[comp];
+        header[10] = 0;  // Deflate
+        header[11] = 0;  // Adaptive filtering
+        header[12] = 0;  // No interlacing
+
+        gpu_write_buffered(buffer, (void*)signature, 8);
+        gpu_write_png_chunk(buffer, "IHDR", header, 13);
+
+        adler = bands[0].adler;
+        for(i = 1; i < num_bands; ++i)
+            adler = gpu_adler32_combine(adler, bands[i].adler, bands[i].filtered_size);
+
+        for(i = 0; i < num_bands; ++i)
+        {
+            GPU_PNGBand* band = &bands[i];
+            unsigned char bytes[4];
+            Uint32 crc = band->crc;
+            int size = band->size;
+
+            // The last band also carries the zlib checksum
+            if(band->is_last)
+            {
+                gpu_put_u32_be(band->data + 4 + size, adler);
+                crc = gpu_update_crc(crc, band->data + 4 + size, 4);
+                size += 4;
+            }
+
+            gpu_put_u32_be(bytes, size);
+            gpu_write_buffered(buffer, bytes, 4);
+            gpu_write_buffered(buffer, band->data, 4 + size);
+            gpu_put_u32_be(bytes, crc ^ 0xFFFFFFFF);
+            gpu_write_buffered(buffer, bytes, 4);
+        }
+
+        gpu_write_png_chunk(buffer, "IEND", NULL, 0);
+        result = gpu_close_write_buffer(buffer);
+    }
+    else
+        result = GPU_FALSE;
+
+    for(i = 0; i < num_bands; ++i)
+    {
+        SDL_free(bands[i].data);
+    }
+
+    return result;
+}
@@ -0,0 +1,609 @@
+#include "SDL_gpu.h"
+#include <string.h>
+
+#ifdef _MSC_VER
+#define __func__ __FUNCTION__
+#endif
+
+// Shader source preprocessing for the renderers' shader compilers.
+// Sources are scanned once in memory.  #include "file" directives are replaced by the file's own preprocessed source, and
+// files are read once and kept until GPU_ClearShaderIncludeCache().  Comment bodies are dropped, so that directives inside
+// comments are ignored.  Defines from GPU_CompileShaderWithDefines() go after the #version line, which only whitespace and
+// comments may precede.
+// Include paths are opened as they are, relative to the working directory.
+
+#define GPU_SHADER_MAX_INCLUDE_DEPTH 16
+#define GPU_SHADER_READ_CHUNK_SIZE 4096
+
+/*! A file read for an #include */
+typedef struct GPU_ShaderIncludeFile
+{
+    char* filename;
+    char* source;  // NULL if the file could not be read
+    Uint32 size;
+} GPU_ShaderIncludeFile;
+
+/*! Growing output of the preprocessor */
+typedef struct GPU_ShaderSourceBuffer
+{
+    char* data;
+    Uint32 size;
+    Uint32 capacity;
+    GPU_bool failed;
+} GPU_ShaderSourceBuffer;
+
+static GPU_ShaderIncludeFile* _gpu_shader_include_files = NULL;
+static int _gpu_num_shader_include_files = 0;
+static int _gpu_shader_include_files_capacity = 0;
+
+
+static void gpu_append_shader_source(GPU_ShaderSourceBuffer* buffer, const char* data, Uint32 size)
+{
+    if(buffer->failed)
+        return;
+
+    if(buffer->size + size + 1 > buffer->capacity)
+    {
+        Uint32 new_capacity = (buffer->capacity > 0? buffer->capacity : 1024);
+        char* new_data;
+        while(buffer->size + size + 1 > new_capacity)
+            new_capacity *= 2;
+
+        new_data = (char*)SDL_realloc(buffer->data, new_capacity);
+        if(new_data == NULL)
+        {
+            buffer->failed = GPU_TRUE;
+            return;
+        }
+        buffer->data = new_data;
+        buffer->capacity = new_capacity;
+    }
+
+    memcpy(buffer->data + buffer->size, data, size);
+    buffer->size += size;
+    buffer->data[buffer->size] = '\0';
+}
+
+// Reads what is left of the stream without relying on seeking
+static char* gpu_read_shader_stream(SDL_RWops* rwops, Uint32* size)
+{
+    GPU_ShaderSourceBuffer buffer = {NULL, 0, 0, GPU_FALSE};
+    char chunk[GPU_SHADER_READ_CHUNK_SIZE];
+    size_t len;
+
+    while((len = SDL_RWread(rwops, chunk, 1, sizeof(chunk))) > 0)
+        gpu_append_shader_source(&buffer, chunk, (Uint32)len);
+    if(buffer.data == NULL)
+        gpu_append_shader_source(&buffer, "", 0);
+
+    if(buffer.failed)
+    {
+        SDL_free(buffer.data);
+        return NULL;
+    }
+    *size = buffer.size;
+    return buffer.data;
+}
+
+static const GPU_ShaderIncludeFile* gpu_get_shader_include_file(const char* filename)
+{
+    GPU_ShaderIncludeFile* file;
+    SDL_RWops* rwops;
+    int i;
+
+    for(i = 0; i < _gpu_num_shader_include_files; ++i)
+    {
+        if(strcmp(_gpu_shader_include_files[i].filename, filename) == 0)
+            return &_gpu_shader_include_files[i];
+    }
+
+    if(_gpu_num_shader_include_files >= _gpu_shader_include_files_capacity)
+    {
+        int new_capacity = (_gpu_shader_include_files_capacity > 0? _gpu_shader_include_files_capacity*2 : 8);
+        GPU_ShaderIncludeFile* new_files = (GPU_ShaderIncludeFile*)SDL_realloc(_gpu_shader_include_files, new_capacity*sizeof(GPU_ShaderIncludeFile));
+        if(new_files == NULL)
+            return NULL;
+        _gpu_shader_include_files = new_files;
+        _gpu_shader_include_files_capacity = new_capacity;
+    }
+
+    file = &_gpu_shader_include_files[_gpu_num_shader_include_files++];
+    file->filename = (char*)SDL_malloc(strlen(filename) + 1);
+    strcpy(file->filename, filename);
+    file->source = NULL;
+    file->size = 0;
+
+    // Missing files are remembered too, so they are not searched for again
+    rwops = SDL_RWFromFile(filename, "rb");
+    if(rwops != NULL)
+    {
+        file->source = gpu_read_shader_stream(rwops, &file->size);
+        SDL_RWclose(rwops);
+    }
+    return file;
+}
+
+void gpu_clear_shader_include_cache(void)
+{
+    int i;
+    for(i = 0; i < _gpu_num_shader_include_files; ++i)
+    {
+        SDL_free(_gpu_shader_include_files[i].filename);
+        SDL_free(_gpu_shader_include_files[i].source);
+    }
+    SDL_free(_gpu_shader_include_files);
+    _gpu_shader_include_files = NULL;
+    _gpu_num_shader_include_files = 0;
+    _gpu_shader_include_files_capacity = 0;
+}
+
+static void gpu_append_shader_defines(GPU_ShaderSourceBuffer* buffer, const char** defines, int num_defines)
+{
+    int i;
+    for(i = 0; i < num_defines; ++i)
+    {
+        // "NAME=VALUE" becomes "#define NAME VALUE"
+        const char* value;
+        if(defines[i] == NULL || defines[i][0] == '\0')
+            continue;
+        value = strchr(defines[i], '=');
+
+        gpu_append_shader_source(buffer, "#define ", 8);
+        if(value == NULL)
+            gpu_append_shader_source(buffer, defines[i], (Uint32)strlen(defines[i]));
+        else
+        {
+            gpu_append_shader_source(buffer, defines[i], (Uint32)(value - defines[i]));
+            gpu_append_shader_source(buffer, " ", 1);
+            gpu_append_shader_source(buffer, value + 1, (Uint32)strlen(value + 1));
+        }
+        gpu_append_shader_source(buffer, "\n", 1);
+    }
+}
+
+// Returns the length of the directive name after the '#' at 'line', and where it starts
+static Uint32 gpu_get_shader_directive(const char* line, const char* end, const char** name)
+{
+    const char* p = line + 1;
+    while(p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    *name = p;
+    while(p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z')))
+        p++;
+    return (Uint32)(p - *name);
+}
+
+static void gpu_preprocess_shader_source(GPU_ShaderSourceBuffer* buffer, const char* source, Uint32 size, const char** defines, int num_defines, int depth)
+{
+    const char* p = source;
+    const char* end = source + size;
+    const char* run = p;  // Start of the text that is copied as it is
+
+    if(num_defines > 0)
+    {
+        // The defines follow the #version directive if there is one
+        const char* q = p;
+        const char* name;
+        for(;;)
+        {
+            while(q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'))
+                q++;
+            if(end - q >= 2 && q[0] == '/' && q[1] == '/')
+            {
+                while(q < end && *q != '\n')
+                    q++;
+            }
+            else if(end - q >= 2 && q[0] == '/' && q[1] == '*')
+            {
+                q += 2;
+                while(end - q >= 2 && !(q[0] == '*' && q[1] == '/'))
+                    q++;
+                q = (end - q >= 2? q + 2 : end);
+            }
+            else
+                break;
+        }
+        if(q < end && *q == '#' && gpu_get_shader_directive(q, end, &name) == 7 && strncmp(name, "version", 7) == 0)
+        {
+            while(q < end && *q != '\n')
+                q++;
+            gpu_append_shader_source(buffer, p, (Uint32)(q - p));
+            gpu_append_shader_source(buffer, "\n", 1);
+            p = run = (q < end? q + 1 : end);
+        }
+        gpu_append_shader_defines(buffer, defines, num_defines);
+    }
+
+    while(p < end && !buffer->failed)
+    {
+        if(*p == '#')
+        {
+            const char* name;
+            const char* line_end = p;
+            while(line_end < end && *line_end != '\n')
+                line_end++;
+
+            if(gpu_get_shader_directive(p, line_end, &name) == 7 && strncmp(name, "include", 7) == 0)
+            {
+                // Get the filename between the quotes
+                const char* first = (const char*)memchr(name, '"', line_end - name);
+                const char* last = (first != NULL? (const char*)memchr(first + 1, '"', line_end - first - 1) : NULL);
+                char filename[1024];
+                const GPU_ShaderIncludeFile* file;
+
+                gpu_append_shader_source(buffer, run, (Uint32)(p - run));
+                p = run = (line_end < end? line_end + 1 : end);
+
+                if(last == NULL || last - first - 1 >= (int)sizeof(filename))
+                {
+                    GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Malformed #include directive");
+                    buffer->failed = GPU_TRUE;
+                    return;
+                }
+                memcpy(filename, first + 1, last - first - 1);
+                filename[last - first - 1] = '\0';
+
+                if(depth >= GPU_SHADER_MAX_INCLUDE_DEPTH)
+                {
+                    GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "#include nested too deeply at \"%s\"", filename);
+                    buffer->failed = GPU_TRUE;
+                    return;
+                }
+
+                file = gpu_get_shader_include_file(filename);
+                if(file == NULL || file->source == NULL)
+                {
+                    GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_FILE_NOT_FOUND, "Shader include \"%s\"", filename);
+                    buffer->failed = GPU_TRUE;
+                    return;
+                }
+
+                gpu_preprocess_shader_source(buffer, file->source, file->size, NULL, 0, depth + 1);
+                gpu_append_shader_source(buffer, "\n", 1);
+                continue;
+            }
+
+            // Other directives are copied along with the rest of their line
+            p = line_end;
+            continue;
+        }
+
+        if(*p == '/' && p + 1 < end && (p[1] == '/' || p[1] == '*'))
+        {
+            // Keep the comment markers but drop the body
+            gpu_append_shader_source(buffer, run, (Uint32)(p - run) + 2);
+            if(p[1] == '/')
+            {
+                p += 2;
+                while(p < end && *p != '\n')
+                    p++;
+                gpu_append_shader_source(buffer, "\n", 1);
+                p = run = (p < end? p + 1 : end);
+            }
+            else
+            {
+                p += 2;
+                while(p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+                    p++;
+                gpu_append_shader_source(buffer, "*/", 2);
+                p = run = (p + 1 < end? p + 2 : end);
+            }
+            continue;
+        }
+
+        p++;
+    }
+
+    gpu_append_shader_source(buffer, run, (Uint32)(p - run));
+}
+
+/*! Preprocesses shader source, expanding #include directives and adding the given defines.
+ * \param defines Entries of the form "NAME" or "NAME=VALUE".  May be NULL if num_defines is 0.
+ * \return A new string to be freed with SDL_free(), or NULL after pushing an error. */
+char* gpu_preprocess_shader(const char* source, Uint32 size, const char** defines, int num_defines)
+{
+    GPU_ShaderSourceBuffer buffer = {NULL, 0, 0, GPU_FALSE};
+
+    gpu_preprocess_shader_source(&buffer, source, size, defines, num_defines, 0);
+    if(buffer.failed || buffer.size == 0)
+    {
+        if(!buffer.failed)
+            GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Failed to read shader source");
+        SDL_free(buffer.data);
+        return NULL;
+    }
+    return buffer.data;
+}
+
+/*! Reads the rest of the stream and preprocesses it like gpu_preprocess_shader(). */
+char* gpu_preprocess_shader_rw(SDL_RWops* rwops, const char** defines, int num_defines)
+{
+    char* source;
+    char* result;
+    Uint32 size = 0;
+
+    if(rwops == NULL)
+    {
+        GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_NULL_ARGUMENT, "shader_source");
+        return NULL;
+    }
+
+    source = gpu_read_shader_stream(rwops, &size);
+    if(source == NULL)
+    {
+        GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Failed to read shader source");
+        return NULL;
+    }
+
+    result = gpu_preprocess_shader(source, size, defines, num_defines);
+    SDL_free(source);
+    return result;
+}
+
+
+
+// Shader variant sets
+// Variants are kept in an open-addressed table keyed by keyword mask, so looking one up on every draw is a probe or two.
+
+#define GPU_SHADER_VARIANT_MIN_CAPACITY 16
+
+typedef struct GPU_ShaderVariant
+{
+    Uint32 keywords;
+    Uint32 program;  // 0 if the variant failed to build
+    GPU_ShaderBlock block;
+    GPU_bool used;
+} GPU_ShaderVariant;
+
+struct GPU_ShaderVariantSet
+{
+    GPU_Renderer* renderer;  // Programs belong to the renderer that was current when they were built
+    char* vertex_source;
+    char* fragment_source;
+    char* keywords[GPU_SHADER_MAX_VARIANT_KEYWORDS];
+    int num_keywords;
+    char* block_names[4];  // position, texcoord, color, modelViewProjection
+
+    GPU_ShaderVariant* variants;
+    int num_variants;
+    int capacity;  // Power of two
+};
+
+static char* gpu_copy_string(const char* s)
+{
+    char* result;
+    if(s == NULL)
+        return NULL;
+    result = (char*)SDL_malloc(strlen(s) + 1);
+    strcpy(result, s);
+    return result;
+}
+
+static Uint32 gpu_hash_variant_keywords(Uint32 keywords)
+{
+    keywords ^= keywords >> 16;
+    keywords *= 0x7feb352d;
+    keywords ^= keywords >> 15;
+    keywords *= 0x846ca68b;
+    keywords ^= keywords >> 16;
+    return keywords;
+}
+
+static GPU_ShaderVariant* gpu_find_shader_variant(GPU_ShaderVariantSet* set, Uint32 keywords)
+{
+    Uint32 mask = (Uint32)set->capacity - 1;
+    Uint32 i = gpu_hash_variant_keywords(keywords) & mask;
+
+    while(set->variants[i].used)
+    {
+        if(set->variants[i].keywords == keywords)
+            return &set->variants[i];
+        i = (i + 1) & mask;
+    }
+    return &set->variants[i];
+}
+
+static void gpu_grow_shader_variants(GPU_ShaderVariantSet* set)
+{
+    GPU_ShaderVariant* old_variants = set->variants;
+    int old_capacity = set->capacity;
+    int i;
+
+    set->capacity = (old_capacity == 0? GPU_SHADER_VARIANT_MIN_CAPACITY : old_capacity*2);
+    set->variants = (GPU_ShaderVariant*)SDL_malloc(set->capacity*sizeof(GPU_ShaderVariant));
+    memset(set->variants, 0, set->capacity*sizeof(GPU_ShaderVariant));
+
+    for(i = 0; i < old_capacity; ++i)
+    {
+        if(old_variants[i].used)
+            *gpu_find_shader_variant(set, old_variants[i].keywords) = old_variants[i];
+    }
+    SDL_free(old_variants);
+}
+
+static void gpu_build_shader_variant(GPU_ShaderVariantSet* set, GPU_ShaderVariant* variant)
+{
+    const char* defines[GPU_SHADER_MAX_VARIANT_KEYWORDS];
+    int num_defines = 0;
+    Uint32 shaders[2];
+    int i;
+
+    variant->program = 0;
+    variant->block.position_loc = -1;
+    variant->block.texcoord_loc = -1;
+    variant->block.color_loc = -1;
+    variant->block.modelViewProjection_loc = -1;
+
+    for(i = 0; i < set->num_keywords; ++i)
+    {
+        if(variant->keywords & (1u << i))
+            defines[num_defines++] = set->keywords[i];
+    }
+
+    shaders[0] = GPU_CompileShaderWithDefines(GPU_VERTEX_SHADER, set->vertex_source, defines, num_defines);
+    shaders[1] = GPU_CompileShaderWithDefines(GPU_FRAGMENT_SHADER, set->fragment_source, defines, num_defines);
+    if(shaders[0] != 0 && shaders[1] != 0)
+        variant->program = GPU_LinkManyShaders(shaders, 2);
+
+    // A linked program keeps its shaders alive until it is freed
+    if(shaders[0] != 0)
+        GPU_FreeShader(shaders[0]);
+    if(shaders[1] != 0)
+        GPU_FreeShader(shaders[1]);
+
+    if(variant->program == 0)
+    {
+        GPU_PushErrorCode("GPU_GetShaderVariant", GPU_ERROR_BACKEND_ERROR, "Failed to build shader variant 0x%x: %s", variant->keywords, GPU_GetShaderMessage());
+        return;
+    }
+
+    variant->block = GPU_LoadShaderBlock(variant->program, set->block_names[0], set->block_names[1], set->block_names[2], set->block_names[3]);
+}
+
+GPU_ShaderVariantSet* GPU_CreateShaderVariantSet(const char* vertex_source, const char* fragment_source, const char** keywords, int num_keywords, const char* position_name, const char* texcoord_name, const char* color_name, const char* modelViewMatrix_name)
+{
+    GPU_ShaderVariantSet* set;
+    int i;
+
+    if(vertex_source == NULL || fragment_source == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "%s", (vertex_source == NULL? "vertex_source" : "fragment_source"));
+        return NULL;
+    }
+    if(num_keywords < 0 || num_keywords > GPU_SHADER_MAX_VARIANT_KEYWORDS || (keywords == NULL && num_keywords > 0))
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_DATA_ERROR, "Invalid keyword list (%d keywords, at most %d)", num_keywords, GPU_SHADER_MAX_VARIANT_KEYWORDS);
+        return NULL;
+    }
+    for(i = 0; i < num_keywords; ++i)
+    {
+        if(keywords[i] == NULL || keywords[i][0] == '\0')
+        {
+            GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "keywords[%d]", i);
+            return NULL;
+        }
+    }
+
+    set = (GPU_ShaderVariantSet*)SDL_malloc(sizeof(GPU_ShaderVariantSet));
+    memset(set, 0, sizeof(GPU_ShaderVariantSet));
+    set->renderer = GPU_GetCurrentRenderer();
+    set->vertex_source = gpu_copy_string(vertex_source);
+    set->fragment_source = gpu_copy_string(fragment_source);
+    for(i = 0; i < num_keywords; ++i)
+        set->keywords[i] = gpu_copy_string(keywords[i]);
+    set->num_keywords = num_keywords;
+    set->block_names[0] = gpu_copy_string(position_name);
+    set->block_names[1] = gpu_copy_string(texcoord_name);
+    set->block_names[2] = gpu_copy_string(color_name);
+    set->block_names[3] = gpu_copy_string(modelViewMatrix_name);
+    gpu_grow_shader_variants(set);
+    return set;
+}
+
+void GPU_FreeShaderVariantSet(GPU_ShaderVariantSet* set)
+{
+    GPU_Renderer* renderer;
+    int i;
+
+    if(set == NULL)
+        return;
+
+    // The programs can only be deleted through the renderer that made them
+    renderer = GPU_GetCurrentRenderer();
+    if(renderer != set->renderer && set->num_variants > 0)
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Freeing a shader variant set while another renderer is current.  Its programs are left to that renderer.");
+    else
+    {
+        for(i = 0; i < set->capacity; ++i)
+        {
+            if(set->variants[i].used && set->variants[i].program != 0)
+                GPU_FreeShaderProgram(set->variants[i].program);
+        }
+    }
+
+    SDL_free(set->vertex_source);
+    SDL_free(set->fragment_source);
+    for(i = 0; i < set->num_keywords; ++i)
+        SDL_free(set->keywords[i]);
+    for(i = 0; i < 4; ++i)
+        SDL_free(set->block_names[i]);
+    SDL_free(set->variants);
+    SDL_free(set);
+}
+
+Uint32 GPU_GetShaderVariantKeyword(GPU_ShaderVariantSet* set, const char* keyword)
+{
+    int i;
+
+    if(set == NULL || keyword == NULL)
+        return 0;
+
+    for(i = 0; i < set->num_keywords; ++i)
+    {
+        if(strcmp(set->keywords[i], keyword) == 0)
+            return (1u << i);
+    }
+
+    GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Unknown shader keyword \"%s\"", keyword);
+    return 0;
+}
+
+Uint32 GPU_GetShaderVariant(GPU_ShaderVariantSet* set, Uint32 keywords, GPU_ShaderBlock* block)
+{
+    GPU_ShaderVariant* variant;
+
+    if(set == NULL)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_NULL_ARGUMENT, "set");
+        return 0;
+    }
+    if(GPU_GetCurrentRenderer() != set->renderer)
+    {
+        GPU_PushErrorCode(__func__, GPU_ERROR_USER_ERROR, "Shader variant sets can only be used with the renderer that was current when they were created");
+        return 0;
+    }
+
+    // Bits without a keyword would make duplicate programs
+    if(set->num_keywords < GPU_SHADER_MAX_VARIANT_KEYWORDS)
+        keywords &= (1u << set->num_keywords) - 1;
+
+    variant = gpu_find_shader_variant(set, keywords);
+    if(!variant->used)
+    {
+        // Keep the table at most half full so that probes stay short
+        if(2*(set->num_variants + 1) > set->capacity)
+        {
+            gpu_grow_shader_variants(set);
+            variant = gpu_find_shader_variant(set, keywords);
+        }
+
+        // Failures are remembered too, so a broken variant is not recompiled on every draw
+        variant->used = GPU_TRUE;
+        variant->keywords = keywords;
+        set->num_variants++;
+        gpu_build_shader_variant(set, variant);
+    }
+
+    if(block != NULL)
+        *block = variant->block;
+    return variant->program;
+}
+
+GPU_bool GPU_ActivateShaderVariant(GPU_ShaderVariantSet* set, Uint32 keywords)
+{
+    GPU_ShaderBlock block;
+    Uint32 program = GPU_GetShaderVariant(set, keywords, &block);
+
+    if(program == 0)
+        return GPU_FALSE;
+
+    GPU_ActivateShaderProgram(program, &block);
+    return GPU_TRUE;
+}
+
+int GPU_GetNumShaderVariants(GPU_ShaderVariantSet* set)
+{
+    if(set == NULL)
+        return 0;
+    return set->num_variants;
+}
@@ -1,11 +1,27 @@
 #include "SDL_gpu.h"
 #include "SDL_gpu_RendererImpl.h"
 #include <string.h>
+#include <math.h>
 
+// Visual C does not support static inline
+#ifndef static_inline
+	#ifdef _MSC_VER
+		#define static_inline static
+	#else
+		#define static_inline static inline
+	#endif
+#endif
+
+// The shape functions skip this check when built with SDL_GPU_DISABLE_ARGUMENT_CHECKS
+#ifdef SDL_GPU_DISABLE_ARGUMENT_CHECKS
+#define CHECK_RENDERER() \
+GPU_Renderer* renderer = GPU_GetCurrentRenderer();
+#else
 #define CHECK_RENDERER() \
 GPU_Renderer* renderer = GPU_GetCurrentRenderer(); \
 if(renderer == NULL) \
     return;
+#endif
 
 #define CHECK_RENDERER_1(ret) \
 GPU_Renderer* renderer = GPU_GetCurrentRenderer(); \
@@ -165,3 +181,711 @@ void GPU_PolygonFilled(GPU_Target* target, unsigned int num_vertices, float* ver
 	renderer->impl->PolygonFilled(renderer, target, num_vertices, vertices, color);
 }
 
+void GPU_PolygonFilledEx(GPU_Target* target, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->PolygonFilledEx(renderer, target, num_contours, contour_sizes, vertices, color);
+}
+
+void GPU_Points(GPU_Target* target, unsigned int num_points, float* points, SDL_Color* colors, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->Points(renderer, target, num_points, points, colors, color);
+}
+
+void GPU_Lines(GPU_Target* target, unsigned int num_lines, float* endpoints, SDL_Color* colors, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->Lines(renderer, target, num_lines, endpoints, colors, color);
+}
+
+void GPU_TrisFilled(GPU_Target* target, unsigned int num_tris, float* vertices, SDL_Color* colors, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->TrisFilled(renderer, target, num_tris, vertices, colors, color);
+}
+
+void GPU_RectanglesFilled(GPU_Target* target, unsigned int num_rects, GPU_Rect* rects, SDL_Color* colors, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->RectanglesFilled(renderer, target, num_rects, rects, colors, color);
+}
+
+void GPU_CirclesFilled(GPU_Target* target, unsigned int num_circles, float* circles, SDL_Color* colors, SDL_Color color)
+{
+	CHECK_RENDERER();
+	renderer->impl->CirclesFilled(renderer, target, num_circles, circles, colors, color);
+}
+
+// Polygon triangulation for GPU_PolygonFilledEx()
+// Ear clipping with hole bridging, following the approach of the earcut library (https://github.com/mapbox/earcut).
+
+typedef struct GPU_TriNode
+{
+    unsigned int i;  // Vertex index
+    float x, y;
+    int prev, next;
+    GPU_bool steiner;
+} GPU_TriNode;
+
+typedef struct GPU_Triangulator
+{
+    GPU_TriNode* nodes;
+    int num_nodes;
+    int max_nodes;
+
+    unsigned int* indices;
+    unsigned int num_indices;
+    unsigned int max_indices;
+
+    GPU_bool failed;  // Set when a buffer can't grow.  The result is incomplete and gets thrown away.
+} GPU_Triangulator;
+
+#define TRI_NODE(n) (tri->nodes[n])
+
+static GPU_bool tri_reserve_nodes(GPU_Triangulator* tri, int num_nodes)
+{
+    GPU_TriNode* nodes;
+    int max_nodes = tri->max_nodes;
+
+    if(tri->failed)
+        return GPU_FALSE;
+    if(tri->num_nodes + num_nodes <= max_nodes)
+        return GPU_TRUE;
+
+    while(tri->num_nodes + num_nodes > max_nodes)
+        max_nodes *= 2;
+    nodes = (GPU_TriNode*)SDL_realloc(tri->nodes, max_nodes * sizeof(GPU_TriNode));
+    if(nodes == NULL)
+    {
+        tri->failed = GPU_TRUE;
+        return GPU_FALSE;
+    }
+    tri->nodes = nodes;
+    tri->max_nodes = max_nodes;
+    return GPU_TRUE;
+}
+
+// Returns -1 if the node can't be allocated
+static int tri_insert_node(GPU_Triangulator* tri, unsigned int i, float x, float y, int last)
+{
+    int p;
+    if(!tri_reserve_nodes(tri, 1))
+        return -1;
+
+    p = tri->num_nodes++;
+    TRI_NODE(p).i = i;
+    TRI_NODE(p).x = x;
+    TRI_NODE(p).y = y;
+    TRI_NODE(p).steiner = GPU_FALSE;
+
+    if(last < 0)
+    {
+        TRI_NODE(p).prev = p;
+        TRI_NODE(p).next = p;
+    }
+    else
+    {
+        TRI_NODE(p).next = TRI_NODE(last).next;
+        TRI_NODE(p).prev = last;
+        TRI_NODE(TRI_NODE(last).next).prev = p;
+        TRI_NODE(last).next = p;
+    }
+    return p;
+}
+
+static void tri_remove_node(GPU_Triangulator* tri, int p)
+{
+    TRI_NODE(TRI_NODE(p).next).prev = TRI_NODE(p).prev;
+    TRI_NODE(TRI_NODE(p).prev).next = TRI_NODE(p).next;
+}
+
+static void tri_add_triangle(GPU_Triangulator* tri, int a, int b, int c)
+{
+    if(tri->failed)
+        return;
+    if(tri->num_indices + 3 > tri->max_indices)
+    {
+        unsigned int* indices = (unsigned int*)SDL_realloc(tri->indices, 2 * tri->max_indices * sizeof(unsigned int));
+        if(indices == NULL)
+        {
+            tri->failed = GPU_TRUE;
+            return;
+        }
+        tri->indices = indices;
+        tri->max_indices *= 2;
+    }
+    tri->indices[tri->num_indices++] = TRI_NODE(a).i;
+    tri->indices[tri->num_indices++] = TRI_NODE(b).i;
+    tri->indices[tri->num_indices++] = TRI_NODE(c).i;
+}
+
+// Signed area of a triangle
+static_inline float tri_area(GPU_Triangulator* tri, int p, int q, int r)
+{
+    return (TRI_NODE(q).y - TRI_NODE(p).y) * (TRI_NODE(r).x - TRI_NODE(q).x) - (TRI_NODE(q).x - TRI_NODE(p).x) * (TRI_NODE(r).y - TRI_NODE(q).y);
+}
+
+static_inline GPU_bool tri_equals(GPU_Triangulator* tri, int p, int q)
+{
+    return (TRI_NODE(p).x == TRI_NODE(q).x && TRI_NODE(p).y == TRI_NODE(q).y);
+}
+
+static_inline GPU_bool tri_point_in_triangle(float ax, float ay, float bx, float by, float cx, float cy, float px, float py)
+{
+    return ((cx - px) * (ay - py) - (ax - px) * (cy - py) >= 0
+            && (ax - px) * (by - py) - (bx - px) * (ay - py) >= 0
+            && (bx - px) * (cy - py) - (cx - px) * (by - py) >= 0);
+}
+
+static GPU_bool tri_intersects(GPU_Triangulator* tri, int p1, int q1, int p2, int q2)
+{
+    if((tri_equals(tri, p1, q1) && tri_equals(tri, p2, q2)) || (tri_equals(tri, p1, q2) && tri_equals(tri, p2, q1)))
+        return GPU_TRUE;
+    return ((tri_area(tri, p1, q1, p2) > 0) != (tri_area(tri, p1, q1, q2) > 0)
+            && (tri_area(tri, p2, q2, p1) > 0) != (tri_area(tri, p2, q2, q1) > 0));
+}
+
+static GPU_bool tri_intersects_polygon(GPU_Triangulator* tri, int a, int b)
+{
+    int p = a;
+    do
+    {
+        int n = TRI_NODE(p).next;
+        if(TRI_NODE(p).i != TRI_NODE(a).i && TRI_NODE(n).i != TRI_NODE(a).i && TRI_NODE(p).i != TRI_NODE(b).i && TRI_NODE(n).i != TRI_NODE(b).i
+           && tri_intersects(tri, p, n, a, b))
+            return GPU_TRUE;
+        p = n;
+    }
+    while(p != a);
+    return GPU_FALSE;
+}
+
+static GPU_bool tri_locally_inside(GPU_Triangulator* tri, int a, int b)
+{
+    if(tri_area(tri, TRI_NODE(a).prev, a, TRI_NODE(a).next) < 0)
+        return (tri_area(tri, a, b, TRI_NODE(a).next) >= 0 && tri_area(tri, a, TRI_NODE(a).prev, b) >= 0);
+    return (tri_area(tri, a, b, TRI_NODE(a).prev) < 0 || tri_area(tri, a, TRI_NODE(a).next, b) < 0);
+}
+
+static GPU_bool tri_middle_inside(GPU_Triangulator* tri, int a, int b)
+{
+    int p = a;
+    GPU_bool inside = GPU_FALSE;
+    float px = (TRI_NODE(a).x + TRI_NODE(b).x) / 2;
+    float py = (TRI_NODE(a).y + TRI_NODE(b).y) / 2;
+    do
+    {
+        GPU_TriNode* n = &TRI_NODE(TRI_NODE(p).next);
+        if(((TRI_NODE(p).y > py) != (n->y > py)) && n->y != TRI_NODE(p).y
+           && (px < (n->x - TRI_NODE(p).x) * (py - TRI_NODE(p).y) / (n->y - TRI_NODE(p).y) + TRI_NODE(p).x))
+            inside = !inside;
+        p = TRI_NODE(p).next;
+    }
+    while(p != a);
+    return inside;
+}
+
+static GPU_bool tri_is_valid_diagonal(GPU_Triangulator* tri, int a, int b)
+{
+    return (TRI_NODE(TRI_NODE(a).next).i != TRI_NODE(b).i && TRI_NODE(TRI_NODE(a).prev).i != TRI_NODE(b).i
+            && !tri_intersects_polygon(tri, a, b)
+            && tri_locally_inside(tri, a, b) && tri_locally_inside(tri, b, a) && tri_middle_inside(tri, a, b));
+}
+
+// Links a with b, splitting the polygon in two.  Returns the start of the new polygon, or -1 without changing anything if the nodes can't be allocated.
+static int tri_split_polygon(GPU_Triangulator* tri, int a, int b)
+{
+    int a2, b2, an, bp;
+
+    if(!tri_reserve_nodes(tri, 2))
+        return -1;
+
+    a2 = tri_insert_node(tri, TRI_NODE(a).i, TRI_NODE(a).x, TRI_NODE(a).y, -1);
+    b2 = tri_insert_node(tri, TRI_NODE(b).i, TRI_NODE(b).x, TRI_NODE(b).y, -1);
+    an = TRI_NODE(a).next;
+    bp = TRI_NODE(b).prev;
+
+    TRI_NODE(a).next = b;
+    TRI_NODE(b).prev = a;
+
+    TRI_NODE(a2).next = an;
+    TRI_NODE(an).prev = a2;
+
+    TRI_NODE(b2).next = a2;
+    TRI_NODE(a2).prev = b2;
+
+    TRI_NODE(bp).next = b2;
+    TRI_NODE(b2).prev = bp;
+
+    return b2;
+}
+
+// Removes duplicate and collinear points
+static int tri_filter_points(GPU_Triangulator* tri, int start, int end)
+{
+    int p;
+    GPU_bool again;
+
+    if(start < 0)
+        return start;
+    if(end < 0)
+        end = start;
+
+    p = start;
+    do
+    {
+        again = GPU_FALSE;
+        if(!TRI_NODE(p).steiner && (tri_equals(tri, p, TRI_NODE(p).next) || tri_area(tri, TRI_NODE(p).prev, p, TRI_NODE(p).next) == 0))
+        {
+            tri_remove_node(tri, p);
+            p = end = TRI_NODE(p).prev;
+            if(p == TRI_NODE(p).next)
+                break;
+            again = GPU_TRUE;
+        }
+        else
+            p = TRI_NODE(p).next;
+    }
+    while(again || p != end);
+
+    return end;
+}
+
+static GPU_bool tri_is_ear(GPU_Triangulator* tri, int ear)
+{
+    int a = TRI_NODE(ear).prev;
+    int c = TRI_NODE(ear).next;
+    int p;
+
+    if(tri_area(tri, a, ear, c) >= 0)
+        return GPU_FALSE;  // Reflex, can't be an ear
+
+    // Make sure we don't have other points inside the potential ear
+    for(p = TRI_NODE(c).next; p != a; p = TRI_NODE(p).next)
+    {
+        if(tri_point_in_triangle(TRI_NODE(a).x, TRI_NODE(a).y, TRI_NODE(ear).x, TRI_NODE(ear).y, TRI_NODE(c).x, TRI_NODE(c).y, TRI_NODE(p).x, TRI_NODE(p).y)
+           && tri_area(tri, TRI_NODE(p).prev, p, TRI_NODE(p).next) >= 0)
+            return GPU_FALSE;
+    }
+    return GPU_TRUE;
+}
+
+// Walks through small self-intersections and clips them
+static int tri_cure_local_intersections(GPU_Triangulator* tri, int start)
+{
+    int p = start;
+    do
+    {
+        int a = TRI_NODE(p).prev;
+        int b = TRI_NODE(TRI_NODE(p).next).next;
+
+        if(!tri_equals(tri, a, b) && tri_intersects(tri, a, p, TRI_NODE(p).next, b) && tri_locally_inside(tri, a, b) && tri_locally_inside(tri, b, a))
+        {
+            tri_add_triangle(tri, a, p, b);
+            tri_remove_node(tri, p);
+            tri_remove_node(tri, TRI_NODE(p).next);
+            p = start = b;
+        }
+        p = TRI_NODE(p).next;
+    }
+    while(p != start);
+
+    return tri_filter_points(tri, p, -1);
+}
+
+static void tri_earcut_linked(GPU_Triangulator* tri, int ear, int pass);
+
+// Tries splitting the polygon along a valid diagonal and triangulating both halves
+static void tri_split_earcut(GPU_Triangulator* tri, int start)
+{
+    int a = start;
+    do
+    {
+        int b = TRI_NODE(TRI_NODE(a).next).next;
+        while(b != TRI_NODE(a).prev)
+        {
+            if(TRI_NODE(a).i != TRI_NODE(b).i && tri_is_valid_diagonal(tri, a, b))
+            {
+                int c = tri_split_polygon(tri, a, b);
+                if(c < 0)
+                    return;
+
+                a = tri_filter_points(tri, a, TRI_NODE(a).next);
+                c = tri_filter_points(tri, c, TRI_NODE(c).next);
+
+                tri_earcut_linked(tri, a, 0);
+                tri_earcut_linked(tri, c, 0);
+                return;
+            }
+            b = TRI_NODE(b).next;
+        }
+        a = TRI_NODE(a).next;
+    }
+    while(a != start);
+}
+
+static void tri_earcut_linked(GPU_Triangulator* tri, int ear, int pass)
+{
+    int stop;
+
+    if(ear < 0)
+        return;
+
+    stop = ear;
+    while(!tri->failed && TRI_NODE(ear).prev != TRI_NODE(ear).next)
+    {
+        int prev = TRI_NODE(ear).prev;
+        int next = TRI_NODE(ear).next;
+
+        if(tri_is_ear(tri, ear))
+        {
+            tri_add_triangle(tri, prev, ear, next);
+            tri_remove_node(tri, ear);
+
+            // Skipping the next vertex leads to fewer sliver triangles
+            ear = TRI_NODE(next).next;
+            stop = ear;
+            continue;
+        }
+
+        ear = next;
+
+        // Looped through the whole remaining polygon without finding an ear
+        if(ear == stop)
+        {
+            if(pass == 0)
+                tri_earcut_linked(tri, tri_filter_points(tri, ear, -1), 1);
+            else if(pass == 1)
+                tri_earcut_linked(tri, tri_cure_local_intersections(tri, tri_filter_points(tri, ear, -1)), 2);
+            else
+                tri_split_earcut(tri, ear);
+            break;
+        }
+    }
+}
+
+// Creates a circular linked list from the contour, in the requested winding order
+static int tri_linked_list(GPU_Triangulator* tri, float* vertices, unsigned int start, unsigned int end, GPU_bool clockwise)
+{
+    unsigned int i, j;
+    float sum = 0.0f;
+    int last = -1;
+
+    for(i = start, j = end - 1; i < end; j = i++)
+        sum += (vertices[2*j] - vertices[2*i]) * (vertices[2*i+1] + vertices[2*j+1]);
+
+    // Reserving the whole contour first means no insertion below can fail
+    if(!tri_reserve_nodes(tri, (int)(end - start)))
+        return -1;
+
+    if(clockwise == (sum > 0))
+    {
+        for(i = start; i < end; i++)
+            last = tri_insert_node(tri, i, vertices[2*i], vertices[2*i+1], last);
+    }
+    else
+    {
+        for(i = end; i > start; i--)
+            last = tri_insert_node(tri, i-1, vertices[2*(i-1)], vertices[2*(i-1)+1], last);
+    }
+
+    if(last >= 0 && tri_equals(tri, last, TRI_NODE(last).next))
+    {
+        int next = TRI_NODE(last).next;
+        tri_remove_node(tri, last);
+        last = next;
+    }
+
+    return last;
+}
+
+static int tri_get_leftmost(GPU_Triangulator* tri, int start)
+{
+    int p = start;
+    int leftmost = start;
+    do
+    {
+        if(TRI_NODE(p).x < TRI_NODE(leftmost).x || (TRI_NODE(p).x == TRI_NODE(leftmost).x && TRI_NODE(p).y < TRI_NODE(leftmost).y))
+            leftmost = p;
+        p = TRI_NODE(p).next;
+    }
+    while(p != start);
+    return leftmost;
+}
+
+static GPU_bool tri_sector_contains_sector(GPU_Triangulator* tri, int m, int p)
+{
+    return (tri_area(tri, TRI_NODE(m).prev, m, TRI_NODE(p).prev) < 0 && tri_area(tri, TRI_NODE(p).next, m, TRI_NODE(m).next) < 0);
+}
+
+// David Eberly's algorithm for finding a bridge between a hole and the outer polygon
+static int tri_find_hole_bridge(GPU_Triangulator* tri, int hole, int outer_node)
+{
+    int p = outer_node;
+    float hx = TRI_NODE(hole).x;
+    float hy = TRI_NODE(hole).y;
+    float qx = -3.4e38f;
+    int m = -1;
+    int stop;
+    float mx, my;
+    float tan_min = 3.4e38f;
+
+    // Find a segment intersected by a ray from the hole's leftmost point to the left.
+    // The segment's endpoint with lesser x will be the potential connection point.
+    do
+    {
+        int n = TRI_NODE(p).next;
+        if(hy <= TRI_NODE(p).y && hy >= TRI_NODE(n).y && TRI_NODE(n).y != TRI_NODE(p).y)
+        {
+            float x = TRI_NODE(p).x + (hy - TRI_NODE(p).y) * (TRI_NODE(n).x - TRI_NODE(p).x) / (TRI_NODE(n).y - TRI_NODE(p).y);
+            if(x <= hx && x > qx)
+            {
+                qx = x;
+                if(x == hx)
+                {
+                    if(hy == TRI_NODE(p).y)
+                        return p;
+                    if(hy == TRI_NODE(n).y)
+                        return n;
+                }
+                m = (TRI_NODE(p).x < TRI_NODE(n).x? p : n);
+            }
+        }
+        p = n;
+    }
+    while(p != outer_node);
+
+    if(m < 0)
+        return -1;
+
+    if(hx == qx)
+        return m;  // The hole touches the outer segment
+
+    // Look for points inside the triangle of hole point, segment intersection and endpoint.
+    // If there are none, then that endpoint is the connection point.
+    // Otherwise, use the point with the minimum angle to the ray.
+    stop = m;
+    mx = TRI_NODE(m).x;
+    my = TRI_NODE(m).y;
+    p = m;
+
+    do
+    {
+        if(hx >= TRI_NODE(p).x && TRI_NODE(p).x >= mx && hx != TRI_NODE(p).x
+           && tri_point_in_triangle(hy < my? hx : qx, hy, mx, my, hy < my? qx : hx, hy, TRI_NODE(p).x, TRI_NODE(p).y))
+        {
+            float tan_cur = fabsf(hy - TRI_NODE(p).y) / (hx - TRI_NODE(p).x);
+
+            if(tri_locally_inside(tri, p, hole)
+               && (tan_cur < tan_min || (tan_cur == tan_min && (TRI_NODE(p).x > TRI_NODE(m).x || (TRI_NODE(p).x == TRI_NODE(m).x && tri_sector_contains_sector(tri, m, p))))))
+            {
+                m = p;
+                tan_min = tan_cur;
+            }
+        }
+        p = TRI_NODE(p).next;
+    }
+    while(p != stop);
+
+    return m;
+}
+
+static int tri_eliminate_holes(GPU_Triangulator* tri, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, int outer_node)
+{
+    unsigned int i, j, start;
+    int* queue = (int*)SDL_malloc((num_contours - 1) * sizeof(int));
+    unsigned int num_queued = 0;
+
+    if(queue == NULL)
+    {
+        tri->failed = GPU_TRUE;
+        return outer_node;
+    }
+
+    start = contour_sizes[0];
+    for(i = 1; i < num_contours; i++)
+    {
+        int list;
+        if(contour_sizes[i] > 0)
+        {
+            list = tri_linked_list(tri, vertices, start, start + contour_sizes[i], GPU_FALSE);
+            if(list >= 0)
+            {
+                if(list == TRI_NODE(list).next)
+                    TRI_NODE(list).steiner = GPU_TRUE;
+                queue[num_queued++] = tri_get_leftmost(tri, list);
+            }
+        }
+        start += contour_sizes[i];
+    }
+
+    // Sort holes from left to right (insertion sort, hole counts are small)
+    for(i = 1; i < num_queued; i++)
+    {
+        int q = queue[i];
+        for(j = i; j > 0 && TRI_NODE(queue[j-1]).x > TRI_NODE(q).x; j--)
+            queue[j] = queue[j-1];
+        queue[j] = q;
+    }
+
+    // Bridge each hole to the outer polygon
+    for(i = 0; i < num_queued; i++)
+    {
+        int bridge = tri_find_hole_bridge(tri, queue[i], outer_node);
+        if(bridge >= 0)
+        {
+            int b = tri_split_polygon(tri, bridge, queue[i]);
+            if(b < 0)
+                break;
+            tri_filter_points(tri, b, TRI_NODE(b).next);
+        }
+        outer_node = tri_filter_points(tri, outer_node, TRI_NODE(outer_node).next);
+    }
+
+    SDL_free(queue);
+    return outer_node;
+}
+
+static void gpu_triangulate(GPU_Triangulator* tri, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, unsigned int num_vertices)
+{
+    int outer_node;
+
+    tri->num_nodes = 0;
+    tri->max_nodes = num_vertices + 2*num_contours + 8;
+    tri->nodes = (GPU_TriNode*)SDL_malloc(tri->max_nodes * sizeof(GPU_TriNode));
+    tri->num_indices = 0;
+    tri->max_indices = 3*(num_vertices + 2*num_contours);
+    tri->indices = (unsigned int*)SDL_malloc(tri->max_indices * sizeof(unsigned int));
+    tri->failed = (tri->nodes == NULL || tri->indices == NULL);
+    if(tri->failed)
+        return;
+
+    outer_node = tri_linked_list(tri, vertices, 0, contour_sizes[0], GPU_TRUE);
+    if(outer_node < 0 || TRI_NODE(outer_node).next == TRI_NODE(outer_node).prev)
+        return;
+
+    if(num_contours > 1)
+        outer_node = tri_eliminate_holes(tri, num_contours, contour_sizes, vertices, outer_node);
+
+    tri_earcut_linked(tri, outer_node, 0);
+}
+
+
+// Tessellation cache, so static polygons are only triangulated once
+#define GPU_POLYGON_CACHE_SIZE 32
+
+typedef struct GPU_PolygonCacheEntry
+{
+    Uint32 hash;
+    unsigned int num_contours;
+    unsigned int* contour_sizes;
+    unsigned int num_vertices;
+    float* vertices;
+    unsigned int num_indices;
+    unsigned int* indices;
+    Uint32 last_used;
+} GPU_PolygonCacheEntry;
+
+static GPU_PolygonCacheEntry _gpu_polygon_cache[GPU_POLYGON_CACHE_SIZE];
+static Uint32 _gpu_polygon_cache_time = 0;
+
+// FNV-1a
+static Uint32 gpu_hash_bytes(Uint32 hash, const void* data, size_t size)
+{
+    const Uint8* bytes = (const Uint8*)data;
+    size_t i;
+    for(i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void gpu_free_polygon_cache_entry(GPU_PolygonCacheEntry* entry)
+{
+    SDL_free(entry->contour_sizes);
+    SDL_free(entry->vertices);
+    SDL_free(entry->indices);
+    memset(entry, 0, sizeof(GPU_PolygonCacheEntry));
+}
+
+void gpu_free_polygon_cache(void)
+{
+    int i;
+    for(i = 0; i < GPU_POLYGON_CACHE_SIZE; i++)
+        gpu_free_polygon_cache_entry(&_gpu_polygon_cache[i]);
+    _gpu_polygon_cache_time = 0;
+}
+
+// Returns triangle indices into the given vertices.  The result is owned by the cache and stays valid until the next call.
+const unsigned int* gpu_triangulate_polygon(unsigned int num_contours, unsigned int* contour_sizes, float* vertices, unsigned int* num_indices)
+{
+    GPU_Triangulator tri;
+    GPU_PolygonCacheEntry* entry;
+    unsigned int num_vertices = 0;
+    unsigned int i;
+    Uint32 hash;
+
+    *num_indices = 0;
+    if(num_contours == 0 || contour_sizes == NULL || vertices == NULL || contour_sizes[0] < 3)
+        return NULL;
+
+    for(i = 0; i < num_contours; i++)
+        num_vertices += contour_sizes[i];
+
+    hash = gpu_hash_bytes(2166136261u, contour_sizes, num_contours * sizeof(unsigned int));
+    hash = gpu_hash_bytes(hash, vertices, 2 * num_vertices * sizeof(float));
+
+    _gpu_polygon_cache_time++;
+
+    // Look for a cached triangulation, keeping track of the least recently used entry
+    entry = &_gpu_polygon_cache[0];
+    for(i = 0; i < GPU_POLYGON_CACHE_SIZE; i++)
+    {
+        GPU_PolygonCacheEntry* e = &_gpu_polygon_cache[i];
+        if(e->vertices != NULL && e->hash == hash && e->num_contours == num_contours && e->num_vertices == num_vertices
+           && memcmp(e->contour_sizes, contour_sizes, num_contours * sizeof(unsigned int)) == 0
+           && memcmp(e->vertices, vertices, 2 * num_vertices * sizeof(float)) == 0)
+        {
+            e->last_used = _gpu_polygon_cache_time;
+            *num_indices = e->num_indices;
+            return e->indices;
+        }
+
+        if(e->last_used < entry->last_used)
+            entry = e;
+    }
+
+    gpu_triangulate(&tri, num_contours, contour_sizes, vertices, num_vertices);
+    SDL_free(tri.nodes);
+
+    // Replace the least recently used entry
+    gpu_free_polygon_cache_entry(entry);
+    if(!tri.failed)
+    {
+        entry->contour_sizes = (unsigned int*)SDL_malloc(num_contours * sizeof(unsigned int));
+        entry->vertices = (float*)SDL_malloc(2 * num_vertices * sizeof(float));
+    }
+    if(tri.failed || entry->contour_sizes == NULL || entry->vertices == NULL)
+    {
+        // A partial triangulation would leave holes, so draw nothing
+        SDL_free(tri.indices);
+        gpu_free_polygon_cache_entry(entry);
+        GPU_PushErrorCode("GPU_PolygonFilledEx", GPU_ERROR_BACKEND_ERROR, "Failed to allocate triangulation of %u vertices.", num_vertices);
+        return NULL;
+    }
+    entry->hash = hash;
+    entry->num_contours = num_contours;
+    memcpy(entry->contour_sizes, contour_sizes, num_contours * sizeof(unsigned int));
+    entry->num_vertices = num_vertices;
+    memcpy(entry->vertices, vertices, 2 * num_vertices * sizeof(float));
+    entry->num_indices = tri.num_indices;
+    entry->indices = tri.indices;
+    entry->last_used = _gpu_polygon_cache_time;
+
+    *num_indices = entry->num_indices;
+    return entry->indices;
+}
+
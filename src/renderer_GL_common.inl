@@ -78,6 +78,16 @@ See a particular renderer's *.c file for specifics. */
 
 int gpu_strcasecmp(const char* s1, const char* s2);
 
+// Pixel conversion kernels (SDL_gpu_pixels.c)
+GPU_bool gpu_get_pixel_order(const SDL_PixelFormat* src_format, const SDL_PixelFormat* dst_format, Uint8* order);
+void gpu_convert_pixels(unsigned char* dst, int dst_pitch, int dst_bpp, const unsigned char* src, int src_pitch, int src_bpp, const Uint8* order, int w, int h);
+void gpu_premultiply_alpha(unsigned char* pixels, int pitch, int w, int h);
+void gpu_unpremultiply_alpha(unsigned char* pixels, int pitch, int w, int h);
+void gpu_flip_rows(unsigned char* pixels, int pitch, int row_bytes, int h);
+
+// CPU mipmap chains (SDL_gpu_mipmap.c)
+unsigned char* gpu_build_mipmaps(const unsigned char* pixels, int w, int h, int channels, GPU_bool premultiplied, GPU_MipmapFilterEnum filter, int num_threads, int* num_levels);
+
 
 // Default to buffer reset VBO upload method
 #if defined(SDL_GPU_USE_BUFFER_PIPELINE) && !defined(SDL_GPU_USE_BUFFER_RESET) && !defined(SDL_GPU_USE_BUFFER_MAPPING) && !defined(SDL_GPU_USE_BUFFER_UPDATE)
@@ -238,6 +248,39 @@ static_inline void get_target_drawable_dimensions(GPU_Target* target, int* w, in
     #endif
 #endif
 
+// Compressed texture formats, which not every GL header defines
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#endif
+
+// KHR_parallel_shader_compile (and the identical ARB extension)
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Texture format of each YCbCr plane.  Core profiles and GLES 3 have no luminance textures, so the planes are red textures there.
+#if (defined(SDL_GPU_USE_OPENGL) && SDL_GPU_GL_MAJOR_VERSION >= 3) || (defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION >= 3)
+#define GPU_GL_PLANE_FORMAT GL_RED
+#define GPU_GL_PLANE_INTERNAL_FORMAT GL_R8
+#else
+#define GPU_GL_PLANE_FORMAT GL_LUMINANCE
+#endif
+
 
 // Workaround for Intel HD glVertexAttrib() bug.
 #ifdef SDL_GPU_USE_OPENGL
@@ -246,10 +289,17 @@ static GPU_bool apply_Intel_attrib_workaround = GPU_FALSE;
 static GPU_bool vendor_is_Intel = GPU_FALSE;
 #endif
 
+// Memory accounting for GPU_GetMemoryStats() and the GPU_SetTextureBudget() eviction list, most recently used first
+static GPU_MemoryStats memory_stats;
+static GPU_IMAGE_DATA* lru_first = NULL;
+static GPU_IMAGE_DATA* lru_last = NULL;
+static Uint32 lru_frame = 0;
+
 
 
 static SDL_PixelFormat* AllocFormat(GLenum glFormat);
 static void FreeFormat(SDL_PixelFormat* format);
+static GPU_bool IsFeatureEnabled(GPU_Renderer* renderer, GPU_FeatureEnum feature);
 
 
 static char shader_message[256];
@@ -350,6 +400,11 @@ static void copy_upload_texture(const unsigned char* pixels, GPU_Rect update_rec
 
 static void (*slow_upload_texture)(const unsigned char* pixels, GPU_Rect update_rect, Uint32 format, int alignment, unsigned int pitch, int bytes_per_pixel) = NULL;
 
+#ifdef SDL_GPU_USE_PBO
+// Without sync objects, the upload PBO ring relies on buffer orphaning instead of fences.
+static GPU_bool use_upload_fences = GPU_FALSE;
+#endif
+
 static_inline void upload_texture(const void* pixels, GPU_Rect update_rect, Uint32 format, int alignment, int row_length, unsigned int pitch, int bytes_per_pixel)
 {
 	(void)pitch;
@@ -365,18 +420,37 @@ static_inline void upload_texture(const void* pixels, GPU_Rect update_rect, Uint
     #endif
 }
 
+// Largest unpack alignment (up to 8) that evenly divides the row pitch
+static_inline int getRowAlignment(int pitch)
+{
+    int alignment = 8;
+    while(pitch % alignment)
+        alignment >>= 1;
+    return alignment;
+}
+
+// GLES 3 only accepts sized internal formats for the newer pixel formats
+static_inline GLint getInternalFormat(Uint32 format)
+{
+    #ifdef GPU_GL_PLANE_INTERNAL_FORMAT
+    if(format == GPU_GL_PLANE_FORMAT)
+        return GPU_GL_PLANE_INTERNAL_FORMAT;
+    #endif
+    return (GLint)format;
+}
+
 static_inline void upload_new_texture(void* pixels, GPU_Rect update_rect, Uint32 format, int alignment, int row_length, int bytes_per_pixel)
 {
     #if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION > 2
 	(void)bytes_per_pixel;
     glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
-    glTexImage2D(GL_TEXTURE_2D, 0, format, (GLsizei)update_rect.w, (GLsizei)update_rect.h, 0,
+    glTexImage2D(GL_TEXTURE_2D, 0, getInternalFormat(format), (GLsizei)update_rect.w, (GLsizei)update_rect.h, 0,
                     format, GL_UNSIGNED_BYTE, pixels);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     #else
-    glTexImage2D(GL_TEXTURE_2D, 0, format, (GLsizei)update_rect.w, (GLsizei)update_rect.h, 0,
+    glTexImage2D(GL_TEXTURE_2D, 0, getInternalFormat(format), (GLsizei)update_rect.w, (GLsizei)update_rect.h, 0,
                  format, GL_UNSIGNED_BYTE, NULL);
     upload_texture(pixels, update_rect, format, alignment, row_length, row_length*bytes_per_pixel, bytes_per_pixel);
     #endif
@@ -591,6 +665,42 @@ static void init_features(GPU_Renderer* renderer)
     #ifdef SDL_GPU_ASSUME_SHADERS
     renderer->enabled_features |= GPU_FEATURE_BASIC_SHADERS;
     #endif
+
+    // Compressed texture formats
+    if(isExtensionSupported("GL_EXT_texture_compression_s3tc") || isExtensionSupported("GL_WEBGL_compressed_texture_s3tc"))
+        renderer->enabled_features |= GPU_FEATURE_TEXTURE_COMPRESSION_S3TC;
+#ifdef SDL_GPU_USE_OPENGL
+    if(GLEW_VERSION_4_3 || isExtensionSupported("GL_ARB_ES3_compatibility"))
+        renderer->enabled_features |= GPU_FEATURE_TEXTURE_COMPRESSION_ETC2;
+#elif defined(SDL_GPU_USE_GLES)
+    #if SDL_GPU_GLES_MAJOR_VERSION >= 3
+        // Core in GLES 3+
+        renderer->enabled_features |= GPU_FEATURE_TEXTURE_COMPRESSION_ETC2;
+    #endif
+#endif
+    if(isExtensionSupported("GL_KHR_texture_compression_astc_ldr"))
+        renderer->enabled_features |= GPU_FEATURE_TEXTURE_COMPRESSION_ASTC;
+
+    // Uniform buffer objects
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+        #ifdef SDL_GPU_USE_OPENGL
+        if(GLEW_VERSION_3_1 || isExtensionSupported("GL_ARB_uniform_buffer_object"))
+            renderer->enabled_features |= GPU_FEATURE_UNIFORM_BUFFERS;
+        #else
+        // Core in GLES 3+
+        renderer->enabled_features |= GPU_FEATURE_UNIFORM_BUFFERS;
+        #endif
+    #endif
+
+    // Sync objects for the upload PBO ring
+    #ifdef SDL_GPU_USE_PBO
+        #ifdef SDL_GPU_USE_OPENGL
+        use_upload_fences = (GLEW_VERSION_3_2 || isExtensionSupported("GL_ARB_sync"));
+        #else
+        // Core in GLES 3+
+        use_upload_fences = GPU_TRUE;
+        #endif
+    #endif
 }
 
 static void extBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
@@ -600,6 +710,16 @@ static void extBindFramebuffer(GPU_Renderer* renderer, GLuint handle)
 }
 
 
+static_inline GPU_bool isPlanarFormat(GPU_FormatEnum format)
+{
+    return (format == GPU_FORMAT_YCbCr420P || format == GPU_FORMAT_YCbCr422);
+}
+
+static_inline GPU_bool isCompressedFormat(GPU_FormatEnum format)
+{
+    return (format >= GPU_FORMAT_BC1 && format <= GPU_FORMAT_ASTC_4x4);
+}
+
 static_inline GPU_bool isPowerOfTwo(unsigned int x)
 {
     return ((x != 0) && !(x & (x - 1)));
@@ -615,15 +735,129 @@ static_inline unsigned int getNearestPowerOf2(unsigned int n)
     return x;
 }
 
+// Returns the video memory used by an uncompressed image's textures
+static Uint32 getTextureBytes(GPU_Image* image)
+{
+    Uint32 bytes = image->texture_w * image->texture_h * image->bytes_per_pixel;
+
+    if(isPlanarFormat(image->format))
+    {
+        Uint32 chroma_w = (image->texture_w + 1)/2;
+        Uint32 chroma_h = (image->format == GPU_FORMAT_YCbCr420P? (image->texture_h + 1)/2 : image->texture_h);
+        bytes += 2*chroma_w*chroma_h;
+    }
+
+    // A full mipmap chain adds a third
+    if(image->has_mipmaps)
+        bytes += bytes/3;
+    return bytes;
+}
+
+static void setTextureBytes(GPU_IMAGE_DATA* data, Uint32 bytes)
+{
+    if(data->texture_bytes == 0 && bytes > 0)
+        memory_stats.num_textures++;
+    else if(data->texture_bytes > 0 && bytes == 0)
+        memory_stats.num_textures--;
+
+    memory_stats.texture_bytes -= data->texture_bytes;
+    memory_stats.texture_bytes += bytes;
+    data->texture_bytes = bytes;
+}
+
+// Drops the CPU copy of an evicted image whose texture is not coming back
+static void discardEvictedPixels(GPU_IMAGE_DATA* data)
+{
+    if(data->evicted_pixels == NULL)
+        return;
+
+    SDL_free(data->evicted_pixels);
+    data->evicted_pixels = NULL;
+    memory_stats.evicted_bytes -= data->texture_bytes;
+    memory_stats.num_evicted_images--;
+    data->texture_bytes = 0;
+}
+
+static_inline GPU_bool isInLRUList(GPU_IMAGE_DATA* data)
+{
+    return (data->lru_prev != NULL || lru_first == data);
+}
+
+static void unlinkImageData(GPU_IMAGE_DATA* data)
+{
+    if(!isInLRUList(data))
+        return;
+
+    if(data->lru_prev != NULL)
+        data->lru_prev->lru_next = data->lru_next;
+    else
+        lru_first = data->lru_next;
+    if(data->lru_next != NULL)
+        data->lru_next->lru_prev = data->lru_prev;
+    else
+        lru_last = data->lru_prev;
+
+    data->lru_prev = NULL;
+    data->lru_next = NULL;
+}
+
+static void linkImageData(GPU_IMAGE_DATA* data)
+{
+    unlinkImageData(data);
+
+    data->lru_next = lru_first;
+    if(lru_first != NULL)
+        lru_first->lru_prev = data;
+    lru_first = data;
+    if(lru_last == NULL)
+        lru_last = data;
+}
+
+// Marks the image as used this frame, at most one list move per frame
+static_inline void touchImage(GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+
+    // Render targets stay the representative image so they are never evicted
+    if(data->lru_image == NULL || data->lru_image->target == NULL)
+        data->lru_image = image;
+
+    if(data->last_use_frame == lru_frame || !data->owns_handle)
+        return;
+    data->last_use_frame = lru_frame;
+    linkImageData(data);
+}
+
+// Defined with the image memory functions below
+static void restoreEvictedImage(GPU_Renderer* renderer, GPU_Image* image);
+
 static void bindTexture(GPU_Renderer* renderer, GPU_Image* image)
 {
+    touchImage(image);
+
     // Bind the texture to which subsequent calls refer
     if(image != ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image)
     {
-        GLuint handle = ((GPU_IMAGE_DATA*)image->data)->handle;
+        GLuint handle;
+        if(((GPU_IMAGE_DATA*)image->data)->evicted_pixels != NULL)
+            restoreEvictedImage(renderer, image);
+
+        handle = ((GPU_IMAGE_DATA*)image->data)->handle;
         renderer->impl->FlushBlitBuffer(renderer);
 
         glBindTexture( GL_TEXTURE_2D, handle );
+        #ifndef SDL_GPU_DISABLE_SHADERS
+        if(isPlanarFormat(image->format))
+        {
+            // Chroma planes go to the units the YCbCr conversion shader samples
+            Uint32* planes = ((GPU_IMAGE_DATA*)image->data)->plane_handles;
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, planes[0]);
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, planes[1]);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        #endif
         ((GPU_CONTEXT_DATA*)renderer->current_context_target->context->data)->last_image = image;
     }
 }
@@ -1046,6 +1280,15 @@ static void disableTexturing(GPU_Renderer* renderer)
 #define MIX_COLOR_COMPONENT_NORMALIZED_RESULT(a, b) ((a)/255.0f * (b)/255.0f)
 #define MIX_COLOR_COMPONENT(a, b) ((Uint8)(((a)/255.0f * (b)/255.0f)*255))
 
+// Premultiplied images need a premultiplied modulation color too
+static SDL_Color premultiply_mod_color(SDL_Color color)
+{
+    color.r = MIX_COLOR_COMPONENT(color.r, GET_ALPHA(color));
+    color.g = MIX_COLOR_COMPONENT(color.g, GET_ALPHA(color));
+    color.b = MIX_COLOR_COMPONENT(color.b, GET_ALPHA(color));
+    return color;
+}
+
 static SDL_Color get_complete_mod_color(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
 {
 	(void)renderer;
@@ -1058,6 +1301,8 @@ static SDL_Color get_complete_mod_color(GPU_Renderer* renderer, GPU_Target* targ
 			color.g = MIX_COLOR_COMPONENT(target->color.g, image->color.g);
 			color.b = MIX_COLOR_COMPONENT(target->color.b, image->color.b);
 			GET_ALPHA(color) = MIX_COLOR_COMPONENT(GET_ALPHA(target->color), GET_ALPHA(image->color));
+			if(image->has_premultiplied_alpha)
+				color = premultiply_mod_color(color);
 		} else {
 			color = target->color;
 		}
@@ -1065,11 +1310,75 @@ static SDL_Color get_complete_mod_color(GPU_Renderer* renderer, GPU_Target* targ
 		return color;
 	}
 	else if ( image != NULL )
-		return image->color;
+		return (image->has_premultiplied_alpha? premultiply_mod_color(image->color) : image->color);
 	else
 		return color;
 }
 
+#ifndef SDL_GPU_DISABLE_SHADERS
+// Compiles the built-in YCbCr conversion program the first time a planar image is drawn.  Returns 0 if it is not available.
+static Uint32 getYUVShaderProgram(GPU_Renderer* renderer)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+    const char* vertex_shader_source = GPU_DEFAULT_TEXTURED_VERTEX_SHADER_SOURCE;
+    const char* fragment_shader_source = GPU_DEFAULT_YUV_FRAGMENT_SHADER_SOURCE;
+    Uint32 v, f, p;
+
+    if(cdata->yuv_shader_program != 0 || !IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+        return cdata->yuv_shader_program;
+
+    #ifdef SDL_GPU_ENABLE_CORE_SHADERS
+    if(renderer->id.major_version > 3 || (renderer->id.major_version == 3 && renderer->id.minor_version >= 2))
+    {
+        vertex_shader_source = GPU_DEFAULT_TEXTURED_VERTEX_SHADER_SOURCE_CORE;
+        fragment_shader_source = GPU_DEFAULT_YUV_FRAGMENT_SHADER_SOURCE_CORE;
+    }
+    #endif
+
+    v = renderer->impl->CompileShader(renderer, GPU_VERTEX_SHADER, vertex_shader_source);
+    if(!v)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to load YCbCr conversion vertex shader: %s.", GPU_GetShaderMessage());
+        return 0;
+    }
+
+    f = renderer->impl->CompileShader(renderer, GPU_FRAGMENT_SHADER, fragment_shader_source);
+    if(!f)
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to load YCbCr conversion fragment shader: %s.", GPU_GetShaderMessage());
+        renderer->impl->FreeShader(renderer, v);
+        return 0;
+    }
+
+    p = renderer->impl->CreateShaderProgram(renderer);
+    renderer->impl->AttachShader(renderer, p, v);
+    renderer->impl->AttachShader(renderer, p, f);
+    if(!renderer->impl->LinkShaderProgram(renderer, p))
+    {
+        GPU_PushErrorCode("GPU_Blit", GPU_ERROR_BACKEND_ERROR, "Failed to link YCbCr conversion shader program: %s.", GPU_GetShaderMessage());
+        renderer->impl->FreeShader(renderer, v);
+        renderer->impl->FreeShader(renderer, f);
+        return 0;
+    }
+    renderer->impl->FreeShader(renderer, v);
+    renderer->impl->FreeShader(renderer, f);
+
+    cdata->yuv_shader_block = renderer->impl->LoadShaderBlock(renderer, p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+
+    // Point the chroma samplers at the units bindTexture() uses
+    renderer->impl->FlushBlitBuffer(renderer);
+    glUseProgram(p);
+    glUniform1i(glGetUniformLocation(p, "tex"), 0);
+    glUniform1i(glGetUniformLocation(p, "tex_u"), 1);
+    glUniform1i(glGetUniformLocation(p, "tex_v"), 2);
+    glUseProgram(context->current_shader_program);
+
+    cdata->yuv_shader_program = p;
+    return p;
+}
+#endif
+
 static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU_Image* image)
 {
     GPU_Context* context = renderer->current_context_target->context;
@@ -1086,6 +1395,27 @@ static void prepareToRenderImage(GPU_Renderer* renderer, GPU_Target* target, GPU
     changeBlending(renderer, image->use_blending);
     changeBlendMode(renderer, image->blend_mode);
 
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)context->data;
+
+        // Planar images need the YCbCr conversion shader in place of the default textured one.
+        if(isPlanarFormat(image->format))
+        {
+            if(context->current_shader_program == context->default_textured_shader_program
+               || context->current_shader_program == context->default_untextured_shader_program)
+            {
+                if(getYUVShaderProgram(renderer) != 0)
+                    renderer->impl->ActivateShaderProgram(renderer, cdata->yuv_shader_program, &cdata->yuv_shader_block);
+            }
+            return;
+        }
+
+        if(cdata->yuv_shader_program != 0 && context->current_shader_program == cdata->yuv_shader_program)
+            renderer->impl->ActivateShaderProgram(renderer, context->default_textured_shader_program, NULL);
+    }
+    #endif
+
     // If we're using the untextured shader, switch it.
     if(context->current_shader_program == context->default_untextured_shader_program)
         renderer->impl->ActivateShaderProgram(renderer, context->default_textured_shader_program, NULL);
@@ -1110,6 +1440,10 @@ static void prepareToRenderShapes(GPU_Renderer* renderer, unsigned int shape)
     // If we're using the textured shader, switch it.
     if(context->current_shader_program == context->default_textured_shader_program)
         renderer->impl->ActivateShaderProgram(renderer, context->default_untextured_shader_program, NULL);
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    else if(((GPU_CONTEXT_DATA*)context->data)->yuv_shader_program != 0 && context->current_shader_program == ((GPU_CONTEXT_DATA*)context->data)->yuv_shader_program)
+        renderer->impl->ActivateShaderProgram(renderer, context->default_untextured_shader_program, NULL);
+    #endif
 }
 
 
@@ -1847,7 +2181,11 @@ static GPU_Target* CreateTargetFromWindow(GPU_Renderer* renderer, Uint32 windowI
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cdata->blit_IBO);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * cdata->blit_buffer_max_num_vertices, NULL, GL_DYNAMIC_DRAW);
 
-        glGenBuffers(16, cdata->attribute_VBO);
+        glGenBuffers(1, &cdata->attribute_VBO);
+        cdata->attribute_buffer = NULL;
+        cdata->attribute_buffer_size = 0;
+        cdata->attribute_stride_bytes = 0;
+        memset(cdata->attribute_layout, 0, 16*sizeof(Uint32));
 
         // Init 16 attributes to 0 / NULL.
         memset(cdata->shader_attributes, 0, 16*sizeof(GPU_AttributeSource));
@@ -1960,6 +2298,21 @@ static void ResetRendererState(GPU_Renderer* renderer)
     SDL_GL_MakeCurrent(SDL_GetWindowFromID(target->context->windowID), target->context->context);
     #endif
 
+    #if defined(SDL_GPU_USE_BUFFER_PIPELINE) && defined(SDL_GPU_NO_VAO)
+    {
+        // Without a VAO, outside GL code may have changed the custom attribute arrays, so specify them again on the next flush
+        int i;
+        for(i = 0; i < 16; i++)
+        {
+            if(cdata->attribute_layout[i] != 0)
+            {
+                glDisableVertexAttribArray(i);
+                cdata->attribute_layout[i] = 0;
+            }
+        }
+    }
+    #endif
+
 
     #ifndef SDL_GPU_USE_BUFFER_PIPELINE
     glColor4f(cdata->last_color.r/255.01f, cdata->last_color.g/255.01f, cdata->last_color.b/255.01f, GET_ALPHA(cdata->last_color)/255.01f);
@@ -2006,6 +2359,7 @@ static GPU_bool AddDepthBuffer(GPU_Renderer* renderer, GPU_Target* target)
     GLuint depth_buffer;
     GLenum status;
     GPU_CONTEXT_DATA* cdata;
+    GPU_TARGET_DATA* tdata;
     
     if(renderer->current_context_target == NULL)
     {
@@ -2031,8 +2385,22 @@ static GPU_bool AddDepthBuffer(GPU_Renderer* renderer, GPU_Target* target)
     if(status != GL_FRAMEBUFFER_COMPLETE)
     {
         GPU_PushErrorCode("GPU_AddDepthBuffer", GPU_ERROR_BACKEND_ERROR, "Failed to attach depth buffer to target.");
+        glDeleteRenderbuffers(1, &depth_buffer);
         return GPU_FALSE;
     }
+
+    // Keep the handle so FreeTarget() can release it, replacing any earlier depth buffer
+    tdata = (GPU_TARGET_DATA*)target->data;
+    if(tdata->depth_buffer != 0)
+    {
+        glDeleteRenderbuffers(1, &tdata->depth_buffer);
+        memory_stats.renderbuffer_bytes -= tdata->depth_buffer_bytes;
+        memory_stats.num_renderbuffers--;
+    }
+    tdata->depth_buffer = depth_buffer;
+    tdata->depth_buffer_bytes = target->base_w * target->base_h * 2;
+    memory_stats.renderbuffer_bytes += tdata->depth_buffer_bytes;
+    memory_stats.num_renderbuffers++;
     
     
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
@@ -2143,10 +2511,19 @@ static void UnsetVirtualResolution(GPU_Renderer* renderer, GPU_Target* target)
         applyTargetCamera(target);
 }
 
+// Defined in renderer_shapes_GL_common.inl
+static void freeShapeTemplates(void);
+static void freeProgramCache(void);
+static void removeProgramRecords(GPU_Context* context, Uint32 program_object);
+
 static void Quit(GPU_Renderer* renderer)
 {
     renderer->impl->FreeTarget(renderer, renderer->current_context_target);
     renderer->current_context_target = NULL;
+
+    freeShapeTemplates();
+    freeProgramCache();
+    removeProgramRecords(NULL, 0);
 }
 
 
@@ -2353,15 +2730,26 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
             break;
         #endif
         case GPU_FORMAT_YCbCr420P:
-            gl_format = GL_LUMINANCE;
+            gl_format = GPU_GL_PLANE_FORMAT;
             num_layers = 3;
             bytes_per_pixel = 1;
             break;
         case GPU_FORMAT_YCbCr422:
-            gl_format = GL_LUMINANCE;
+            gl_format = GPU_GL_PLANE_FORMAT;
             num_layers = 3;
             bytes_per_pixel = 1;
             break;
+        // Compressed images are read back as RGBA
+        case GPU_FORMAT_BC1:
+        case GPU_FORMAT_BC2:
+        case GPU_FORMAT_BC3:
+        case GPU_FORMAT_ETC2_RGB8:
+        case GPU_FORMAT_ETC2_RGBA8:
+        case GPU_FORMAT_ASTC_4x4:
+            gl_format = GL_RGBA;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
         default:
             GPU_PushErrorCode("GPU_CreateUninitializedImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
             return NULL;
@@ -2385,7 +2773,9 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
     result = (GPU_Image*)SDL_malloc(sizeof(GPU_Image));
     result->refcount = 1;
     data = (GPU_IMAGE_DATA*)SDL_malloc(sizeof(GPU_IMAGE_DATA));
+    memset(data, 0, sizeof(GPU_IMAGE_DATA));
     data->refcount = 1;
+    data->locked_PBO = -1;
     result->target = NULL;
     result->renderer = renderer;
     result->context_target = renderer->current_context_target;
@@ -2407,9 +2797,13 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
 
     result->data = data;
     result->is_alias = GPU_FALSE;
+    result->has_premultiplied_alpha = GPU_FALSE;
     data->handle = handle;
     data->owns_handle = GPU_TRUE;
     data->format = gl_format;
+    data->lru_image = result;
+    data->last_use_frame = lru_frame;
+    linkImageData(data);
 
     result->using_virtual_resolution = GPU_FALSE;
     result->w = w;
@@ -2424,6 +2818,34 @@ static GPU_Image* CreateUninitializedImage(GPU_Renderer* renderer, Uint16 w, Uin
 }
 
 
+// Creates the Cb and Cr textures of a planar image, sized relative to its Y texture so all three share texture coordinates.
+static GPU_bool createChromaPlanes(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned int w = (image->texture_w + 1)/2;
+    unsigned int h = (image->format == GPU_FORMAT_YCbCr420P? (image->texture_h + 1)/2 : image->texture_h);
+    unsigned char* neutral;
+    int i;
+
+    // Start out black rather than green
+    neutral = (unsigned char*)SDL_malloc(w*h);
+    memset(neutral, 128, w*h);
+
+    for(i = 0; i < 2; ++i)
+    {
+        data->plane_handles[i] = CreateUninitializedTexture(renderer);
+        if(data->plane_handles[i] == 0)
+        {
+            SDL_free(neutral);
+            return GPU_FALSE;
+        }
+        upload_new_texture(neutral, GPU_MakeRect(0, 0, w, h), data->format, 1, w, 1);
+    }
+
+    SDL_free(neutral);
+    return GPU_TRUE;
+}
+
 static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
 {
 	GPU_Image* result;
@@ -2431,7 +2853,7 @@ static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_Fo
 	static unsigned char* zero_buffer = NULL;
 	static unsigned int zero_buffer_size = 0;
 
-    if(format < 1)
+    if(format < 1 || isCompressedFormat(format))
     {
         GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
         return NULL;
@@ -2476,77 +2898,257 @@ static GPU_Image* CreateImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_Fo
     result->texture_w = w;
     result->texture_h = h;
 
+    if(isPlanarFormat(format) && !createChromaPlanes(renderer, result))
+    {
+        GPU_PushErrorCode("GPU_CreateImage", GPU_ERROR_BACKEND_ERROR, "Failed to create chroma plane textures.");
+        renderer->impl->FreeImage(renderer, result);
+        return NULL;
+    }
+
+    setTextureBytes((GPU_IMAGE_DATA*)result->data, getTextureBytes(result));
 
     return result;
 }
 
 
-static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHandle handle, GPU_bool take_ownership)
+static GLenum getCompressedInternalFormat(GPU_FormatEnum format)
 {
-    #ifdef SDL_GPU_DISABLE_TEXTURE_GETS
-    GPU_PushErrorCode("GPU_CreateImageUsingTexture", GPU_ERROR_UNSUPPORTED_FUNCTION, "Renderer %s does not support this function", renderer->id.name);
-    return NULL;
-    #else
-
-    GLint w, h;
-    GLuint num_layers, bytes_per_pixel;
-    GLint gl_format;
-    GLint wrap_s, wrap_t;
-    GLint min_filter;
+    switch(format)
+    {
+        case GPU_FORMAT_BC1:
+            return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case GPU_FORMAT_BC2:
+            return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case GPU_FORMAT_BC3:
+            return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case GPU_FORMAT_ETC2_RGB8:
+            return GL_COMPRESSED_RGB8_ETC2;
+        case GPU_FORMAT_ETC2_RGBA8:
+            return GL_COMPRESSED_RGBA8_ETC2_EAC;
+        case GPU_FORMAT_ASTC_4x4:
+            return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+        default:
+            return 0;
+    }
+}
 
-    GPU_FormatEnum format;
-    GPU_WrapEnum wrap_x, wrap_y;
-    GPU_FilterEnum filter_mode;
-	SDL_Color white = { 255, 255, 255, 255 };
+static GPU_Image* CreateCompressedImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format, int num_levels, const unsigned char** level_data, const unsigned int* level_sizes)
+{
+    GPU_Image* result;
+    GLenum internal_format;
+    Uint32 bytes;
+    int i;
 
-	GPU_Image* result;
-	GPU_IMAGE_DATA* data;
-	
-	#ifdef SDL_GPU_USE_GLES
-	if(renderer->id.major_version == 3 && renderer->id.minor_version == 0)
-	{
-	    GPU_PushErrorCode("GPU_CreateImageUsingTexture", GPU_ERROR_UNSUPPORTED_FUNCTION, "Renderer %s's runtime version on this device (3.0) does not support this function", renderer->id.name);
+    internal_format = getCompressedInternalFormat(format);
+    if(internal_format == 0 || level_data == NULL || level_sizes == NULL || num_levels < 1)
+    {
+        GPU_PushErrorCode("GPU_CreateCompressedImage", GPU_ERROR_DATA_ERROR, "Unsupported image format (0x%x)", format);
         return NULL;
-	}
+    }
+
+    #if !defined(SDL_GPU_USE_OPENGL) && SDL_GPU_GLES_MAJOR_VERSION < 3
+    // Without GL_TEXTURE_MAX_LEVEL, a chain that stops short of 1x1 would leave the texture incomplete
+    if((w >> (num_levels - 1)) > 1 || (h >> (num_levels - 1)) > 1)
+        num_levels = 1;
     #endif
 
-    flushAndBindTexture(renderer, handle);
+    result = CreateUninitializedImage(renderer, w, h, format);
+    if(result == NULL)
+    {
+        GPU_PushErrorCode("GPU_CreateCompressedImage", GPU_ERROR_BACKEND_ERROR, "Could not create image as requested.");
+        return NULL;
+    }
 
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &gl_format);
+    changeTexturing(renderer, GPU_TRUE);
+    bindTexture(renderer, result);
 
-    switch(gl_format)
+    #if defined(SDL_GPU_USE_GLES) && (SDL_GPU_GLES_MAJOR_VERSION == 1)
+    // The prebuilt levels replace generated ones
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+    #endif
+
+    bytes = 0;
+    for(i = 0; i < num_levels; ++i)
     {
-        case GL_LUMINANCE:
-            format = GPU_FORMAT_LUMINANCE;
-            num_layers = 1;
-            bytes_per_pixel = 1;
-            break;
-        case GL_LUMINANCE_ALPHA:
-            format = GPU_FORMAT_LUMINANCE_ALPHA;
-            num_layers = 1;
-            bytes_per_pixel = 2;
-            break;
-        case GL_RGB:
-            format = GPU_FORMAT_RGB;
-            num_layers = 1;
-            bytes_per_pixel = 3;
-            break;
-        case GL_RGBA:
-            format = GPU_FORMAT_RGBA;
-            num_layers = 1;
-            bytes_per_pixel = 4;
-            break;
-        #ifdef GL_BGR
-        case GL_BGR:
-            format = GPU_FORMAT_BGR;
-            num_layers = 1;
-            bytes_per_pixel = 3;
-            break;
+        GLsizei level_w = (w >> i > 0? w >> i : 1);
+        GLsizei level_h = (h >> i > 0? h >> i : 1);
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, internal_format, level_w, level_h, 0, level_sizes[i], level_data[i]);
+        bytes += level_sizes[i];
+    }
+    setTextureBytes((GPU_IMAGE_DATA*)result->data, bytes);
+
+    if(num_levels > 1)
+    {
+        #if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
         #endif
-        #ifdef GL_BGRA
-        case GL_BGRA:
-            format = GPU_FORMAT_BGRA;
-            num_layers = 1;
+        result->has_mipmaps = GPU_TRUE;
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+    }
+
+    return result;
+}
+
+static GPU_bool UploadMipmaps(GPU_Renderer* renderer, GPU_Image* image, int num_levels, const unsigned char* levels)
+{
+    GPU_IMAGE_DATA* data;
+    GLint filter;
+    int i;
+
+    if(image == NULL || levels == NULL || num_levels < 2)
+        return GPU_FALSE;
+
+    // The levels are sized for the image, so padded textures are left to GenerateMipmaps()
+    if(image->texture_w != image->base_w || image->texture_h != image->base_h
+       || (image->format != GPU_FORMAT_RGB && image->format != GPU_FORMAT_RGBA))
+        return GPU_FALSE;
+
+    #if !defined(SDL_GPU_USE_OPENGL) && SDL_GPU_GLES_MAJOR_VERSION < 3
+    // Without GL_TEXTURE_MAX_LEVEL, a chain that stops short of 1x1 would leave the texture incomplete
+    if((image->base_w >> (num_levels - 1)) > 1 || (image->base_h >> (num_levels - 1)) > 1)
+        return GPU_FALSE;
+    #endif
+
+    data = (GPU_IMAGE_DATA*)image->data;
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        renderer->impl->FlushBlitBuffer(renderer);
+    bindTexture(renderer, image);
+
+    #if defined(SDL_GPU_USE_GLES) && (SDL_GPU_GLES_MAJOR_VERSION == 1)
+    // The prebuilt levels replace generated ones
+    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+    #endif
+
+    // RGB rows of odd widths are not 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(i = 1; i < num_levels; ++i)
+    {
+        GLsizei level_w = (image->base_w >> i > 0? image->base_w >> i : 1);
+        GLsizei level_h = (image->base_h >> i > 0? image->base_h >> i : 1);
+        glTexImage2D(GL_TEXTURE_2D, i, data->format, level_w, level_h, 0, data->format, GL_UNSIGNED_BYTE, levels);
+        levels += level_w*level_h*image->bytes_per_pixel;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    #if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+    #endif
+    image->has_mipmaps = GPU_TRUE;
+    setTextureBytes(data, getTextureBytes(image));
+
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
+    if(filter == GL_LINEAR)
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+
+    return GPU_TRUE;
+}
+
+
+// Sizes the stream buffers for the whole image.  The CPU buffer is allocated when it is first needed.
+static void allocStreamingStore(GPU_Image* image)
+{
+    #ifdef SDL_GPU_USE_PBO
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+
+    // Allocate the whole ring now so locking never has to resize a buffer
+    unsigned int size = image->base_w * image->base_h * image->bytes_per_pixel;
+    unsigned int i;
+
+    glGenBuffers(GPU_UPLOAD_PBO_RING_SIZE, data->stream_PBO);
+    for(i = 0; i < GPU_UPLOAD_PBO_RING_SIZE; ++i)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, data->stream_PBO[i]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    #else
+    (void)image;
+    #endif
+}
+
+static GPU_Image* CreateStreamingImage(GPU_Renderer* renderer, Uint16 w, Uint16 h, GPU_FormatEnum format)
+{
+    GPU_Image* result;
+    GPU_IMAGE_DATA* data;
+
+    result = renderer->impl->CreateImage(renderer, w, h, format);
+    if(result == NULL)
+        return NULL;
+
+    data = (GPU_IMAGE_DATA*)result->data;
+    data->streaming = GPU_TRUE;
+    allocStreamingStore(result);
+
+    return result;
+}
+
+
+static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHandle handle, GPU_bool take_ownership)
+{
+    #ifdef SDL_GPU_DISABLE_TEXTURE_GETS
+    GPU_PushErrorCode("GPU_CreateImageUsingTexture", GPU_ERROR_UNSUPPORTED_FUNCTION, "Renderer %s does not support this function", renderer->id.name);
+    return NULL;
+    #else
+
+    GLint w, h;
+    GLuint num_layers, bytes_per_pixel;
+    GLint gl_format;
+    GLint wrap_s, wrap_t;
+    GLint min_filter;
+
+    GPU_FormatEnum format;
+    GPU_WrapEnum wrap_x, wrap_y;
+    GPU_FilterEnum filter_mode;
+	SDL_Color white = { 255, 255, 255, 255 };
+
+	GPU_Image* result;
+	GPU_IMAGE_DATA* data;
+	
+	#ifdef SDL_GPU_USE_GLES
+	if(renderer->id.major_version == 3 && renderer->id.minor_version == 0)
+	{
+	    GPU_PushErrorCode("GPU_CreateImageUsingTexture", GPU_ERROR_UNSUPPORTED_FUNCTION, "Renderer %s's runtime version on this device (3.0) does not support this function", renderer->id.name);
+        return NULL;
+	}
+    #endif
+
+    flushAndBindTexture(renderer, handle);
+
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &gl_format);
+
+    switch(gl_format)
+    {
+        case GL_LUMINANCE:
+            format = GPU_FORMAT_LUMINANCE;
+            num_layers = 1;
+            bytes_per_pixel = 1;
+            break;
+        case GL_LUMINANCE_ALPHA:
+            format = GPU_FORMAT_LUMINANCE_ALPHA;
+            num_layers = 1;
+            bytes_per_pixel = 2;
+            break;
+        case GL_RGB:
+            format = GPU_FORMAT_RGB;
+            num_layers = 1;
+            bytes_per_pixel = 3;
+            break;
+        case GL_RGBA:
+            format = GPU_FORMAT_RGBA;
+            num_layers = 1;
+            bytes_per_pixel = 4;
+            break;
+        #ifdef GL_BGR
+        case GL_BGR:
+            format = GPU_FORMAT_BGR;
+            num_layers = 1;
+            bytes_per_pixel = 3;
+            break;
+        #endif
+        #ifdef GL_BGRA
+        case GL_BGRA:
+            format = GPU_FORMAT_BGRA;
+            num_layers = 1;
             bytes_per_pixel = 4;
             break;
         #endif
@@ -2642,7 +3244,9 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHan
 	// Finally create the image
 
     data = (GPU_IMAGE_DATA*)SDL_malloc(sizeof(GPU_IMAGE_DATA));
+    memset(data, 0, sizeof(GPU_IMAGE_DATA));
     data->refcount = 1;
+    data->locked_PBO = -1;
     data->handle = (GLuint)handle;
     data->owns_handle = take_ownership;
     data->format = gl_format;
@@ -2671,6 +3275,7 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHan
 
     result->data = data;
     result->is_alias = GPU_FALSE;
+    result->has_premultiplied_alpha = GPU_FALSE;
 
     result->using_virtual_resolution = GPU_FALSE;
     result->w = (Uint16)w;
@@ -2681,6 +3286,15 @@ static GPU_Image* CreateImageUsingTexture(GPU_Renderer* renderer, GPU_TextureHan
     result->texture_w = (Uint16)w;
     result->texture_h = (Uint16)h;
 
+    // Only owned textures count against the budget
+    if(take_ownership)
+    {
+        data->lru_image = result;
+        data->last_use_frame = lru_frame;
+        linkImageData(data);
+        setTextureBytes(data, getTextureBytes(result));
+    }
+
     return result;
     #endif
 }
@@ -2733,6 +3347,9 @@ static GPU_bool readImagePixels(GPU_Renderer* renderer, GPU_Image* source, GLint
     if(source == NULL)
         return GPU_FALSE;
 
+    if(((GPU_IMAGE_DATA*)source->data)->evicted_pixels != NULL)
+        restoreEvictedImage(renderer, source);
+
     // No glGetTexImage() in OpenGLES
     #ifdef SDL_GPU_USE_GLES
     // Load up the target
@@ -2766,9 +3383,6 @@ static unsigned char* getRawTargetData(GPU_Renderer* renderer, GPU_Target* targe
 {
 	int bytes_per_pixel;
 	unsigned char* data;
-	int pitch;
-	unsigned char* copy;
-	int y;
 
     if(isCurrentTarget(renderer, target))
         renderer->impl->FlushBlitBuffer(renderer);
@@ -2786,18 +3400,7 @@ static unsigned char* getRawTargetData(GPU_Renderer* renderer, GPU_Target* targe
     }
 
     // Flip the data vertically (OpenGL framebuffer is read upside down)
-    pitch = target->base_w * bytes_per_pixel;
-    copy = (unsigned char*)SDL_malloc(pitch);
-
-    for(y = 0; y < target->base_h/2; y++)
-    {
-        unsigned char* top = &data[target->base_w * y * bytes_per_pixel];
-        unsigned char* bottom = &data[target->base_w * (target->base_h - y - 1) * bytes_per_pixel];
-        memcpy(copy, top, pitch);
-        memcpy(top, bottom, pitch);
-        memcpy(bottom, copy, pitch);
-    }
-    SDL_free(copy);
+    gpu_flip_rows(data, target->base_w * bytes_per_pixel, target->base_w * bytes_per_pixel, target->base_h);
 
     return data;
 }
@@ -2895,6 +3498,192 @@ static SDL_Surface* CopySurfaceFromTarget(GPU_Renderer* renderer, GPU_Target* ta
     return result;
 }
 
+
+/*! A GPU_ReadTargetAsync() request waiting for its callback.  Requests complete in order. */
+typedef struct GPU_TargetRead
+{
+    GPU_Target* target;
+    GPU_Context* context;  // Owner of the pack buffer
+    int w, h;
+    int PBO;  // Index into the context's download PBO ring, or -1 when the surface already holds the pixels
+    SDL_Surface* surface;
+    GPU_ReadTargetCallback callback;
+    void* userdata;
+    struct GPU_TargetRead* next;
+} GPU_TargetRead;
+
+static GPU_TargetRead* target_reads_first = NULL;
+static GPU_TargetRead* target_reads_last = NULL;
+
+static SDL_Surface* createReadSurface(int w, int h)
+{
+    SDL_PixelFormat* format = AllocFormat(GL_RGBA);
+    SDL_Surface* result = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, format->BitsPerPixel, format->Rmask, format->Gmask, format->Bmask, format->Amask);
+    FreeFormat(format);
+    return result;
+}
+
+// Copies rows read from OpenGL into the surface top to bottom
+static void copyFlippedRows(SDL_Surface* surface, const unsigned char* pixels)
+{
+    int row_bytes = surface->w*4;
+    int y;
+
+    for(y = 0; y < surface->h; ++y)
+        memcpy((Uint8*)surface->pixels + y*surface->pitch, pixels + (surface->h - 1 - y)*row_bytes, row_bytes);
+}
+
+static GPU_bool hasPendingTargetReads(GPU_Target* target, GPU_Context* context)
+{
+    GPU_TargetRead* read;
+    for(read = target_reads_first; read != NULL; read = read->next)
+    {
+        if((target != NULL && read->target == target) || (context != NULL && read->context == context))
+            return GPU_TRUE;
+    }
+    return GPU_FALSE;
+}
+
+// Delivers finished reads in order.  With 'wait', blocks until all of them are done.
+static void completeTargetReads(GPU_bool wait)
+{
+    while(target_reads_first != NULL)
+    {
+        GPU_TargetRead* read = target_reads_first;
+
+        #ifdef SDL_GPU_USE_PBO
+        if(read->PBO >= 0)
+        {
+            GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)read->context->data;
+            GLsync fence = (GLsync)cdata->download_PBO_fence[read->PBO];
+            const unsigned char* pixels;
+
+            if(!wait && glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+                break;
+            if(wait)
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+            glDeleteSync(fence);
+            cdata->download_PBO_fence[read->PBO] = NULL;
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, cdata->download_PBO[read->PBO]);
+            pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, read->w*read->h*4, GL_MAP_READ_BIT);
+            if(pixels != NULL)
+            {
+                read->surface = createReadSurface(read->w, read->h);
+                if(read->surface != NULL)
+                    copyFlippedRows(read->surface, pixels);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        #endif
+
+        // Dequeue first, since the callback may start new reads
+        target_reads_first = read->next;
+        if(target_reads_first == NULL)
+            target_reads_last = NULL;
+
+        read->callback(read->target, read->surface, read->userdata);
+        SDL_free(read);
+    }
+}
+
+static GPU_bool ReadTargetAsync(GPU_Renderer* renderer, GPU_Target* target, const GPU_Rect* rect, GPU_ReadTargetCallback callback, void* userdata)
+{
+    GPU_TargetRead* read;
+    GPU_Rect r;
+    int x, y, w, h;
+
+    if(target == NULL || callback == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReadTargetAsync", GPU_ERROR_NULL_ARGUMENT, (target == NULL? "target" : "callback"));
+        return GPU_FALSE;
+    }
+
+    // Clip the region to the target
+    r = (rect != NULL? *rect : GPU_MakeRect(0, 0, target->base_w, target->base_h));
+    x = (r.x > 0? (int)r.x : 0);
+    y = (r.y > 0? (int)r.y : 0);
+    w = (int)(r.x + r.w) - x;
+    h = (int)(r.y + r.h) - y;
+    if(x + w > target->base_w)
+        w = target->base_w - x;
+    if(y + h > target->base_h)
+        h = target->base_h - y;
+    if(w < 1 || h < 1)
+    {
+        GPU_PushErrorCode("GPU_ReadTargetAsync", GPU_ERROR_DATA_ERROR, "Clipped region has zero size.");
+        return GPU_FALSE;
+    }
+
+    if(isCurrentTarget(renderer, target))
+        renderer->impl->FlushBlitBuffer(renderer);
+    if(!bindFramebuffer(renderer, target))
+    {
+        GPU_PushErrorCode("GPU_ReadTargetAsync", GPU_ERROR_BACKEND_ERROR, "Failed to bind target framebuffer.");
+        return GPU_FALSE;
+    }
+
+    read = (GPU_TargetRead*)SDL_malloc(sizeof(GPU_TargetRead));
+    memset(read, 0, sizeof(GPU_TargetRead));
+    read->target = target;
+    read->context = renderer->current_context_target->context;
+    read->w = w;
+    read->h = h;
+    read->PBO = -1;
+    read->callback = callback;
+    read->userdata = userdata;
+
+    // OpenGL rows go bottom to top
+    y = target->base_h - (y + h);
+
+    #ifdef SDL_GPU_USE_PBO
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)read->context->data;
+        unsigned int i = cdata->download_PBO_next;
+        unsigned int size = w*h*4;
+
+        // Every buffer is in flight, so finish up to the oldest one
+        while(cdata->download_PBO_fence[i] != NULL)
+            completeTargetReads(GPU_TRUE);
+
+        cdata->download_PBO_next = (i + 1) % GPU_DOWNLOAD_PBO_RING_SIZE;
+        if(cdata->download_PBO[i] == 0)
+            glGenBuffers(1, &cdata->download_PBO[i]);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, cdata->download_PBO[i]);
+        if(size > cdata->download_PBO_size[i])
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+            cdata->download_PBO_size[i] = size;
+        }
+
+        // Returns right away, the copy happens on the GPU
+        glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        cdata->download_PBO_fence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        read->PBO = (int)i;
+    }
+    #else
+    {
+        unsigned char* pixels = (unsigned char*)SDL_malloc(w*h*4);
+        glReadPixels(x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        read->surface = createReadSurface(w, h);
+        if(read->surface != NULL)
+            copyFlippedRows(read->surface, pixels);
+        SDL_free(pixels);
+    }
+    #endif
+
+    if(target_reads_last != NULL)
+        target_reads_last->next = read;
+    else
+        target_reads_first = read;
+    target_reads_last = read;
+
+    return GPU_TRUE;
+}
+
 static SDL_Surface* CopySurfaceFromImage(GPU_Renderer* renderer, GPU_Image* image)
 {
     unsigned char* data;
@@ -2953,6 +3742,10 @@ static SDL_Surface* CopySurfaceFromImage(GPU_Renderer* renderer, GPU_Image* imag
         }
     }
 
+    // Surfaces use straight alpha
+    if(image->has_premultiplied_alpha && format->BytesPerPixel == 4)
+        gpu_unpremultiply_alpha((unsigned char*)result->pixels, result->pitch, w, h);
+
     SDL_free(data);
 
     FreeFormat(format);
@@ -3234,6 +4027,33 @@ static void FreeFormat(SDL_PixelFormat* format)
 }
 
 
+// Returns a new surface in the given format, or NULL on failure
+static SDL_Surface* convertSurface(SDL_Surface* surface, GLenum glFormat)
+{
+    SDL_PixelFormat* dst_fmt = AllocFormat(glFormat);
+    SDL_Surface* result;
+    Uint8 order[4];
+
+    // Plain byte swizzles and 24 <-> 32 bit repacking have vectorized kernels.  SDL handles the rest, including color keys.
+    if(dst_fmt != NULL && !has_colorkey(surface) && gpu_get_pixel_order(surface->format, dst_fmt, order))
+    {
+        result = SDL_CreateRGBSurface(SDL_SWSURFACE, surface->w, surface->h, dst_fmt->BitsPerPixel, dst_fmt->Rmask, dst_fmt->Gmask, dst_fmt->Bmask, dst_fmt->Amask);
+        if(result != NULL)
+        {
+            if(SDL_MUSTLOCK(surface))
+                SDL_LockSurface(surface);
+            gpu_convert_pixels((unsigned char*)result->pixels, result->pitch, dst_fmt->BytesPerPixel, (const unsigned char*)surface->pixels, surface->pitch, surface->format->BytesPerPixel, order, surface->w, surface->h);
+            if(SDL_MUSTLOCK(surface))
+                SDL_UnlockSurface(surface);
+        }
+    }
+    else
+        result = SDL_ConvertSurface(surface, dst_fmt, 0);
+
+    FreeFormat(dst_fmt);
+    return result;
+}
+
 // Returns NULL on failure.  Returns the original surface if no copy is needed.  Returns a new surface converted to the right format otherwise.
 static SDL_Surface* copySurfaceIfNeeded(GPU_Renderer* renderer, GLenum glFormat, SDL_Surface* surface, GLenum* surfaceFormatResult)
 {
@@ -3249,9 +4069,7 @@ static SDL_Surface* copySurfaceIfNeeded(GPU_Renderer* renderer, GLenum glFormat,
     if(format_compare > 0)
     {
         // Convert to the right format
-        SDL_PixelFormat* dst_fmt = AllocFormat(glFormat);
-        surface = SDL_ConvertSurface(surface, dst_fmt, 0);
-        FreeFormat(dst_fmt);
+        surface = convertSurface(surface, glFormat);
         if(surfaceFormatResult != NULL && surface != NULL)
             *surfaceFormatResult = glFormat;
     }
@@ -3398,6 +4216,7 @@ static GPU_Image* CopyImage(GPU_Renderer* renderer, GPU_Image* image)
         GPU_SetColor(result, image->color);
         GPU_SetBlending(result, image->use_blending);
         result->blend_mode = image->blend_mode;
+        result->has_premultiplied_alpha = image->has_premultiplied_alpha;
         GPU_SetImageFilter(result, image->filter_mode);
         GPU_SetSnapMode(result, image->snap_mode);
         GPU_SetWrapMode(result, image->wrap_mode_x, image->wrap_mode_y);
@@ -3426,6 +4245,12 @@ static void UpdateImage(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect
     if(image == NULL || surface == NULL)
         return;
 
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_UpdateImage", GPU_ERROR_UNSUPPORTED_FUNCTION, "Compressed images cannot be updated.");
+        return;
+    }
+
     data = (GPU_IMAGE_DATA*)image->data;
     original_format = data->format;
 
@@ -3542,6 +4367,12 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
     if(image == NULL || bytes == NULL)
         return;
 
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_UpdateImageBytes", GPU_ERROR_UNSUPPORTED_FUNCTION, "Compressed images cannot be updated.");
+        return;
+    }
+
     data = (GPU_IMAGE_DATA*)image->data;
     original_format = data->format;
 
@@ -3594,39 +4425,359 @@ static void UpdateImageBytes(GPU_Renderer* renderer, GPU_Image* image, const GPU
 }
 
 
-
-static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
+// Clips a region to the image's original dimensions in whole pixels, so the row length is exact when uploading.  NULL means the whole image.
+static GPU_Rect getClippedImageRect(GPU_Image* image, const GPU_Rect* image_rect)
 {
-	GPU_IMAGE_DATA* data;
-	GPU_Rect sourceRect;
-	SDL_Surface* newSurface;
-	GLenum internal_format;
-	Uint8* pixels;
-	int w, h;
-	int alignment;
+    GPU_Rect result;
 
-    if(image == NULL)
+    if(image_rect == NULL)
+        return GPU_MakeRect(0, 0, image->base_w, image->base_h);
+
+    result = *image_rect;
+    if(result.x < 0)
     {
-        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "image");
-        return GPU_FALSE;
+        result.w += result.x;
+        result.x = 0;
+    }
+    if(result.y < 0)
+    {
+        result.h += result.y;
+        result.y = 0;
     }
+    if(result.x + result.w > image->base_w)
+        result.w += image->base_w - (result.x + result.w);
+    if(result.y + result.h > image->base_h)
+        result.h += image->base_h - (result.y + result.h);
 
-    if(surface == NULL)
+    return GPU_MakeRect(floorf(result.x), floorf(result.y), floorf(result.w), floorf(result.h));
+}
+
+static void UpdateImageYUV(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, const unsigned char* y_plane, const unsigned char* u_plane, const unsigned char* v_plane, const int* pitches)
+{
+    GPU_IMAGE_DATA* data;
+    GPU_Rect updateRect, chromaRect;
+    const unsigned char* chroma_planes[2];
+    int i;
+
+    if(image == NULL || y_plane == NULL || u_plane == NULL || v_plane == NULL || pitches == NULL)
+        return;
+
+    if(!isPlanarFormat(image->format))
     {
-        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "surface");
-        return GPU_FALSE;
+        GPU_PushErrorCode("GPU_UpdateImageYUV", GPU_ERROR_USER_ERROR, "Image is not in a planar YCbCr format.");
+        return;
     }
 
     data = (GPU_IMAGE_DATA*)image->data;
-    internal_format = data->format;
 
-    newSurface = copySurfaceIfNeeded(renderer, internal_format, surface, &internal_format);
+    updateRect = getClippedImageRect(image, image_rect);
+    if(updateRect.w <= 0 || updateRect.h <= 0)
+        return;
+
+    // Chroma is subsampled, so start on a shared chroma sample
+    updateRect.x = (float)((int)updateRect.x & ~1);
+    if(image->format == GPU_FORMAT_YCbCr420P)
+        updateRect.y = (float)((int)updateRect.y & ~1);
+
+    chromaRect.x = updateRect.x/2;
+    chromaRect.w = (float)(((int)updateRect.w + 1)/2);
+    if(image->format == GPU_FORMAT_YCbCr420P)
+    {
+        chromaRect.y = updateRect.y/2;
+        chromaRect.h = (float)(((int)updateRect.h + 1)/2);
+    }
+    else
+    {
+        chromaRect.y = updateRect.y;
+        chromaRect.h = updateRect.h;
+    }
+
+    changeTexturing(renderer, 1);
+    flushBlitBufferIfCurrentTexture(renderer, image);
+    if(image->target != NULL && isCurrentTarget(renderer, image->target))
+        renderer->impl->FlushBlitBuffer(renderer);
+
+    bindTexture(renderer, image);
+    upload_texture(y_plane, updateRect, data->format, getRowAlignment(pitches[0]), pitches[0], pitches[0], 1);
+
+    chroma_planes[0] = u_plane;
+    chroma_planes[1] = v_plane;
+    for(i = 0; i < 2; ++i)
+    {
+        flushAndBindTexture(renderer, data->plane_handles[i]);
+        upload_texture(chroma_planes[i], chromaRect, data->format, getRowAlignment(pitches[i+1]), pitches[i+1], pitches[i+1], 1);
+    }
+}
+
+#ifdef SDL_GPU_USE_PBO
+// Maps the next free buffer of a PBO ring for writing and returns its index through 'index'.  If 'sizes' is NULL, the buffers were allocated up front and are large enough.
+// 'mapped' tracks buffers that stay mapped while their images are locked.  It can be NULL for a ring that has only one lock at a time.  Returns NULL if every buffer is mapped.
+static void* mapUploadPBO(unsigned int* PBOs, unsigned int* sizes, void** fences, unsigned int* next, unsigned int* mapped, unsigned int size, int* index)
+{
+    unsigned int i = *next;
+    unsigned int n;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    void* result;
+
+    *index = -1;
+    if(mapped != NULL)
+    {
+        for(n = 0; n < GPU_UPLOAD_PBO_RING_SIZE && (*mapped & (1u << i)); ++n)
+            i = (i + 1) % GPU_UPLOAD_PBO_RING_SIZE;
+        if(n == GPU_UPLOAD_PBO_RING_SIZE)
+            return NULL;
+    }
+
+    *next = (i + 1) % GPU_UPLOAD_PBO_RING_SIZE;
+
+    if(PBOs[i] == 0)
+        glGenBuffers(1, &PBOs[i]);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBOs[i]);
+
+    if(fences[i] != NULL)
+    {
+        // Wait until the GPU has finished reading the last upload from this buffer, then write without further synchronization.
+        glClientWaitSync((GLsync)fences[i], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync((GLsync)fences[i]);
+        fences[i] = NULL;
+        access |= GL_MAP_UNSYNCHRONIZED_BIT;
+    }
+
+    if(sizes != NULL && size > sizes[i])
+    {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        sizes[i] = size;
+    }
+
+    // Without fences, invalidating the buffer lets the driver orphan it instead of stalling.
+    result = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, access);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if(result != NULL)
+    {
+        *index = (int)i;
+        if(mapped != NULL)
+            *mapped |= (1u << i);
+    }
+    return result;
+}
+#endif
+
+
+static GPU_bool LockImageRegion(GPU_Renderer* renderer, GPU_Image* image, const GPU_Rect* image_rect, void** pixels, int* pitch)
+{
+    GPU_IMAGE_DATA* data;
+    GPU_Rect lockRect;
+    int row_bytes;
+    unsigned int size;
+
+    if(image == NULL || pixels == NULL || pitch == NULL)
+        return GPU_FALSE;
+
+    if(isCompressedFormat(image->format))
+    {
+        GPU_PushErrorCode("GPU_LockImageRegion", GPU_ERROR_UNSUPPORTED_FUNCTION, "Compressed images cannot be locked.");
+        return GPU_FALSE;
+    }
+
+    data = (GPU_IMAGE_DATA*)image->data;
+    if(data->locked)
+    {
+        GPU_PushErrorCode("GPU_LockImageRegion", GPU_ERROR_USER_ERROR, "Image is already locked.");
+        return GPU_FALSE;
+    }
+
+    lockRect = getClippedImageRect(image, image_rect);
+    if(lockRect.w <= 0 || lockRect.h <= 0)
+    {
+        GPU_PushErrorCode("GPU_LockImageRegion", GPU_ERROR_USER_ERROR, "Given empty image rectangle.");
+        return GPU_FALSE;
+    }
+
+    row_bytes = (int)lockRect.w * image->bytes_per_pixel;
+    size = (unsigned int)(row_bytes * (int)lockRect.h);
+
+    data->locked_rect = lockRect;
+    data->locked_pitch = row_bytes;
+    data->locked_PBO = -1;
+    data->locked_pixels = NULL;
+
+    #ifdef SDL_GPU_USE_PBO
+    if(data->streaming)
+        data->locked_pixels = mapUploadPBO(data->stream_PBO, NULL, data->stream_PBO_fence, &data->stream_PBO_next, NULL, size, &data->locked_PBO);
+    else
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        data->locked_pixels = mapUploadPBO(cdata->upload_PBO, cdata->upload_PBO_size, cdata->upload_PBO_fence, &cdata->upload_PBO_next, &cdata->upload_PBO_mapped, size, &data->locked_PBO);
+    }
+    #endif
+
+    if(data->locked_pixels == NULL)
+    {
+        if(data->streaming)
+        {
+            // Keep the whole-image buffer around for the next frame
+            if(data->stream_pixels == NULL)
+                data->stream_pixels = SDL_malloc(image->base_w * image->base_h * image->bytes_per_pixel);
+            data->locked_pixels = data->stream_pixels;
+        }
+        else
+            data->locked_pixels = SDL_malloc(size);
+
+        if(data->locked_pixels == NULL)
+        {
+            GPU_PushErrorCode("GPU_LockImageRegion", GPU_ERROR_BACKEND_ERROR, "Failed to allocate pixel buffer.");
+            return GPU_FALSE;
+        }
+    }
+
+    data->locked = GPU_TRUE;
+    *pixels = data->locked_pixels;
+    *pitch = data->locked_pitch;
+    return GPU_TRUE;
+}
+
+static void UnlockImageRegion(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data;
+
+    if(image == NULL)
+        return;
+
+    data = (GPU_IMAGE_DATA*)image->data;
+    if(!data->locked)
+    {
+        GPU_PushErrorCode("GPU_UnlockImageRegion", GPU_ERROR_USER_ERROR, "Image is not locked.");
+        return;
+    }
+
+    data->locked = GPU_FALSE;
+
+    #ifdef SDL_GPU_USE_PBO
+    if(data->locked_PBO >= 0)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        unsigned int* PBOs = (data->streaming? data->stream_PBO : cdata->upload_PBO);
+        void** fences = (data->streaming? data->stream_PBO_fence : cdata->upload_PBO_fence);
+        int alignment;
+
+        changeTexturing(renderer, 1);
+        flushBlitBufferIfCurrentTexture(renderer, image);
+        if(image->target != NULL && isCurrentTarget(renderer, image->target))
+            renderer->impl->FlushBlitBuffer(renderer);
+        bindTexture(renderer, image);
+
+        alignment = getRowAlignment(data->locked_pitch);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, PBOs[data->locked_PBO]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        if(!data->streaming)
+            cdata->upload_PBO_mapped &= ~(1u << data->locked_PBO);
+
+        // With a bound unpack buffer, the pixel pointer is an offset into it and the copy happens on the GPU.
+        fast_upload_texture(NULL, data->locked_rect, data->format, alignment, (int)data->locked_rect.w);
+
+        if(use_upload_fences)
+            fences[data->locked_PBO] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        data->locked_PBO = -1;
+        data->locked_pixels = NULL;
+        return;
+    }
+    #endif
+
+    UpdateImageBytes(renderer, image, &data->locked_rect, (const unsigned char*)data->locked_pixels, data->locked_pitch);
+    if(data->locked_pixels != data->stream_pixels)
+        SDL_free(data->locked_pixels);
+    data->locked_pixels = NULL;
+}
+
+// Releases a locked region without uploading it
+static void discardLockedImageRegion(GPU_Renderer* renderer, GPU_IMAGE_DATA* data)
+{
+    (void)renderer;
+    if(!data->locked)
+        return;
+
+    data->locked = GPU_FALSE;
+
+    #ifdef SDL_GPU_USE_PBO
+    if(data->locked_PBO >= 0)
+    {
+        GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, (data->streaming? data->stream_PBO : cdata->upload_PBO)[data->locked_PBO]);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if(!data->streaming)
+            cdata->upload_PBO_mapped &= ~(1u << data->locked_PBO);
+        data->locked_PBO = -1;
+        data->locked_pixels = NULL;
+        return;
+    }
+    #endif
+
+    if(data->locked_pixels != data->stream_pixels)
+        SDL_free(data->locked_pixels);
+    data->locked_pixels = NULL;
+}
+
+static void freeStreamingStore(GPU_IMAGE_DATA* data)
+{
+    #ifdef SDL_GPU_USE_PBO
+    unsigned int i;
+    for(i = 0; i < GPU_UPLOAD_PBO_RING_SIZE; ++i)
+    {
+        if(data->stream_PBO_fence[i] != NULL)
+            glDeleteSync((GLsync)data->stream_PBO_fence[i]);
+        data->stream_PBO_fence[i] = NULL;
+    }
+    glDeleteBuffers(GPU_UPLOAD_PBO_RING_SIZE, data->stream_PBO);
+    memset(data->stream_PBO, 0, sizeof(data->stream_PBO));
+    data->stream_PBO_next = 0;
+    #endif
+
+    SDL_free(data->stream_pixels);
+    data->stream_pixels = NULL;
+}
+
+
+
+static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surface* surface, const GPU_Rect* surface_rect)
+{
+	GPU_IMAGE_DATA* data;
+	GPU_Rect sourceRect;
+	SDL_Surface* newSurface;
+	GLenum internal_format;
+	Uint8* pixels;
+	int w, h;
+	int alignment;
+
+    if(image == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "image");
+        return GPU_FALSE;
+    }
+
+    if(surface == NULL)
+    {
+        GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_NULL_ARGUMENT, "surface");
+        return GPU_FALSE;
+    }
+
+    data = (GPU_IMAGE_DATA*)image->data;
+    internal_format = data->format;
+
+    newSurface = copySurfaceIfNeeded(renderer, internal_format, surface, &internal_format);
     if(newSurface == NULL)
     {
         GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_BACKEND_ERROR, "Failed to convert surface to proper pixel format.");
         return GPU_FALSE;
     }
 
+    // A locked region belongs to the old texture
+    discardLockedImageRegion(renderer, data);
+
     // Free the attached framebuffer
     if((renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS) && image->target != NULL)
     {
@@ -3634,7 +4785,10 @@ static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surfa
         if(renderer->current_context_target != NULL)
             flushAndClearBlitBufferIfCurrentFramebuffer(renderer, image->target);
         if(tdata->handle != 0)
+        {
             glDeleteFramebuffersPROC(1, &tdata->handle);
+            memory_stats.num_framebuffers--;
+        }
         tdata->handle = 0;
     }
 
@@ -3642,6 +4796,12 @@ static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surfa
     if(data->owns_handle)
         glDeleteTextures( 1, &data->handle);
     data->handle = 0;
+    discardEvictedPixels(data);
+    setTextureBytes(data, 0);
+
+    // The replacement is uploaded uncompressed
+    if(isCompressedFormat(image->format))
+        image->format = GPU_FORMAT_RGBA;
 
     // Get the area of the surface we'll use
     if(surface_rect == NULL)
@@ -3714,6 +4874,13 @@ static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surfa
 
     image->has_mipmaps = GPU_FALSE;
 
+    // The stream buffers were sized for the old image
+    if(data->streaming)
+    {
+        freeStreamingStore(data);
+        allocStreamingStore(image);
+    }
+
 
     // Upload surface pixel data
     alignment = 8;
@@ -3726,6 +4893,9 @@ static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surfa
 
     upload_new_texture(pixels, GPU_MakeRect(0, 0, (float)w, (float)h), internal_format, alignment, (newSurface->pitch / newSurface->format->BytesPerPixel), newSurface->format->BytesPerPixel);
     
+    setTextureBytes(data, getTextureBytes(image));
+    data->last_use_frame = lru_frame;
+    linkImageData(data);
 
     // Delete temporary surface
     if(surface != newSurface)
@@ -3748,6 +4918,7 @@ static GPU_bool ReplaceImage(GPU_Renderer* renderer, GPU_Image* image, SDL_Surfa
             GPU_PushErrorCode("GPU_ReplaceImage", GPU_ERROR_BACKEND_ERROR, "Failed to create new framebuffer target.");
             return GPU_FALSE;
         }
+        memory_stats.num_framebuffers++;
 
         flushAndBindFramebuffer(renderer, tdata->handle);
 
@@ -3849,6 +5020,26 @@ static GPU_Image* CopyImageFromSurface(GPU_Renderer* renderer, SDL_Surface* surf
     if(image == NULL)
         return NULL;
 
+    if(format == GPU_FORMAT_RGBA && GPU_GetPremultiplyOnLoad())
+    {
+        // Premultiply a converted copy, which also resolves color keys into alpha
+        SDL_Surface* premultiplied = convertSurface(surface, GL_RGBA);
+        if(premultiplied == NULL)
+        {
+            GPU_PushErrorCode("GPU_CopyImageFromSurface", GPU_ERROR_DATA_ERROR, "Failed to convert surface for premultiplication.");
+            renderer->impl->FreeImage(renderer, image);
+            return NULL;
+        }
+
+        gpu_premultiply_alpha((unsigned char*)premultiplied->pixels, premultiplied->pitch, premultiplied->w, premultiplied->h);
+        image->has_premultiplied_alpha = GPU_TRUE;
+        image->blend_mode = GPU_GetBlendModeFromPreset(GPU_BLEND_PREMULTIPLIED_ALPHA);
+
+        renderer->impl->UpdateImage(renderer, image, NULL, premultiplied, NULL);
+        SDL_FreeSurface(premultiplied);
+        return image;
+    }
+
     renderer->impl->UpdateImage(renderer, image, NULL, surface, NULL);
 
     return image;
@@ -3908,6 +5099,9 @@ static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
     if(data->refcount > 1)
     {
         data->refcount--;
+        // The next alias to be drawn takes over
+        if(data->lru_image == image)
+            data->lru_image = NULL;
     }
     else
     {
@@ -3915,7 +5109,15 @@ static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
         {
             GPU_MakeCurrent(image->context_target, image->context_target->context->windowID);
             glDeleteTextures( 1, &data->handle);
+            if(data->plane_handles[0] != 0)
+                glDeleteTextures( 2, data->plane_handles);
         }
+        discardEvictedPixels(data);
+        setTextureBytes(data, 0);
+        unlinkImageData(data);
+        discardLockedImageRegion(renderer, data);
+        if(data->streaming)
+            freeStreamingStore(data);
         SDL_free(data);
     }
 
@@ -3923,6 +5125,170 @@ static void FreeImage(GPU_Renderer* renderer, GPU_Image* image)
 }
 
 
+// Uploads the CPU copy of an image evicted by the texture budget into a new texture
+static void restoreEvictedImage(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned char* pixels = data->evicted_pixels;
+    GLuint handle;
+
+    handle = CreateUninitializedTexture(renderer);
+    if(handle == 0)
+    {
+        GPU_PushErrorCode("GPU_SetTextureBudget", GPU_ERROR_BACKEND_ERROR, "Failed to generate a texture handle for an evicted image.");
+        return;
+    }
+
+    data->handle = handle;
+    data->evicted_pixels = NULL;
+    upload_new_texture(pixels, GPU_MakeRect(0, 0, image->texture_w, image->texture_h), data->format, 1, image->texture_w, image->bytes_per_pixel);
+    SDL_free(pixels);
+
+    memory_stats.evicted_bytes -= data->texture_bytes;
+    memory_stats.num_evicted_images--;
+    memory_stats.texture_bytes += data->texture_bytes;
+    memory_stats.num_textures++;
+
+    data->last_use_frame = lru_frame;
+    linkImageData(data);
+
+    #ifndef __IPHONEOS__
+    if(image->has_mipmaps)
+        glGenerateMipmapPROC(GL_TEXTURE_2D);
+    #endif
+
+    // The new texture starts with default sampler state
+    renderer->impl->SetImageFilter(renderer, image, image->filter_mode);
+    renderer->impl->SetWrapMode(renderer, image, image->wrap_mode_x, image->wrap_mode_y);
+}
+
+// Reads the whole texture of an image, padding included, in the layout restoreEvictedImage() uploads.  Returns NULL on failure.
+static unsigned char* readEvictedPixels(GPU_Renderer* renderer, GPU_Image* image)
+{
+    GPU_IMAGE_DATA* data = (GPU_IMAGE_DATA*)image->data;
+    unsigned int num_pixels = image->texture_w * image->texture_h;
+    unsigned char* pixels;
+    #ifdef SDL_GPU_USE_GLES
+    GPU_bool result;
+    unsigned int i;
+
+    // No glGetTexImage() in OpenGLES, and framebuffer reads are only guaranteed in RGBA
+    if(data->format != GL_RGB && data->format != GL_RGBA)
+        return NULL;
+
+    pixels = (unsigned char*)SDL_malloc(num_pixels * 4);
+    if(pixels == NULL)
+        return NULL;
+
+    renderer->impl->GetTarget(renderer, image);
+    result = (image->target != NULL && bindFramebuffer(renderer, image->target));
+    if(result)
+        glReadPixels(0, 0, image->texture_w, image->texture_h, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    renderer->impl->FreeTarget(renderer, image->target);
+    if(!result)
+    {
+        SDL_free(pixels);
+        return NULL;
+    }
+
+    // Pack down to the texture's format
+    if(data->format == GL_RGB)
+    {
+        for(i = 0; i < num_pixels; ++i)
+        {
+            pixels[3*i] = pixels[4*i];
+            pixels[3*i + 1] = pixels[4*i + 1];
+            pixels[3*i + 2] = pixels[4*i + 2];
+        }
+    }
+    #else
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+
+    pixels = (unsigned char*)SDL_malloc(num_pixels * image->bytes_per_pixel);
+    if(pixels == NULL)
+        return NULL;
+
+    // Tightly packed rows to match the upload
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, data->handle);
+    glGetTexImage(GL_TEXTURE_2D, 0, data->format, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    if(cdata->last_image != NULL)
+        glBindTexture(GL_TEXTURE_2D, ((GPU_IMAGE_DATA*)cdata->last_image->data)->handle);
+    #endif
+
+    return pixels;
+}
+
+// Replaces an image's texture with a CPU copy.  Returns false if the image can't be evicted.
+static GPU_bool evictImage(GPU_Renderer* renderer, GPU_IMAGE_DATA* data)
+{
+    GPU_CONTEXT_DATA* cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
+    GPU_Image* image = data->lru_image;
+    unsigned char* pixels;
+
+    if(image == NULL || image->target != NULL || !data->owns_handle || data->locked || data->streaming
+       || isPlanarFormat(image->format) || isCompressedFormat(image->format)
+       || data->texture_bytes == 0 || data->evicted_pixels != NULL)
+        return GPU_FALSE;
+
+    pixels = readEvictedPixels(renderer, image);
+    if(pixels == NULL)
+        return GPU_FALSE;
+
+    // Aliases share the texture too
+    if(cdata->last_image != NULL && cdata->last_image->data == data)
+    {
+        renderer->impl->FlushBlitBuffer(renderer);
+        cdata->last_image = NULL;
+    }
+
+    glDeleteTextures(1, &data->handle);
+    data->handle = 0;
+    data->evicted_pixels = pixels;
+    unlinkImageData(data);
+
+    memory_stats.texture_bytes -= data->texture_bytes;
+    memory_stats.num_textures--;
+    memory_stats.evicted_bytes += data->texture_bytes;
+    memory_stats.num_evicted_images++;
+    return GPU_TRUE;
+}
+
+static void enforceTextureBudget(GPU_Renderer* renderer)
+{
+    GPU_IMAGE_DATA* data = lru_last;
+
+    while(data != NULL && memory_stats.texture_bytes > memory_stats.budget_bytes)
+    {
+        GPU_IMAGE_DATA* prev = data->lru_prev;
+
+        // Everything from here to the front was used this frame and may still have draws queued
+        if(data->last_use_frame == lru_frame)
+            break;
+
+        evictImage(renderer, data);
+        data = prev;
+    }
+}
+
+static GPU_MemoryStats GetMemoryStats(GPU_Renderer* renderer)
+{
+    (void)renderer;
+    return memory_stats;
+}
+
+static void SetTextureBudget(GPU_Renderer* renderer, Uint64 max_bytes)
+{
+    memory_stats.budget_bytes = max_bytes;
+    if(max_bytes > 0)
+    {
+        renderer->impl->FlushBlitBuffer(renderer);
+        enforceTextureBudget(renderer);
+    }
+}
+
+
 
 static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
 {
@@ -3940,6 +5306,10 @@ static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
     if(!(renderer->enabled_features & GPU_FEATURE_RENDER_TARGETS))
         return NULL;
 
+    // The texture has to exist to be attached
+    if(((GPU_IMAGE_DATA*)image->data)->evicted_pixels != NULL)
+        restoreEvictedImage(renderer, image);
+
     // Create framebuffer object
     glGenFramebuffersPROC(1, &handle);
     flushAndBindFramebuffer(renderer, handle);
@@ -3962,6 +5332,9 @@ static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
     result->data = data;
     data->handle = handle;
     data->format = ((GPU_IMAGE_DATA*)image->data)->format;
+    data->depth_buffer = 0;
+    data->depth_buffer_bytes = 0;
+    memory_stats.num_framebuffers++;
 
     result->renderer = renderer;
     result->context_target = renderer->current_context_target;
@@ -3989,6 +5362,7 @@ static GPU_Target* GetTarget(GPU_Renderer* renderer, GPU_Image* image)
     result->use_color = GPU_FALSE;
 
     image->target = result;
+    ((GPU_IMAGE_DATA*)image->data)->lru_image = image;
     return result;
 }
 
@@ -4010,7 +5384,18 @@ static void FreeTargetData(GPU_Renderer* renderer, GPU_TARGET_DATA* data)
     {
         // It might be possible to check against the default framebuffer (save that binding in the context data) and avoid deleting that...  Is that desired?
         glDeleteFramebuffersPROC(1, &data->handle);
+        if(data->handle != 0)
+            memory_stats.num_framebuffers--;
+    }
+
+    #if !defined(SDL_GPU_USE_GLES) || SDL_GPU_GLES_MAJOR_VERSION != 1
+    if(data->depth_buffer != 0)
+    {
+        glDeleteRenderbuffers(1, &data->depth_buffer);
+        memory_stats.renderbuffer_bytes -= data->depth_buffer_bytes;
+        memory_stats.num_renderbuffers--;
     }
+    #endif
     
     SDL_free(data);
 }
@@ -4034,17 +5419,40 @@ static void FreeContext(GPU_Context* context)
 
     SDL_free(cdata->blit_buffer);
     SDL_free(cdata->index_buffer);
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    SDL_free(cdata->attribute_buffer);
+    #endif
+    removeProgramRecords(context, 0);
 
     if(!context->failed)
     {
         #ifdef SDL_GPU_USE_BUFFER_PIPELINE
         glDeleteBuffers(2, cdata->blit_VBO);
         glDeleteBuffers(1, &cdata->blit_IBO);
-        glDeleteBuffers(16, cdata->attribute_VBO);
+        glDeleteBuffers(1, &cdata->attribute_VBO);
         #if !defined(SDL_GPU_NO_VAO)
         glDeleteVertexArrays(1, &cdata->blit_VAO);
         #endif
         #endif
+
+        #ifndef SDL_GPU_DISABLE_SHADERS
+        if(cdata->yuv_shader_program != 0)
+            glDeleteProgram(cdata->yuv_shader_program);
+        #endif
+
+        #ifdef SDL_GPU_USE_PBO
+        for(i = 0; i < GPU_UPLOAD_PBO_RING_SIZE; ++i)
+        {
+            if(cdata->upload_PBO_fence[i] != NULL)
+                glDeleteSync((GLsync)cdata->upload_PBO_fence[i]);
+        }
+        glDeleteBuffers(GPU_UPLOAD_PBO_RING_SIZE, cdata->upload_PBO);
+
+        // Reads into this context's pack buffers have to finish first
+        if(hasPendingTargetReads(NULL, context))
+            completeTargetReads(GPU_TRUE);
+        glDeleteBuffers(GPU_DOWNLOAD_PBO_RING_SIZE, cdata->download_PBO);
+        #endif
     }
 
     #ifdef SDL_GPU_USE_SDL2
@@ -4088,6 +5496,10 @@ static void FreeTarget(GPU_Renderer* renderer, GPU_Target* target)
     else if(target->context_target != NULL)
         GPU_MakeCurrent(target->context_target, target->context_target->context->windowID);
 
+    // Callbacks of GPU_ReadTargetAsync() must not see a freed target
+    if(hasPendingTargetReads(target, NULL))
+        completeTargetReads(GPU_TRUE);
+
     
     // Release renderer data reference
     FreeTargetData(renderer, (GPU_TARGET_DATA*)target->data);
@@ -4216,6 +5628,7 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
 	int color_index;
 	float r, g, b, a;
 
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(image == NULL)
     {
         GPU_PushErrorCode("GPU_Blit", GPU_ERROR_NULL_ARGUMENT, "image");
@@ -4231,13 +5644,16 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
         GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "Mismatched renderer");
         return;
     }
+    #endif
 
     makeContextCurrent(renderer, target);
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(renderer->current_context_target == NULL)
     {
         GPU_PushErrorCode("GPU_Blit", GPU_ERROR_USER_ERROR, "NULL context");
         return;
     }
+    #endif
 
     prepareToRenderToTarget(renderer, target);
     prepareToRenderImage(renderer, target, image);
@@ -4374,6 +5790,7 @@ static void Blit(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, G
 static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees)
 {
 	float w, h;
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(image == NULL)
     {
         GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "image");
@@ -4384,6 +5801,7 @@ static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_r
         GPU_PushErrorCode("GPU_BlitRotate", GPU_ERROR_NULL_ARGUMENT, "target");
         return;
     }
+    #endif
 
     w = (src_rect == NULL? image->w : src_rect->w);
     h = (src_rect == NULL? image->h : src_rect->h);
@@ -4393,6 +5811,7 @@ static void BlitRotate(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_r
 static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float scaleX, float scaleY)
 {
 	float w, h;
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(image == NULL)
     {
         GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "image");
@@ -4403,6 +5822,7 @@ static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_re
         GPU_PushErrorCode("GPU_BlitScale", GPU_ERROR_NULL_ARGUMENT, "target");
         return;
     }
+    #endif
 
     w = (src_rect == NULL? image->w : src_rect->w);
     h = (src_rect == NULL? image->h : src_rect->h);
@@ -4412,6 +5832,7 @@ static void BlitScale(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_re
 static void BlitTransform(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* src_rect, GPU_Target* target, float x, float y, float degrees, float scaleX, float scaleY)
 {
 	float w, h;
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(image == NULL)
     {
         GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "image");
@@ -4422,6 +5843,7 @@ static void BlitTransform(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* sr
         GPU_PushErrorCode("GPU_BlitTransform", GPU_ERROR_NULL_ARGUMENT, "target");
         return;
     }
+    #endif
 
     w = (src_rect == NULL? image->w : src_rect->w);
     h = (src_rect == NULL? image->h : src_rect->h);
@@ -4443,6 +5865,7 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
 	int color_index;
 	float r, g, b, a;
 
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(image == NULL)
     {
         GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_NULL_ARGUMENT, "image");
@@ -4458,6 +5881,7 @@ static void BlitTransformX(GPU_Renderer* renderer, GPU_Image* image, GPU_Rect* s
         GPU_PushErrorCode("GPU_BlitTransformX", GPU_ERROR_USER_ERROR, "Mismatched renderer");
         return;
     }
+    #endif
 
 
     makeContextCurrent(renderer, target);
@@ -4665,145 +6089,584 @@ static_inline int sizeof_GPU_type(GPU_TypeEnum type)
     return 0;
 }
 
-static void refresh_attribute_data(GPU_CONTEXT_DATA* cdata)
+static_inline void copy_attribute_value(char* dest, const char* src, int size_bytes)
 {
+    // Constant sizes let the compiler inline the common cases
+    switch(size_bytes)
+    {
+        case 4:
+            memcpy(dest, src, 4);
+            break;
+        case 8:
+            memcpy(dest, src, 8);
+            break;
+        case 12:
+            memcpy(dest, src, 12);
+            break;
+        case 16:
+            memcpy(dest, src, 16);
+            break;
+        default:
+            memcpy(dest, src, size_bytes);
+            break;
+    }
+}
+
+// Copies the next values of an attribute into the interleaved staging buffer and returns where the following flush should continue.
+static const char* stream_attribute_values(GPU_AttributeSource* a, char* dest, int dest_stride_bytes, int value_size_bytes, int num_vertices)
+{
+    const char* src = (const char*)a->next_value;
+    int src_stride_bytes = a->per_vertex_storage_stride_bytes;
     int i;
-    for(i = 0; i < 16; i++)
+
+    if(a->attribute.format.is_per_sprite)
     {
-        GPU_AttributeSource* a = &cdata->shader_attributes[i];
-        if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0 && a->attribute.format.is_per_sprite)
+        // Each value covers the 4 vertices of a sprite.  A previous flush may have stopped partway through one.
+        int corner = (4 - a->num_values%4)%4;
+        for(i = 0; i < num_vertices; i++)
         {
-            // Expand the values to 4 vertices
-            int n;
-            void* storage_ptr = a->per_vertex_storage;
-            void* values_ptr = (void*)((char*)a->attribute.values + a->attribute.format.offset_bytes);
-            int value_size_bytes = a->attribute.format.num_elems_per_value * sizeof_GPU_type(a->attribute.format.type);
-            for(n = 0; n < a->num_values; n+=4)
+            copy_attribute_value(dest, src, value_size_bytes);
+            dest += dest_stride_bytes;
+            if(++corner == 4)
             {
-                memcpy(storage_ptr, values_ptr, value_size_bytes);
-                storage_ptr = (void*)((char*)storage_ptr + a->per_vertex_storage_stride_bytes);
-                memcpy(storage_ptr, values_ptr, value_size_bytes);
-                storage_ptr = (void*)((char*)storage_ptr + a->per_vertex_storage_stride_bytes);
-                memcpy(storage_ptr, values_ptr, value_size_bytes);
-                storage_ptr = (void*)((char*)storage_ptr + a->per_vertex_storage_stride_bytes);
-                memcpy(storage_ptr, values_ptr, value_size_bytes);
-                storage_ptr = (void*)((char*)storage_ptr + a->per_vertex_storage_stride_bytes);
-
-                values_ptr = (void*)((char*)values_ptr + a->attribute.format.stride_bytes);
+                corner = 0;
+                src += src_stride_bytes;
             }
         }
     }
+    else
+    {
+        for(i = 0; i < num_vertices; i++)
+        {
+            copy_attribute_value(dest, src, value_size_bytes);
+            dest += dest_stride_bytes;
+            src += src_stride_bytes;
+        }
+    }
+
+    return src;
 }
 
-static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, int num_vertices)
+static_inline Uint32 get_location_bit(int location)
 {
+    return (location >= 0 && location < 16? (Uint32)1 << location : 0);
+}
+
+static_inline Uint32 get_attribute_layout(GPU_AttributeSource* a, int offset_bytes)
+{
+    // Always nonzero, so 0 can mean a disabled array
+    return 0x80000000 | ((Uint32)offset_bytes << 16) | ((Uint32)(a->attribute.format.type & 0xFF) << 8) | (a->attribute.format.normalize? 0x10 : 0) | (Uint32)(a->attribute.format.num_elems_per_value & 0xF);
+}
+
+// Interleaves the custom attributes into one streaming buffer.  The array formats stay specified in the VAO (or in the global state without one) between flushes and are only changed when the layout does.
+// 'builtin_locations' has a bit set for each location that the built-in attributes enabled for this draw.
+static void upload_attribute_data(GPU_CONTEXT_DATA* cdata, Uint32 builtin_locations, int num_vertices)
+{
+    int offsets[16];
+    int value_sizes[16];
+    int stride_bytes = 0;
     int i;
+
     for(i = 0; i < 16; i++)
     {
         GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        offsets[i] = -1;
         if(a->attribute.values != NULL && a->attribute.location >= 0 && a->num_values > 0)
         {
+            value_sizes[i] = a->attribute.format.num_elems_per_value * sizeof_GPU_type(a->attribute.format.type);
+            offsets[i] = stride_bytes;
+            stride_bytes += (value_sizes[i] + 3) & ~3;  // Keep every attribute 4-byte aligned
+        }
+    }
+
+    if(stride_bytes > 0)
+    {
+        int needed_size = stride_bytes * num_vertices;
+        if(cdata->attribute_buffer_size < needed_size)
+        {
+            SDL_free(cdata->attribute_buffer);
+            cdata->attribute_buffer = (char*)SDL_malloc(needed_size);
+            cdata->attribute_buffer_size = needed_size;
+        }
+
+        for(i = 0; i < 16; i++)
+        {
+            GPU_AttributeSource* a = &cdata->shader_attributes[i];
             int num_values_used = num_vertices;
-			int bytes_used;
+            const char* next_value;
+
+            if(offsets[i] < 0)
+                continue;
 
             if(a->num_values < num_values_used)
                 num_values_used = a->num_values;
 
-            glBindBuffer(GL_ARRAY_BUFFER, cdata->attribute_VBO[i]);
-
-            bytes_used = a->per_vertex_storage_stride_bytes * num_values_used;
-            glBufferData(GL_ARRAY_BUFFER, bytes_used, a->next_value, GL_STREAM_DRAW);
+            next_value = stream_attribute_values(a, cdata->attribute_buffer + offsets[i], stride_bytes, value_sizes[i], num_values_used);
 
-            glEnableVertexAttribArray(a->attribute.location);
-            glVertexAttribPointer(a->attribute.location, a->attribute.format.num_elems_per_value, a->attribute.format.type, a->attribute.format.normalize, a->per_vertex_storage_stride_bytes, (void*)(intptr_t)a->per_vertex_storage_offset_bytes);
-
-            a->enabled = GPU_TRUE;
             // Move the data along so we use the next values for the next flush
             a->num_values -= num_values_used;
             if(a->num_values <= 0)
-                a->next_value = a->per_vertex_storage;
+                a->next_value = (char*)a->attribute.values + a->attribute.format.offset_bytes;
             else
-                a->next_value = (void*)(((char*)a->next_value) + bytes_used);
+                a->next_value = (void*)next_value;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, cdata->attribute_VBO);
+        glBufferData(GL_ARRAY_BUFFER, needed_size, cdata->attribute_buffer, GL_STREAM_DRAW);
+    }
+
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        GPU_bool is_shared = ((builtin_locations & get_location_bit(i)) != 0);
+        Uint32 layout = (offsets[i] < 0? 0 : get_attribute_layout(a, offsets[i]));
+
+        if(layout == 0)
+        {
+            // A built-in attribute that took over this location disables it after the draw
+            if(cdata->attribute_layout[i] != 0 && !is_shared)
+                glDisableVertexAttribArray(i);
+            cdata->attribute_layout[i] = 0;
+            continue;
+        }
+
+        if(is_shared || layout != cdata->attribute_layout[i] || stride_bytes != cdata->attribute_stride_bytes)
+        {
+            if(is_shared || cdata->attribute_layout[i] == 0)
+                glEnableVertexAttribArray(i);
+            glVertexAttribPointer(i, a->attribute.format.num_elems_per_value, a->attribute.format.type, a->attribute.format.normalize, stride_bytes, (void*)(intptr_t)offsets[i]);
+        }
+
+        if(is_shared)
+        {
+            // A location shared with a built-in attribute is taken over again every flush, so it is disabled after the draw instead of being cached
+            a->enabled = GPU_TRUE;
+            cdata->attribute_layout[i] = 0;
+        }
+        else
+            cdata->attribute_layout[i] = layout;
+    }
+
+    cdata->attribute_stride_bytes = stride_bytes;
+}
+
+static void disable_attribute_data(GPU_CONTEXT_DATA* cdata)
+{
+    int i;
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        if(a->enabled)
+        {
+            glDisableVertexAttribArray(a->attribute.location);
+            a->enabled = GPU_FALSE;
+        }
+    }
+}
+
+#endif
+
+static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
+{
+    int lowest = cap;
+
+#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    int i;
+    for(i = 0; i < 16; i++)
+    {
+        GPU_AttributeSource* a = &cdata->shader_attributes[i];
+        if(a->attribute.values != NULL && a->attribute.location >= 0)
+        {
+            if(a->num_values < lowest)
+                lowest = a->num_values;
+        }
+    }
+#else
+	(void)cdata;
+#endif
+
+    return lowest;
+}
+
+static_inline void submit_buffer_data(int bytes, float* values, int bytes_indices, unsigned short* indices)
+{
+    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
+        #if defined(SDL_GPU_USE_BUFFER_RESET)
+        glBufferData(GL_ARRAY_BUFFER, bytes, values, GL_STREAM_DRAW);
+        if(indices != NULL)
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
+        #elif defined(SDL_GPU_USE_BUFFER_MAPPING)
+        // NOTE: On the Raspberry Pi, you may have to use GL_DYNAMIC_DRAW instead of GL_STREAM_DRAW for buffers to work with glMapBuffer().
+        float* data = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+        unsigned short* data_i = (indices == NULL? NULL : (unsigned short*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
+        if(data != NULL)
+        {
+            memcpy(data, values, bytes);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+        if(data_i != NULL)
+        {
+            memcpy(data_i, indices, bytes_indices);
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        }
+        #elif defined(SDL_GPU_USE_BUFFER_UPDATE)
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, values);
+        if(indices != NULL)
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
+        #else
+            #error "SDL_gpu's VBO upload needs to choose SDL_GPU_USE_BUFFER_RESET, SDL_GPU_USE_BUFFER_MAPPING, or SDL_GPU_USE_BUFFER_UPDATE and none is defined!"
+        #endif
+	#else
+	(void)indices;
+    #endif
+}
+
+
+// Uniform value and location cache
+// Each program keeps a copy of the last values given to its uniforms through SDL_gpu, so that setting a uniform to the
+// value it already has skips both glUniform*() and the blit buffer flush before it.  GL keeps uniform values with the
+// program, so the copies stay valid across activations until the program is relinked or freed.
+// Uniform and attribute locations are remembered by name the same way, so GetUniformLocation() and
+// GetAttributeLocation() ask the driver once per name and program.
+
+#define GPU_UNIFORM_KIND_INT 0
+#define GPU_UNIFORM_KIND_UINT 1
+#define GPU_UNIFORM_KIND_FLOAT 2
+#define GPU_UNIFORM_KIND_MATRIX 3
+
+/*! The last value set for one uniform location */
+typedef struct GPU_UniformValue
+{
+    int location;  // -1 marks an empty slot
+    Uint32 signature;  // Kind, shape and count of the value, see uniformSignature()
+    Uint32 size;
+    void* data;
+} GPU_UniformValue;
+
+/*! A uniform or attribute location looked up by name */
+typedef struct GPU_LocationEntry
+{
+    char* name;  // NULL marks an empty slot
+    Uint32 hash;
+    GPU_bool is_attribute;
+    int location;  // -1 is kept too, so missing names are not looked up again
+} GPU_LocationEntry;
+
+/*! Cached state of one shader program in one context */
+typedef struct GPU_ProgramRecord
+{
+    GPU_Context* context;
+    Uint32 program_object;
+    GPU_UniformValue* uniforms;  // Open-addressed by location
+    int num_uniforms;
+    int uniforms_capacity;  // Power of two
+    GPU_LocationEntry* locations;  // Open-addressed by name hash
+    int num_locations;
+    int locations_capacity;  // Power of two
+    GPU_bool link_pending;  // Linked by LinkShaderProgramAsync() and not checked yet
+    GPU_bool link_failed;
+    Uint64 link_hash;  // Key for saving the program binary when the pending link is checked, or 0
+} GPU_ProgramRecord;
+
+static GPU_ProgramRecord* program_records = NULL;
+static int num_program_records = 0;
+static int program_records_capacity = 0;
+static int last_program_record = -1;  // Index of the last record found, as most lookups are for the active program
+
+static void freeProgramRecord(GPU_ProgramRecord* record)
+{
+    int i;
+    for(i = 0; i < record->uniforms_capacity; ++i)
+        SDL_free(record->uniforms[i].data);
+    SDL_free(record->uniforms);
+    for(i = 0; i < record->locations_capacity; ++i)
+        SDL_free(record->locations[i].name);
+    SDL_free(record->locations);
+}
+
+// Drops the cached state of a program, or of every program of the context if program_object is 0, or of everything if context is NULL too
+static void removeProgramRecords(GPU_Context* context, Uint32 program_object)
+{
+    int i = 0;
+    while(i < num_program_records)
+    {
+        GPU_ProgramRecord* record = &program_records[i];
+        if((context == NULL || record->context == context) && (program_object == 0 || record->program_object == program_object))
+        {
+            freeProgramRecord(record);
+            *record = program_records[--num_program_records];
+        }
+        else
+            ++i;
+    }
+    last_program_record = -1;
+
+    if(num_program_records == 0)
+    {
+        SDL_free(program_records);
+        program_records = NULL;
+        program_records_capacity = 0;
+    }
+}
+
+#ifndef SDL_GPU_DISABLE_SHADERS
+// Returns NULL if there is no record and one can't be created
+static GPU_ProgramRecord* getProgramRecord(GPU_Renderer* renderer, Uint32 program_object, GPU_bool create)
+{
+    GPU_Context* context = renderer->current_context_target->context;
+    GPU_ProgramRecord* record;
+    int i;
+
+    if(last_program_record >= 0 && program_records[last_program_record].program_object == program_object
+       && program_records[last_program_record].context == context)
+        return &program_records[last_program_record];
+
+    for(i = 0; i < num_program_records; ++i)
+    {
+        if(program_records[i].program_object == program_object && program_records[i].context == context)
+        {
+            last_program_record = i;
+            return &program_records[i];
+        }
+    }
+
+    if(!create)
+        return NULL;
+
+    if(num_program_records == program_records_capacity)
+    {
+        int new_capacity = (program_records_capacity == 0? 8 : program_records_capacity*2);
+        GPU_ProgramRecord* new_records = (GPU_ProgramRecord*)SDL_realloc(program_records, new_capacity*sizeof(GPU_ProgramRecord));
+        if(new_records == NULL)
+            return NULL;
+        program_records = new_records;
+        program_records_capacity = new_capacity;
+    }
+
+    record = &program_records[num_program_records];
+    memset(record, 0, sizeof(GPU_ProgramRecord));
+    record->context = context;
+    record->program_object = program_object;
+    last_program_record = num_program_records++;
+    return record;
+}
+
+static_inline Uint32 uniformSignature(int kind, int rows, int columns, GPU_bool transpose, int count)
+{
+    return (Uint32)kind | ((Uint32)rows << 2) | ((Uint32)columns << 5) | ((Uint32)(transpose != 0) << 8) | ((Uint32)count << 9);
+}
+
+static_inline Uint32 hashUniformLocation(int location)
+{
+    Uint32 h = (Uint32)location * 0x9E3779B1u;
+    return h ^ (h >> 16);
+}
+
+static GPU_UniformValue* findUniformValue(GPU_ProgramRecord* record, int location)
+{
+    Uint32 mask = (Uint32)record->uniforms_capacity - 1;
+    Uint32 i = hashUniformLocation(location) & mask;
+
+    while(record->uniforms[i].location != -1 && record->uniforms[i].location != location)
+        i = (i + 1) & mask;
+    return &record->uniforms[i];
+}
+
+// Returns GPU_FALSE, keeping the old table, if the new one can't be allocated
+static GPU_bool growUniformValues(GPU_ProgramRecord* record)
+{
+    GPU_UniformValue* old_uniforms = record->uniforms;
+    int old_capacity = record->uniforms_capacity;
+    int new_capacity = (old_capacity == 0? 16 : old_capacity*2);
+    GPU_UniformValue* new_uniforms = (GPU_UniformValue*)SDL_malloc(new_capacity*sizeof(GPU_UniformValue));
+    int i;
+
+    if(new_uniforms == NULL)
+        return GPU_FALSE;
+
+    record->uniforms = new_uniforms;
+    record->uniforms_capacity = new_capacity;
+    for(i = 0; i < record->uniforms_capacity; ++i)
+    {
+        record->uniforms[i].location = -1;
+        record->uniforms[i].data = NULL;
+    }
+
+    for(i = 0; i < old_capacity; ++i)
+    {
+        if(old_uniforms[i].location != -1)
+            *findUniformValue(record, old_uniforms[i].location) = old_uniforms[i];
+    }
+    SDL_free(old_uniforms);
+    return GPU_TRUE;
+}
+
+// Records a value for a uniform of the active program.  Returns GPU_FALSE if the uniform already has it, so there is nothing to upload.
+// Values that can't be recorded for lack of memory are always uploaded.
+static GPU_bool updateUniformValue(GPU_Renderer* renderer, int location, Uint32 signature, const void* data, Uint32 size)
+{
+    Uint32 program_object = renderer->current_context_target->context->current_shader_program;
+    GPU_ProgramRecord* record;
+    GPU_UniformValue* value;
+    int count;
+
+    // GL ignores location -1, so there is never anything to upload
+    if(location < 0 || program_object == 0)
+        return GPU_FALSE;
+
+    record = getProgramRecord(renderer, program_object, GPU_TRUE);
+    if(record == NULL || (record->uniforms_capacity == 0 && !growUniformValues(record)))
+        return GPU_TRUE;
+
+    // Each array element has its own location, which other calls can set, so arrays are always uploaded.  Values recorded for the elements they cover are stale afterwards.
+    count = (int)(signature >> 9);
+    if(count > 1)
+    {
+        int i;
+        for(i = 0; i < count; ++i)
+        {
+            value = findUniformValue(record, location + i);
+            if(value->location == location + i)
+                value->signature = 0;  // Matches no real signature
+        }
+        return GPU_TRUE;
+    }
+
+    value = findUniformValue(record, location);
+    if(value->location == location)
+    {
+        if(value->signature == signature && value->size == size && memcmp(value->data, data, size) == 0)
+            return GPU_FALSE;
+    }
+    else
+    {
+        // Keep the table at most half full
+        if(2*(record->num_uniforms + 1) > record->uniforms_capacity)
+        {
+            if(!growUniformValues(record))
+                return GPU_TRUE;
+            value = findUniformValue(record, location);
         }
+        value->location = location;
+        value->size = 0;
+        record->num_uniforms++;
     }
-}
 
-static void disable_attribute_data(GPU_CONTEXT_DATA* cdata)
-{
-    int i;
-    for(i = 0; i < 16; i++)
+    if(value->size != size)
     {
-        GPU_AttributeSource* a = &cdata->shader_attributes[i];
-        if(a->enabled)
+        SDL_free(value->data);
+        value->data = SDL_malloc(size);
+        if(value->data == NULL)
         {
-            glDisableVertexAttribArray(a->attribute.location);
-            a->enabled = GPU_FALSE;
+            value->size = 0;
+            value->signature = 0;  // Matches no real signature
+            return GPU_TRUE;
         }
+        value->size = size;
     }
+    value->signature = signature;
+    memcpy(value->data, data, size);
+    return GPU_TRUE;
 }
 
-#endif
+static Uint32 hashLocationName(const char* name, GPU_bool is_attribute)
+{
+    // FNV-1a, seeded differently for attributes so that they do not collide with uniforms of the same name
+    Uint32 hash = (is_attribute? 0x050C5D1Fu : 0x811C9DC5u);
+    while(*name != '\0')
+    {
+        hash ^= (unsigned char)*name++;
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
 
-static int get_lowest_attribute_num_values(GPU_CONTEXT_DATA* cdata, int cap)
+static GPU_LocationEntry* findLocationEntry(GPU_ProgramRecord* record, const char* name, Uint32 hash, GPU_bool is_attribute)
 {
-    int lowest = cap;
+    Uint32 mask = (Uint32)record->locations_capacity - 1;
+    Uint32 i = hash & mask;
 
-#ifdef SDL_GPU_USE_BUFFER_PIPELINE
+    while(record->locations[i].name != NULL)
+    {
+        GPU_LocationEntry* entry = &record->locations[i];
+        if(entry->hash == hash && entry->is_attribute == is_attribute && strcmp(entry->name, name) == 0)
+            break;
+        i = (i + 1) & mask;
+    }
+    return &record->locations[i];
+}
+
+// Returns GPU_FALSE, keeping the old table, if the new one can't be allocated
+static GPU_bool growLocationEntries(GPU_ProgramRecord* record)
+{
+    GPU_LocationEntry* old_locations = record->locations;
+    int old_capacity = record->locations_capacity;
+    int new_capacity = (old_capacity == 0? 32 : old_capacity*2);
+    GPU_LocationEntry* new_locations = (GPU_LocationEntry*)SDL_malloc(new_capacity*sizeof(GPU_LocationEntry));
     int i;
-    for(i = 0; i < 16; i++)
+
+    if(new_locations == NULL)
+        return GPU_FALSE;
+
+    memset(new_locations, 0, new_capacity*sizeof(GPU_LocationEntry));
+    record->locations = new_locations;
+    record->locations_capacity = new_capacity;
+
+    for(i = 0; i < old_capacity; ++i)
     {
-        GPU_AttributeSource* a = &cdata->shader_attributes[i];
-        if(a->attribute.values != NULL && a->attribute.location >= 0)
-        {
-            if(a->num_values < lowest)
-                lowest = a->num_values;
-        }
+        GPU_LocationEntry* entry = &old_locations[i];
+        if(entry->name != NULL)
+            *findLocationEntry(record, entry->name, entry->hash, entry->is_attribute) = *entry;
     }
-#else
-	(void)cdata;
-#endif
+    SDL_free(old_locations);
+    return GPU_TRUE;
+}
 
-    return lowest;
+static_inline int getLocation(Uint32 program_object, const char* name, GPU_bool is_attribute)
+{
+    return (is_attribute? glGetAttribLocation(program_object, name) : glGetUniformLocation(program_object, name));
 }
 
-static_inline void submit_buffer_data(int bytes, float* values, int bytes_indices, unsigned short* indices)
+// Returns the location of a uniform or attribute, asking GL only the first time the name is used with the program.
+// GL is asked every time if the cache can't grow.
+static int getCachedLocation(GPU_Renderer* renderer, Uint32 program_object, const char* name, GPU_bool is_attribute)
 {
-    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        #if defined(SDL_GPU_USE_BUFFER_RESET)
-        glBufferData(GL_ARRAY_BUFFER, bytes, values, GL_STREAM_DRAW);
-        if(indices != NULL)
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes_indices, indices, GL_DYNAMIC_DRAW);
-        #elif defined(SDL_GPU_USE_BUFFER_MAPPING)
-        // NOTE: On the Raspberry Pi, you may have to use GL_DYNAMIC_DRAW instead of GL_STREAM_DRAW for buffers to work with glMapBuffer().
-        float* data = (float*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-        unsigned short* data_i = (indices == NULL? NULL : (unsigned short*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_WRITE_ONLY));
-        if(data != NULL)
-        {
-            memcpy(data, values, bytes);
-            glUnmapBuffer(GL_ARRAY_BUFFER);
-        }
-        if(data_i != NULL)
-        {
-            memcpy(data_i, indices, bytes_indices);
-            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-        }
-        #elif defined(SDL_GPU_USE_BUFFER_UPDATE)
-        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, values);
-        if(indices != NULL)
-            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes_indices, indices);
-        #else
-            #error "SDL_gpu's VBO upload needs to choose SDL_GPU_USE_BUFFER_RESET, SDL_GPU_USE_BUFFER_MAPPING, or SDL_GPU_USE_BUFFER_UPDATE and none is defined!"
-        #endif
-	#else
-	(void)indices;
-    #endif
+    GPU_ProgramRecord* record = getProgramRecord(renderer, program_object, GPU_TRUE);
+    Uint32 hash = hashLocationName(name, is_attribute);
+    GPU_LocationEntry* entry;
+
+    if(record == NULL || (record->locations_capacity == 0 && !growLocationEntries(record)))
+        return getLocation(program_object, name, is_attribute);
+
+    entry = findLocationEntry(record, name, hash, is_attribute);
+    if(entry->name != NULL)
+        return entry->location;
+
+    // Keep the table at most half full
+    if(2*(record->num_locations + 1) > record->locations_capacity)
+    {
+        if(!growLocationEntries(record))
+            return getLocation(program_object, name, is_attribute);
+        entry = findLocationEntry(record, name, hash, is_attribute);
+    }
+
+    entry->name = (char*)SDL_malloc(strlen(name) + 1);
+    if(entry->name == NULL)
+        return getLocation(program_object, name, is_attribute);
+    strcpy(entry->name, name);
+    entry->hash = hash;
+    entry->is_attribute = is_attribute;
+    entry->location = getLocation(program_object, name, is_attribute);
+    record->num_locations++;
+    return entry->location;
 }
+#endif
 
 
 static void SetAttributefv(GPU_Renderer* renderer, int location, int num_elements, float* value);
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-static void gpu_upload_modelviewprojection(GPU_Target* dest, GPU_Context* context)
+static void gpu_upload_modelviewprojection(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context* context)
 {
     if(context->current_shader_block.modelViewProjection_loc >= 0)
     {
@@ -4826,7 +6689,8 @@ static void gpu_upload_modelviewprojection(GPU_Target* dest, GPU_Context* contex
         // MVP = P * MV
         GPU_MatrixMultiply(mvp, p, mv);
         
-        glUniformMatrix4fv(context->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
+        if(updateUniformValue(renderer, context->current_shader_block.modelViewProjection_loc, uniformSignature(GPU_UNIFORM_KIND_MATRIX, 4, 4, GPU_FALSE, 1), mvp, sizeof(mvp)))
+            glUniformMatrix4fv(context->current_shader_block.modelViewProjection_loc, 1, 0, mvp);
     }
 }
 #endif
@@ -4852,6 +6716,7 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
     if(num_vertices == 0)
         return;
 
+    #ifndef SDL_GPU_DISABLE_ARGUMENT_CHECKS
     if(target == NULL)
     {
         GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_NULL_ARGUMENT, "target");
@@ -4862,6 +6727,7 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
         GPU_PushErrorCode("GPU_PrimitiveBatchX", GPU_ERROR_USER_ERROR, "Mismatched renderer");
         return;
     }
+    #endif
 
     makeContextCurrent(renderer, target);
 
@@ -4927,10 +6793,6 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
         }
     }
 
-    #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-    refresh_attribute_data(cdata);
-    #endif
-
     if(indices == NULL)
         num_indices = num_vertices;
 
@@ -5084,6 +6946,8 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
 
 #ifdef SDL_GPU_USE_BUFFER_PIPELINE
     {
+        Uint32 builtin_locations = 0;
+
         // Skip uploads if we have no attribute location
         if(context->current_shader_block.position_loc < 0)
             use_vertices = GPU_FALSE;
@@ -5097,7 +6961,7 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
         glBindVertexArray(cdata->blit_VAO);
         #endif
 
-        gpu_upload_modelviewprojection(target, context);
+        gpu_upload_modelviewprojection(renderer, target, context);
 
         if(values != NULL)
         {
@@ -5114,15 +6978,18 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
             {
                 glEnableVertexAttribArray(context->current_shader_block.position_loc);  // Tell GL to use client-side attribute data
                 glVertexAttribPointer(context->current_shader_block.position_loc, size_vertices, GL_FLOAT, GL_FALSE, stride, 0);  // Tell how the data is formatted
+                builtin_locations |= get_location_bit(context->current_shader_block.position_loc);
             }
             if(use_texcoords)
             {
                 glEnableVertexAttribArray(context->current_shader_block.texcoord_loc);
                 glVertexAttribPointer(context->current_shader_block.texcoord_loc, size_texcoords, GL_FLOAT, GL_FALSE, stride, (void*)(offset_texcoords));
+                builtin_locations |= get_location_bit(context->current_shader_block.texcoord_loc);
             }
             if(use_colors)
             {
                 glEnableVertexAttribArray(context->current_shader_block.color_loc);
+                builtin_locations |= get_location_bit(context->current_shader_block.color_loc);
                 if(use_byte_colors)
                 {
                     glVertexAttribPointer(context->current_shader_block.color_loc, size_colors, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)(offset_colors));
@@ -5140,7 +7007,7 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
             }
         }
 
-        upload_attribute_data(cdata, num_indices);
+        upload_attribute_data(cdata, builtin_locations, num_indices);
 
         if(indices == NULL)
             glDrawArrays(primitive_type, 0, num_indices);
@@ -5172,9 +7039,30 @@ static void PrimitiveBatchV(GPU_Renderer* renderer, GPU_Image* image, GPU_Target
 
 static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
 {
-    #ifndef __IPHONEOS__
+    #ifdef __IPHONEOS__
+    // glGenerateMipmap() is not used here, so the chain is built on the CPU from the texture's contents
+    GPU_MipmapFilterEnum filter;
+    unsigned char* pixels;
+    unsigned char* levels;
+    int num_levels;
+    if(image == NULL || isCompressedFormat(image->format) || image->texture_w != image->base_w || image->texture_h != image->base_h)
+        return;
+
+    pixels = getRawImageData(renderer, image);
+    if(pixels == NULL)
+        return;
+
+    GPU_GetMipmapsOnLoad(&filter);
+    levels = gpu_build_mipmaps(pixels, image->base_w, image->base_h, image->bytes_per_pixel, image->has_premultiplied_alpha, filter, 0, &num_levels);
+    if(levels != NULL)
+        UploadMipmaps(renderer, image, num_levels, levels);
+
+    SDL_free(levels);
+    SDL_free(pixels);
+    #else
     GLint filter;
-    if(image == NULL)
+    // Compressed textures can't be filtered by the driver, so they keep the levels they were loaded with
+    if(image == NULL || isCompressedFormat(image->format))
         return;
 
     if(image->target != NULL && isCurrentTarget(renderer, image->target))
@@ -5182,6 +7070,7 @@ static void GenerateMipmaps(GPU_Renderer* renderer, GPU_Image* image)
     bindTexture(renderer, image);
     glGenerateMipmapPROC(GL_TEXTURE_2D);
     image->has_mipmaps = GPU_TRUE;
+    setTextureBytes((GPU_IMAGE_DATA*)image->data, getTextureBytes(image));
 
     glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filter);
     if(filter == GL_LINEAR)
@@ -5233,6 +7122,9 @@ static void swizzle_for_format(SDL_Color* color, GLenum format, unsigned char pi
 {
     switch(format)
     {
+    #ifdef GPU_GL_PLANE_INTERNAL_FORMAT
+    case GPU_GL_PLANE_FORMAT:
+    #endif
     case GL_LUMINANCE:
         color->b = color->g = color->r = pixel[0];
         GET_ALPHA(*color) = 255;
@@ -5438,7 +7330,9 @@ static void SetWrapMode(GPU_Renderer* renderer, GPU_Image* image, GPU_WrapEnum w
 
 static GPU_TextureHandle GetTextureHandle(GPU_Renderer* renderer, GPU_Image* image)
 {
-	(void)renderer;
+    // The caller may keep the handle, so the texture has to be resident
+    if(((GPU_IMAGE_DATA*)image->data)->evicted_pixels != NULL)
+        restoreEvictedImage(renderer, image);
     return ((GPU_IMAGE_DATA*)image->data)->handle;
 }
 
@@ -5523,7 +7417,7 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
             glBindVertexArray(cdata->blit_VAO);
             #endif
 
-            gpu_upload_modelviewprojection(dest, context);
+            gpu_upload_modelviewprojection(renderer, dest, context);
 
             // Upload blit buffer to a single buffer object
             glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
@@ -5550,7 +7444,7 @@ static void DoPartialFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Context
                 glVertexAttribPointer(context->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
             }
 
-            upload_attribute_data(cdata, num_vertices);
+            upload_attribute_data(cdata, get_location_bit(context->current_shader_block.position_loc) | get_location_bit(context->current_shader_block.texcoord_loc) | get_location_bit(context->current_shader_block.color_loc), num_vertices);
 
             glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
 
@@ -5620,7 +7514,7 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
         glBindVertexArray(cdata->blit_VAO);
         #endif
 
-        gpu_upload_modelviewprojection(dest, context);
+        gpu_upload_modelviewprojection(renderer, dest, context);
 
         // Upload blit buffer to a single buffer object
         glBindBuffer(GL_ARRAY_BUFFER, cdata->blit_VBO[cdata->blit_VBO_flop]);
@@ -5642,7 +7536,7 @@ static void DoUntexturedFlush(GPU_Renderer* renderer, GPU_Target* dest, GPU_Cont
             glVertexAttribPointer(context->current_shader_block.color_loc, 4, GL_FLOAT, GL_FALSE, GPU_BLIT_BUFFER_STRIDE, (void*)(GPU_BLIT_BUFFER_COLOR_OFFSET * sizeof(float)));
         }
 
-        upload_attribute_data(cdata, num_vertices);
+        upload_attribute_data(cdata, get_location_bit(context->current_shader_block.position_loc) | get_location_bit(context->current_shader_block.color_loc), num_vertices);
 
         glDrawElements(cdata->last_shape, num_indices, GL_UNSIGNED_SHORT, (void*)0);
 
@@ -5692,10 +7586,6 @@ static void FlushBlitBuffer(GPU_Renderer* renderer)
 
         setClipRect(renderer, dest);
 
-        #ifdef SDL_GPU_USE_BUFFER_PIPELINE
-        refresh_attribute_data(cdata);
-        #endif
-
         blit_buffer = cdata->blit_buffer;
         index_buffer = cdata->index_buffer;
 
@@ -5745,6 +7635,16 @@ static void Flip(GPU_Renderer* renderer, GPU_Target* target)
     if(vendor_is_Intel)
         apply_Intel_attrib_workaround = GPU_TRUE;
     #endif
+
+    // Deliver the GPU_ReadTargetAsync() results that have arrived
+    completeTargetReads(GPU_FALSE);
+
+    // Evict before the frame ends so the images drawn in it are kept
+    if(memory_stats.budget_bytes > 0)
+        enforceTextureBudget(renderer);
+
+    // Images drawn from here on count as used in the next frame
+    lru_frame++;
 }
 
 
@@ -5755,241 +7655,373 @@ static void Flip(GPU_Renderer* renderer, GPU_Target* target)
 
 #include <string.h>
 
-// On some platforms (e.g. Android), it might not be possible to just create a rwops and get the expected #included files.
-// To do it, I might want to add an optional argument that specifies a base directory to prepend to #include file names.
+// Shader preprocessor (SDL_gpu_shaders.c)
+char* gpu_preprocess_shader(const char* source, Uint32 size, const char** defines, int num_defines);
+char* gpu_preprocess_shader_rw(SDL_RWops* rwops, const char** defines, int num_defines);
+
+
+// Program binary cache (GPU_SetShaderCacheDirectory())
+// Linked programs are saved with glGetProgramBinary() under a hash of the driver and the attached shader sources.
+// Sources that have compiled before with this driver are only handed to GL by compile_shader_source(), and get compiled
+// later by LinkShaderProgram() if no cached binary covers their program.
+
+#define GPU_PROGRAM_CACHE_MAGIC 0x42504753  // "SGPB"
+#define GPU_PROGRAM_CACHE_MAX_SHADERS 16
+#define GPU_PROGRAM_CACHE_PATH_MAX 1024
+
+/*! A shader object from compile_shader_source() */
+typedef struct GPU_ShaderRecord
+{
+    Uint32 shader_object;
+    Uint64 hash;  // Of the shader type and source
+    GPU_bool compiled;  // GPU_FALSE while compilation is deferred
+} GPU_ShaderRecord;
+
+static GPU_ShaderRecord* shader_records = NULL;
+static int num_shader_records = 0;
+static int shader_records_capacity = 0;
+
+// Shader sources that compiled with this driver, loaded from the cache directory's index
+static Uint64* known_shader_hashes = NULL;
+static int num_known_shader_hashes = 0;
+static int known_shader_hashes_capacity = 0;
+static GPU_bool known_shader_hashes_loaded = GPU_FALSE;
+
+static int program_binary_support = -1;
+static Uint64 driver_hash = 0;
+static int parallel_compile_support = -1;
+
+static void freeProgramCache(void)
+{
+    SDL_free(shader_records);
+    shader_records = NULL;
+    num_shader_records = 0;
+    shader_records_capacity = 0;
+
+    SDL_free(known_shader_hashes);
+    known_shader_hashes = NULL;
+    num_known_shader_hashes = 0;
+    known_shader_hashes_capacity = 0;
+    known_shader_hashes_loaded = GPU_FALSE;
 
-static Uint32 GetShaderSourceSize(const char* filename);
-static Uint32 GetShaderSource(const char* filename, char* result);
+    program_binary_support = -1;
+    parallel_compile_support = -1;
+}
 
-static void read_until_end_of_comment(SDL_RWops* rwops, char multiline)
+#ifndef SDL_GPU_DISABLE_SHADERS
+static Uint64 hashBytes(Uint64 hash, const void* data, size_t size)
 {
-    char buffer;
-    while(SDL_RWread(rwops, &buffer, 1, 1) > 0)
+    // FNV-1a
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t i;
+    for(i = 0; i < size; ++i)
     {
-        if(!multiline)
-        {
-            if(buffer == '\n')
-                break;
-        }
-        else
-        {
-            if(buffer == '*')
-            {
-                // If the stream ends at the next character or it is a '/', then we're done.
-                if(SDL_RWread(rwops, &buffer, 1, 1) <= 0 || buffer == '/')
-                    break;
-            }
-        }
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
     }
+    return hash;
 }
 
-static Uint32 GetShaderSourceSize_RW(SDL_RWops* shader_source)
+static Uint64 hashString(Uint64 hash, const char* str)
 {
-	Uint32 size;
-	char last_char;
-	char buffer[512];
-	long len;
-
-    if(shader_source == NULL)
-        return 0;
+    if(str == NULL)
+        str = "";
+    // Include the terminator so that adjacent strings can't run together
+    return hashBytes(hash, str, strlen(str) + 1);
+}
 
-    size = 0;
+// Returns the cache directory if the cache can be used right now
+static const char* getProgramCacheDirectory(GPU_Renderer* renderer)
+{
+    const char* directory = GPU_GetShaderCacheDirectory();
+	(void)renderer;
+    if(directory == NULL)
+        return NULL;
 
-    // Read 1 byte at a time until we reach the end
-    last_char = ' ';
-    len = 0;
-    while((len = SDL_RWread(shader_source, &buffer, 1, 1)) > 0)
+    #if !defined(SDL_GPU_DISABLE_SHADERS) && (defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3)
+    if(program_binary_support < 0)
     {
-        // Follow through an #include directive?
-        if(buffer[0] == '#')
+        GLint num_formats = 0;
+        program_binary_support = 0;
+        #ifdef SDL_GPU_USE_OPENGL
+        if(isExtensionSupported("GL_ARB_get_program_binary"))
+        #endif
         {
-            // Get the rest of the line
-            int line_size = 1;
-            unsigned long line_len;
-			char* token;
-            while((line_len = SDL_RWread(shader_source, buffer+line_size, 1, 1)) > 0)
-            {
-                line_size += line_len;
-                if(buffer[line_size - line_len] == '\n')
-                    break;
-            }
-            buffer[line_size] = '\0';
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+            program_binary_support = (num_formats > 0);
+        }
 
-            // Is there "include" after '#'?
-            token = strtok(buffer, "# \t");
+        // Any change of driver gives every program a new key
+        driver_hash = hashString(0xCBF29CE484222325ULL, renderer->id.name);
+        driver_hash = hashBytes(driver_hash, &renderer->id.major_version, sizeof(renderer->id.major_version));
+        driver_hash = hashBytes(driver_hash, &renderer->id.minor_version, sizeof(renderer->id.minor_version));
+        driver_hash = hashString(driver_hash, (const char*)glGetString(GL_VENDOR));
+        driver_hash = hashString(driver_hash, (const char*)glGetString(GL_RENDERER));
+        driver_hash = hashString(driver_hash, (const char*)glGetString(GL_VERSION));
+        driver_hash = hashString(driver_hash, (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+    }
 
-            if(token != NULL && strcmp(token, "include") == 0)
-            {
-                // Get filename token
-                token = strtok(NULL, "\"");  // Skip the empty token before the quote
-                if(token != NULL)
-                {
-                    // Add the size of the included file and a newline character
-                    size += GetShaderSourceSize(token) + 1;
-                }
-            }
-            else
-                size += line_size;
-            last_char = ' ';
-            continue;
-        }
+    return (program_binary_support? directory : NULL);
+    #else
+    return NULL;
+    #endif
+}
 
-        size += len;
+static void getProgramCachePath(char* path, const char* directory, const char* prefix, Uint64 hash, const char* extension)
+{
+    snprintf(path, GPU_PROGRAM_CACHE_PATH_MAX, "%s/%s%08x%08x.%s", directory, prefix, (unsigned int)(hash >> 32), (unsigned int)(hash & 0xFFFFFFFF), extension);
+}
 
-        if(last_char == '/')
-        {
-            if(buffer[0] == '/')
-            {
-                read_until_end_of_comment(shader_source, 0);
-                size++;  // For the end of the comment
-            }
-            else if(buffer[0] == '*')
-            {
-                read_until_end_of_comment(shader_source, 1);
-                size += 2;  // For the end of the comments
-            }
-            last_char = ' ';
-        }
-        else
-            last_char = buffer[0];
+static GPU_bool isKnownShaderHash(Uint64 hash)
+{
+    int i;
+    for(i = 0; i < num_known_shader_hashes; ++i)
+    {
+        if(known_shader_hashes[i] == hash)
+            return GPU_TRUE;
     }
+    return GPU_FALSE;
+}
 
-    // Go back to the beginning of the stream
-    SDL_RWseek(shader_source, 0, SEEK_SET);
-    return size;
+static void addKnownShaderHash(Uint64 hash)
+{
+    if(num_known_shader_hashes >= known_shader_hashes_capacity)
+    {
+        int new_capacity = (known_shader_hashes_capacity > 0? known_shader_hashes_capacity*2 : 64);
+        Uint64* new_hashes = (Uint64*)SDL_realloc(known_shader_hashes, new_capacity*sizeof(Uint64));
+        if(new_hashes == NULL)
+            return;
+        known_shader_hashes = new_hashes;
+        known_shader_hashes_capacity = new_capacity;
+    }
+    known_shader_hashes[num_known_shader_hashes++] = hash;
 }
 
+// The index lists every shader source that has compiled with this driver, one Uint64 hash after another
+static void loadKnownShaderHashes(const char* directory)
+{
+    char path[GPU_PROGRAM_CACHE_PATH_MAX];
+    SDL_RWops* rwops;
+    Uint64 hash;
+
+    if(known_shader_hashes_loaded)
+        return;
+    known_shader_hashes_loaded = GPU_TRUE;
+
+    getProgramCachePath(path, directory, "shaders-", driver_hash, "idx");
+    rwops = SDL_RWFromFile(path, "rb");
+    if(rwops == NULL)
+        return;
+
+    while(SDL_RWread(rwops, &hash, sizeof(hash), 1) == 1)
+        addKnownShaderHash(hash);
+    SDL_RWclose(rwops);
+}
 
-static Uint32 GetShaderSource_RW(SDL_RWops* shader_source, char* result)
+static void saveKnownShaderHash(const char* directory, Uint64 hash)
 {
-	Uint32 size;
-	char last_char;
-	char buffer[512];
-	long len;
+    char path[GPU_PROGRAM_CACHE_PATH_MAX];
+    SDL_RWops* rwops;
 
-    if(shader_source == NULL)
+    if(isKnownShaderHash(hash))
+        return;
+    addKnownShaderHash(hash);
+
+    getProgramCachePath(path, directory, "shaders-", driver_hash, "idx");
+    rwops = SDL_RWFromFile(path, "ab");
+    if(rwops == NULL)
+        return;
+    SDL_RWwrite(rwops, &hash, sizeof(hash), 1);
+    SDL_RWclose(rwops);
+}
+
+static GPU_ShaderRecord* getShaderRecord(Uint32 shader_object)
+{
+    int i;
+    for(i = 0; i < num_shader_records; ++i)
     {
-        result[0] = '\0';
-        return 0;
+        if(shader_records[i].shader_object == shader_object)
+            return &shader_records[i];
+    }
+    return NULL;
+}
+
+static void addShaderRecord(Uint32 shader_object, Uint64 hash, GPU_bool compiled)
+{
+    // A name freed behind our back may have been reused
+    GPU_ShaderRecord* record = getShaderRecord(shader_object);
+    if(record != NULL)
+    {
+        record->hash = hash;
+        record->compiled = compiled;
+        return;
+    }
+
+    if(num_shader_records >= shader_records_capacity)
+    {
+        int new_capacity = (shader_records_capacity > 0? shader_records_capacity*2 : 32);
+        GPU_ShaderRecord* new_records = (GPU_ShaderRecord*)SDL_realloc(shader_records, new_capacity*sizeof(GPU_ShaderRecord));
+        if(new_records == NULL)
+            return;
+        shader_records = new_records;
+        shader_records_capacity = new_capacity;
     }
+    shader_records[num_shader_records].shader_object = shader_object;
+    shader_records[num_shader_records].hash = hash;
+    shader_records[num_shader_records].compiled = compiled;
+    num_shader_records++;
+}
 
-    size = 0;
+static void removeShaderRecord(Uint32 shader_object)
+{
+    GPU_ShaderRecord* record = getShaderRecord(shader_object);
+    if(record != NULL)
+        *record = shader_records[--num_shader_records];
+}
+
+#endif
+
+#if !defined(SDL_GPU_DISABLE_SHADERS) && (defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3)
+// Combines the hashes of the attached shaders.  Returns GPU_FALSE if one of them did not come through compile_shader_source().
+static GPU_bool getProgramHash(Uint32 program_object, Uint64* hash)
+{
+    GLuint shaders[GPU_PROGRAM_CACHE_MAX_SHADERS];
+    Uint64 shader_hashes[GPU_PROGRAM_CACHE_MAX_SHADERS];
+    GLsizei num_shaders = 0;
+    int i, j;
+
+    glGetAttachedShaders(program_object, GPU_PROGRAM_CACHE_MAX_SHADERS, &num_shaders, shaders);
+    if(num_shaders == 0)
+        return GPU_FALSE;
 
-    // Read 1 byte at a time until we reach the end
-    last_char = ' ';
-    len = 0;
-    while((len = SDL_RWread(shader_source, &buffer, 1, 1)) > 0)
+    for(i = 0; i < num_shaders; ++i)
     {
-        // Follow through an #include directive?
-        if(buffer[0] == '#')
-        {
-            // Get the rest of the line
-            int line_size = 1;
-			unsigned long line_len;
-			char token_buffer[512];  // strtok() is destructive
-			char* token;
-            while((line_len = SDL_RWread(shader_source, buffer+line_size, 1, 1)) > 0)
-            {
-                line_size += line_len;
-                if(buffer[line_size - line_len] == '\n')
-                    break;
-            }
+        GPU_ShaderRecord* record = getShaderRecord(shaders[i]);
+        if(record == NULL)
+            return GPU_FALSE;
 
-            // Is there "include" after '#'?
-            memcpy(token_buffer, buffer, line_size+1);
-            token_buffer[line_size] = '\0';
-            token = strtok(token_buffer, "# \t");
+        // GL doesn't promise an order, so sort them
+        for(j = i; j > 0 && shader_hashes[j - 1] > record->hash; --j)
+            shader_hashes[j] = shader_hashes[j - 1];
+        shader_hashes[j] = record->hash;
+    }
 
-            if(token != NULL && strcmp(token, "include") == 0)
-            {
-                // Get filename token
-                token = strtok(NULL, "\"");  // Skip the empty token before the quote
-                if(token != NULL)
-                {
-                    // Add the size of the included file and a newline character
-                    size += GetShaderSource(token, result + size);
-                    result[size] = '\n';
-                    size++;
-                }
-            }
-            else
-            {
-                memcpy(result + size, buffer, line_size);
-                size += line_size;
-            }
-            last_char = ' ';
-            continue;
-        }
+    *hash = hashBytes(driver_hash, shader_hashes, num_shaders*sizeof(Uint64));
+    return GPU_TRUE;
+}
 
-        memcpy(result + size, buffer, len);
-        size += len;
+static GPU_bool loadProgramBinary(const char* directory, Uint32 program_object, Uint64 hash)
+{
+    char path[GPU_PROGRAM_CACHE_PATH_MAX];
+    SDL_RWops* rwops;
+    Uint32 header[3];  // Magic, binary format, size
+    void* binary;
+    GLint linked = 0;
+
+    getProgramCachePath(path, directory, "", hash, "bin");
+    rwops = SDL_RWFromFile(path, "rb");
+    if(rwops == NULL)
+        return GPU_FALSE;
 
-        if(last_char == '/')
+    binary = NULL;
+    if(SDL_RWread(rwops, header, sizeof(header), 1) == 1 && header[0] == GPU_PROGRAM_CACHE_MAGIC && header[2] > 0)
+    {
+        binary = SDL_malloc(header[2]);
+        if(binary != NULL && SDL_RWread(rwops, binary, header[2], 1) != 1)
         {
-            if(buffer[0] == '/')
-            {
-                read_until_end_of_comment(shader_source, 0);
-                memcpy(result + size, "\n", 1);
-                size++;
-            }
-            else if(buffer[0] == '*')
-            {
-                read_until_end_of_comment(shader_source, 1);
-                memcpy(result + size, "*/", 2);
-                size += 2;
-            }
-            last_char = ' ';
+            SDL_free(binary);
+            binary = NULL;
         }
-        else
-            last_char = buffer[0];
     }
-    result[size] = '\0';
+    SDL_RWclose(rwops);
+
+    if(binary == NULL)
+        return GPU_FALSE;
 
-    // Go back to the beginning of the stream
-    SDL_RWseek(shader_source, 0, SEEK_SET);
-    return size;
+    // The driver rejects binaries it can no longer use, and the program is then linked from source
+    glProgramBinary(program_object, header[1], binary, header[2]);
+    SDL_free(binary);
+    glGetProgramiv(program_object, GL_LINK_STATUS, &linked);
+    return (linked != 0);
 }
 
-static Uint32 GetShaderSource(const char* filename, char* result)
+static void saveProgramBinary(const char* directory, Uint32 program_object, Uint64 hash)
 {
-	SDL_RWops* rwops;
-	Uint32 size;
+    char path[GPU_PROGRAM_CACHE_PATH_MAX];
+    SDL_RWops* rwops;
+    Uint32 header[3];
+    GLint size = 0;
+    GLenum format = 0;
+    void* binary;
 
-    if(filename == NULL)
-        return 0;
-    rwops = SDL_RWFromFile(filename, "r");
-
-    size = GetShaderSource_RW(rwops, result);
+    glGetProgramiv(program_object, GL_PROGRAM_BINARY_LENGTH, &size);
+    if(size <= 0)
+        return;
+    binary = SDL_malloc(size);
+    if(binary == NULL)
+        return;
+    glGetProgramBinary(program_object, size, &size, &format, binary);
 
-    SDL_RWclose(rwops);
-    return size;
+    getProgramCachePath(path, directory, "", hash, "bin");
+    rwops = SDL_RWFromFile(path, "wb");
+    if(rwops != NULL)
+    {
+        header[0] = GPU_PROGRAM_CACHE_MAGIC;
+        header[1] = format;
+        header[2] = size;
+        SDL_RWwrite(rwops, header, sizeof(header), 1);
+        SDL_RWwrite(rwops, binary, size, 1);
+        SDL_RWclose(rwops);
+    }
+    SDL_free(binary);
 }
 
-static Uint32 GetShaderSourceSize(const char* filename)
+// Compiles attached shaders whose compilation was deferred.  Without 'wait', their errors are left for the link to report.
+static GPU_bool compileDeferredShaders(Uint32 program_object, GPU_bool wait)
 {
-	SDL_RWops* rwops;
-	Uint32 result;
-
-    if(filename == NULL)
-        return 0;
-    rwops = SDL_RWFromFile(filename, "r");
+    GLuint shaders[GPU_PROGRAM_CACHE_MAX_SHADERS];
+    GLsizei num_shaders = 0;
+    int i;
 
-    result = GetShaderSourceSize_RW(rwops);
+    glGetAttachedShaders(program_object, GPU_PROGRAM_CACHE_MAX_SHADERS, &num_shaders, shaders);
+    for(i = 0; i < num_shaders; ++i)
+    {
+        GPU_ShaderRecord* record = getShaderRecord(shaders[i]);
+        GLint compiled;
+        if(record == NULL || record->compiled)
+            continue;
 
-    SDL_RWclose(rwops);
-    return result;
+        glCompileShader(shaders[i]);
+        record->compiled = GPU_TRUE;
+        if(!wait)
+            continue;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+        if(!compiled)
+        {
+            GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Failed to compile shader source");
+            glGetShaderInfoLog(shaders[i], 256, NULL, shader_message);
+            return GPU_FALSE;
+        }
+    }
+    return GPU_TRUE;
 }
+#endif
 
 
-static Uint32 compile_shader_source(GPU_ShaderEnum shader_type, const char* shader_source)
+// Without 'wait', the compile status is not checked, so the driver may still be compiling when this returns.
+static Uint32 compile_shader_source(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source, GPU_bool wait)
 {
     // Create the proper new shader object
     GLuint shader_object = 0;
+	(void)renderer;
 	(void)shader_type;
 	(void)shader_source;
+	(void)wait;
 
     #ifndef SDL_GPU_DISABLE_SHADERS
     GLint compiled;
+    const char* cache_directory;
+    Uint64 hash;
 
     switch(shader_type)
     {
@@ -6019,10 +8051,32 @@ static Uint32 compile_shader_source(GPU_ShaderEnum shader_type, const char* shad
 
 	glShaderSource(shader_object, 1, &shader_source, NULL);
 
+    hash = hashBytes(0xCBF29CE484222325ULL, &shader_type, sizeof(shader_type));
+    hash = hashString(hash, shader_source);
+
+    // A source that compiled before will likely be covered by a cached program binary
+    cache_directory = getProgramCacheDirectory(renderer);
+    if(cache_directory != NULL)
+    {
+        loadKnownShaderHashes(cache_directory);
+        if(isKnownShaderHash(hash))
+        {
+            addShaderRecord(shader_object, hash, GPU_FALSE);
+            return shader_object;
+        }
+    }
+
     // Compile the shader source
 
 	glCompileShader(shader_object);
 
+    // The status is checked by the link
+    if(!wait)
+    {
+        addShaderRecord(shader_object, hash, GPU_TRUE);
+        return shader_object;
+    }
+
     glGetShaderiv(shader_object, GL_COMPILE_STATUS, &compiled);
     if(!compiled)
     {
@@ -6032,6 +8086,10 @@ static Uint32 compile_shader_source(GPU_ShaderEnum shader_type, const char* shad
         return 0;
     }
 
+    addShaderRecord(shader_object, hash, GPU_TRUE);
+    if(cache_directory != NULL)
+        saveKnownShaderHash(cache_directory, hash);
+
     #endif
 
     return shader_object;
@@ -6041,37 +8099,62 @@ static Uint32 compile_shader_source(GPU_ShaderEnum shader_type, const char* shad
 static Uint32 CompileShader_RW(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, SDL_RWops* shader_source, GPU_bool free_rwops)
 {
     // Read in the shader source code
-    Uint32 size = GetShaderSourceSize_RW(shader_source);
-    char* source_string = (char*)SDL_malloc(size+1);
-    int result = GetShaderSource_RW(shader_source, source_string);
-	Uint32 result2;
-	(void)renderer;
+    char* source_string = gpu_preprocess_shader_rw(shader_source, NULL, 0);
+	Uint32 result;
 
-    if(free_rwops)
+    if(free_rwops && shader_source != NULL)
         SDL_RWclose(shader_source);
     
-    if(!result)
+    if(source_string == NULL)
     {
-        GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Failed to read shader source");
         snprintf(shader_message, 256, "Failed to read shader source.\n");
-        SDL_free(source_string);
         return 0;
     }
 
-    result2 = compile_shader_source(shader_type, source_string);
+    result = compile_shader_source(renderer, shader_type, source_string, GPU_TRUE);
     SDL_free(source_string);
 
-    return result2;
+    return result;
 }
 
-static Uint32 CompileShader(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source)
+static Uint32 preprocess_and_compile(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source, const char** defines, int num_defines, GPU_bool wait)
 {
-    Uint32 size = (Uint32)strlen(shader_source);
-	SDL_RWops* rwops;
+    Uint32 size;
+    char* source_string;
+	Uint32 result;
+
+    if(shader_source == NULL)
+        return 0;
+    size = (Uint32)strlen(shader_source);
     if(size == 0)
         return 0;
-    rwops = SDL_RWFromConstMem(shader_source, size);
-    return renderer->impl->CompileShader_RW(renderer, shader_type, rwops, 1);
+
+    source_string = gpu_preprocess_shader(shader_source, size, defines, num_defines);
+    if(source_string == NULL)
+    {
+        snprintf(shader_message, 256, "Failed to read shader source.\n");
+        return 0;
+    }
+
+    result = compile_shader_source(renderer, shader_type, source_string, wait);
+    SDL_free(source_string);
+
+    return result;
+}
+
+static Uint32 CompileShaderWithDefines(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source, const char** defines, int num_defines)
+{
+    return preprocess_and_compile(renderer, shader_type, shader_source, defines, num_defines, GPU_TRUE);
+}
+
+static Uint32 CompileShaderAsync(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source)
+{
+    return preprocess_and_compile(renderer, shader_type, shader_source, NULL, 0, GPU_FALSE);
+}
+
+static Uint32 CompileShader(GPU_Renderer* renderer, GPU_ShaderEnum shader_type, const char* shader_source)
+{
+    return renderer->impl->CompileShaderWithDefines(renderer, shader_type, shader_source, NULL, 0);
 }
 
 static Uint32 CreateShaderProgram(GPU_Renderer* renderer)
@@ -6091,19 +8174,73 @@ static Uint32 CreateShaderProgram(GPU_Renderer* renderer)
 	#endif
 }
 
-static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
+#ifndef SDL_GPU_DISABLE_SHADERS
+// Puts the compile log of the first attached shader that failed into shader_message.  Shaders compiled without
+// waiting for their status only report errors this way, through the link that uses them.
+static void reportShaderCompileErrors(Uint32 program_object)
 {
-    #ifndef SDL_GPU_DISABLE_SHADERS
-	int linked;
+    GLuint shaders[GPU_PROGRAM_CACHE_MAX_SHADERS];
+    GLsizei num_shaders = 0;
+    int i;
 
-    if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+    glGetAttachedShaders(program_object, GPU_PROGRAM_CACHE_MAX_SHADERS, &num_shaders, shaders);
+    for(i = 0; i < num_shaders; ++i)
+    {
+        GLint compiled = 0;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compiled);
+        if(!compiled)
+        {
+            GPU_PushErrorCode("GPU_CompileShader", GPU_ERROR_DATA_ERROR, "Failed to compile shader source");
+            glGetShaderInfoLog(shaders[i], 256, NULL, shader_message);
+            return;
+        }
+    }
+}
+
+// Starts linking a program.  Returns GPU_FALSE if that already failed.  *linked is set if a cached binary made linking unnecessary,
+// and *hash is set to the key for saving the program's binary once it links, or 0 if it should not be saved.
+static GPU_bool startLinkingProgram(GPU_Renderer* renderer, Uint32 program_object, GPU_bool wait, GPU_bool* linked, Uint64* hash)
+{
+	(void)wait;
+    *linked = GPU_FALSE;
+    *hash = 0;
+
+    // Linking resets the program's uniforms
+    removeProgramRecords(renderer->current_context_target->context, program_object);
+
+    #if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3
+    if(getProgramCacheDirectory(renderer) != NULL)
+    {
+        if(!getProgramHash(program_object, hash))
+            *hash = 0;
+        else if(loadProgramBinary(getProgramCacheDirectory(renderer), program_object, *hash))
+        {
+            *linked = GPU_TRUE;
+            return GPU_TRUE;
+        }
+    }
+
+    if(!compileDeferredShaders(program_object, wait))
         return GPU_FALSE;
+
+    if(*hash != 0)
+        glProgramParameteri(program_object, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    #endif
     
     // Bind the position attribute to location 0.
     // We always pass position data (right?), but on some systems (e.g. GL 2 on OS X), color is bound to 0
     // and the shader won't run when TriangleBatch uses GPU_BATCH_XY_ST (no color array).  Guess they didn't consider default attribute values...
     glBindAttribLocation(program_object, 0, "gpu_Vertex");
 	glLinkProgram(program_object);
+    return GPU_TRUE;
+}
+
+// Checks the result of glLinkProgram(), which waits for the driver if it has not finished yet
+static GPU_bool finishLinkingProgram(GPU_Renderer* renderer, Uint32 program_object, Uint64 hash)
+{
+	int linked = 0;
+	(void)renderer;
+	(void)hash;
 
 	glGetProgramiv(program_object, GL_LINK_STATUS, &linked);
 
@@ -6111,6 +8248,68 @@ static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
     {
         GPU_PushErrorCode("GPU_LinkShaderProgram", GPU_ERROR_BACKEND_ERROR, "Failed to link shader program");
         glGetProgramInfoLog(program_object, 256, NULL, shader_message);
+        reportShaderCompileErrors(program_object);
+        return GPU_FALSE;
+    }
+
+    #if defined(SDL_GPU_USE_OPENGL) || SDL_GPU_GLES_MAJOR_VERSION >= 3
+    if(hash != 0 && getProgramCacheDirectory(renderer) != NULL)
+    {
+        // Shaders compiled without waiting have not been recorded as compiling yet
+        GLuint shaders[GPU_PROGRAM_CACHE_MAX_SHADERS];
+        GLsizei num_shaders = 0;
+        int i;
+
+        glGetAttachedShaders(program_object, GPU_PROGRAM_CACHE_MAX_SHADERS, &num_shaders, shaders);
+        for(i = 0; i < num_shaders; ++i)
+        {
+            GPU_ShaderRecord* record = getShaderRecord(shaders[i]);
+            if(record != NULL)
+                saveKnownShaderHash(getProgramCacheDirectory(renderer), record->hash);
+        }
+
+        saveProgramBinary(getProgramCacheDirectory(renderer), program_object, hash);
+    }
+    #endif
+
+	return GPU_TRUE;
+}
+
+static GPU_bool hasParallelShaderCompile(void)
+{
+    if(parallel_compile_support < 0)
+        parallel_compile_support = (isExtensionSupported("GL_KHR_parallel_shader_compile") || isExtensionSupported("GL_ARB_parallel_shader_compile"));
+    return (parallel_compile_support != 0);
+}
+
+// Waits for a link started by LinkShaderProgramAsync(), if there is one.  Returns GPU_FALSE if the program failed to link.
+static GPU_bool finishPendingLink(GPU_Renderer* renderer, Uint32 program_object)
+{
+    GPU_ProgramRecord* record = getProgramRecord(renderer, program_object, GPU_FALSE);
+    if(record == NULL)
+        return GPU_TRUE;
+
+    if(record->link_pending)
+    {
+        record->link_pending = GPU_FALSE;
+        record->link_failed = !finishLinkingProgram(renderer, program_object, record->link_hash);
+    }
+    return !record->link_failed;
+}
+#endif
+
+static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
+{
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    GPU_bool linked;
+    Uint64 hash;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+        return GPU_FALSE;
+
+    if(!startLinkingProgram(renderer, program_object, GPU_TRUE, &linked, &hash)
+       || (!linked && !finishLinkingProgram(renderer, program_object, hash)))
+    {
         glDeleteProgram(program_object);
         return GPU_FALSE;
     }
@@ -6125,13 +8324,87 @@ static GPU_bool LinkShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
 	#endif
 }
 
+static GPU_bool LinkShaderProgramAsync(GPU_Renderer* renderer, Uint32 program_object)
+{
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    GPU_bool linked;
+    Uint64 hash;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+        return GPU_FALSE;
+
+    if(!startLinkingProgram(renderer, program_object, GPU_FALSE, &linked, &hash))
+        return GPU_FALSE;
+
+    if(!linked)
+    {
+        GPU_ProgramRecord* record = getProgramRecord(renderer, program_object, GPU_TRUE);
+
+        // Without a record to remember the pending link, finish it now
+        if(record == NULL)
+            return finishLinkingProgram(renderer, program_object, hash);
+
+        record->link_pending = GPU_TRUE;
+        record->link_hash = hash;
+    }
+	return GPU_TRUE;
+
+    #else
+	(void)renderer;
+	(void)program_object;
+    return GPU_FALSE;
+
+	#endif
+}
+
+static GPU_ShaderStatusEnum GetShaderProgramStatus(GPU_Renderer* renderer, Uint32 program_object)
+{
+    #ifndef SDL_GPU_DISABLE_SHADERS
+    GPU_ProgramRecord* record;
+    GLint status = 0;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+        return GPU_SHADER_STATUS_FAILED;
+    program_object = get_proper_program_id(renderer, program_object);
+    if(program_object == 0)
+        return GPU_SHADER_STATUS_FAILED;
+
+    record = getProgramRecord(renderer, program_object, GPU_FALSE);
+    if(record != NULL && record->link_pending)
+    {
+        // Without the extension, any status query waits for the driver
+        if(hasParallelShaderCompile())
+        {
+            glGetProgramiv(program_object, GL_COMPLETION_STATUS_KHR, &status);
+            if(!status)
+                return GPU_SHADER_STATUS_PENDING;
+        }
+        return (finishPendingLink(renderer, program_object)? GPU_SHADER_STATUS_READY : GPU_SHADER_STATUS_FAILED);
+    }
+    if(record != NULL && record->link_failed)
+        return GPU_SHADER_STATUS_FAILED;
+
+    glGetProgramiv(program_object, GL_LINK_STATUS, &status);
+    return (status? GPU_SHADER_STATUS_READY : GPU_SHADER_STATUS_FAILED);
+
+    #else
+	(void)renderer;
+	(void)program_object;
+    return GPU_SHADER_STATUS_FAILED;
+
+	#endif
+}
+
 static void FreeShader(GPU_Renderer* renderer, Uint32 shader_object)
 {
 	(void)renderer;
 	(void)shader_object;
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+    {
         glDeleteShader(shader_object);
+        removeShaderRecord(shader_object);
+    }
     #endif
 }
 
@@ -6141,7 +8414,19 @@ static void FreeShaderProgram(GPU_Renderer* renderer, Uint32 program_object)
 	(void)program_object;
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
+    {
+        GPU_Context* context = renderer->current_context_target->context;
+
+        // GL reuses program names, so a new program could otherwise look like it is already active
+        if(program_object != 0 && context->current_shader_program == program_object)
+        {
+            renderer->impl->FlushBlitBuffer(renderer);
+            context->current_shader_program = 0;
+        }
+
         glDeleteProgram(program_object);
+        removeProgramRecords(context, program_object);
+    }
     #endif
 }
 
@@ -6178,35 +8463,49 @@ static void ActivateShaderProgram(GPU_Renderer* renderer, Uint32 program_object,
         {
             // Already using a default shader?
             if(target->context->current_shader_program == target->context->default_textured_shader_program
-                || target->context->current_shader_program == target->context->default_untextured_shader_program)
+                || target->context->current_shader_program == target->context->default_untextured_shader_program
+                || (((GPU_CONTEXT_DATA*)target->context->data)->yuv_shader_program != 0
+                    && target->context->current_shader_program == ((GPU_CONTEXT_DATA*)target->context->data)->yuv_shader_program))
                 return;
 
             program_object = target->context->default_untextured_shader_program;
         }
 
-        renderer->impl->FlushBlitBuffer(renderer);
-        glUseProgram(program_object);
+        // Programs from LinkShaderProgramAsync() are checked when they are first used
+        if(!finishPendingLink(renderer, program_object))
+        {
+            GPU_PushErrorCode("GPU_ActivateShaderProgram", GPU_ERROR_USER_ERROR, "Shader program %u failed to link", program_object);
+            return;
+        }
 
 		{
 			// Set up our shader attribute and uniform locations
+			GPU_ShaderBlock b;
 			if(block == NULL)
 			{
 				if(program_object == target->context->default_textured_shader_program)
-					target->context->current_shader_block = target->context->default_textured_shader_block;
+					b = target->context->default_textured_shader_block;
 				else if(program_object == target->context->default_untextured_shader_program)
-					target->context->current_shader_block = target->context->default_untextured_shader_block;
+					b = target->context->default_untextured_shader_block;
 				else
 				{
-						GPU_ShaderBlock b;
 						b.position_loc = -1;
 						b.texcoord_loc = -1;
 						b.color_loc = -1;
 						b.modelViewProjection_loc = -1;
-						target->context->current_shader_block = b;
 				}
 			}
 			else
-				target->context->current_shader_block = *block;
+				b = *block;
+
+			// Reactivating the current program does not need a flush.  Its uniforms are still set.
+			if(program_object == target->context->current_shader_program
+			   && memcmp(&b, &target->context->current_shader_block, sizeof(GPU_ShaderBlock)) == 0)
+				return;
+
+			renderer->impl->FlushBlitBuffer(renderer);
+			glUseProgram(program_object);
+			target->context->current_shader_block = b;
 		}
     }
     #endif
@@ -6231,9 +8530,9 @@ static int GetAttributeLocation(GPU_Renderer* renderer, Uint32 program_object, c
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return -1;
     program_object = get_proper_program_id(renderer, program_object);
-    if(program_object == 0)
+    if(program_object == 0 || attrib_name == NULL)
         return -1;
-    return glGetAttribLocation(program_object, attrib_name);
+    return getCachedLocation(renderer, program_object, attrib_name, GPU_TRUE);
 	#else
 	(void)renderer;
 	(void)program_object;
@@ -6248,9 +8547,9 @@ static int GetUniformLocation(GPU_Renderer* renderer, Uint32 program_object, con
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return -1;
     program_object = get_proper_program_id(renderer, program_object);
-    if(program_object == 0)
+    if(program_object == 0 || uniform_name == NULL)
         return -1;
-    return glGetUniformLocation(program_object, uniform_name);
+    return getCachedLocation(renderer, program_object, uniform_name, GPU_FALSE);
 	#else
 	(void)renderer;
 	(void)program_object;
@@ -6310,10 +8609,16 @@ static void SetShaderImage(GPU_Renderer* renderer, GPU_Image* image, int locatio
 
     new_texture = 0;
     if(image != NULL)
+    {
+        if(((GPU_IMAGE_DATA*)image->data)->evicted_pixels != NULL)
+            restoreEvictedImage(renderer, image);
+        touchImage(image);
         new_texture = ((GPU_IMAGE_DATA*)image->data)->handle;
+    }
 
     // Set the new image unit
-    glUniform1i(location, image_unit);
+    if(updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_INT, 1, 1, GPU_FALSE, 1), &image_unit, sizeof(int)))
+        glUniform1i(location, image_unit);
     glActiveTexture(GL_TEXTURE0 + image_unit);
     glBindTexture(GL_TEXTURE_2D, new_texture);
 
@@ -6354,9 +8659,9 @@ static void SetUniformi(GPU_Renderer* renderer, int location, int value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_INT, 1, 1, GPU_FALSE, 1), &value, sizeof(int)))
         return;
+    renderer->impl->FlushBlitBuffer(renderer);
     glUniform1i(location, value);
     #endif
 }
@@ -6372,9 +8677,11 @@ static void SetUniformiv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(num_elements_per_value < 1 || num_elements_per_value > 4 || num_values < 1)
         return;
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_INT, num_elements_per_value, 1, GPU_FALSE, num_values), values, num_elements_per_value*num_values*sizeof(int)))
+        return;
+    renderer->impl->FlushBlitBuffer(renderer);
     switch(num_elements_per_value)
     {
         case 1:
@@ -6423,9 +8730,9 @@ static void SetUniformui(GPU_Renderer* renderer, int location, unsigned int valu
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_UINT, 1, 1, GPU_FALSE, 1), &value, sizeof(unsigned int)))
         return;
+    renderer->impl->FlushBlitBuffer(renderer);
     #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
     glUniform1i(location, (int)value);
     #else
@@ -6445,9 +8752,11 @@ static void SetUniformuiv(GPU_Renderer* renderer, int location, int num_elements
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(num_elements_per_value < 1 || num_elements_per_value > 4 || num_values < 1)
+        return;
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_UINT, num_elements_per_value, 1, GPU_FALSE, num_values), values, num_elements_per_value*num_values*sizeof(unsigned int)))
         return;
+    renderer->impl->FlushBlitBuffer(renderer);
     #if defined(SDL_GPU_USE_GLES) && SDL_GPU_GLES_MAJOR_VERSION < 3
     switch(num_elements_per_value)
     {
@@ -6510,9 +8819,9 @@ static void SetUniformf(GPU_Renderer* renderer, int location, float value)
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_FLOAT, 1, 1, GPU_FALSE, 1), &value, sizeof(float)))
         return;
+    renderer->impl->FlushBlitBuffer(renderer);
     glUniform1f(location, value);
     #endif
 }
@@ -6528,9 +8837,11 @@ static void SetUniformfv(GPU_Renderer* renderer, int location, int num_elements_
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
-    if(renderer->current_context_target->context->current_shader_program == 0)
+    if(num_elements_per_value < 1 || num_elements_per_value > 4 || num_values < 1)
         return;
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_FLOAT, num_elements_per_value, 1, GPU_FALSE, num_values), values, num_elements_per_value*num_values*sizeof(float)))
+        return;
+    renderer->impl->FlushBlitBuffer(renderer);
     switch(num_elements_per_value)
     {
         case 1:
@@ -6562,7 +8873,6 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     #ifndef SDL_GPU_DISABLE_SHADERS
     if(!IsFeatureEnabled(renderer, GPU_FEATURE_BASIC_SHADERS))
         return;
-    renderer->impl->FlushBlitBuffer(renderer);
     if(renderer->current_context_target->context->current_shader_program == 0)
         return;
     if(num_rows < 2 || num_rows > 4 || num_columns < 2 || num_columns > 4)
@@ -6585,6 +8895,12 @@ static void SetUniformMatrixfv(GPU_Renderer* renderer, int location, int num_mat
     }
     #endif
 
+    if(num_matrices < 1)
+        return;
+    if(!updateUniformValue(renderer, location, uniformSignature(GPU_UNIFORM_KIND_MATRIX, num_rows, num_columns, transpose, num_matrices), values, num_rows*num_columns*num_matrices*sizeof(float)))
+        return;
+    renderer->impl->FlushBlitBuffer(renderer);
+
     switch(num_rows)
     {
     case 2:
@@ -6837,42 +9153,24 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     FlushBlitBuffer(renderer);
     cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data;
     a = &cdata->shader_attributes[source.location];
-    if(source.format.is_per_sprite)
-    {
-		int needed_size;
-
-        a->per_vertex_storage_offset_bytes = 0;
-        a->per_vertex_storage_stride_bytes = source.format.num_elems_per_value * sizeof_GPU_type(source.format.type);
-        a->num_values = 4 * num_values;  // 4 vertices now
-        needed_size = a->num_values * a->per_vertex_storage_stride_bytes;
-
-        // Make sure we have enough room for converted per-vertex data
-        if(a->per_vertex_storage_size < needed_size)
-        {
-            SDL_free(a->per_vertex_storage);
-            a->per_vertex_storage = SDL_malloc(needed_size);
-            a->per_vertex_storage_size = needed_size;
-        }
-    }
-    else if(a->per_vertex_storage_size > 0)
+    if(a->per_vertex_storage_size > 0)
     {
         SDL_free(a->per_vertex_storage);
-        a->per_vertex_storage = NULL;
         a->per_vertex_storage_size = 0;
     }
 
     a->enabled = GPU_FALSE;
     a->attribute = source;
 
-    if(!source.format.is_per_sprite)
-    {
-        a->per_vertex_storage = source.values;
-        a->num_values = num_values;
-        a->per_vertex_storage_stride_bytes = source.format.stride_bytes;
-        a->per_vertex_storage_offset_bytes = source.format.offset_bytes;
-    }
+    // Values are read straight from the source when flushing.  Per-sprite values are expanded to 4 vertices then.
+    a->per_vertex_storage = source.values;
+    a->per_vertex_storage_offset_bytes = source.format.offset_bytes;
+    a->per_vertex_storage_stride_bytes = source.format.stride_bytes;
+    if(a->per_vertex_storage_stride_bytes <= 0)
+        a->per_vertex_storage_stride_bytes = source.format.num_elems_per_value * sizeof_GPU_type(source.format.type);  // Tightly packed
+    a->num_values = (source.format.is_per_sprite? 4 * num_values : num_values);
 
-    a->next_value = a->per_vertex_storage;
+    a->next_value = (source.values == NULL? NULL : (char*)source.values + source.format.offset_bytes);
 
 	#endif
 
@@ -6882,6 +9180,111 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
 }
 
 
+static Uint32 CreateUniformBuffer(GPU_Renderer* renderer, Uint32 size_bytes, const void* data)
+{
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+    GLuint buffer = 0;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_UNIFORM_BUFFERS))
+    {
+        GPU_PushErrorCode("GPU_CreateUniformBuffer", GPU_ERROR_UNSUPPORTED_FUNCTION, "Uniform buffers are not supported by this renderer");
+        return 0;
+    }
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, size_bytes, data, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return buffer;
+    #else
+	(void)size_bytes;
+	(void)data;
+    GPU_PushErrorCode("GPU_CreateUniformBuffer", GPU_ERROR_UNSUPPORTED_FUNCTION, "Uniform buffers are not supported by this renderer");
+    (void)renderer;
+    return 0;
+    #endif
+}
+
+static void UpdateUniformBuffer(GPU_Renderer* renderer, Uint32 buffer, Uint32 offset_bytes, Uint32 size_bytes, const void* data)
+{
+	(void)renderer;
+	(void)buffer;
+	(void)offset_bytes;
+	(void)size_bytes;
+	(void)data;
+
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_UNIFORM_BUFFERS))
+        return;
+
+    // Batched draws read the buffer when they are flushed
+    renderer->impl->FlushBlitBuffer(renderer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset_bytes, size_bytes, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    #endif
+}
+
+static void BindUniformBuffer(GPU_Renderer* renderer, Uint32 buffer, Uint32 binding_point)
+{
+	(void)renderer;
+	(void)buffer;
+	(void)binding_point;
+
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_UNIFORM_BUFFERS))
+        return;
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding_point, buffer);
+    #endif
+}
+
+static GPU_bool SetUniformBlockBinding(GPU_Renderer* renderer, Uint32 program_object, const char* block_name, Uint32 binding_point)
+{
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+    GLuint index;
+
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_UNIFORM_BUFFERS))
+        return GPU_FALSE;
+    program_object = get_proper_program_id(renderer, program_object);
+    if(program_object == 0)
+        return GPU_FALSE;
+
+    index = glGetUniformBlockIndex(program_object, block_name);
+    if(index == GL_INVALID_INDEX)
+    {
+        GPU_PushErrorCode("GPU_SetUniformBlockBinding", GPU_ERROR_USER_ERROR, "Shader program %u has no uniform block \"%s\"", program_object, block_name);
+        return GPU_FALSE;
+    }
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    glUniformBlockBinding(program_object, index, binding_point);
+    return GPU_TRUE;
+    #else
+	(void)renderer;
+	(void)program_object;
+	(void)block_name;
+	(void)binding_point;
+    return GPU_FALSE;
+    #endif
+}
+
+static void FreeUniformBuffer(GPU_Renderer* renderer, Uint32 buffer)
+{
+	(void)renderer;
+	(void)buffer;
+
+    #ifdef SDL_GPU_USE_UNIFORM_BUFFERS
+    if(!IsFeatureEnabled(renderer, GPU_FEATURE_UNIFORM_BUFFERS))
+        return;
+
+    renderer->impl->FlushBlitBuffer(renderer);
+    glDeleteBuffers(1, &buffer);
+    #endif
+}
+
+
 
 #define SET_COMMON_FUNCTIONS(impl) \
     impl->Init = &Init; \
@@ -6901,15 +9304,22 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
  \
     impl->CreateImage = &CreateImage; \
     impl->CreateImageUsingTexture = &CreateImageUsingTexture; \
+    impl->CreateStreamingImage = &CreateStreamingImage; \
+    impl->CreateCompressedImage = &CreateCompressedImage; \
+    impl->UploadMipmaps = &UploadMipmaps; \
     impl->CreateAliasImage = &CreateAliasImage; \
     impl->SaveImage = &SaveImage; \
     impl->CopyImage = &CopyImage; \
     impl->UpdateImage = &UpdateImage; \
     impl->UpdateImageBytes = &UpdateImageBytes; \
+    impl->LockImageRegion = &LockImageRegion; \
+    impl->UnlockImageRegion = &UnlockImageRegion; \
+    impl->UpdateImageYUV = &UpdateImageYUV; \
     impl->ReplaceImage = &ReplaceImage; \
     impl->CopyImageFromSurface = &CopyImageFromSurface; \
     impl->CopyImageFromTarget = &CopyImageFromTarget; \
     impl->CopySurfaceFromTarget = &CopySurfaceFromTarget; \
+    impl->ReadTargetAsync = &ReadTargetAsync; \
     impl->CopySurfaceFromImage = &CopySurfaceFromImage; \
     impl->FreeImage = &FreeImage; \
  \
@@ -6932,6 +9342,8 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->SetImageFilter = &SetImageFilter; \
     impl->SetWrapMode = &SetWrapMode; \
     impl->GetTextureHandle = &GetTextureHandle; \
+    impl->GetMemoryStats = &GetMemoryStats; \
+    impl->SetTextureBudget = &SetTextureBudget; \
  \
     impl->ClearRGBA = &ClearRGBA; \
     impl->FlushBlitBuffer = &FlushBlitBuffer; \
@@ -6939,8 +9351,12 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
      \
     impl->CompileShader_RW = &CompileShader_RW; \
     impl->CompileShader = &CompileShader; \
+    impl->CompileShaderWithDefines = &CompileShaderWithDefines; \
+    impl->CompileShaderAsync = &CompileShaderAsync; \
     impl->CreateShaderProgram = &CreateShaderProgram; \
     impl->LinkShaderProgram = &LinkShaderProgram; \
+    impl->LinkShaderProgramAsync = &LinkShaderProgramAsync; \
+    impl->GetShaderProgramStatus = &GetShaderProgramStatus; \
     impl->FreeShader = &FreeShader; \
     impl->FreeShaderProgram = &FreeShaderProgram; \
     impl->AttachShader = &AttachShader; \
@@ -6969,6 +9385,11 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->SetAttributeiv = &SetAttributeiv; \
     impl->SetAttributeuiv = &SetAttributeuiv; \
     impl->SetAttributeSource = &SetAttributeSource; \
+    impl->CreateUniformBuffer = &CreateUniformBuffer; \
+    impl->UpdateUniformBuffer = &UpdateUniformBuffer; \
+    impl->BindUniformBuffer = &BindUniformBuffer; \
+    impl->SetUniformBlockBinding = &SetUniformBlockBinding; \
+    impl->FreeUniformBuffer = &FreeUniformBuffer; \
 	 \
 	/* Shape rendering */ \
 	 \
@@ -6992,5 +9413,11 @@ static void SetAttributeSource(GPU_Renderer* renderer, int num_values, GPU_Attri
     impl->RectangleRoundFilled = &RectangleRoundFilled; \
     impl->Polygon = &Polygon; \
 	impl->Polyline = &Polyline; \
-    impl->PolygonFilled = &PolygonFilled;
+    impl->PolygonFilled = &PolygonFilled; \
+    impl->PolygonFilledEx = &PolygonFilledEx; \
+    impl->Points = &Points; \
+    impl->Lines = &Lines; \
+    impl->TrisFilled = &TrisFilled; \
+    impl->RectanglesFilled = &RectanglesFilled; \
+    impl->CirclesFilled = &CirclesFilled;
 
@@ -2,20 +2,21 @@
 See a particular renderer's *.c file for specifics. */
 
 
+// Defined in SDL_gpu_shapes.c
+const unsigned int* gpu_triangulate_polygon(unsigned int num_contours, unsigned int* contour_sizes, float* vertices, unsigned int* num_indices);
 
 
 
 
 
-// All shapes start this way for setup and so they can access the blit buffer properly
-#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices) \
-	GPU_CONTEXT_DATA* cdata; \
-	float* blit_buffer; \
-	unsigned short* index_buffer; \
-	int vert_index; \
-	int color_index; \
-	float r, g, b, a; \
-	unsigned short blit_buffer_starting_index; \
+
+
+// Argument validation, which builds with SDL_GPU_DISABLE_ARGUMENT_CHECKS leave out
+#ifdef SDL_GPU_DISABLE_ARGUMENT_CHECKS
+#define CHECK_SHAPE_TARGET(function_name)
+#define CHECK_SHAPE_CONTEXT(function_name)
+#else
+#define CHECK_SHAPE_TARGET(function_name) \
     if(target == NULL) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_NULL_ARGUMENT, "target"); \
@@ -25,14 +26,27 @@ See a particular renderer's *.c file for specifics. */
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "Mismatched renderer"); \
         return; \
-    } \
-     \
-    makeContextCurrent(renderer, target); \
+    }
+#define CHECK_SHAPE_CONTEXT(function_name) \
     if(renderer->current_context_target == NULL) \
     { \
         GPU_PushErrorCode(function_name, GPU_ERROR_USER_ERROR, "NULL context"); \
         return; \
-    } \
+    }
+#endif
+
+// All shapes start this way for setup and so they can access the blit buffer properly
+#define BEGIN_UNTEXTURED(function_name, shape, num_additional_vertices, num_additional_indices) \
+	GPU_CONTEXT_DATA* cdata; \
+	float* blit_buffer; \
+	unsigned short* index_buffer; \
+	int vert_index; \
+	int color_index; \
+	float r, g, b, a; \
+	unsigned short blit_buffer_starting_index; \
+    CHECK_SHAPE_TARGET(function_name); \
+    makeContextCurrent(renderer, target); \
+    CHECK_SHAPE_CONTEXT(function_name); \
      \
     if(!bindFramebuffer(renderer, target)) \
     { \
@@ -80,6 +94,157 @@ See a particular renderer's *.c file for specifics. */
     (void)blit_buffer_starting_index;
 
 
+// Bulk shapes do the setup once, then reserve buffer space per chunk with BEGIN_BULK_CHUNK()
+#define BEGIN_UNTEXTURED_BULK(function_name, shape) \
+	GPU_CONTEXT_DATA* cdata; \
+	float* blit_buffer; \
+	unsigned short* index_buffer; \
+	int vert_index; \
+	int color_index; \
+	float r, g, b, a; \
+	unsigned short blit_buffer_starting_index; \
+    CHECK_SHAPE_TARGET(function_name); \
+    makeContextCurrent(renderer, target); \
+    CHECK_SHAPE_CONTEXT(function_name); \
+     \
+    if(!bindFramebuffer(renderer, target)) \
+    { \
+        GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to bind framebuffer."); \
+        return; \
+    } \
+     \
+    prepareToRenderToTarget(renderer, target); \
+    prepareToRenderShapes(renderer, shape); \
+     \
+    cdata = (GPU_CONTEXT_DATA*)renderer->current_context_target->context->data; \
+    SET_BULK_COLOR(color); \
+    blit_buffer_starting_index = 0; \
+    (void)blit_buffer_starting_index;
+
+// Makes room for num_elements more shapes (or as many as will fit) and sets chunk_end accordingly
+#define BEGIN_BULK_CHUNK(chunk_end, start, num_elements, verts_per_element, indices_per_element) \
+    chunk_end = (start) + reserveBulkShapes(renderer, cdata, (num_elements), (verts_per_element), (indices_per_element)); \
+    blit_buffer = cdata->blit_buffer; \
+    index_buffer = cdata->index_buffer; \
+    vert_index = GPU_BLIT_BUFFER_VERTEX_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX; \
+    color_index = GPU_BLIT_BUFFER_COLOR_OFFSET + cdata->blit_buffer_num_vertices*GPU_BLIT_BUFFER_FLOATS_PER_VERTEX;
+
+#define SET_BULK_COLOR(shape_color) \
+    if(target->use_color) \
+    { \
+        r = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.r, (shape_color).r); \
+        g = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.g, (shape_color).g); \
+        b = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(target->color.b, (shape_color).b); \
+        a = MIX_COLOR_COMPONENT_NORMALIZED_RESULT(GET_ALPHA(target->color), GET_ALPHA(shape_color)); \
+    } \
+    else \
+    { \
+        r = (shape_color).r/255.0f; \
+        g = (shape_color).g/255.0f; \
+        b = (shape_color).b/255.0f; \
+        a = GET_ALPHA(shape_color)/255.0f; \
+    }
+
+// Grows the buffers for up to num_elements shapes, flushing if they are already full.  Returns how many shapes fit.
+static unsigned int reserveBulkShapes(GPU_Renderer* renderer, GPU_CONTEXT_DATA* cdata, unsigned int num_elements, unsigned int verts_per_element, unsigned int indices_per_element)
+{
+    unsigned int num_fit;
+
+    if(num_elements > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES/verts_per_element)
+        num_elements = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES/verts_per_element;
+
+    growBlitBuffer(cdata, cdata->blit_buffer_num_vertices + num_elements*verts_per_element);
+    growIndexBuffer(cdata, cdata->index_buffer_num_vertices + num_elements*indices_per_element);
+
+    if(cdata->blit_buffer_num_vertices + verts_per_element > cdata->blit_buffer_max_num_vertices
+       || cdata->index_buffer_num_vertices + indices_per_element > cdata->index_buffer_max_num_vertices)
+    {
+        renderer->impl->FlushBlitBuffer(renderer);
+        growBlitBuffer(cdata, num_elements*verts_per_element);
+        growIndexBuffer(cdata, num_elements*indices_per_element);
+    }
+
+    num_fit = (cdata->blit_buffer_max_num_vertices - cdata->blit_buffer_num_vertices)/verts_per_element;
+    if(num_fit > (cdata->index_buffer_max_num_vertices - cdata->index_buffer_num_vertices)/indices_per_element)
+        num_fit = (cdata->index_buffer_max_num_vertices - cdata->index_buffer_num_vertices)/indices_per_element;
+    if(num_fit > num_elements)
+        num_fit = num_elements;
+    return num_fit;
+}
+
+
+
+
+
+// Unit-space outlines for shapes that are often redrawn with the same parameters, so only translating and scaling is left per call
+#define GPU_SHAPE_TEMPLATE_CACHE_SIZE 16
+
+#define GPU_SHAPE_TEMPLATE_ROUNDED_CORNERS 1
+#define GPU_SHAPE_TEMPLATE_ARC 2
+
+typedef struct GPU_ShapeTemplate
+{
+    int type;
+    float params[3];
+    int num_points;  // Zero until the caller fills in the points
+    int max_points;
+    float* points;  // Unit circle directions stored as x and y pairs
+    Uint32 last_used;
+} GPU_ShapeTemplate;
+
+static GPU_ShapeTemplate shape_templates[GPU_SHAPE_TEMPLATE_CACHE_SIZE];
+static Uint32 shape_template_time = 0;
+
+// Returns the matching template, or reuses the least recently used one with room for num_points and num_points set to 0.  Returns NULL if the points can't be allocated.
+static GPU_ShapeTemplate* getShapeTemplate(const char* function_name, int type, float param0, float param1, float param2, int num_points)
+{
+    GPU_ShapeTemplate* result = &shape_templates[0];
+    int i;
+
+    shape_template_time++;
+    for(i = 0; i < GPU_SHAPE_TEMPLATE_CACHE_SIZE; i++)
+    {
+        GPU_ShapeTemplate* t = &shape_templates[i];
+        if(t->num_points == num_points && t->type == type && t->params[0] == param0 && t->params[1] == param1 && t->params[2] == param2)
+        {
+            t->last_used = shape_template_time;
+            return t;
+        }
+        if(t->last_used < result->last_used)
+            result = t;
+    }
+
+    if(result->max_points < num_points)
+    {
+        SDL_free(result->points);
+        result->points = (float*)SDL_malloc(2 * num_points * sizeof(float));
+        if(result->points == NULL)
+        {
+            memset(result, 0, sizeof(GPU_ShapeTemplate));
+            GPU_PushErrorCode(function_name, GPU_ERROR_BACKEND_ERROR, "Failed to allocate shape template of %d points.", num_points);
+            return NULL;
+        }
+        result->max_points = num_points;
+    }
+    result->type = type;
+    result->params[0] = param0;
+    result->params[1] = param1;
+    result->params[2] = param2;
+    result->num_points = 0;
+    result->last_used = shape_template_time;
+    return result;
+}
+
+static void freeShapeTemplates(void)
+{
+    int i;
+    for(i = 0; i < GPU_SHAPE_TEMPLATE_CACHE_SIZE; i++)
+    {
+        SDL_free(shape_templates[i].points);
+        memset(&shape_templates[i], 0, sizeof(GPU_ShapeTemplate));
+    }
+    shape_template_time = 0;
+}
 
 
 
@@ -267,42 +432,46 @@ static void ArcFilled(GPU_Renderer* renderer, GPU_Target* target, float x, float
 		return;
 
 	{
+		GPU_ShapeTemplate* t;
+		int num_points = numSegments + 2;
+
 		BEGIN_UNTEXTURED("GPU_ArcFilled", GL_TRIANGLES, 3 + (numSegments - 1) + 1, 3 + (numSegments - 1) * 3 + 3);
-        
-        c = cosf(dt);
-        s = sinf(dt);
-        
-        // Rotate to start
-        start_angle *= RAD_PER_DEG;
-        dx = cosf(start_angle);
-        dy = sinf(start_angle);
 
-		// First triangle
-		SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);
-		SET_UNTEXTURED_VERTEX(x + radius*dx, y + radius*dy, r, g, b, a); // first point
-		
-        tempx = c * dx - s * dy;
-        dy = s * dx + c * dy;
-        dx = tempx;
-		SET_UNTEXTURED_VERTEX(x + radius*dx, y + radius*dy, r, g, b, a); // new point
+		// The radius only picks the number of points, so arcs of any size with the same angles and point count share the outline
+		t = getShapeTemplate("GPU_ArcFilled", GPU_SHAPE_TEMPLATE_ARC, start_angle, end_angle, 0.0f, num_points);
+		if(t == NULL)
+			return;
+		if(t->num_points == 0)
+		{
+			// Unit directions evenly spaced from the start angle to the end angle
+			float step = ((end_angle - start_angle)*RAD_PER_DEG)/(num_points - 1);
+			c = cosf(step);
+			s = sinf(step);
+
+			// Rotate to start
+			dx = cosf(start_angle*RAD_PER_DEG);
+			dy = sinf(start_angle*RAD_PER_DEG);
+			for(i = 0; i < num_points - 1; i++)
+			{
+				t->points[2*i] = dx;
+				t->points[2*i+1] = dy;
+				tempx = c * dx - s * dy;
+				dy = s * dx + c * dy;
+				dx = tempx;
+			}
+			t->points[2*i] = cosf(end_angle*RAD_PER_DEG);
+			t->points[2*i+1] = sinf(end_angle*RAD_PER_DEG);
+			t->num_points = num_points;
+		}
 
-		for (i = 2; i < numSegments + 1; i++)
+		SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // center
+		SET_UNTEXTURED_VERTEX(x + radius*t->points[0], y + radius*t->points[1], r, g, b, a); // first point
+		for(i = 1; i < num_points; i++)
 		{
-            tempx = c * dx - s * dy;
-            dy = s * dx + c * dy;
-            dx = tempx;
 			SET_INDEXED_VERTEX(0);  // center
 			SET_INDEXED_VERTEX(i);  // last point
-			SET_UNTEXTURED_VERTEX(x + radius*dx, y + radius*dy, r, g, b, a); // new point
+			SET_UNTEXTURED_VERTEX(x + radius*t->points[2*i], y + radius*t->points[2*i+1], r, g, b, a); // new point
 		}
-
-		// Last triangle
-        end_angle *= RAD_PER_DEG;
-        dx = cosf(end_angle);
-        dy = sinf(end_angle);
-		SET_INDEXED_VERTEX(0);  // center
-		SET_INDEXED_VERTEX(i);  // last point
-		SET_UNTEXTURED_VERTEX(x + radius*dx, y + radius*dy, r, g, b, a); // new point
 	}
 }
 
@@ -915,70 +1084,59 @@ static void RectangleRoundFilled(GPU_Renderer* renderer, GPU_Target* target, flo
 		radius = (y2 - y1) / 2;
 
 	{
-		float tau = 2 * PI;
-
 		int verts_per_corner = 7;
-		float corner_angle_increment = (tau / 4) / (verts_per_corner - 1);  // 0, 15, 30, 45, 60, 75, 90
-
-		// Starting angle
-		float angle = tau*0.75f;
-		int last_index = 2;
-		int i;
+		int num_points = 4 * verts_per_corner;
+		GPU_ShapeTemplate* t;
+		float cx[4], cy[4];
+		int corner, i, j;
 
 		BEGIN_UNTEXTURED("GPU_RectangleRoundFilled", GL_TRIANGLES, 6 + 4 * (verts_per_corner - 1) - 1, 15 + 4 * (verts_per_corner - 1) * 3 - 3);
 
-
-		// First triangle
-		SET_UNTEXTURED_VERTEX((x2 + x1) / 2, (y2 + y1) / 2, r, g, b, a);  // Center
-		SET_UNTEXTURED_VERTEX(x2 - radius + cosf(angle)*radius, y1 + radius + sinf(angle)*radius, r, g, b, a);
-		angle += corner_angle_increment;
-		SET_UNTEXTURED_VERTEX(x2 - radius + cosf(angle)*radius, y1 + radius + sinf(angle)*radius, r, g, b, a);
-		angle += corner_angle_increment;
-
-		for (i = 2; i < verts_per_corner; i++)
-		{
-			SET_INDEXED_VERTEX(0);
-			SET_INDEXED_VERTEX(last_index++);
-			SET_UNTEXTURED_VERTEX(x2 - radius + cosf(angle)*radius, y1 + radius + sinf(angle)*radius, r, g, b, a);
-			angle += corner_angle_increment;
-		}
-
-		SET_INDEXED_VERTEX(0);
-		SET_INDEXED_VERTEX(last_index++);
-		SET_UNTEXTURED_VERTEX(x2 - radius + cosf(angle)*radius, y2 - radius + sinf(angle)*radius, r, g, b, a);
-		for (i = 1; i < verts_per_corner; i++)
+		t = getShapeTemplate("GPU_RectangleRoundFilled", GPU_SHAPE_TEMPLATE_ROUNDED_CORNERS, (float)verts_per_corner, 0.0f, 0.0f, num_points);
+		if(t == NULL)
+			return;
+		if(t->num_points == 0)
 		{
-			SET_INDEXED_VERTEX(0);
-			SET_INDEXED_VERTEX(last_index++);
-			SET_UNTEXTURED_VERTEX(x2 - radius + cosf(angle)*radius, y2 - radius + sinf(angle)*radius, r, g, b, a);
-			angle += corner_angle_increment;
+			// Each corner sweeps 90 degrees, starting at 270 for the top right
+			float corner_angle_increment = (PI / 2) / (verts_per_corner - 1);  // 0, 15, 30, 45, 60, 75, 90
+			for(corner = 0; corner < 4; corner++)
+			{
+				for(j = 0; j < verts_per_corner; j++)
+				{
+					float angle = 1.5f*PI + corner*(PI / 2) + j*corner_angle_increment;
+					t->points[2*(corner*verts_per_corner + j)] = cosf(angle);
+					t->points[2*(corner*verts_per_corner + j)+1] = sinf(angle);
+				}
+			}
+			t->num_points = num_points;
 		}
 
-		SET_INDEXED_VERTEX(0);
-		SET_INDEXED_VERTEX(last_index++);
-		SET_UNTEXTURED_VERTEX(x1 + radius + cosf(angle)*radius, y2 - radius + sinf(angle)*radius, r, g, b, a);
-		for (i = 1; i < verts_per_corner; i++)
-		{
-			SET_INDEXED_VERTEX(0);
-			SET_INDEXED_VERTEX(last_index++);
-			SET_UNTEXTURED_VERTEX(x1 + radius + cosf(angle)*radius, y2 - radius + sinf(angle)*radius, r, g, b, a);
-			angle += corner_angle_increment;
-		}
+		// Corner centers
+		cx[0] = x2 - radius;
+		cy[0] = y1 + radius;
+		cx[1] = x2 - radius;
+		cy[1] = y2 - radius;
+		cx[2] = x1 + radius;
+		cy[2] = y2 - radius;
+		cx[3] = x1 + radius;
+		cy[3] = y1 + radius;
 
-		SET_INDEXED_VERTEX(0);
-		SET_INDEXED_VERTEX(last_index++);
-		SET_UNTEXTURED_VERTEX(x1 + radius + cosf(angle)*radius, y1 + radius + sinf(angle)*radius, r, g, b, a);
-		for (i = 1; i < verts_per_corner; i++)
+		SET_UNTEXTURED_VERTEX((x2 + x1) / 2, (y2 + y1) / 2, r, g, b, a);  // Center
+		SET_UNTEXTURED_VERTEX(cx[0] + radius*t->points[0], cy[0] + radius*t->points[1], r, g, b, a);
+		i = 1;
+		for(corner = 0; corner < 4; corner++)
 		{
-			SET_INDEXED_VERTEX(0);
-			SET_INDEXED_VERTEX(last_index++);
-			SET_UNTEXTURED_VERTEX(x1 + radius + cosf(angle)*radius, y1 + radius + sinf(angle)*radius, r, g, b, a);
-			angle += corner_angle_increment;
+			for(j = (corner == 0? 1 : 0); j < verts_per_corner; j++)
+			{
+				SET_INDEXED_VERTEX(0);
+				SET_INDEXED_VERTEX(i++);
+				SET_UNTEXTURED_VERTEX(cx[corner] + radius*t->points[2*i-2], cy[corner] + radius*t->points[2*i-1], r, g, b, a);
+			}
 		}
 
 		// Last triangle
 		SET_INDEXED_VERTEX(0);
-		SET_INDEXED_VERTEX(last_index++);
+		SET_INDEXED_VERTEX(i);
 		SET_INDEXED_VERTEX(1);
 	}
 }
@@ -1094,3 +1252,281 @@ static void PolygonFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned i
 	}
 }
 
+
+static void PolygonFilledEx(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_contours, unsigned int* contour_sizes, float* vertices, SDL_Color color)
+{
+    unsigned int num_vertices = 0;
+    unsigned int num_indices;
+    const unsigned int* indices;
+    unsigned int i;
+
+    if(num_contours == 0 || contour_sizes == NULL || vertices == NULL)
+        return;
+
+    for(i = 0; i < num_contours; i++)
+        num_vertices += contour_sizes[i];
+
+    if(num_vertices > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+    {
+        GPU_PushErrorCode("GPU_PolygonFilledEx", GPU_ERROR_USER_ERROR, "Too many vertices (%u, max is %d)", num_vertices, GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES);
+        return;
+    }
+
+    indices = gpu_triangulate_polygon(num_contours, contour_sizes, vertices, &num_indices);
+    if(indices == NULL || num_indices == 0)
+        return;
+
+    {
+        BEGIN_UNTEXTURED("GPU_PolygonFilledEx", GL_TRIANGLES, num_vertices, num_indices);
+
+        for(i = 0; i < num_vertices; i++)
+        {
+            SET_UNTEXTURED_VERTEX_UNINDEXED(vertices[2*i], vertices[2*i+1], r, g, b, a);
+        }
+        cdata->blit_buffer_num_vertices += num_vertices;
+
+        for(i = 0; i < num_indices; i++)
+        {
+            SET_INDEXED_VERTEX(indices[i]);
+        }
+    }
+}
+
+static void Points(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_points, float* points, SDL_Color* colors, SDL_Color color)
+{
+    unsigned int i, chunk_end;
+
+    if(num_points == 0 || points == NULL)
+        return;
+
+    {
+        BEGIN_UNTEXTURED_BULK("GPU_Points", GL_POINTS);
+
+        for(i = 0; i < num_points; )
+        {
+            BEGIN_BULK_CHUNK(chunk_end, i, num_points - i, 1, 1);
+
+            for(; i < chunk_end; i++)
+            {
+                if(colors != NULL)
+                {
+                    SET_BULK_COLOR(colors[i]);
+                }
+                SET_UNTEXTURED_VERTEX(points[2*i], points[2*i+1], r, g, b, a);
+            }
+        }
+    }
+}
+
+static void Lines(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_lines, float* endpoints, SDL_Color* colors, SDL_Color color)
+{
+    unsigned int i, chunk_end;
+    float t = GetLineThickness(renderer)/2;
+
+    if(num_lines == 0 || endpoints == NULL)
+        return;
+
+    {
+        BEGIN_UNTEXTURED_BULK("GPU_Lines", GL_TRIANGLES);
+
+        for(i = 0; i < num_lines; )
+        {
+            BEGIN_BULK_CHUNK(chunk_end, i, num_lines - i, 4, 6);
+
+            for(; i < chunk_end; i++)
+            {
+                float* e = endpoints + 4*i;
+                float dx = e[2] - e[0];
+                float dy = e[3] - e[1];
+                float len = sqrtf(dx*dx + dy*dy);
+                float tc, ts;
+
+                // Same offsets as Line(), without the trig
+                if(len > 0.0f)
+                {
+                    tc = t*dx/len;
+                    ts = t*dy/len;
+                }
+                else
+                {
+                    tc = t;
+                    ts = 0.0f;
+                }
+
+                if(colors != NULL)
+                {
+                    SET_BULK_COLOR(colors[i]);
+                }
+
+                blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+                SET_UNTEXTURED_VERTEX(e[0] + ts, e[1] - tc, r, g, b, a);
+                SET_UNTEXTURED_VERTEX(e[0] - ts, e[1] + tc, r, g, b, a);
+                SET_UNTEXTURED_VERTEX(e[2] + ts, e[3] - tc, r, g, b, a);
+
+                SET_INDEXED_VERTEX(1);
+                SET_INDEXED_VERTEX(2);
+                SET_UNTEXTURED_VERTEX(e[2] - ts, e[3] + tc, r, g, b, a);
+            }
+        }
+    }
+}
+
+static void TrisFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_tris, float* vertices, SDL_Color* colors, SDL_Color color)
+{
+    unsigned int i, chunk_end;
+
+    if(num_tris == 0 || vertices == NULL)
+        return;
+
+    {
+        BEGIN_UNTEXTURED_BULK("GPU_TrisFilled", GL_TRIANGLES);
+
+        for(i = 0; i < num_tris; )
+        {
+            BEGIN_BULK_CHUNK(chunk_end, i, num_tris - i, 3, 3);
+
+            for(; i < chunk_end; i++)
+            {
+                float* v = vertices + 6*i;
+
+                if(colors != NULL)
+                {
+                    SET_BULK_COLOR(colors[i]);
+                }
+
+                SET_UNTEXTURED_VERTEX(v[0], v[1], r, g, b, a);
+                SET_UNTEXTURED_VERTEX(v[2], v[3], r, g, b, a);
+                SET_UNTEXTURED_VERTEX(v[4], v[5], r, g, b, a);
+            }
+        }
+    }
+}
+
+static void RectanglesFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_rects, GPU_Rect* rects, SDL_Color* colors, SDL_Color color)
+{
+    unsigned int i, chunk_end;
+
+    if(num_rects == 0 || rects == NULL)
+        return;
+
+    {
+        BEGIN_UNTEXTURED_BULK("GPU_RectanglesFilled", GL_TRIANGLES);
+
+        for(i = 0; i < num_rects; )
+        {
+            BEGIN_BULK_CHUNK(chunk_end, i, num_rects - i, 4, 6);
+
+            for(; i < chunk_end; i++)
+            {
+                float x1 = rects[i].x;
+                float y1 = rects[i].y;
+                float x2 = rects[i].x + rects[i].w;
+                float y2 = rects[i].y + rects[i].h;
+
+                if(colors != NULL)
+                {
+                    SET_BULK_COLOR(colors[i]);
+                }
+
+                blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+                SET_UNTEXTURED_VERTEX(x1, y1, r, g, b, a);
+                SET_UNTEXTURED_VERTEX(x1, y2, r, g, b, a);
+                SET_UNTEXTURED_VERTEX(x2, y1, r, g, b, a);
+
+                SET_INDEXED_VERTEX(1);
+                SET_INDEXED_VERTEX(2);
+                SET_UNTEXTURED_VERTEX(x2, y2, r, g, b, a);
+            }
+        }
+    }
+}
+
+static void CirclesFilled(GPU_Renderer* renderer, GPU_Target* target, unsigned int num_circles, float* circles, SDL_Color* colors, SDL_Color color)
+{
+    unsigned int i, chunk_end;
+    float last_radius = -1.0f;
+    float c = 1.0f, s = 0.0f;
+    int numSegments = 0;
+
+    if(num_circles == 0 || circles == NULL)
+        return;
+
+    {
+        BEGIN_UNTEXTURED_BULK("GPU_CirclesFilled", GL_TRIANGLES);
+
+        for(i = 0; i < num_circles; )
+        {
+            float x = circles[3*i];
+            float y = circles[3*i+1];
+            float radius = circles[3*i+2];
+            float dx, dy, tempx;
+            int j;
+
+            if(radius <= 0.0f)
+            {
+                i++;
+                continue;
+            }
+
+            // Same tessellation as CircleFilled(), only recomputed when the radius changes
+            if(radius != last_radius)
+            {
+                float dt = (1.25f/sqrtf(radius));
+                numSegments = (int)(2*PI/dt)+1;
+                if(numSegments + 1 > GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES)
+                    numSegments = GPU_BLIT_BUFFER_ABSOLUTE_MAX_VERTICES - 1;
+                c = cosf(dt);
+                s = sinf(dt);
+                last_radius = radius;
+            }
+
+            if(numSegments < 3)
+            {
+                i++;
+                continue;
+            }
+
+            BEGIN_BULK_CHUNK(chunk_end, i, 1, 3 + (numSegments-2), 3 + (numSegments-2)*3 + 3);
+            if(chunk_end == i)
+            {
+                i++;
+                continue;
+            }
+
+            if(colors != NULL)
+            {
+                SET_BULK_COLOR(colors[i]);
+            }
+
+            blit_buffer_starting_index = cdata->blit_buffer_num_vertices;
+
+            // First triangle
+            SET_UNTEXTURED_VERTEX(x, y, r, g, b, a);  // Center
+
+            dx = 1.0f;
+            dy = 0.0f;
+            SET_UNTEXTURED_VERTEX(x+radius*dx, y+radius*dy, r, g, b, a); // first point
+
+            tempx = c * dx - s * dy;
+            dy = s * dx + c * dy;
+            dx = tempx;
+            SET_UNTEXTURED_VERTEX(x+radius*dx, y+radius*dy, r, g, b, a); // new point
+
+            for(j = 2; j < numSegments; j++)
+            {
+                tempx = c * dx - s * dy;
+                dy = s * dx + c * dy;
+                dx = tempx;
+                SET_INDEXED_VERTEX(0);  // center
+                SET_INDEXED_VERTEX(j);  // last point
+                SET_UNTEXTURED_VERTEX(x+radius*dx, y+radius*dy, r, g, b, a); // new point
+            }
+
+            SET_INDEXED_VERTEX(0);  // center
+            SET_INDEXED_VERTEX(j);  // last point
+            SET_INDEXED_VERTEX(1);  // first point
+
+            i++;
+        }
+    }
+}
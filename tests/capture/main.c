@@ -0,0 +1,116 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <math.h>
+
+// Records the screen while it animates.  Press 1 for a Y4M video, 2 for numbered QOI frames or 3 for numbered PNG frames, then press the same key to stop.
+// Press W to toggle between dropping frames and waiting for the encoders.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image;
+        GPU_Capture* capture = NULL;
+        GPU_CapturePolicyEnum policy = GPU_CAPTURE_DROP_FRAMES;
+        float angle;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_w)
+                    {
+                        policy = (policy == GPU_CAPTURE_DROP_FRAMES? GPU_CAPTURE_WAIT : GPU_CAPTURE_DROP_FRAMES);
+                        GPU_SetCaptureOptions(policy, 8, 0, 60);
+                        GPU_LogError("New captures will %s\n", (policy == GPU_CAPTURE_WAIT? "wait for the encoders" : "drop frames"));
+                    }
+                    else if(event.key.keysym.sym == SDLK_1 || event.key.keysym.sym == SDLK_2 || event.key.keysym.sym == SDLK_3)
+                    {
+                        if(capture != NULL)
+                        {
+                            int written, dropped;
+                            GPU_GetCaptureFrameCounts(capture, &written, &dropped);
+                            GPU_StopCapture(capture);
+                            capture = NULL;
+                            GPU_LogError("Capture stopped: %d frames written so far, %d dropped\n", written, dropped);
+                        }
+                        else
+                        {
+                            if(event.key.keysym.sym == SDLK_1)
+                            {
+                                capture = GPU_StartCapture(screen, GPU_CAPTURE_Y4M, "capture.y4m");
+                            }
+                            else if(event.key.keysym.sym == SDLK_2)
+                            {
+                                capture = GPU_StartCapture(screen, GPU_CAPTURE_QOI, "capture%05d.qoi");
+                            }
+                            else
+                            {
+                                capture = GPU_StartCapture(screen, GPU_CAPTURE_PNG, "capture%05d.png");
+                            }
+                            if(capture != NULL)
+                                GPU_LogError("Capture started\n");
+                        }
+                    }
+                }
+            }
+
+            angle = SDL_GetTicks()/10.0f;
+
+            GPU_Clear(screen);
+            GPU_BlitRotate(image, NULL, screen, screen->w/2.0f, screen->h/2.0f, angle);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+            {
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+                if(capture != NULL)
+                {
+                    int written, dropped;
+                    GPU_GetCaptureFrameCounts(capture, &written, &dropped);
+                    printf("Captured frames: %d written, %d dropped\n", written, dropped);
+                }
+            }
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_StopCapture(capture);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,86 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include "compat.h"
+#include <math.h>
+
+// Draws the same picture from a BMP, a BC1 DDS and an ETC2 KTX file, shrinking and growing to show the prebuilt mipmaps.
+// Formats that the renderer lacks are decoded on the CPU, which this test reports at startup.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* images[3];
+        const char* names[3] = {"data/test.bmp", "data/test_bc1.dds", "data/test_etc2.ktx"};
+        float scale;
+        int i;
+
+        GPU_LogError("S3TC: %s, ETC2: %s, ASTC: %s\n",
+                     (GPU_IsFeatureEnabled(GPU_FEATURE_TEXTURE_COMPRESSION_S3TC)? "yes" : "no (CPU decoded)"),
+                     (GPU_IsFeatureEnabled(GPU_FEATURE_TEXTURE_COMPRESSION_ETC2)? "yes" : "no (CPU decoded)"),
+                     (GPU_IsFeatureEnabled(GPU_FEATURE_TEXTURE_COMPRESSION_ASTC)? "yes" : "no"));
+
+        for(i = 0; i < 3; i++)
+        {
+            images[i] = GPU_LoadImage(names[i]);
+            if(images[i] == NULL)
+                return -1;
+            GPU_LogError("%s: format %d, %s\n", names[i], images[i]->format, (images[i]->has_mipmaps? "mipmapped" : "no mipmaps"));
+        }
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            scale = 0.55f + 0.45f*sin(SDL_GetTicks()/1000.0f);
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < 3; i++)
+                GPU_BlitScale(images[i], NULL, screen, screen->w*(i + 1)/4.0f, screen->h/2.0f, scale, scale);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < 3; i++)
+            GPU_FreeImage(images[i]);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
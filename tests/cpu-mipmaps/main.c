@@ -0,0 +1,89 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <math.h>
+
+// Shrinks the same picture with mipmaps from the GPU (left) and from the CPU with the box, Kaiser and Lanczos filters.
+// The CPU chains are filtered in linear light, so fine detail fades to its true brightness instead of darkening.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* images[4];
+        const GPU_MipmapFilterEnum filters[3] = {GPU_MIPMAP_FILTER_BOX, GPU_MIPMAP_FILTER_KAISER, GPU_MIPMAP_FILTER_LANCZOS};
+        Uint32 load_time;
+        float scale;
+        int i;
+
+        images[0] = GPU_LoadImage("data/test.bmp");
+        if(images[0] == NULL)
+            return -1;
+        GPU_GenerateMipmaps(images[0]);
+
+        for(i = 0; i < 3; i++)
+        {
+            GPU_SetMipmapsOnLoad(GPU_TRUE, filters[i]);
+            load_time = SDL_GetTicks();
+            images[i + 1] = GPU_LoadImage("data/test.bmp");
+            if(images[i + 1] == NULL)
+                return -1;
+            GPU_LogError("Filter %d: loaded in %u ms, %s\n", filters[i], SDL_GetTicks() - load_time, (images[i + 1]->has_mipmaps? "mipmapped" : "no mipmaps"));
+        }
+        GPU_SetMipmapsOnLoad(GPU_FALSE, GPU_MIPMAP_FILTER_BOX);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            scale = 0.15f + 0.1f*sin(SDL_GetTicks()/1000.0f);
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < 4; i++)
+                GPU_BlitScale(images[i], NULL, screen, screen->w*(i + 0.5f)/4.0f, screen->h/2.0f, scale, scale);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < 4; i++)
+            GPU_FreeImage(images[i]);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
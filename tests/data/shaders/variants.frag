@@ -0,0 +1,25 @@
+varying vec4 color;
+varying vec2 texCoord;
+
+uniform sampler2D tex;
+
+#ifndef TINT_COLOR
+#define TINT_COLOR vec3(1.0, 0.6, 0.3)
+#endif
+
+#include "data/shaders/luma.glsl"
+
+void main(void)
+{
+    vec4 texel = texture2D(tex, texCoord) * color;
+#ifdef GRAYSCALE
+    texel.rgb = vec3(luma(texel.rgb));
+#endif
+#ifdef INVERT
+    texel.rgb = vec3(1.0) - texel.rgb;
+#endif
+#ifdef TINT
+    texel.rgb *= TINT_COLOR;
+#endif
+    gl_FragColor = texel;
+}
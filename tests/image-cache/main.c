@@ -0,0 +1,93 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Loads one file under different spellings through the image cache and checks that they share a single image.
+// Press space to release the extra references and purge the cache, then reload.
+
+#define NUM_NAMES 3
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        const char* names[NUM_NAMES] = {"data/test.bmp", "./data/test.bmp", "data/../data//test.bmp"};
+        GPU_Image* images[NUM_NAMES];
+        int i;
+
+        for(i = 0; i < NUM_NAMES; i++)
+        {
+            images[i] = GPU_LoadImageCached(names[i]);
+            if(images[i] == NULL)
+                return -1;
+        }
+
+        GPU_LogError("Shared: %s, refcount: %d (one per request plus the cache)\n", (images[0] == images[1] && images[1] == images[2]? "yes" : "no"), images[0]->refcount);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        Uint32 frame = GPU_GetFrameCount();
+
+                        for(i = 1; i < NUM_NAMES; i++)
+                            GPU_FreeImage(images[i]);
+                        GPU_LogError("Held images unused since frame %u: %d\n", frame, GPU_GetCachedImagesUnusedSince(frame, NULL, 0));
+
+                        GPU_FreeImage(images[0]);
+                        GPU_LogError("Purged %d image(s)\n", GPU_PurgeImageCache());
+
+                        for(i = 0; i < NUM_NAMES; i++)
+                            images[i] = GPU_LoadImageCached(names[i]);
+                    }
+                }
+            }
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < NUM_NAMES; i++)
+                GPU_BlitScale(images[i], NULL, screen, screen->w*(i + 1)/4.0f, screen->h/2.0f, 0.5f, 0.5f);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < NUM_NAMES; i++)
+            GPU_FreeImage(images[i]);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
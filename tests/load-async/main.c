@@ -0,0 +1,145 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include "compat.h"
+#include <math.h>
+
+// Loads a batch of images with GPU_LoadImageAsync() while the frame keeps animating.
+// SPACE reloads the batch, 's' compares against loading the same files with GPU_LoadImage().
+
+#define NUM_IMAGES 64
+
+static const char* filenames[] = {"data/test.bmp", "data/test2.png", "data/test3.png", "data/big_test.png", "data/test4.bmp", "data/small_test.png"};
+#define NUM_FILENAMES (sizeof(filenames)/sizeof(filenames[0]))
+
+static GPU_Image* images[NUM_IMAGES];
+static int num_loaded = 0;
+
+static void SDLCALL on_image_loaded(GPU_Image* image, const char* filename, void* userdata)
+{
+    int index = (int)(intptr_t)userdata;
+    if(image == NULL)
+        GPU_LogError("Failed to load %s\n", filename);
+
+    GPU_FreeImage(images[index]);
+    images[index] = image;
+    num_loaded++;
+}
+
+static void free_images(void)
+{
+    int i;
+    for(i = 0; i < NUM_IMAGES; i++)
+    {
+        GPU_FreeImage(images[i]);
+        images[i] = NULL;
+    }
+    num_loaded = 0;
+}
+
+static void start_loading(GPU_bool use_async)
+{
+    int i;
+    Uint32 start = SDL_GetTicks();
+
+    free_images();
+    for(i = 0; i < NUM_IMAGES; i++)
+    {
+        if(use_async)
+            GPU_LoadImageAsync(filenames[i % NUM_FILENAMES], &on_image_loaded, (void*)(intptr_t)i);
+        else
+            on_image_loaded(GPU_LoadImage(filenames[i % NUM_FILENAMES]), filenames[i % NUM_FILENAMES], (void*)(intptr_t)i);
+    }
+
+    GPU_LogError("%s blocked for %u ms\n", (use_async? "GPU_LoadImageAsync()" : "GPU_LoadImage()"), SDL_GetTicks() - start);
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_bool use_async = GPU_TRUE;
+        Uint32 load_start;
+        GPU_bool reported;
+        float angle = 0.0f;
+        int i;
+
+        start_loading(use_async);
+        load_start = SDL_GetTicks();
+        reported = GPU_FALSE;
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE || event.key.keysym.sym == SDLK_s)
+                    {
+                        if(event.key.keysym.sym == SDLK_s)
+                            use_async = !use_async;
+                        start_loading(use_async);
+                        load_start = SDL_GetTicks();
+                        reported = GPU_FALSE;
+                    }
+                }
+            }
+
+            if(!reported && num_loaded == NUM_IMAGES)
+            {
+                GPU_LogError("All %d images ready after %u ms\n", NUM_IMAGES, SDL_GetTicks() - load_start);
+                reported = GPU_TRUE;
+            }
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < NUM_IMAGES; i++)
+            {
+                GPU_Rect dest = GPU_MakeRect((i%8)*100.0f, (i/8)*75.0f, 100.0f, 75.0f);
+                if(images[i] != NULL)
+                    GPU_BlitRect(images[i], NULL, screen, &dest);
+            }
+
+            // Something moving, to show stalls
+            angle += 2.0f;
+            GPU_RectangleFilled(screen, 400 - 20, 300 - 20, 400 + 20, 300 + 20, GPU_MakeColor(255, 255, 255, 255));
+            GPU_CircleFilled(screen, 400 + 200*cosf(angle*3.14159f/180), 300 + 200*sinf(angle*3.14159f/180), 15, GPU_MakeColor(255, 0, 0, 255));
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free_images();
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,145 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include "compat.h"
+#include <stdlib.h>
+
+// Streams a generated pattern into an image every frame.
+// 'l' toggles between GPU_LockImageRegion() and GPU_UpdateImageBytes(), 'r' toggles updating only a sub-region.
+// 's' toggles between a regular image and one from GPU_CreateStreamingImage().
+
+#define IMAGE_W 1024
+#define IMAGE_H 1024
+
+static void fill_pattern(unsigned char* pixels, int pitch, int w, int h, int offset_x, int offset_y, Uint32 time)
+{
+    int x, y;
+    for(y = 0; y < h; y++)
+    {
+        unsigned char* row = pixels + y*pitch;
+        for(x = 0; x < w; x++)
+        {
+            row[4*x] = (unsigned char)(x + offset_x + time/4);
+            row[4*x+1] = (unsigned char)(y + offset_y + time/8);
+            row[4*x+2] = (unsigned char)((x + offset_x) ^ (y + offset_y));
+            row[4*x+3] = 255;
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* regular_image;
+        GPU_Image* streaming_image;
+        GPU_Image* image;
+        unsigned char* bytes;
+        GPU_bool use_lock;
+        GPU_bool use_region;
+        GPU_Rect region;
+
+        regular_image = GPU_CreateImage(IMAGE_W, IMAGE_H, GPU_FORMAT_RGBA);
+        streaming_image = GPU_CreateStreamingImage(IMAGE_W, IMAGE_H, GPU_FORMAT_RGBA);
+        if(regular_image == NULL || streaming_image == NULL)
+            return -1;
+        image = regular_image;
+
+        bytes = (unsigned char*)malloc(IMAGE_W*IMAGE_H*4);
+
+        use_lock = GPU_TRUE;
+        use_region = GPU_FALSE;
+        region = GPU_MakeRect(IMAGE_W/4, IMAGE_H/4, IMAGE_W/2, IMAGE_H/2);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_l)
+                    {
+                        use_lock = !use_lock;
+                        GPU_LogError("Using %s\n", (use_lock? "GPU_LockImageRegion()" : "GPU_UpdateImageBytes()"));
+                    }
+                    else if(event.key.keysym.sym == SDLK_r)
+                        use_region = !use_region;
+                    else if(event.key.keysym.sym == SDLK_s)
+                    {
+                        image = (image == regular_image? streaming_image : regular_image);
+                        GPU_LogError("Using %s image\n", (image == streaming_image? "streaming" : "regular"));
+                    }
+
+                    startTime = SDL_GetTicks();
+                    frameCount = 0;
+                }
+            }
+
+            {
+                GPU_Rect* rect = (use_region? &region : NULL);
+                int w = (use_region? (int)region.w : IMAGE_W);
+                int h = (use_region? (int)region.h : IMAGE_H);
+                int offset_x = (use_region? (int)region.x : 0);
+                int offset_y = (use_region? (int)region.y : 0);
+
+                if(use_lock)
+                {
+                    void* pixels;
+                    int pitch;
+                    if(GPU_LockImageRegion(image, rect, &pixels, &pitch))
+                    {
+                        fill_pattern((unsigned char*)pixels, pitch, w, h, offset_x, offset_y, SDL_GetTicks());
+                        GPU_UnlockImageRegion(image);
+                    }
+                }
+                else
+                {
+                    fill_pattern(bytes, w*4, w, h, offset_x, offset_y, SDL_GetTicks());
+                    GPU_UpdateImageBytes(image, rect, bytes, w*4);
+                }
+            }
+
+            GPU_Clear(screen);
+
+            GPU_BlitRect(image, NULL, screen, NULL);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free(bytes);
+        GPU_FreeImage(regular_image);
+        GPU_FreeImage(streaming_image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
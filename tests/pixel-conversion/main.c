@@ -0,0 +1,134 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Uploads surfaces in every 24 and 32-bit channel order and reads them back, checking every pixel.
+// The widths cover the scalar tails of the vectorized conversion kernels as well as whole vectors.
+
+typedef struct SurfaceFormat
+{
+    const char* name;
+    int bits;
+    Uint32 Rmask, Gmask, Bmask, Amask;
+} SurfaceFormat;
+
+static const SurfaceFormat formats[] = {
+    {"RGB24", 24, 0x0000FF, 0x00FF00, 0xFF0000, 0},
+    {"BGR24", 24, 0xFF0000, 0x00FF00, 0x0000FF, 0},
+    {"RGBA32", 32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000},
+    {"BGRA32", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000},
+    {"ABGR32", 32, 0xFF000000, 0x00FF0000, 0x0000FF00, 0x000000FF},
+    {"ARGB32", 32, 0x0000FF00, 0x00FF0000, 0xFF000000, 0x000000FF},
+    {"XRGB32", 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0}
+};
+
+static void putPixel(SDL_Surface* surface, int x, int y, Uint32 value)
+{
+    Uint8* p = (Uint8*)surface->pixels + y*surface->pitch + x*surface->format->BytesPerPixel;
+    int i;
+    for(i = 0; i < surface->format->BytesPerPixel; ++i)
+    {
+        #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        p[i] = (Uint8)(value >> (8*(surface->format->BytesPerPixel - 1 - i)));
+        #else
+        p[i] = (Uint8)(value >> (8*i));
+        #endif
+    }
+}
+
+static Uint32 getPixel(SDL_Surface* surface, int x, int y)
+{
+    Uint8* p = (Uint8*)surface->pixels + y*surface->pitch + x*surface->format->BytesPerPixel;
+    Uint32 value = 0;
+    int i;
+    for(i = 0; i < surface->format->BytesPerPixel; ++i)
+    {
+        #if SDL_BYTEORDER == SDL_BIG_ENDIAN
+        value = (value << 8) | p[i];
+        #else
+        value |= (Uint32)p[i] << (8*i);
+        #endif
+    }
+    return value;
+}
+
+// Returns the number of mismatched pixels
+static int testFormat(const SurfaceFormat* format, int w, int h)
+{
+    SDL_Surface* surface;
+    SDL_Surface* result;
+    GPU_Image* image;
+    int x, y, errors = 0;
+
+    surface = SDL_CreateRGBSurface(SDL_SWSURFACE, w, h, format->bits, format->Rmask, format->Gmask, format->Bmask, format->Amask);
+    if(surface == NULL)
+        return w*h;
+
+    // Every value in every channel, in different combinations
+    for(y = 0; y < h; ++y)
+    {
+        for(x = 0; x < w; ++x)
+        {
+            int i = y*w + x;
+            putPixel(surface, x, y, SDL_MapRGBA(surface->format, (Uint8)i, (Uint8)(i*7 + y), (Uint8)(255 - i), (Uint8)(i*13 + 5)));
+        }
+    }
+
+    image = GPU_CopyImageFromSurface(surface);
+    result = (image != NULL? GPU_CopySurfaceFromImage(image) : NULL);
+    if(result == NULL)
+        errors = w*h;
+    else
+    {
+        for(y = 0; y < h; ++y)
+        {
+            for(x = 0; x < w; ++x)
+            {
+                Uint8 r1, g1, b1, a1, r2, g2, b2, a2;
+                SDL_GetRGBA(getPixel(surface, x, y), surface->format, &r1, &g1, &b1, &a1);
+                SDL_GetRGBA(getPixel(result, x, y), result->format, &r2, &g2, &b2, &a2);
+                if(r1 != r2 || g1 != g2 || b1 != b2 || a1 != a2)
+                    errors++;
+            }
+        }
+    }
+
+    SDL_FreeSurface(result);
+    GPU_FreeImage(image);
+    SDL_FreeSurface(surface);
+    return errors;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+	int failures = 0;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+        int f, w;
+
+        for(f = 0; f < (int)(sizeof(formats)/sizeof(SurfaceFormat)); ++f)
+        {
+            int errors = 0;
+            for(w = 1; w <= 67; ++w)
+                errors += testFormat(&formats[f], w, 3);
+            errors += testFormat(&formats[f], 256, 256);
+
+            GPU_LogError("%s: %s (%d mismatched pixels)\n", formats[f].name, (errors == 0? "passed" : "FAILED"), errors);
+            if(errors > 0)
+                failures++;
+        }
+	}
+
+	GPU_Quit();
+
+	return (failures > 0? 1 : 0);
+}
@@ -0,0 +1,272 @@
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// The kernels are private to the library, so its pixel code is compiled in here
+#include "../../src/SDL_gpu_pixels.c"
+
+// Checks each vectorized pixel kernel against the scalar code without a window or renderer.
+// Conversions run every byte order at widths 1 to 67, so every vector tail is covered.  Alpha premultiplication and
+// unpremultiplication run every (color, alpha) pair at the same widths.
+
+#define MAX_WIDTH 67
+#define GUARD_BYTES 32
+#define NUM_ALPHA_PIXELS 65536
+
+typedef int (*ConvertFunction)(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels);
+typedef int (*AlphaFunction)(unsigned char* pixels, int num_pixels);
+
+typedef struct ConvertKernel
+{
+    const char* name;
+    int src_bpp, dst_bpp;  // 0 for any
+    ConvertFunction convert;
+} ConvertKernel;
+
+typedef struct AlphaKernel
+{
+    const char* name;
+    GPU_bool premultiply;
+    AlphaFunction run;
+} AlphaKernel;
+
+
+// Each wrapper returns the number of pixels it converted, like the kernels do.  The scalar code finishes the rest.
+static int convert_dispatch(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    gpu_convert_pixels(dst, num_pixels*dst_bpp, dst_bpp, src, num_pixels*src_bpp, src_bpp, order, num_pixels, 1);
+    return num_pixels;
+}
+
+#ifdef GPU_PIXELS_SSE2
+static int convert_permute4_sse2(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    (void)dst_bpp;
+    (void)src_bpp;
+    return permute4_sse2(dst, src, order, num_pixels);
+}
+#endif
+
+#ifdef GPU_PIXELS_AVX2
+static int convert_permute4_avx2(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    (void)dst_bpp;
+    (void)src_bpp;
+    return permute4_avx2(dst, src, order, num_pixels);
+}
+
+static int convert_expand3_avx2(unsigned char* dst, int dst_bpp, const unsigned char* src, int src_bpp, const Uint8* order, int num_pixels)
+{
+    (void)dst_bpp;
+    (void)src_bpp;
+    return expand3_avx2(dst, src, order, num_pixels);
+}
+#endif
+
+static int premultiply_dispatch(unsigned char* pixels, int num_pixels)
+{
+    gpu_premultiply_alpha(pixels, 4*num_pixels, num_pixels, 1);
+    return num_pixels;
+}
+
+static int unpremultiply_dispatch(unsigned char* pixels, int num_pixels)
+{
+    gpu_unpremultiply_alpha(pixels, 4*num_pixels, num_pixels, 1);
+    return num_pixels;
+}
+
+static const ConvertKernel convert_kernels[] = {
+    {"gpu_convert_pixels", 0, 0, &convert_dispatch},
+    #ifdef GPU_PIXELS_SSE2
+    {"permute4_sse2", 4, 4, &convert_permute4_sse2},
+    #endif
+    #ifdef GPU_PIXELS_AVX2
+    {"permute4_avx2", 4, 4, &convert_permute4_avx2},
+    {"expand3_avx2", 3, 4, &convert_expand3_avx2},
+    #endif
+    #ifdef GPU_PIXELS_NEON
+    {"convert_neon", 0, 0, &convert_neon},
+    #endif
+};
+
+static const AlphaKernel alpha_kernels[] = {
+    {"gpu_premultiply_alpha", GPU_TRUE, &premultiply_dispatch},
+    {"gpu_unpremultiply_alpha", GPU_FALSE, &unpremultiply_dispatch},
+    #ifdef GPU_PIXELS_SSE2
+    {"premultiply_sse2", GPU_TRUE, &premultiply_sse2},
+    {"unpremultiply_sse2", GPU_FALSE, &unpremultiply_sse2},
+    #endif
+    #ifdef GPU_PIXELS_NEON
+    {"premultiply_neon", GPU_TRUE, &premultiply_neon},
+    #endif
+};
+
+
+static GPU_bool isKernelSupported(const char* name)
+{
+    #ifdef GPU_PIXELS_AVX2
+    if(strstr(name, "avx2") != NULL)
+        return gpu_has_avx2();
+    #endif
+    (void)name;
+    return GPU_TRUE;
+}
+
+// Returns the number of mismatched (order, width) cases
+static int testConvertKernel(const ConvertKernel* kernel, int src_bpp, int dst_bpp)
+{
+    unsigned char src[MAX_WIDTH*4 + GUARD_BYTES];
+    unsigned char expected[MAX_WIDTH*4 + GUARD_BYTES];
+    unsigned char actual[MAX_WIDTH*4 + GUARD_BYTES];
+    Uint8 order[4];
+    int num_choices = src_bpp + 1;  // Each source byte or opaque
+    int num_orders = 1;
+    int i, k, n, w, errors = 0;
+
+    for(i = 0; i < (int)sizeof(src); ++i)
+        src[i] = (unsigned char)(rand() & 0xFF);
+
+    for(k = 0; k < dst_bpp; ++k)
+        num_orders *= num_choices;
+
+    for(n = 0; n < num_orders; ++n)
+    {
+        int c = n;
+        for(k = 0; k < dst_bpp; ++k)
+        {
+            order[k] = (Uint8)(c % num_choices == src_bpp? GPU_PIXEL_OPAQUE : c % num_choices);
+            c /= num_choices;
+        }
+
+        for(w = 1; w <= MAX_WIDTH; ++w)
+        {
+            int done;
+
+            // The guard bytes catch writes past the end
+            memset(expected, 0xCD, sizeof(expected));
+            memset(actual, 0xCD, sizeof(actual));
+            convert_pixels_scalar(expected, dst_bpp, src, src_bpp, order, w);
+
+            done = kernel->convert(actual, dst_bpp, src, src_bpp, order, w);
+            if(done < 0 || done > w)
+            {
+                errors++;
+                continue;
+            }
+            convert_pixels_scalar(actual + dst_bpp*done, dst_bpp, src + src_bpp*done, src_bpp, order, w - done);
+
+            if(memcmp(expected, actual, sizeof(actual)) != 0)
+                errors++;
+        }
+    }
+
+    return errors;
+}
+
+// Returns the number of mismatched widths
+static int testAlphaKernel(const AlphaKernel* kernel)
+{
+    unsigned char* original = (unsigned char*)malloc(4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+    unsigned char* expected = (unsigned char*)malloc(4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+    unsigned char* actual = (unsigned char*)malloc(4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+    int i, w, errors = 0;
+
+    if(original == NULL || expected == NULL || actual == NULL)
+    {
+        free(original);
+        free(expected);
+        free(actual);
+        return 1;
+    }
+
+    // Every color with every alpha, differently in each channel
+    memset(original, 0xCD, 4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+    for(i = 0; i < NUM_ALPHA_PIXELS; ++i)
+    {
+        Uint8 color = (Uint8)(i & 0xFF);
+        original[4*i] = color;
+        original[4*i + 1] = (Uint8)(255 - color);
+        original[4*i + 2] = (Uint8)(color ^ 0xA5);
+        original[4*i + 3] = (Uint8)(i >> 8);
+    }
+
+    memcpy(expected, original, 4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+    if(kernel->premultiply)
+        premultiply_scalar(expected, NUM_ALPHA_PIXELS);
+    else
+        unpremultiply_scalar(expected, NUM_ALPHA_PIXELS);
+
+    // Cover the whole buffer in spans of each width
+    for(w = 1; w <= MAX_WIDTH; ++w)
+    {
+        int start;
+
+        memcpy(actual, original, 4*NUM_ALPHA_PIXELS + GUARD_BYTES);
+        for(start = 0; start < NUM_ALPHA_PIXELS; start += w)
+        {
+            int n = (NUM_ALPHA_PIXELS - start < w? NUM_ALPHA_PIXELS - start : w);
+            int done = kernel->run(actual + 4*start, n);
+            if(done < 0 || done > n)
+                break;
+            if(kernel->premultiply)
+                premultiply_scalar(actual + 4*(start + done), n - done);
+            else
+                unpremultiply_scalar(actual + 4*(start + done), n - done);
+        }
+
+        if(start < NUM_ALPHA_PIXELS || memcmp(expected, actual, 4*NUM_ALPHA_PIXELS + GUARD_BYTES) != 0)
+            errors++;
+    }
+
+    free(original);
+    free(expected);
+    free(actual);
+    return errors;
+}
+
+int main(int argc, char* argv[])
+{
+    int failures = 0;
+    int i, src_bpp, dst_bpp;
+
+    (void)argc;
+    (void)argv;
+
+    srand(12345);
+
+    for(i = 0; i < (int)(sizeof(convert_kernels)/sizeof(ConvertKernel)); ++i)
+    {
+        const ConvertKernel* kernel = &convert_kernels[i];
+        if(!isKernelSupported(kernel->name))
+        {
+            printf("%s: skipped (not supported by this CPU)\n", kernel->name);
+            continue;
+        }
+
+        for(src_bpp = 3; src_bpp <= 4; ++src_bpp)
+        {
+            for(dst_bpp = 3; dst_bpp <= 4; ++dst_bpp)
+            {
+                int errors;
+                if((kernel->src_bpp != 0 && kernel->src_bpp != src_bpp) || (kernel->dst_bpp != 0 && kernel->dst_bpp != dst_bpp))
+                    continue;
+
+                errors = testConvertKernel(kernel, src_bpp, dst_bpp);
+                printf("%s (%d -> %d bytes): %s (%d mismatched cases)\n", kernel->name, src_bpp, dst_bpp, (errors == 0? "passed" : "FAILED"), errors);
+                if(errors > 0)
+                    failures++;
+            }
+        }
+    }
+
+    for(i = 0; i < (int)(sizeof(alpha_kernels)/sizeof(AlphaKernel)); ++i)
+    {
+        int errors = testAlphaKernel(&alpha_kernels[i]);
+        printf("%s: %s (%d mismatched widths)\n", alpha_kernels[i].name, (errors == 0? "passed" : "FAILED"), errors);
+        if(errors > 0)
+            failures++;
+    }
+
+    return (failures > 0? 1 : 0);
+}
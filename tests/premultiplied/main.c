@@ -0,0 +1,86 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include "compat.h"
+#include <math.h>
+
+// Draws a sprite loaded with straight alpha (left) and premultiplied alpha (right), magnified with linear filtering over a bright background.
+// The straight version shows dark fringes where transparent texels blend into the edges.  Both fade in and out through their modulation color.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* straight;
+        GPU_Image* premultiplied;
+        SDL_Color color = {255, 255, 255, 255};
+        float t;
+
+        straight = GPU_LoadImage("data/test3.png");
+        GPU_SetPremultiplyOnLoad(GPU_TRUE);
+        premultiplied = GPU_LoadImage("data/test3.png");
+        GPU_SetPremultiplyOnLoad(GPU_FALSE);
+        if(straight == NULL || premultiplied == NULL)
+            return -1;
+
+        GPU_LogError("Second image is %s\n", (premultiplied->has_premultiplied_alpha? "premultiplied" : "not premultiplied"));
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            t = SDL_GetTicks()/1000.0f;
+            color.g = (Uint8)(191 + 64*sin(t*0.7f));
+            GET_ALPHA(color) = (Uint8)(127 + 128*sin(t));
+            GPU_SetColor(straight, color);
+            GPU_SetColor(premultiplied, color);
+
+            GPU_ClearRGB(screen, 255, 240, 200);
+
+            GPU_BlitScale(straight, NULL, screen, screen->w/4.0f, screen->h/2.0f, 3.0f, 3.0f);
+            GPU_BlitScale(premultiplied, NULL, screen, screen->w*3/4.0f, screen->h/2.0f, 3.0f, 3.0f);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_FreeImage(premultiplied);
+        GPU_FreeImage(straight);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
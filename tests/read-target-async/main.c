@@ -0,0 +1,96 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <math.h>
+
+// Reads the screen back without stalling, reporting how many frames each read took to arrive.
+// Press space to save the next result to screenshot.png.
+
+static long frameCount = 0;
+static GPU_bool saveNext = GPU_FALSE;
+
+static void SDLCALL onRead(GPU_Target* target, SDL_Surface* surface, void* userdata)
+{
+    long requestFrame = (long)(intptr_t)userdata;
+
+    if(surface == NULL)
+    {
+        GPU_LogError("Read from frame %ld failed\n", requestFrame);
+        return;
+    }
+
+    GPU_LogError("%dx%d read from frame %ld arrived %ld frame(s) later\n", surface->w, surface->h, requestFrame, frameCount - requestFrame);
+    if(saveNext)
+    {
+        GPU_SaveSurface(surface, "screenshot.png", GPU_FILE_AUTO);
+        saveNext = GPU_FALSE;
+    }
+    SDL_FreeSurface(surface);
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image;
+        float angle;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        startTime = SDL_GetTicks();
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                        saveNext = GPU_TRUE;
+                }
+            }
+
+            angle = SDL_GetTicks()/10.0f;
+
+            GPU_Clear(screen);
+            GPU_BlitRotate(image, NULL, screen, screen->w/2.0f, screen->h/2.0f, angle);
+
+            if(frameCount%60 == 0 || saveNext)
+                GPU_ReadTargetAsync(screen, NULL, &onRead, (void*)(intptr_t)frameCount);
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
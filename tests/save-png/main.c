@@ -0,0 +1,73 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Saves the screen as PNG at each compression level and filter setting, reporting the time and size of each file.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+        GPU_Image* image;
+        SDL_Surface* surface;
+        GPU_SaveOptions options;
+        char filename[64];
+        int level, threads;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        GPU_Clear(screen);
+        GPU_BlitScale(image, NULL, screen, screen->w/2.0f, screen->h/2.0f, 2.0f, 2.0f);
+        GPU_Flip(screen);
+
+        surface = GPU_CopySurfaceFromTarget(screen);
+        if(surface == NULL)
+            return -1;
+
+        options = GPU_GetSaveOptions();
+        for(threads = 1; threads >= 0; threads--)
+        {
+            for(level = 0; level <= 9; level += 3)
+            {
+                SDL_RWops* rwops;
+                Uint32 startTime;
+
+                options.compression_level = level;
+                options.filter = GPU_PNG_FILTER_ADAPTIVE;
+                options.num_threads = threads;
+                GPU_SetSaveOptions(options);
+
+                SDL_snprintf(filename, sizeof(filename), "save-level%d.png", level);
+                startTime = SDL_GetTicks();
+                if(!GPU_SaveSurface(surface, filename, GPU_FILE_AUTO))
+                {
+                    GPU_LogError("Failed to save %s\n", filename);
+                    continue;
+                }
+
+                rwops = SDL_RWFromFile(filename, "rb");
+                SDL_RWseek(rwops, 0, RW_SEEK_END);
+                GPU_LogError("Level %d, %s: %d ms, %d bytes\n", level, (threads == 0? "all cores" : "1 thread"), (int)(SDL_GetTicks() - startTime), (int)SDL_RWtell(rwops));
+                SDL_RWclose(rwops);
+            }
+        }
+
+        SDL_FreeSurface(surface);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
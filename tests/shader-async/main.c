@@ -0,0 +1,166 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Starts compiling and linking 16 tinted variants of one shader at once, then draws each variant as soon as GPU_GetShaderProgramStatus() reports it ready.
+// With GL_KHR_parallel_shader_compile, the driver builds them on its own threads while this keeps rendering.
+
+#define NUM_PROGRAMS 16
+
+static char* read_file(const char* filename)
+{
+    SDL_RWops* rwops;
+    char* source;
+    int file_size;
+
+    rwops = SDL_RWFromFile(filename, "rb");
+    if(rwops == NULL)
+        return NULL;
+    file_size = SDL_RWseek(rwops, 0, SEEK_END);
+    SDL_RWseek(rwops, 0, SEEK_SET);
+
+    source = (char*)malloc(file_size + 1);
+    SDL_RWread(rwops, source, 1, file_size);
+    source[file_size] = '\0';
+    SDL_RWclose(rwops);
+    return source;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Renderer* renderer = GPU_GetCurrentRenderer();
+        const char* header = "";
+        GPU_Image* image;
+        char* vertex_body;
+        char* fragment_body;
+        char* source;
+        Uint32 v;
+        Uint32 programs[NUM_PROGRAMS];
+        GPU_ShaderStatusEnum status[NUM_PROGRAMS];
+        GPU_ShaderBlock blocks[NUM_PROGRAMS];
+        int num_pending = NUM_PROGRAMS;
+        Uint32 compileStartTime;
+        int i;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        // Same version headers as load_shader()
+        if(renderer->shader_language == GPU_LANGUAGE_GLSL)
+            header = (renderer->max_shader_version >= 120? "#version 120\n" : "#version 110\n");
+        else if(renderer->shader_language == GPU_LANGUAGE_GLSLES)
+            header = "#version 100\nprecision mediump int;\nprecision mediump float;\n";
+
+        vertex_body = read_file("data/shaders/time_mod.vert");
+        fragment_body = read_file("data/shaders/variants.frag");
+        if(vertex_body == NULL || fragment_body == NULL)
+            return -1;
+        source = (char*)malloc(strlen(header) + strlen(vertex_body) + strlen(fragment_body) + 256);
+
+        compileStartTime = SDL_GetTicks();
+
+        // Issue every compile and link before asking about any of them
+        sprintf(source, "%s%s", header, vertex_body);
+        v = GPU_CompileShaderAsync(GPU_VERTEX_SHADER, source);
+        for(i = 0; i < NUM_PROGRAMS; i++)
+        {
+            Uint32 f;
+            sprintf(source, "%s#define TINT\n#define TINT_COLOR vec3(%.2f, %.2f, %.2f)\n%s", header,
+                    (i%4)/3.0f, (i/4)/3.0f, 1.0f - i/(float)NUM_PROGRAMS, fragment_body);
+            f = GPU_CompileShaderAsync(GPU_FRAGMENT_SHADER, source);
+
+            programs[i] = GPU_CreateShaderProgram();
+            GPU_AttachShader(programs[i], v);
+            GPU_AttachShader(programs[i], f);
+            GPU_LinkShaderProgramAsync(programs[i]);
+            GPU_FreeShader(f);
+            status[i] = GPU_SHADER_STATUS_PENDING;
+        }
+        GPU_FreeShader(v);
+        free(source);
+        free(vertex_body);
+        free(fragment_body);
+
+        GPU_LogError("Issued %d compiles and links in %u ms\n", NUM_PROGRAMS + 1, SDL_GetTicks() - compileStartTime);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            for(i = 0; i < NUM_PROGRAMS; i++)
+            {
+                if(status[i] != GPU_SHADER_STATUS_PENDING)
+                    continue;
+                status[i] = GPU_GetShaderProgramStatus(programs[i]);
+                if(status[i] == GPU_SHADER_STATUS_PENDING)
+                    continue;
+
+                if(status[i] == GPU_SHADER_STATUS_READY)
+                    blocks[i] = GPU_LoadShaderBlock(programs[i], "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+                else
+                    GPU_LogError("Program %d failed: %s\n", i, GPU_GetShaderMessage());
+
+                num_pending--;
+                if(num_pending == 0)
+                    GPU_LogError("All programs done after %u ms\n", SDL_GetTicks() - compileStartTime);
+            }
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < NUM_PROGRAMS; i++)
+            {
+                if(status[i] != GPU_SHADER_STATUS_READY)
+                    continue;
+                GPU_ActivateShaderProgram(programs[i], &blocks[i]);
+                GPU_BlitScale(image, NULL, screen, screen->w*(i%4 + 0.5f)/4.0f, screen->h*(i/4 + 0.5f)/4.0f, 0.25f, 0.25f);
+            }
+            GPU_DeactivateShaderProgram();
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < NUM_PROGRAMS; i++)
+            GPU_FreeShaderProgram(programs[i]);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,98 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Times GPU_Init() and a shader program build with the program binary cache in the current directory.
+// Run it twice: the second run should find every program in the cache and skip compiling.
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+	Uint32 init_time;
+
+	printRenderers();
+
+	GPU_SetShaderCacheDirectory(".");
+
+	init_time = SDL_GetTicks();
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+	init_time = SDL_GetTicks() - init_time;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image;
+        Uint32 v, f, p;
+        Uint32 build_time;
+        GPU_ShaderBlock block;
+        int timeloc;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        build_time = SDL_GetTicks();
+        v = load_shader(GPU_VERTEX_SHADER, "data/shaders/time_mod.vert");
+        f = load_shader(GPU_FRAGMENT_SHADER, "data/shaders/time_mod.frag");
+        p = GPU_LinkShaders(v, f);
+        build_time = SDL_GetTicks() - build_time;
+        if(p == 0)
+        {
+            GPU_LogError("Failed to build shader program: %s\n", GPU_GetShaderMessage());
+            return -1;
+        }
+
+        GPU_LogError("GPU_Init(): %u ms, shader program: %u ms\n", init_time, build_time);
+
+        block = GPU_LoadShaderBlock(p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+        GPU_ActivateShaderProgram(p, &block);
+        GPU_SetUniformi(GPU_GetUniformLocation(p, "tex"), 0);
+        timeloc = GPU_GetUniformLocation(p, "time");
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            GPU_SetUniformf(timeloc, SDL_GetTicks()/1000.0f);
+
+            GPU_Clear(screen);
+            GPU_Blit(image, NULL, screen, screen->w/2.0f, screen->h/2.0f);
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_FreeShader(v);
+        GPU_FreeShader(f);
+        GPU_FreeShaderProgram(p);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,137 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Builds three programs from one fragment shader file with GPU_CompileShaderWithDefines(): plain, grayscale and tinted.
+// The file #includes a helper, which is read from disk only once for all three.
+
+static char* read_source(const char* filename)
+{
+    SDL_RWops* rwops;
+    char* source;
+    int header_size, file_size;
+    const char* header = "";
+    GPU_Renderer* renderer = GPU_GetCurrentRenderer();
+
+    rwops = SDL_RWFromFile(filename, "rb");
+    if(rwops == NULL)
+        return NULL;
+    file_size = SDL_RWseek(rwops, 0, SEEK_END);
+    SDL_RWseek(rwops, 0, SEEK_SET);
+
+    // Same version headers as load_shader()
+    if(renderer->shader_language == GPU_LANGUAGE_GLSL)
+        header = (renderer->max_shader_version >= 120? "#version 120\n" : "#version 110\n");
+    else if(renderer->shader_language == GPU_LANGUAGE_GLSLES)
+        header = "#version 100\nprecision mediump int;\nprecision mediump float;\n";
+    header_size = strlen(header);
+
+    source = (char*)malloc(header_size + file_size + 1);
+    strcpy(source, header);
+    SDL_RWread(rwops, source + header_size, 1, file_size);
+    source[header_size + file_size] = '\0';
+    SDL_RWclose(rwops);
+    return source;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        const char* grayscale[1] = {"GRAYSCALE"};
+        const char* tinted[3] = {"GRAYSCALE", "TINT", "TINT_COLOR=vec3(0.3, 0.6, 1.0)"};
+        GPU_Image* image;
+        char* fragment_source;
+        Uint32 v;
+        Uint32 f[3];
+        Uint32 p[3];
+        GPU_ShaderBlock blocks[3];
+        int i;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        fragment_source = read_source("data/shaders/variants.frag");
+        if(fragment_source == NULL)
+            return -1;
+
+        v = load_shader(GPU_VERTEX_SHADER, "data/shaders/time_mod.vert");
+        f[0] = GPU_CompileShaderWithDefines(GPU_FRAGMENT_SHADER, fragment_source, NULL, 0);
+        f[1] = GPU_CompileShaderWithDefines(GPU_FRAGMENT_SHADER, fragment_source, grayscale, 1);
+        f[2] = GPU_CompileShaderWithDefines(GPU_FRAGMENT_SHADER, fragment_source, tinted, 3);
+        free(fragment_source);
+
+        for(i = 0; i < 3; i++)
+        {
+            p[i] = GPU_LinkShaders(v, f[i]);
+            if(p[i] == 0)
+            {
+                GPU_LogError("Failed to build variant %d: %s\n", i, GPU_GetShaderMessage());
+                return -1;
+            }
+            blocks[i] = GPU_LoadShaderBlock(p[i], "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+        }
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                }
+            }
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < 3; i++)
+            {
+                GPU_ActivateShaderProgram(p[i], &blocks[i]);
+                GPU_BlitScale(image, NULL, screen, screen->w*(i + 1)/4.0f, screen->h/2.0f, 0.5f, 0.5f);
+            }
+            GPU_DeactivateShaderProgram();
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < 3; i++)
+        {
+            GPU_FreeShaderProgram(p[i]);
+            GPU_FreeShader(f[i]);
+        }
+        GPU_FreeShader(v);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
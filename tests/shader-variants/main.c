@@ -0,0 +1,133 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Draws a grid of one image with every combination of the GRAYSCALE, INVERT and TINT keywords from one GPU_ShaderVariantSet.
+// Press space to add a column; each new variant is only compiled when it is first drawn, which this test reports.
+
+static char* read_source(const char* filename)
+{
+    SDL_RWops* rwops;
+    char* source;
+    int header_size, file_size;
+    const char* header = "";
+    GPU_Renderer* renderer = GPU_GetCurrentRenderer();
+
+    rwops = SDL_RWFromFile(filename, "rb");
+    if(rwops == NULL)
+        return NULL;
+    file_size = SDL_RWseek(rwops, 0, SEEK_END);
+    SDL_RWseek(rwops, 0, SEEK_SET);
+
+    // Same version headers as load_shader()
+    if(renderer->shader_language == GPU_LANGUAGE_GLSL)
+        header = (renderer->max_shader_version >= 120? "#version 120\n" : "#version 110\n");
+    else if(renderer->shader_language == GPU_LANGUAGE_GLSLES)
+        header = "#version 100\nprecision mediump int;\nprecision mediump float;\n";
+    header_size = strlen(header);
+
+    source = (char*)malloc(header_size + file_size + 1);
+    strcpy(source, header);
+    SDL_RWread(rwops, source + header_size, 1, file_size);
+    source[header_size + file_size] = '\0';
+    SDL_RWclose(rwops);
+    return source;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        const char* keywords[3] = {"GRAYSCALE", "INVERT", "TINT"};
+        GPU_Image* image;
+        GPU_ShaderVariantSet* set;
+        char* vertex_source;
+        char* fragment_source;
+        int num_shown = 1;
+        int num_built = 0;
+        Uint32 mask;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        vertex_source = read_source("data/shaders/time_mod.vert");
+        fragment_source = read_source("data/shaders/variants.frag");
+        if(vertex_source == NULL || fragment_source == NULL)
+            return -1;
+
+        set = GPU_CreateShaderVariantSet(vertex_source, fragment_source, keywords, 3, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+        free(vertex_source);
+        free(fragment_source);
+        if(set == NULL)
+            return -1;
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        if(num_shown < 8)
+                            num_shown++;
+                    }
+                }
+            }
+
+            GPU_Clear(screen);
+
+            for(mask = 0; mask < (Uint32)num_shown; mask++)
+            {
+                if(!GPU_ActivateShaderVariant(set, mask))
+                    continue;
+                GPU_BlitScale(image, NULL, screen, screen->w*(mask + 0.5f)/8.0f, screen->h/2.0f, 0.2f, 0.2f);
+            }
+            GPU_DeactivateShaderProgram();
+
+            if(GPU_GetNumShaderVariants(set) != num_built)
+            {
+                num_built = GPU_GetNumShaderVariants(set);
+                GPU_LogError("Variants built: %d\n", num_built);
+            }
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_FreeShaderVariantSet(set);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "compat.h"
+#include "common.h"
+#include <stdlib.h>
+
+// Compares the bulk shape functions against drawing each shape separately.
+// SPACE/BACKSPACE change the shape type, 'm' toggles between bulk and per-shape calls.
+
+#define NUM_SHAPES 100000
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        int shapeType;
+        int numShapeTypes;
+        GPU_bool use_bulk;
+        int i;
+
+        SDL_Color* colors;
+        float* points;
+        float* lines;
+        float* tris;
+        GPU_Rect* rects;
+        float* circles;
+
+        colors = (SDL_Color*)malloc(NUM_SHAPES*sizeof(SDL_Color));
+        points = (float*)malloc(2*NUM_SHAPES*sizeof(float));
+        lines = (float*)malloc(4*NUM_SHAPES*sizeof(float));
+        tris = (float*)malloc(6*NUM_SHAPES*sizeof(float));
+        rects = (GPU_Rect*)malloc(NUM_SHAPES*sizeof(GPU_Rect));
+        circles = (float*)malloc(3*NUM_SHAPES*sizeof(float));
+
+        for(i = 0; i < NUM_SHAPES; i++)
+        {
+            int j;
+
+            colors[i].r = rand()%256;
+            colors[i].g = rand()%256;
+            colors[i].b = rand()%256;
+            GET_ALPHA(colors[i]) = rand()%256;
+
+            points[2*i] = rand()%screen->w;
+            points[2*i+1] = rand()%screen->h;
+
+            lines[4*i] = rand()%screen->w;
+            lines[4*i+1] = rand()%screen->h;
+            lines[4*i+2] = lines[4*i] + rand()%21 - 10;
+            lines[4*i+3] = lines[4*i+1] + rand()%21 - 10;
+
+            tris[6*i] = rand()%screen->w;
+            tris[6*i+1] = rand()%screen->h;
+            for(j = 2; j < 6; j += 2)
+            {
+                tris[6*i+j] = tris[6*i] + rand()%21 - 10;
+                tris[6*i+j+1] = tris[6*i+1] + rand()%21 - 10;
+            }
+
+            rects[i] = GPU_MakeRect(rand()%screen->w, rand()%screen->h, rand()%10 + 1, rand()%10 + 1);
+
+            circles[3*i] = rand()%screen->w;
+            circles[3*i+1] = rand()%screen->h;
+            circles[3*i+2] = rand()%4 + 2;
+        }
+
+        shapeType = 0;
+        numShapeTypes = 5;
+        use_bulk = GPU_TRUE;
+
+        GPU_SetShapeBlending(GPU_TRUE);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        shapeType++;
+                        if(shapeType >= numShapeTypes)
+                            shapeType = 0;
+                    }
+                    else if(event.key.keysym.sym == SDLK_BACKSPACE)
+                    {
+                        shapeType--;
+                        if(shapeType < 0)
+                            shapeType = numShapeTypes-1;
+                    }
+                    else if(event.key.keysym.sym == SDLK_m)
+                    {
+                        use_bulk = !use_bulk;
+                        GPU_LogError("Using %s\n", (use_bulk? "bulk functions" : "separate calls"));
+                    }
+
+                    startTime = SDL_GetTicks();
+                    frameCount = 0;
+                }
+            }
+
+            GPU_Clear(screen);
+
+            switch(shapeType)
+            {
+                case 0:
+                    if(use_bulk)
+                        GPU_Points(screen, NUM_SHAPES, points, colors, colors[0]);
+                    else
+                    {
+                        for(i = 0; i < NUM_SHAPES; i++)
+                            GPU_Pixel(screen, points[2*i], points[2*i+1], colors[i]);
+                    }
+                    break;
+                case 1:
+                    if(use_bulk)
+                        GPU_Lines(screen, NUM_SHAPES, lines, colors, colors[0]);
+                    else
+                    {
+                        for(i = 0; i < NUM_SHAPES; i++)
+                            GPU_Line(screen, lines[4*i], lines[4*i+1], lines[4*i+2], lines[4*i+3], colors[i]);
+                    }
+                    break;
+                case 2:
+                    if(use_bulk)
+                        GPU_TrisFilled(screen, NUM_SHAPES, tris, colors, colors[0]);
+                    else
+                    {
+                        for(i = 0; i < NUM_SHAPES; i++)
+                            GPU_TriFilled(screen, tris[6*i], tris[6*i+1], tris[6*i+2], tris[6*i+3], tris[6*i+4], tris[6*i+5], colors[i]);
+                    }
+                    break;
+                case 3:
+                    if(use_bulk)
+                        GPU_RectanglesFilled(screen, NUM_SHAPES, rects, colors, colors[0]);
+                    else
+                    {
+                        for(i = 0; i < NUM_SHAPES; i++)
+                            GPU_RectangleFilled2(screen, rects[i], colors[i]);
+                    }
+                    break;
+                case 4:
+                    if(use_bulk)
+                        GPU_CirclesFilled(screen, NUM_SHAPES, circles, colors, colors[0]);
+                    else
+                    {
+                        for(i = 0; i < NUM_SHAPES; i++)
+                            GPU_CircleFilled(screen, circles[3*i], circles[3*i+1], circles[3*i+2], colors[i]);
+                    }
+                    break;
+            }
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free(colors);
+        free(points);
+        free(lines);
+        free(tris);
+        free(rects);
+        free(circles);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
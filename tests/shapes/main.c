@@ -70,6 +70,10 @@ int main(int argc, char* argv[])
         int pn[NUM_POLYS];
         float* pv[NUM_POLYS];
         
+        #define STAR_POINTS 10
+        unsigned int star_sizes[2] = {2*STAR_POINTS, 4};
+        float star[2*(2*STAR_POINTS + 4)];
+        
         Uint8 blend;
         float thickness;
         
@@ -77,7 +81,7 @@ int main(int argc, char* argv[])
         frameCount = 0;
         
         shapeType = 0;
-        numShapeTypes = 18;
+        numShapeTypes = 19;
         
         for(i = 0; i < NUM_COLORS; i++)
         {
@@ -151,6 +155,22 @@ int main(int argc, char* argv[])
             }
         }
         
+        // A concave star outline with a square hole
+        for(i = 0; i < 2*STAR_POINTS; i++)
+        {
+            float radius = (i%2 == 0? 250.0f : 100.0f);
+            star[2*i] = screen->w/2 + radius*cos(M_PI*i/STAR_POINTS);
+            star[2*i+1] = screen->h/2 + radius*sin(M_PI*i/STAR_POINTS);
+        }
+        star[4*STAR_POINTS] = screen->w/2 - 40;
+        star[4*STAR_POINTS+1] = screen->h/2 - 40;
+        star[4*STAR_POINTS+2] = screen->w/2 + 40;
+        star[4*STAR_POINTS+3] = screen->h/2 - 40;
+        star[4*STAR_POINTS+4] = screen->w/2 + 40;
+        star[4*STAR_POINTS+5] = screen->h/2 + 40;
+        star[4*STAR_POINTS+6] = screen->w/2 - 40;
+        star[4*STAR_POINTS+7] = screen->h/2 + 40;
+        
         blend = 0;
         thickness = 1.0f;
         
@@ -327,6 +347,9 @@ int main(int argc, char* argv[])
                         GPU_PolygonFilled(screen, pn[i], pv[i], colors[i]);
                     }
                     break;
+                case 18:
+                    GPU_PolygonFilledEx(screen, 2, star_sizes, star, colors[0]);
+                    break;
             }
             
             GPU_Flip(screen);
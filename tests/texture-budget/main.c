@@ -0,0 +1,106 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+
+// Loads more images than the texture budget holds and draws a few at a time, so the rest are evicted and reuploaded as the window moves.
+// Prints the memory stats every 100 frames.  Press space to toggle the budget.
+
+#define NUM_IMAGES 16
+#define NUM_VISIBLE 4
+
+static void printMemoryStats(void)
+{
+    GPU_MemoryStats stats = GPU_GetMemoryStats();
+    GPU_LogError("Textures: %d (%u KB), evicted: %d (%u KB), budget: %u KB, renderbuffers: %d, framebuffers: %d\n",
+                 stats.num_textures, (unsigned int)(stats.texture_bytes/1024),
+                 stats.num_evicted_images, (unsigned int)(stats.evicted_bytes/1024),
+                 (unsigned int)(stats.budget_bytes/1024), stats.num_renderbuffers, stats.num_framebuffers);
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* images[NUM_IMAGES];
+        Uint64 budget;
+        int first;
+        int i;
+
+        for(i = 0; i < NUM_IMAGES; i++)
+        {
+            images[i] = GPU_LoadImage("data/test.bmp");
+            if(images[i] == NULL)
+                return -1;
+        }
+
+        printMemoryStats();
+
+        // Room for the visible images and a couple more
+        budget = GPU_GetMemoryStats().texture_bytes*(NUM_VISIBLE + 2)/NUM_IMAGES;
+        GPU_SetTextureBudget(budget);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                    {
+                        GPU_SetTextureBudget(GPU_GetMemoryStats().budget_bytes > 0? 0 : budget);
+                        printMemoryStats();
+                    }
+                }
+            }
+
+            GPU_Clear(screen);
+
+            first = (SDL_GetTicks()/500)%NUM_IMAGES;
+            for(i = 0; i < NUM_VISIBLE; i++)
+            {
+                GPU_Image* image = images[(first + i)%NUM_IMAGES];
+                GPU_BlitScale(image, NULL, screen, screen->w*(i + 0.5f)/NUM_VISIBLE, screen->h/2.0f, 0.5f, 0.5f);
+            }
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+            {
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+                printMemoryStats();
+            }
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        for(i = 0; i < NUM_IMAGES; i++)
+            GPU_FreeImage(images[i]);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,169 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include <math.h>
+
+// Two shader programs read the same "Frame" uniform block, which is written once per frame with GPU_UpdateUniformBuffer().
+// Each program also sets its own "scale" uniform every frame to a value that rarely changes, which the uniform cache skips.
+
+static const char* vertex_body =
+    "in vec3 gpu_Vertex;\n"
+    "in vec2 gpu_TexCoord;\n"
+    "in vec4 gpu_Color;\n"
+    "uniform mat4 gpu_ModelViewProjectionMatrix;\n"
+    "out vec4 color;\n"
+    "out vec2 texCoord;\n"
+    "void main(void)\n"
+    "{\n"
+    "    color = gpu_Color;\n"
+    "    texCoord = gpu_TexCoord;\n"
+    "    gl_Position = gpu_ModelViewProjectionMatrix * vec4(gpu_Vertex, 1.0);\n"
+    "}\n";
+
+static const char* fragment_body =
+    "in vec4 color;\n"
+    "in vec2 texCoord;\n"
+    "out vec4 fragColor;\n"
+    "uniform sampler2D tex;\n"
+    "uniform float scale;\n"
+    "layout(std140) uniform Frame\n"
+    "{\n"
+    "    vec4 tint;\n"
+    "    float time;\n"
+    "};\n"
+    "void main(void)\n"
+    "{\n"
+    "    vec4 texel = texture(tex, texCoord) * color;\n"
+    "#ifdef WAVE\n"
+    "    texel.rgb *= 0.75 + 0.25*sin(time*3.0 + texCoord.x*12.0);\n"
+    "#endif\n"
+    "    fragColor = vec4(texel.rgb * tint.rgb * scale, texel.a);\n"
+    "}\n";
+
+static Uint32 build_program(const char* header, const char* define, GPU_ShaderBlock* block)
+{
+    char source[2048];
+    Uint32 v, f, p;
+
+    SDL_snprintf(source, sizeof(source), "%s%s", header, vertex_body);
+    v = GPU_CompileShader(GPU_VERTEX_SHADER, source);
+    SDL_snprintf(source, sizeof(source), "%s%s%s", header, define, fragment_body);
+    f = GPU_CompileShader(GPU_FRAGMENT_SHADER, source);
+    p = GPU_LinkShaders(v, f);
+    GPU_FreeShader(v);
+    GPU_FreeShader(f);
+    if(p == 0)
+    {
+        GPU_LogError("Failed to link shader program: %s\n", GPU_GetShaderMessage());
+        return 0;
+    }
+
+    // The block reads from binding point 0
+    GPU_SetUniformBlockBinding(p, "Frame", 0);
+    *block = GPU_LoadShaderBlock(p, "gpu_Vertex", "gpu_TexCoord", "gpu_Color", "gpu_ModelViewProjectionMatrix");
+    return p;
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	if(!GPU_IsFeatureEnabled(GPU_FEATURE_UNIFORM_BUFFERS))
+	{
+		GPU_LogError("This renderer does not support uniform buffers.\n");
+		GPU_Quit();
+		return 0;
+	}
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        const char* header = (GPU_GetCurrentRenderer()->shader_language == GPU_LANGUAGE_GLSLES? "#version 300 es\nprecision mediump float;\n" : "#version 140\n");
+        GPU_Image* image;
+        Uint32 programs[2];
+        GPU_ShaderBlock blocks[2];
+        Uint32 frame_buffer;
+        float frame_data[8];  // std140: vec4 tint, float time, padded to 32 bytes
+        float scale = 1.0f;
+        int i;
+
+        image = GPU_LoadImage("data/test.bmp");
+        if(image == NULL)
+            return -1;
+
+        programs[0] = build_program(header, "", &blocks[0]);
+        programs[1] = build_program(header, "#define WAVE\n", &blocks[1]);
+        if(programs[0] == 0 || programs[1] == 0)
+            return -1;
+
+        memset(frame_data, 0, sizeof(frame_data));
+        frame_buffer = GPU_CreateUniformBuffer(sizeof(frame_data), frame_data);
+        GPU_BindUniformBuffer(frame_buffer, 0);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_SPACE)
+                        scale = (scale == 1.0f? 0.5f : 1.0f);
+                }
+            }
+
+            // One write serves both programs
+            frame_data[0] = 0.6f + 0.4f*sin(SDL_GetTicks()/700.0f);
+            frame_data[1] = 0.8f;
+            frame_data[2] = 0.6f + 0.4f*cos(SDL_GetTicks()/900.0f);
+            frame_data[3] = 1.0f;
+            frame_data[4] = SDL_GetTicks()/1000.0f;
+            GPU_UpdateUniformBuffer(frame_buffer, 0, sizeof(frame_data), frame_data);
+
+            GPU_Clear(screen);
+
+            for(i = 0; i < 2; i++)
+            {
+                GPU_ActivateShaderProgram(programs[i], &blocks[i]);
+                GPU_SetUniformf(GPU_GetUniformLocation(programs[i], "scale"), scale);
+                GPU_Blit(image, NULL, screen, screen->w*(i + 1)/3.0f, screen->h/2.0f);
+            }
+            GPU_DeactivateShaderProgram();
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%500 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        GPU_FreeUniformBuffer(frame_buffer);
+        for(i = 0; i < 2; i++)
+            GPU_FreeShaderProgram(programs[i]);
+        GPU_FreeImage(image);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "SDL.h"
+#include "SDL_gpu.h"
+#include "common.h"
+#include "compat.h"
+#include <stdlib.h>
+
+// Uploads a generated planar YCbCr frame every frame and draws it with the built-in conversion shader.
+// 'f' toggles between 4:2:0 and 4:2:2 chroma subsampling.
+
+#define FRAME_W 640
+#define FRAME_H 360
+
+// Moving color bars in BT.601 video range
+static void fill_frame(unsigned char* y_plane, unsigned char* u_plane, unsigned char* v_plane, int chroma_h, Uint32 time)
+{
+    static const unsigned char bar_y[8] = {235, 210, 170, 145, 106, 81, 41, 16};
+    static const unsigned char bar_u[8] = {128, 16, 166, 54, 202, 90, 240, 128};
+    static const unsigned char bar_v[8] = {128, 146, 16, 34, 222, 240, 110, 128};
+    int x, y;
+    int shift = (int)(time/10) % FRAME_W;
+
+    for(y = 0; y < FRAME_H; y++)
+    {
+        for(x = 0; x < FRAME_W; x++)
+            y_plane[y*FRAME_W + x] = bar_y[((x + shift) % FRAME_W) * 8 / FRAME_W];
+    }
+
+    for(y = 0; y < chroma_h; y++)
+    {
+        for(x = 0; x < FRAME_W/2; x++)
+        {
+            int bar = ((2*x + shift) % FRAME_W) * 8 / FRAME_W;
+            u_plane[y*(FRAME_W/2) + x] = bar_u[bar];
+            v_plane[y*(FRAME_W/2) + x] = bar_v[bar];
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+	GPU_Target* screen;
+
+	printRenderers();
+
+	screen = GPU_Init(800, 600, GPU_DEFAULT_INIT_FLAGS);
+	if(screen == NULL)
+		return -1;
+
+	printCurrentRenderer();
+
+	{
+		Uint32 startTime;
+		long frameCount;
+		Uint8 done;
+		SDL_Event event;
+
+        GPU_Image* image420;
+        GPU_Image* image422;
+        GPU_Image* image;
+        unsigned char* y_plane;
+        unsigned char* u_plane;
+        unsigned char* v_plane;
+        int pitches[3] = {FRAME_W, FRAME_W/2, FRAME_W/2};
+
+        image420 = GPU_CreateImage(FRAME_W, FRAME_H, GPU_FORMAT_YCbCr420P);
+        image422 = GPU_CreateImage(FRAME_W, FRAME_H, GPU_FORMAT_YCbCr422);
+        if(image420 == NULL || image422 == NULL)
+            return -1;
+        image = image420;
+
+        y_plane = (unsigned char*)malloc(FRAME_W*FRAME_H);
+        u_plane = (unsigned char*)malloc(FRAME_W/2*FRAME_H);
+        v_plane = (unsigned char*)malloc(FRAME_W/2*FRAME_H);
+
+        startTime = SDL_GetTicks();
+        frameCount = 0;
+
+        done = 0;
+        while(!done)
+        {
+            while(SDL_PollEvent(&event))
+            {
+                if(event.type == SDL_QUIT)
+                    done = 1;
+                else if(event.type == SDL_KEYDOWN)
+                {
+                    if(event.key.keysym.sym == SDLK_ESCAPE)
+                        done = 1;
+                    else if(event.key.keysym.sym == SDLK_f)
+                    {
+                        image = (image == image420? image422 : image420);
+                        GPU_LogError("Using %s\n", (image == image420? "YCbCr 4:2:0" : "YCbCr 4:2:2"));
+                    }
+                }
+            }
+
+            fill_frame(y_plane, u_plane, v_plane, (image == image420? FRAME_H/2 : FRAME_H), SDL_GetTicks());
+            GPU_UpdateImageYUV(image, NULL, y_plane, u_plane, v_plane, pitches);
+
+            GPU_Clear(screen);
+
+            GPU_Blit(image, NULL, screen, screen->w/2, screen->h/2);
+            GPU_RectangleFilled(screen, 10, 10, 60, 60, GPU_MakeColor(255, 0, 0, 255));
+
+            GPU_Flip(screen);
+
+            frameCount++;
+            if(frameCount%100 == 0)
+                printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+        }
+
+        printf("Average FPS: %.2f\n", 1000.0f*frameCount/(SDL_GetTicks() - startTime));
+
+        free(y_plane);
+        free(u_plane);
+        free(v_plane);
+        GPU_FreeImage(image420);
+        GPU_FreeImage(image422);
+	}
+
+	GPU_Quit();
+
+	return 0;
+}